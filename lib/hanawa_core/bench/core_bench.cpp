@@ -0,0 +1,389 @@
+// Benchmarks des Analyse-Kerns auf dem Rechner (Ziel core_bench in CMakeLists.txt)
+//
+//   cmake -S lib/hanawa_core -B build && cmake --build build
+//   ./build/core_bench                                  # Tabelle
+//   ./build/core_bench --benchmark_out=vorher.json      # zusätzlich JSON
+//   ./build/core_bench --benchmark_filter=reduction/gamma/testimage
+//   ./build/core_bench --image=anderes.jpg
+//
+// Misst jede Stufe der Analyse (Namen wie in stage_metrics.h) auf
+// local_test/testimage.jpg und auf einem synthetischen Frame, jeweils über
+// die Dekodier-Skalierungen 1/2/4/8 und mehrere Fensteranzahlen. Die Zeiten
+// gelten für den Rechner: sie vergleichen zwei Stände eines Kernels, nicht
+// Rechner und ESP32 (dort /api/metrics).
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "microbench.h"
+#include "ambilight_protocol.h"
+#include "color_math.h"
+#include "color_reduce.h"
+#include "window_geometry.h"
+
+#ifdef HANAWA_HAVE_JPEG
+#include "host_jpeg.h"
+#endif
+
+#ifndef HANAWA_TESTIMAGE
+#define HANAWA_TESTIMAGE "testimage.jpg"
+#endif
+
+// Kamera-Auflösung (VGA) und Lage des Fernsehers in testimage.jpg
+// (generate_testimage.py: 80,60 bis 560,420)
+#define FRAME_WIDTH   640
+#define FRAME_HEIGHT  480
+static const float TV_CORNERS[4][2] = { {80, 60}, {560, 60}, {560, 420}, {80, 420} };
+
+static const int SCALES[] = { 1, 2, 4, 8 };
+static const int WINDOWS[][2] = { {4, 3}, {10, 8}, {20, 12}, {40, 24} };
+
+// ============================================================================
+// FRAMES
+// ============================================================================
+
+struct Frame {
+    int width;
+    int height;
+    std::vector<uint8_t> rgb565;   // High-Byte zuerst wie jpg2rgb565()
+};
+
+static std::vector<uint8_t> s_jpeg;
+
+static bool loadFile(const char* path, std::vector<uint8_t>& out) {
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        return false;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    out.resize(size > 0 ? size : 0);
+    bool ok = size > 0 && fread(out.data(), 1, size, f) == (size_t)size;
+    fclose(f);
+    return ok;
+}
+
+#ifdef HANAWA_HAVE_JPEG
+static bool decodeJpeg(const std::vector<uint8_t>& jpeg, int scale, Frame& frame) {
+    return hostDecodeJpeg(jpeg.data(), jpeg.size(), scale, frame.rgb565, &frame.width, &frame.height);
+}
+#endif
+
+// Verlauf mit Rauschen: jedes Rechteck bekommt eine andere Mischfarbe
+static void makeSynthetic(int scale, Frame& frame) {
+    frame.width = FRAME_WIDTH / scale;
+    frame.height = FRAME_HEIGHT / scale;
+    frame.rgb565.resize((size_t)frame.width * frame.height * 2);
+    uint32_t seed = 12345;
+    for (int y = 0; y < frame.height; y++) {
+        for (int x = 0; x < frame.width; x++) {
+            seed = seed * 1103515245 + 12345;
+            int noise = (seed >> 16) & 0x1F;
+            uint8_t r = (uint8_t)(x * 255 / frame.width);
+            uint8_t g = (uint8_t)(y * 255 / frame.height);
+            uint8_t b = (uint8_t)((x + y + noise) & 0xFF);
+            uint16_t pixel = rgb565Pack(r, g, b);
+            size_t idx = ((size_t)y * frame.width + x) * 2;
+            frame.rgb565[idx] = pixel >> 8;
+            frame.rgb565[idx + 1] = pixel & 0xFF;
+        }
+    }
+}
+
+// ============================================================================
+// FÄLLE
+// ============================================================================
+
+struct Windows {
+    std::vector<WindowRect> top, bottom, left, right;
+
+    void compute(int scale, int hSeg, int vSeg) {
+        float c[4][2];
+        for (int i = 0; i < 4; i++) {
+            c[i][0] = TV_CORNERS[i][0] / scale;
+            c[i][1] = TV_CORNERS[i][1] / scale;
+        }
+        top.clear();
+        bottom.clear();
+        left.clear();
+        right.clear();
+        calculateAmbilightWindows(c[0], c[1], c[3], c[2], hSeg, vSeg, top, bottom, left, right);
+    }
+
+    int count() const { return (int)(top.size() + bottom.size() + left.size() + right.size()); }
+};
+
+typedef RGB (*Reducer)(const uint8_t*, int, int, int, int, int, int);
+
+static std::string windowsName(int hSeg, int vSeg) {
+    return "windows:" + std::to_string(hSeg) + "x" + std::to_string(vSeg);
+}
+
+static void registerGeometry() {
+    for (const auto& w : WINDOWS) {
+        int hSeg = w[0], vSeg = w[1];
+        benchRegister("geometry/" + windowsName(hSeg, vSeg), [hSeg, vSeg](BenchState& state) {
+            Windows windows;
+            while (state.keepRunning()) {
+                windows.compute(2, hSeg, vSeg);
+                benchDoNotOptimize(windows.top.data());
+            }
+            state.setItemsProcessed(state.iterations() * windows.count());
+        });
+    }
+}
+
+static void registerDecode() {
+    for (int scale : SCALES) {
+        benchRegister("jpeg_decode/testimage/scale:" + std::to_string(scale), [scale](BenchState& state) {
+#ifdef HANAWA_HAVE_JPEG
+            if (s_jpeg.empty()) {
+                state.skip("Testbild fehlt");
+                return;
+            }
+            Frame frame;
+            while (state.keepRunning()) {
+                if (!decodeJpeg(s_jpeg, scale, frame)) {
+                    state.skip("JPEG fehlerhaft");
+                    return;
+                }
+            }
+            state.setItemsProcessed(state.iterations() * frame.width * frame.height);
+            state.setCounter("bytes", (double)s_jpeg.size());
+#else
+            state.skip("ohne libjpeg übersetzt");
+#endif
+        });
+    }
+}
+
+// Ein Frame pro Quelle und Skalierung, gemeinsam für alle Fälle
+static const Frame* sourceFrame(const std::string& source, int scale) {
+    static std::vector<Frame> s_frames(2 * 4);
+    static std::vector<bool> s_ready(2 * 4, false);
+    int slot = (source == "testimage" ? 0 : 4) + (scale == 1 ? 0 : scale == 2 ? 1 : scale == 4 ? 2 : 3);
+    if (!s_ready[slot]) {
+        if (source == "synthetic") {
+            makeSynthetic(scale, s_frames[slot]);
+        } else {
+#ifdef HANAWA_HAVE_JPEG
+            if (s_jpeg.empty() || !decodeJpeg(s_jpeg, scale, s_frames[slot])) {
+                return nullptr;
+            }
+#else
+            return nullptr;
+#endif
+        }
+        s_ready[slot] = true;
+    }
+    return &s_frames[slot];
+}
+
+static void registerReduction(const char* kernel, Reducer reducer) {
+    for (const char* source : { "testimage", "synthetic" }) {
+        for (int scale : SCALES) {
+            for (const auto& w : WINDOWS) {
+                int hSeg = w[0], vSeg = w[1];
+                std::string src = source;
+                std::string name = std::string("reduction/") + kernel + "/" + source +
+                                   "/scale:" + std::to_string(scale) + "/" + windowsName(hSeg, vSeg);
+                benchRegister(name, [src, scale, hSeg, vSeg, reducer](BenchState& state) {
+                    const Frame* frame = sourceFrame(src, scale);
+                    if (!frame) {
+                        state.skip("Testbild nicht dekodierbar");
+                        return;
+                    }
+                    Windows windows;
+                    windows.compute(scale, hSeg, vSeg);
+                    const std::vector<WindowRect>* sides[4] = { &windows.top, &windows.right, &windows.bottom, &windows.left };
+                    const uint8_t* buf = frame->rgb565.data();
+                    while (state.keepRunning()) {
+                        for (const std::vector<WindowRect>* side : sides) {
+                            for (const WindowRect& r : *side) {
+                                benchDoNotOptimize(reducer(buf, frame->width, frame->height, r.x1, r.y1, r.x2, r.y2));
+                            }
+                        }
+                    }
+                    state.setItemsProcessed(state.iterations() * windows.count());
+                    state.setCounter("rects", windows.count());
+                });
+            }
+        }
+    }
+}
+
+// Reduktion auf zwei Kernen (sucher2 reduce_worker.cpp): misst nur den
+// größeren der beiden Teile aus splitRectsByArea(), also die Wandzeit, wenn
+// beide Kerne gleichzeitig rechnen. share = Pixelanteil dieses Teils.
+static void registerReductionSplit() {
+    for (const char* source : { "testimage", "synthetic" }) {
+        for (const auto& w : WINDOWS) {
+            int hSeg = w[0], vSeg = w[1];
+            std::string src = source;
+            std::string name = std::string("reduction/gamma_split/") + source + "/scale:2/" + windowsName(hSeg, vSeg);
+            benchRegister(name, [src, hSeg, vSeg](BenchState& state) {
+                const Frame* frame = sourceFrame(src, 2);
+                if (!frame) {
+                    state.skip("Testbild nicht dekodierbar");
+                    return;
+                }
+                Windows windows;
+                windows.compute(2, hSeg, vSeg);
+                std::vector<WindowRect> all(windows.top);
+                all.insert(all.end(), windows.right.begin(), windows.right.end());
+                all.insert(all.end(), windows.bottom.begin(), windows.bottom.end());
+                all.insert(all.end(), windows.left.begin(), windows.left.end());
+                int n = (int)all.size();
+                int split = splitRectsByArea(all.data(), n, frame->width, frame->height);
+
+                double area[2] = { 0, 0 };
+                for (int i = 0; i < n; i++) {
+                    area[i < split ? 0 : 1] += (double)(all[i].x2 - all[i].x1) * (all[i].y2 - all[i].y1);
+                }
+                bool front = area[0] >= area[1];
+                const WindowRect* rects = front ? all.data() : all.data() + split;
+                int count = front ? split : n - split;
+                std::vector<RGB> colors(n);
+                while (state.keepRunning()) {
+                    calculateMeanRGB2Rects(frame->rgb565.data(), frame->width, frame->height, rects, count, colors.data());
+                    benchDoNotOptimize(colors[0]);
+                }
+                state.setItemsProcessed(state.iterations() * n);
+                state.setCounter("rects", n);
+                state.setCounter("share", area[front ? 0 : 1] / (area[0] + area[1]));
+            });
+        }
+    }
+}
+
+// v1-Firmware: Segment-Geometrie und RMS über alle Pixel (ein Frame)
+static void registerReductionV1() {
+    for (const char* source : { "testimage", "synthetic" }) {
+        for (int scale : SCALES) {
+            for (const auto& w : WINDOWS) {
+                int hDiv = w[0], vDiv = w[1];
+                std::string src = source;
+                std::string name = std::string("reduction/v1_rms/") + source +
+                                   "/scale:" + std::to_string(scale) + "/" + windowsName(hDiv, vDiv);
+                benchRegister(name, [src, scale, hDiv, vDiv](BenchState& state) {
+                    const Frame* frame = sourceFrame(src, scale);
+                    if (!frame) {
+                        state.skip("Testbild nicht dekodierbar");
+                        return;
+                    }
+                    int corners[4][2];
+                    for (int i = 0; i < 4; i++) {
+                        corners[i][0] = (int)(TV_CORNERS[i][0] / scale);
+                        corners[i][1] = (int)(TV_CORNERS[i][1] / scale);
+                    }
+                    std::vector<WindowRect> rects(2 * (hDiv + vDiv));
+                    int count = 0;
+                    const uint8_t* buf = frame->rgb565.data();
+                    while (state.keepRunning()) {
+                        count = calculateEdgeSegments(corners, hDiv, vDiv, rects.data(), (int)rects.size());
+                        for (int i = 0; i < count; i++) {
+                            const WindowRect& r = rects[i];
+                            RGB color = calculateSegmentRms(buf, frame->width, frame->height, r.x1, r.y1, r.x2, r.y2);
+                            benchDoNotOptimize(rgbLuminance(color));
+                        }
+                    }
+                    state.setItemsProcessed(state.iterations() * count);
+                    state.setCounter("rects", count);
+                });
+            }
+        }
+    }
+}
+
+static void registerColorMath() {
+    benchRegister("color/srgb_to_linear", [](BenchState& state) {
+        while (state.keepRunning()) {
+            float sum = 0;
+            for (int v = 0; v < 256; v++) {
+                sum += srgbToLinear((uint8_t)v);
+            }
+            benchDoNotOptimize(sum);
+        }
+        state.setItemsProcessed(state.iterations() * 256);
+    });
+    benchRegister("color/linear_to_srgb", [](BenchState& state) {
+        while (state.keepRunning()) {
+            unsigned sum = 0;
+            for (int v = 0; v < 256; v++) {
+                sum += linearToSrgb(v / 255.0f);
+            }
+            benchDoNotOptimize(sum);
+        }
+        state.setItemsProcessed(state.iterations() * 256);
+    });
+}
+
+class NullTransport : public AmbilightTransport {
+public:
+    bool sendPacket(const uint8_t* data, size_t len) override {
+        benchDoNotOptimize(data[len - 1]);
+        return true;
+    }
+};
+
+static void registerEncode() {
+    for (int v2 = 0; v2 < 2; v2++) {
+        for (const auto& w : WINDOWS) {
+            int hSeg = w[0], vSeg = w[1];
+            std::string name = std::string("encode/") + (v2 ? "v2_fec_timing/" : "v1/") + windowsName(hSeg, vSeg);
+            benchRegister(name, [v2, hSeg, vSeg](BenchState& state) {
+                int vertical = vSeg - 2;
+                std::vector<RGB> top(hSeg), bottom(hSeg), left(vertical), right(vertical);
+                for (int i = 0; i < hSeg; i++) {
+                    top[i] = {(uint8_t)i, 10, 20};
+                    bottom[i] = {(uint8_t)i, 30, 40};
+                }
+                for (int i = 0; i < vertical; i++) {
+                    left[i] = {50, (uint8_t)i, 60};
+                    right[i] = {70, (uint8_t)i, 80};
+                }
+                AmbilightSides sides = { top.data(), hSeg, right.data(), vertical,
+                                         bottom.data(), hSeg, left.data(), vertical };
+                AmbilightFrameEncoder encoder;
+                encoder.setParityEnabled(v2 != 0);
+                encoder.setTimingEnabled(v2 != 0);
+                AmbilightFrameMeta meta = { 0, 0, 100 };
+                NullTransport transport;
+                int packets = 0;
+                while (state.keepRunning()) {
+                    meta.sequence++;
+                    packets = encoder.encode(hSeg, vSeg, sides, &meta);
+                    encoder.send(transport);
+                }
+                state.setItemsProcessed(state.iterations());
+                state.setCounter("packets", packets);
+            });
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    const char* image = HANAWA_TESTIMAGE;
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--image=", 8) == 0) {
+            image = argv[i] + 8;
+        }
+    }
+    if (!loadFile(image, s_jpeg)) {
+        fprintf(stderr, "core_bench: %s nicht lesbar, nur synthetische Frames\n", image);
+        s_jpeg.clear();
+    }
+
+    registerGeometry();
+    registerDecode();
+    registerReduction("rms", calculateMeanRGB);
+    registerReduction("gamma", calculateMeanRGB2);
+    registerReductionSplit();
+    registerReductionV1();
+    registerColorMath();
+    registerEncode();
+    return benchMain(argc, argv);
+}
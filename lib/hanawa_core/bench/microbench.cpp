@@ -0,0 +1,280 @@
+#include "microbench.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <chrono>
+#include <regex>
+#include <thread>
+
+// ============================================================================
+// STATE
+// ============================================================================
+
+struct BenchCase {
+    std::string name;
+    BenchFunction fn;
+};
+
+struct BenchResult {
+    std::string name;
+    int64_t iterations;
+    double realNs;      // pro Iteration
+    double cpuNs;
+    double itemsPerSecond;
+    std::vector<std::pair<std::string, double> > counters;
+    std::string skipped;
+};
+
+static std::vector<BenchCase>& registry() {
+    static std::vector<BenchCase> s_cases;
+    return s_cases;
+}
+
+void benchRegister(const std::string& name, BenchFunction fn) {
+    registry().push_back({name, fn});
+}
+
+// ============================================================================
+// MESSUNG
+// ============================================================================
+
+static double cpuSeconds() {
+    timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Wie Google Benchmark: Iterationen erhöhen, bis ein Lauf minTime dauert
+static BenchResult runCase(const BenchCase& c, double minTime) {
+    BenchResult result;
+    result.name = c.name;
+    int64_t n = 1;
+    for (;;) {
+        BenchState state(n);
+        double cpu0 = cpuSeconds();
+        auto t0 = std::chrono::steady_clock::now();
+        c.fn(state);
+        auto t1 = std::chrono::steady_clock::now();
+        double cpu = cpuSeconds() - cpu0;
+        double real = std::chrono::duration<double>(t1 - t0).count();
+
+        if (!state.skipped().empty()) {
+            result.iterations = 0;
+            result.realNs = result.cpuNs = result.itemsPerSecond = 0;
+            result.skipped = state.skipped();
+            return result;
+        }
+        if (real >= minTime || n >= 1000000000) {
+            result.iterations = n;
+            result.realNs = real * 1e9 / n;
+            result.cpuNs = cpu * 1e9 / n;
+            result.itemsPerSecond = state.itemsProcessed() > 0 && real > 0 ? state.itemsProcessed() / real : 0;
+            result.counters = state.counters();
+            return result;
+        }
+        double factor = real > 0 ? minTime * 1.4 / real : 10.0;
+        if (real < minTime / 10 || factor > 10.0) {
+            factor = 10.0;
+        }
+        int64_t next = (int64_t)(n * factor);
+        n = next > n ? next : n + 1;
+    }
+}
+
+// ============================================================================
+// AUSGABE
+// ============================================================================
+
+static void formatTime(char* out, size_t cap, double ns) {
+    if (ns < 10e3) {
+        snprintf(out, cap, "%.1f ns", ns);
+    } else if (ns < 10e6) {
+        snprintf(out, cap, "%.2f us", ns / 1e3);
+    } else {
+        snprintf(out, cap, "%.2f ms", ns / 1e6);
+    }
+}
+
+static void formatRate(char* out, size_t cap, double perSecond) {
+    if (perSecond >= 1e9) {
+        snprintf(out, cap, "%.3fG/s", perSecond / 1e9);
+    } else if (perSecond >= 1e6) {
+        snprintf(out, cap, "%.3fM/s", perSecond / 1e6);
+    } else if (perSecond >= 1e3) {
+        snprintf(out, cap, "%.3fk/s", perSecond / 1e3);
+    } else {
+        snprintf(out, cap, "%.3f/s", perSecond);
+    }
+}
+
+static void printRow(FILE* f, const BenchResult& r, int nameWidth) {
+    if (!r.skipped.empty()) {
+        fprintf(f, "%-*s SKIPPED: %s\n", nameWidth, r.name.c_str(), r.skipped.c_str());
+        return;
+    }
+    char real[32], cpu[32];
+    formatTime(real, sizeof(real), r.realNs);
+    formatTime(cpu, sizeof(cpu), r.cpuNs);
+    fprintf(f, "%-*s %13s %13s %12lld", nameWidth, r.name.c_str(), real, cpu, (long long)r.iterations);
+    if (r.itemsPerSecond > 0) {
+        char rate[32];
+        formatRate(rate, sizeof(rate), r.itemsPerSecond);
+        fprintf(f, " items_per_second=%s", rate);
+    }
+    for (const auto& counter : r.counters) {
+        fprintf(f, " %s=%g", counter.first.c_str(), counter.second);
+    }
+    fprintf(f, "\n");
+}
+
+static std::string jsonEscape(const std::string& text) {
+    std::string out;
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+        }
+        out += c;
+    }
+    return out;
+}
+
+static void writeJson(FILE* f, const char* executable, const std::vector<BenchResult>& results) {
+    char date[64];
+    time_t now = time(nullptr);
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S%z", localtime(&now));
+    char host[128] = "unknown";
+    gethostname(host, sizeof(host) - 1);
+#ifdef NDEBUG
+    const char* buildType = "release";
+#else
+    const char* buildType = "debug";
+#endif
+
+    fprintf(f, "{\n  \"context\": {\n");
+    fprintf(f, "    \"date\": \"%s\",\n", date);
+    fprintf(f, "    \"host_name\": \"%s\",\n", jsonEscape(host).c_str());
+    fprintf(f, "    \"executable\": \"%s\",\n", jsonEscape(executable).c_str());
+    fprintf(f, "    \"num_cpus\": %u,\n", std::thread::hardware_concurrency());
+    fprintf(f, "    \"library_build_type\": \"%s\"\n", buildType);
+    fprintf(f, "  },\n  \"benchmarks\": [");
+
+    bool first = true;
+    for (const BenchResult& r : results) {
+        if (!r.skipped.empty()) {
+            continue;
+        }
+        fprintf(f, "%s\n    {\n", first ? "" : ",");
+        first = false;
+        std::string name = jsonEscape(r.name);
+        fprintf(f, "      \"name\": \"%s\",\n", name.c_str());
+        fprintf(f, "      \"run_name\": \"%s\",\n", name.c_str());
+        fprintf(f, "      \"run_type\": \"iteration\",\n");
+        fprintf(f, "      \"repetitions\": 1,\n      \"repetition_index\": 0,\n      \"threads\": 1,\n");
+        fprintf(f, "      \"iterations\": %lld,\n", (long long)r.iterations);
+        fprintf(f, "      \"real_time\": %.6e,\n", r.realNs);
+        fprintf(f, "      \"cpu_time\": %.6e,\n", r.cpuNs);
+        fprintf(f, "      \"time_unit\": \"ns\"");
+        if (r.itemsPerSecond > 0) {
+            fprintf(f, ",\n      \"items_per_second\": %.6e", r.itemsPerSecond);
+        }
+        for (const auto& counter : r.counters) {
+            fprintf(f, ",\n      \"%s\": %.6e", jsonEscape(counter.first).c_str(), counter.second);
+        }
+        fprintf(f, "\n    }");
+    }
+    fprintf(f, "\n  ]\n}\n");
+}
+
+// ============================================================================
+// API
+// ============================================================================
+
+static bool flagValue(const char* arg, const char* flag, const char** value) {
+    size_t n = strlen(flag);
+    if (strncmp(arg, flag, n) == 0 && arg[n] == '=') {
+        *value = arg + n + 1;
+        return true;
+    }
+    return false;
+}
+
+int benchMain(int argc, char** argv) {
+    std::string filter = ".";
+    double minTime = 0.1;
+    std::string format = "console";
+    const char* outPath = nullptr;
+
+    for (int i = 1; i < argc; i++) {
+        const char* value = nullptr;
+        if (flagValue(argv[i], "--benchmark_filter", &value)) {
+            filter = value;
+        } else if (flagValue(argv[i], "--benchmark_min_time", &value)) {
+            minTime = atof(value);   // Sekunden, ein angehängtes "s" wird ignoriert
+        } else if (flagValue(argv[i], "--benchmark_format", &value)) {
+            format = value;
+        } else if (flagValue(argv[i], "--benchmark_out", &value)) {
+            outPath = value;
+        } else if (strncmp(argv[i], "--benchmark_", 12) == 0) {
+            fprintf(stderr, "Unbekannte Option: %s\n", argv[i]);
+            return 1;
+        }
+        // Alles andere gehört dem Aufrufer
+    }
+    if (format != "console" && format != "json") {
+        fprintf(stderr, "--benchmark_format=console|json\n");
+        return 1;
+    }
+
+    std::regex re;
+    try {
+        re = std::regex(filter);
+    } catch (const std::regex_error&) {
+        fprintf(stderr, "Ungültiger Filter: %s\n", filter.c_str());
+        return 1;
+    }
+
+    std::vector<const BenchCase*> selected;
+    int nameWidth = 10;
+    for (const BenchCase& c : registry()) {
+        if (std::regex_search(c.name, re)) {
+            selected.push_back(&c);
+            if ((int)c.name.size() > nameWidth) {
+                nameWidth = (int)c.name.size();
+            }
+        }
+    }
+    if (selected.empty()) {
+        fprintf(stderr, "Kein Benchmark passt auf '%s'\n", filter.c_str());
+        return 1;
+    }
+
+    bool console = format == "console";
+    if (console) {
+        printf("%-*s %13s %13s %12s\n", nameWidth, "Benchmark", "Time", "CPU", "Iterations");
+        printf("%s\n", std::string(nameWidth + 41, '-').c_str());
+    }
+    std::vector<BenchResult> results;
+    for (const BenchCase* c : selected) {
+        results.push_back(runCase(*c, minTime));
+        if (console) {
+            printRow(stdout, results.back(), nameWidth);
+            fflush(stdout);
+        }
+    }
+
+    if (!console) {
+        writeJson(stdout, argv[0], results);
+    }
+    if (outPath) {
+        FILE* f = fopen(outPath, "w");
+        if (!f) {
+            fprintf(stderr, "Kann %s nicht schreiben\n", outPath);
+            return 1;
+        }
+        writeJson(f, argv[0], results);
+        fclose(f);
+    }
+    return 0;
+}
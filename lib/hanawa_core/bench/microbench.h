@@ -0,0 +1,73 @@
+#ifndef MICROBENCH_H
+#define MICROBENCH_H
+
+// Kleiner Benchmark-Runner im Stil von Google Benchmark, ohne Abhängigkeit.
+// Gleiche Kommandozeile (--benchmark_filter, --benchmark_min_time,
+// --benchmark_format, --benchmark_out) und gleiches JSON-Format, damit
+// compare.py aus Google Benchmark zwei Läufe direkt vergleichen kann.
+//
+//   benchRegister("reduction/gamma/scale:2", [](BenchState& state) {
+//       while (state.keepRunning()) {
+//           benchDoNotOptimize(calculateMeanRGB2(...));
+//       }
+//       state.setItemsProcessed(state.iterations() * rects);
+//   });
+//   return benchMain(argc, argv);
+
+#include <stdint.h>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+class BenchState {
+public:
+    explicit BenchState(int64_t maxIterations) : m_max(maxIterations), m_done(0) {}
+
+    // Schleifenbedingung der Messung (wie "for (auto _ : state)")
+    bool keepRunning() {
+        if (m_done < m_max) {
+            m_done++;
+            return true;
+        }
+        return false;
+    }
+
+    int64_t iterations() const { return m_max; }
+
+    // Ergibt items_per_second in Tabelle und JSON
+    void setItemsProcessed(int64_t items) { m_items = items; }
+    int64_t itemsProcessed() const { return m_items; }
+
+    // Zusätzliche Spalte (z. B. Rechtecke pro Frame), wird nicht durch die Zeit geteilt
+    void setCounter(const char* name, double value) { m_counters.push_back(std::make_pair(std::string(name), value)); }
+    const std::vector<std::pair<std::string, double> >& counters() const { return m_counters; }
+
+    // Lauf abbrechen (z. B. Testbild fehlt), erscheint als "SKIPPED"
+    void skip(const char* reason) { m_skipped = reason; m_max = 0; }
+    const std::string& skipped() const { return m_skipped; }
+
+private:
+    int64_t m_max;
+    int64_t m_done;
+    int64_t m_items = 0;
+    std::vector<std::pair<std::string, double> > m_counters;
+    std::string m_skipped;
+};
+
+typedef std::function<void(BenchState&)> BenchFunction;
+
+// Registriert einen Fall; Namen mit "/" gruppieren wie in Google Benchmark
+void benchRegister(const std::string& name, BenchFunction fn);
+
+// Führt alle (gefilterten) Fälle aus, gibt die Tabelle aus und schreibt
+// optional JSON. Liefert den Exit-Code für main().
+int benchMain(int argc, char** argv);
+
+// Verhindert, dass der Compiler ein Ergebnis als unbenutzt wegoptimiert
+template <class T>
+inline void benchDoNotOptimize(T const& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+#endif // MICROBENCH_H
@@ -0,0 +1,342 @@
+// Spielt ein Farb-Log (.hcol, color_recording.h) in einen Transport ab
+// (Ziel colorplay in CMakeLists.txt)
+//
+//   curl "http://<ip>/api/record?start=1&s=60"      # Aufnahme auf dem Gerät
+//   curl -o farben.hcol "http://<ip>/api/record"    # danach abholen
+//   ./build/colorplay farben.hcol                   # im aufgenommenen Takt, Referenz-Empfänger
+//   ./build/colorplay farben.hcol --fast --loop=100 # Durchsatz des Empfängers
+//   ./build/colorplay farben.hcol --sink=udp --udp=192.168.1.50:8888
+//
+// Jeder Frame wird wie auf dem Gerät kodiert (AmbilightFrameEncoder) und an
+// den gewählten Transport gegeben:
+//   receiver  AmbilightReceiver im selben Prozess; misst das Dekodieren und
+//             vergleicht die Farben mit dem Log (Standard)
+//   udp       Datagramme an einen Leuchter oder die Multicast-Gruppe
+//             (Standard 239.0.0.81:8888 wie UDP_FANOUT in config.h)
+//   null      nur kodieren
+// So lässt sich ein Empfänger (Dekodieren, Interpolation, LED-Ausgabe)
+// ohne Kamera und mit immer denselben Farben messen. Kodieren und Senden
+// laufen wie auf dem Gerät als serialize und transmit über stage_metrics.h.
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ambilight_protocol.h"
+#include "color_recording.h"
+#include "stage_metrics.h"
+
+enum Sink {
+    SINK_RECEIVER,
+    SINK_UDP,
+    SINK_NULL,
+};
+
+struct LogFrame {
+    ColorRecordingFrameHeader header;
+    size_t offset;   // Farben in s_data
+};
+
+static std::vector<uint8_t> s_data;
+static std::vector<LogFrame> s_frames;
+
+// ============================================================================
+// HILFSFUNKTIONEN
+// ============================================================================
+
+static bool loadLog(const char* path) {
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        fprintf(stderr, "[colorplay] %s nicht lesbar\n", path);
+        return false;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    s_data.resize(size > 0 ? size : 0);
+    bool ok = size > 0 && fread(s_data.data(), 1, size, f) == (size_t)size;
+    fclose(f);
+    if (!ok || !colorRecordingParseFileHeader(s_data.data(), s_data.size())) {
+        fprintf(stderr, "[colorplay] %s ist kein Farb-Log\n", path);
+        return false;
+    }
+
+    size_t pos = COLOR_RECORDING_FILE_HEADER;
+    while (pos + COLOR_RECORDING_FRAME_HEADER <= s_data.size()) {
+        LogFrame frame;
+        if (!colorRecordingParseFrameHeader(&s_data[pos], s_data.size() - pos, &frame.header)) {
+            fprintf(stderr, "[colorplay] Ungültiger Frame-Header bei Byte %zu, Rest verworfen\n", pos);
+            break;
+        }
+        frame.offset = pos + COLOR_RECORDING_FRAME_HEADER;
+        if (frame.offset + frame.header.rectCount * 3 > s_data.size()) {
+            break;   // abgeschnittener letzter Frame
+        }
+        s_frames.push_back(frame);
+        pos = frame.offset + frame.header.rectCount * 3;
+    }
+    if (s_frames.empty()) {
+        fprintf(stderr, "[colorplay] %s enthält keine Frames\n", path);
+        return false;
+    }
+    return true;
+}
+
+// ============================================================================
+// TRANSPORTE
+// ============================================================================
+
+class NullTransport : public AmbilightTransport {
+public:
+    bool sendPacket(const uint8_t*, size_t) override {
+        return true;
+    }
+};
+
+// Referenz-Empfänger; ein Frame gilt als angekommen, wenn onPacket() true liefert
+class ReceiverTransport : public AmbilightTransport {
+public:
+    bool sendPacket(const uint8_t* data, size_t len) override {
+        if (m_receiver.onPacket(data, len)) {
+            m_complete = true;
+        }
+        return true;
+    }
+
+    AmbilightReceiver m_receiver;
+    bool m_complete = false;
+};
+
+class UdpTransport : public AmbilightTransport {
+public:
+    bool open(const char* target) {
+        char host[64] = "239.0.0.81";
+        int port = 8888;
+        if (target) {
+            const char* colon = strrchr(target, ':');
+            size_t hostLen = colon ? (size_t)(colon - target) : strlen(target);
+            if (hostLen == 0 || hostLen >= sizeof(host)) {
+                return false;
+            }
+            memcpy(host, target, hostLen);
+            host[hostLen] = '\0';
+            if (colon) {
+                port = atoi(colon + 1);
+            }
+        }
+        memset(&m_addr, 0, sizeof(m_addr));
+        m_addr.sin_family = AF_INET;
+        m_addr.sin_port = htons(port);
+        if (inet_pton(AF_INET, host, &m_addr.sin_addr) != 1) {
+            return false;
+        }
+        m_socket = socket(AF_INET, SOCK_DGRAM, 0);
+        return m_socket >= 0;
+    }
+
+    ~UdpTransport() {
+        if (m_socket >= 0) {
+            close(m_socket);
+        }
+    }
+
+    bool sendPacket(const uint8_t* data, size_t len) override {
+        return sendto(m_socket, data, len, 0, (const sockaddr*)&m_addr, sizeof(m_addr)) == (ssize_t)len;
+    }
+
+private:
+    int m_socket = -1;
+    sockaddr_in m_addr;
+};
+
+static void usage() {
+    fprintf(stderr,
+        "colorplay <farben.hcol> [Optionen]\n"
+        "  --fast              ohne Takt, jeden Frame sofort\n"
+        "  --loop=N            Log N-mal abspielen (Standard 1)\n"
+        "  --sink=receiver|udp|null   Transport (Standard receiver)\n"
+        "  --udp=IP[:PORT]     Ziel für --sink=udp (Standard 239.0.0.81:8888)\n"
+        "  --fec --timing      v2-Pakete mit Parität bzw. Timing-Erweiterung\n"
+        "  --json=DATEI        Zusammenfassung als JSON\n");
+}
+
+// ============================================================================
+// MAIN
+// ============================================================================
+
+int main(int argc, char** argv) {
+    const char* path = nullptr;
+    const char* udpTarget = nullptr;
+    const char* jsonPath = nullptr;
+    Sink sink = SINK_RECEIVER;
+    bool fast = false, fec = false, timing = false;
+    int loops = 1;
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        if (strcmp(arg, "--fast") == 0) {
+            fast = true;
+        } else if (strncmp(arg, "--loop=", 7) == 0) {
+            loops = atoi(arg + 7);
+        } else if (strcmp(arg, "--sink=receiver") == 0) {
+            sink = SINK_RECEIVER;
+        } else if (strcmp(arg, "--sink=udp") == 0) {
+            sink = SINK_UDP;
+        } else if (strcmp(arg, "--sink=null") == 0) {
+            sink = SINK_NULL;
+        } else if (strncmp(arg, "--udp=", 6) == 0) {
+            udpTarget = arg + 6;
+        } else if (strcmp(arg, "--fec") == 0) {
+            fec = true;
+        } else if (strcmp(arg, "--timing") == 0) {
+            timing = true;
+        } else if (strncmp(arg, "--json=", 7) == 0) {
+            jsonPath = arg + 7;
+        } else if (arg[0] != '-' && !path) {
+            path = arg;
+        } else {
+            usage();
+            return 2;
+        }
+    }
+    if (!path || loops < 1) {
+        usage();
+        return 2;
+    }
+    if (!loadLog(path)) {
+        return 1;
+    }
+
+    NullTransport nullTransport;
+    ReceiverTransport receiverTransport;
+    UdpTransport udpTransport;
+    AmbilightTransport* transport = &nullTransport;
+    if (sink == SINK_RECEIVER) {
+        transport = &receiverTransport;
+    } else if (sink == SINK_UDP) {
+        if (!udpTransport.open(udpTarget)) {
+            fprintf(stderr, "[colorplay] Ungültiges UDP-Ziel %s\n", udpTarget ? udpTarget : "");
+            return 2;
+        }
+        transport = &udpTransport;
+    }
+
+    // Takt: Abstände der Capture-Zeitpunkte, ein Durchlauf endet einen
+    // mittleren Frame-Abstand nach dem letzten Frame
+    int64_t firstUs = s_frames.front().header.captureUs;
+    int64_t span = s_frames.back().header.captureUs - firstUs;
+    int64_t periodUs = s_frames.size() > 1 ? span + span / (int64_t)(s_frames.size() - 1) : 100000;
+    // Sequenz läuft über die Durchläufe weiter, sonst verwirft der Empfänger
+    // ab dem zweiten Durchlauf alles als veraltet
+    uint32_t sequenceSpan = s_frames.back().header.sequence - s_frames.front().header.sequence + 1;
+
+    AmbilightFrameEncoder encoder;
+    encoder.setParityEnabled(fec);
+    encoder.setTimingEnabled(timing);
+    RGB scratch[AMBI_MAX_RECTANGLES];
+    int64_t maxLagUs = 0;
+    uint32_t played = 0, packets = 0, sendFailures = 0, mismatches = 0, incomplete = 0, skipped = 0;
+    int64_t start = metricsNowUs();
+
+    for (int loop = 0; loop < loops; loop++) {
+        for (const LogFrame& frame : s_frames) {
+            if (!fast) {
+                int64_t due = start + loop * periodUs + (frame.header.captureUs - firstUs);
+                int64_t now = metricsNowUs();
+                if (due > now) {
+                    std::this_thread::sleep_for(std::chrono::microseconds(due - now));
+                }
+                maxLagUs = std::max(maxLagUs, metricsNowUs() - due);
+            }
+
+            const uint8_t* rgb = &s_data[frame.offset];
+            StageTimer serializeTimer(STAGE_SERIALIZE);
+            AmbilightSides sides = colorRecordingSides(frame.header, rgb, scratch);
+            AmbilightFrameMeta meta = { frame.header.sequence + loop * sequenceSpan,
+                                        (uint32_t)frame.header.captureUs, 0 };
+            int count = encoder.encode(frame.header.hSeg, frame.header.vSeg, sides, &meta);
+            serializeTimer.stop();
+            if (count == 0) {
+                skipped++;   // passt nicht ins Protokoll (z.B. v2 mit Erweiterung)
+                continue;
+            }
+            receiverTransport.m_complete = false;
+            StageTimer transmitTimer(STAGE_TRANSMIT);
+            int sent = encoder.send(*transport);
+            transmitTimer.stop();
+
+            played++;
+            packets += sent;
+            sendFailures += count - sent;
+            if (sink == SINK_RECEIVER) {
+                const AmbilightReceiver& receiver = receiverTransport.m_receiver;
+                if (!receiverTransport.m_complete) {
+                    incomplete++;
+                } else if (receiver.rectCount() != frame.header.rectCount ||
+                           memcmp(receiver.rgb(), rgb, frame.header.rectCount * 3) != 0) {
+                    mismatches++;
+                }
+            }
+        }
+    }
+
+    // ========================================================================
+    // AUSGABE
+    // ========================================================================
+
+    int64_t runUs = metricsNowUs() - start;
+    double framesPerSecond = runUs > 0 ? played * 1e6 / runUs : 0.0;
+    static const char* SINK_NAMES[] = { "receiver", "udp", "null" };
+
+    printf("[colorplay] %s: %u Frames abgespielt (%zu im Log, %d Durchläufe, %s, %s)\n",
+           path, played, s_frames.size(), loops, fast ? "fast" : "Echtzeit", SINK_NAMES[sink]);
+    printf("[colorplay] %.1f Frames/s, %u Pakete, Sendefehler %u, nicht kodierbar %u\n",
+           framesPerSecond, packets, sendFailures, skipped);
+    if (sink == SINK_RECEIVER) {
+        printf("[colorplay] Empfänger: %u unvollständig, %u mit abweichenden Farben\n", incomplete, mismatches);
+    }
+
+    if (!fast) {
+        printf("[colorplay] Verzug gegenüber dem Takt höchstens %lld µs\n", (long long)maxLagUs);
+    }
+
+    // transmit enthält beim Referenz-Empfänger auch dessen Dekodieren
+    const MetricStage stages[] = { STAGE_SERIALIZE, STAGE_TRANSMIT };
+    printf("%-10s %10s %10s %10s %10s %10s\n", "Stufe", "p50 µs", "p95 µs", "p99 µs", "max µs", "Mittel µs");
+    for (MetricStage stage : stages) {
+        StageSummary s = getStageSummary(stage);
+        printf("%-10s %10u %10u %10u %10u %10u\n", s.name, (unsigned)s.p50Us, (unsigned)s.p95Us,
+               (unsigned)s.p99Us, (unsigned)s.maxUs, (unsigned)s.meanUs);
+    }
+
+    if (jsonPath) {
+        FILE* json = fopen(jsonPath, "w");
+        if (!json) {
+            fprintf(stderr, "[colorplay] %s nicht schreibbar\n", jsonPath);
+            return 1;
+        }
+        fprintf(json, "{\n  \"source\": \"%s\",\n  \"pace\": \"%s\",\n  \"sink\": \"%s\",\n",
+                path, fast ? "fast" : "realtime", SINK_NAMES[sink]);
+        fprintf(json, "  \"frames\": %u,\n  \"packets\": %u,\n  \"send_failures\": %u,\n  \"skipped\": %u,\n",
+                played, packets, sendFailures, skipped);
+        fprintf(json, "  \"incomplete\": %u,\n  \"mismatches\": %u,\n", incomplete, mismatches);
+        if (!fast) {
+            fprintf(json, "  \"max_lag_us\": %lld,\n", (long long)maxLagUs);
+        }
+        // Stufen im selben Format wie /api/metrics
+        std::string metrics(formatMetricsJson(nullptr, 0, nullptr, 0) + 1, '\0');
+        formatMetricsJson(&metrics[0], metrics.size(), nullptr, 0);
+        fprintf(json, "  \"frames_per_second\": %.2f,\n  \"metrics\": %s\n}\n", framesPerSecond, metrics.c_str());
+        fclose(json);
+    }
+
+    return played > 0 && incomplete == 0 && mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,38 @@
+#ifndef HOST_ESP_CAMERA_H
+#define HOST_ESP_CAMERA_H
+
+// Host-Ersatz für esp_camera.h aus esp32-camera: nur Frame-Puffer und
+// esp_camera_fb_get()/esp_camera_fb_return(). Die Frames liefert die
+// virtuelle Kamera (virtual_camera.h) aus einer Aufnahme oder JPEG-Dateien.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/time.h>
+
+// Gleiche Reihenfolge wie in sensor.h von esp32-camera
+typedef enum {
+    PIXFORMAT_RGB565,
+    PIXFORMAT_YUV422,
+    PIXFORMAT_YUV420,
+    PIXFORMAT_GRAYSCALE,
+    PIXFORMAT_JPEG,
+    PIXFORMAT_RGB888,
+    PIXFORMAT_RAW,
+    PIXFORMAT_RGB444,
+    PIXFORMAT_RGB555,
+} pixformat_t;
+
+typedef struct {
+    uint8_t* buf;
+    size_t len;
+    size_t width;
+    size_t height;
+    pixformat_t format;
+    struct timeval timestamp;   // Capture-Zeitpunkt, Basis virtualCameraNowUs()
+} camera_fb_t;
+
+// nullptr = Aufnahme zu Ende (oder keine geöffnet)
+camera_fb_t* esp_camera_fb_get();
+void esp_camera_fb_return(camera_fb_t* fb);
+
+#endif // HOST_ESP_CAMERA_H
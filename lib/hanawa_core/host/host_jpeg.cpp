@@ -0,0 +1,58 @@
+#include "host_jpeg.h"
+#include <stdio.h>
+#include <setjmp.h>
+#include <jpeglib.h>
+#include "color_math.h"
+
+struct JpegError {
+    jpeg_error_mgr mgr;
+    jmp_buf jump;
+};
+
+static void onJpegError(j_common_ptr cinfo) {
+    longjmp(((JpegError*)cinfo->err)->jump, 1);
+}
+
+static void onJpegMessage(j_common_ptr) {
+    // Warnungen (z. B. abgeschnittene Daten) nicht auf stderr ausgeben
+}
+
+bool hostDecodeJpeg(const uint8_t* jpeg, size_t len, int scale,
+                    std::vector<uint8_t>& out, int* width, int* height) {
+    jpeg_decompress_struct cinfo;
+    JpegError err;
+    cinfo.err = jpeg_std_error(&err.mgr);
+    err.mgr.error_exit = onJpegError;
+    err.mgr.output_message = onJpegMessage;
+    if (setjmp(err.jump)) {
+        jpeg_destroy_decompress(&cinfo);
+        return false;
+    }
+    jpeg_create_decompress(&cinfo);
+    jpeg_mem_src(&cinfo, jpeg, len);
+    jpeg_read_header(&cinfo, TRUE);
+    cinfo.out_color_space = JCS_RGB;
+    cinfo.scale_num = 1;
+    cinfo.scale_denom = scale;
+    jpeg_start_decompress(&cinfo);
+
+    int w = cinfo.output_width;
+    int h = cinfo.output_height;
+    out.resize((size_t)w * h * 2);
+    std::vector<uint8_t> line((size_t)w * 3);
+    while (cinfo.output_scanline < cinfo.output_height) {
+        uint8_t* row = line.data();
+        uint8_t* dst = out.data() + (size_t)cinfo.output_scanline * w * 2;
+        jpeg_read_scanlines(&cinfo, &row, 1);
+        for (int x = 0; x < w; x++) {
+            uint16_t pixel = rgb565Pack(row[x * 3], row[x * 3 + 1], row[x * 3 + 2]);
+            dst[x * 2] = pixel >> 8;
+            dst[x * 2 + 1] = pixel & 0xFF;
+        }
+    }
+    jpeg_finish_decompress(&cinfo);
+    jpeg_destroy_decompress(&cinfo);
+    *width = w;
+    *height = h;
+    return true;
+}
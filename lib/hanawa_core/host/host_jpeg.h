@@ -0,0 +1,16 @@
+#ifndef HOST_JPEG_H
+#define HOST_JPEG_H
+
+// JPEG → RGB565 auf dem Rechner (libjpeg), Gegenstück zu jpg2rgb565() der
+// Firmware: gleiche Skalierungen 1/2/4/8, High-Byte zuerst. Nur im Host-Build
+// mit HANAWA_HAVE_JPEG (CMakeLists.txt, find_package(JPEG)).
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+// Liefert false bei defektem JPEG; out wird auf width * height * 2 Bytes gebracht
+bool hostDecodeJpeg(const uint8_t* jpeg, size_t len, int scale,
+                    std::vector<uint8_t>& out, int* width, int* height);
+
+#endif // HOST_JPEG_H
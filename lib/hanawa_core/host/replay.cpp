@@ -0,0 +1,323 @@
+// Wiedergabe einer Aufnahme durch die Analyse-Kette auf dem Rechner
+// (Ziel replay in CMakeLists.txt, nur mit libjpeg)
+//
+//   curl -o clip.hrec "http://<ip>:82/record?s=10"
+//   ./build/replay clip.hrec                       # im aufgenommenen Takt
+//   ./build/replay clip.hrec --fast --loop=5       # so schnell wie möglich
+//   ./build/replay bilder/ --fps=15                # Ordner mit JPEGs
+//   ./build/replay clip.hrec --colors=farben.csv --json=lauf.json
+//   ./build/replay clip.hrec --record=farben.hcol  # Farb-Log für colorplay
+//
+// Die Schritte pro Frame entsprechen calculateAmbilightContinuous() in
+// sucher2 (windows.cpp): Frame holen, Plan aus den normierten Ecken
+// (buildSamplingPlan(), neu nur bei anderer Bildgröße), jpg2rgb565 (hier
+// libjpeg) mit der geplanten Skalierung, calculateMeanRGB2, Pakete kodieren
+// und an einen leeren Transport senden. --scale= erzwingt eine Skalierung
+// wie der Autotuner (minSamples 0).
+// Gemessen wird mit stage_metrics.h wie auf dem Gerät (gleiche Stufen,
+// Buckets und Perzentile), die Zahlen lassen sich also direkt neben
+// /api/metrics legen. Gleiche Aufnahme + gleiche Optionen = gleiche
+// Farben, die CSV eignet sich also als Referenz für Änderungen am Kern.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "ambilight_protocol.h"
+#include "color_recording.h"
+#include "color_reduce.h"
+#include "host_jpeg.h"
+#include "stage_metrics.h"
+#include "virtual_camera.h"
+#include "window_geometry.h"
+
+// Wie DECODE_MIN_SAMPLES_DEFAULT und DECODE_MAX_SCALE in sucher2 (windows.h)
+#define REPLAY_MIN_SAMPLES_DEFAULT  64
+#define REPLAY_MAX_SCALE            8
+
+// Lage des Fernsehers in testimage.jpg (80,60 bis 560,420 in 640x480),
+// normiert wie die Kalibrierung der Firmware
+static float s_corners[4][2] = { {0.125f, 0.125f}, {0.875f, 0.125f}, {0.875f, 0.875f}, {0.125f, 0.875f} };
+
+// ============================================================================
+// HILFSFUNKTIONEN
+// ============================================================================
+
+class NullTransport : public AmbilightTransport {
+public:
+    bool sendPacket(const uint8_t*, size_t) override {
+        return true;
+    }
+};
+
+static bool parseCorners(const char* text) {
+    float v[8];
+    if (sscanf(text, "%f,%f,%f,%f,%f,%f,%f,%f", &v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &v[6], &v[7]) != 8) {
+        return false;
+    }
+    for (int i = 0; i < 8; i++) {
+        if (v[i] < 0.0f || v[i] > 1.0f) {
+            return false;
+        }
+    }
+    for (int i = 0; i < 4; i++) {
+        s_corners[i][0] = v[i * 2];
+        s_corners[i][1] = v[i * 2 + 1];
+    }
+    return true;
+}
+
+static void usage() {
+    fprintf(stderr,
+        "replay <aufnahme.hrec|ordner|bild.jpg> [Optionen]\n"
+        "  --fast              ohne Takt, jeden Frame sofort\n"
+        "  --loop=N            Quelle N-mal abspielen (Standard 1)\n"
+        "  --fps=N             Takt für JPEG-Ordner/Einzelbild (Standard 10)\n"
+        "  --min_samples=N     Pixel je Fenster für die Wahl der Skalierung (Standard 64 wie sucher2)\n"
+        "  --scale=N           Dekodier-Skalierung 1/2/4/8 erzwingen (Standard: geplant)\n"
+        "  --windows=HxV       Fenster (Standard 10x8)\n"
+        "  --corners=x,y,...   TV-Ecken oben links, oben rechts, unten rechts, unten links\n"
+        "                      normiert auf 0..1 (Standard: testimage.jpg)\n"
+        "  --fec --timing      v2-Pakete mit Parität bzw. Timing-Erweiterung\n"
+        "  --colors=DATEI|-    Farben je Frame als CSV\n"
+        "  --record=DATEI      Farben als Farb-Log (.hcol) für colorplay\n"
+        "  --json=DATEI        Zusammenfassung als JSON\n");
+}
+
+// ============================================================================
+// MAIN
+// ============================================================================
+
+int main(int argc, char** argv) {
+    const char* source = nullptr;
+    const char* colorsPath = nullptr;
+    const char* jsonPath = nullptr;
+    const char* recordPath = nullptr;
+    VirtualCameraPace pace = VCAM_REALTIME;
+    int loops = 1, fps = 10, scale = 0, minSamples = REPLAY_MIN_SAMPLES_DEFAULT, hSeg = 10, vSeg = 8;
+    bool fec = false, timing = false;
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        if (strcmp(arg, "--fast") == 0) {
+            pace = VCAM_FAST;
+        } else if (strncmp(arg, "--loop=", 7) == 0) {
+            loops = atoi(arg + 7);
+        } else if (strncmp(arg, "--fps=", 6) == 0) {
+            fps = atoi(arg + 6);
+        } else if (strncmp(arg, "--min_samples=", 14) == 0) {
+            minSamples = atoi(arg + 14);
+        } else if (strncmp(arg, "--scale=", 8) == 0) {
+            scale = atoi(arg + 8);
+        } else if (strncmp(arg, "--windows=", 10) == 0) {
+            if (sscanf(arg + 10, "%dx%d", &hSeg, &vSeg) != 2) {
+                usage();
+                return 2;
+            }
+        } else if (strncmp(arg, "--corners=", 10) == 0) {
+            if (!parseCorners(arg + 10)) {
+                usage();
+                return 2;
+            }
+        } else if (strcmp(arg, "--fec") == 0) {
+            fec = true;
+        } else if (strcmp(arg, "--timing") == 0) {
+            timing = true;
+        } else if (strncmp(arg, "--colors=", 9) == 0) {
+            colorsPath = arg + 9;
+        } else if (strncmp(arg, "--record=", 9) == 0) {
+            recordPath = arg + 9;
+        } else if (strncmp(arg, "--json=", 7) == 0) {
+            jsonPath = arg + 7;
+        } else if (arg[0] != '-' && !source) {
+            source = arg;
+        } else {
+            usage();
+            return 2;
+        }
+    }
+    if (!source || (scale != 0 && scale != 1 && scale != 2 && scale != 4 && scale != 8) || minSamples < 0 ||
+        hSeg < 2 || vSeg < 3 || ambilightRectCount(hSeg, vSeg) > AMBI_MAX_RECTANGLES) {
+        usage();
+        return 2;
+    }
+    if (!virtualCameraOpen(source, pace, loops, fps)) {
+        return 1;
+    }
+
+    FILE* colors = nullptr;
+    if (colorsPath) {
+        colors = strcmp(colorsPath, "-") == 0 ? stdout : fopen(colorsPath, "w");
+        if (!colors) {
+            fprintf(stderr, "[replay] %s nicht schreibbar\n", colorsPath);
+            return 1;
+        }
+        fprintf(colors, "frame,capture_us,packets,colors\n");
+    }
+
+    FILE* record = nullptr;
+    if (recordPath) {
+        record = fopen(recordPath, "wb");
+        if (!record) {
+            fprintf(stderr, "[replay] %s nicht schreibbar\n", recordPath);
+            return 1;
+        }
+        uint8_t header[COLOR_RECORDING_FILE_HEADER];
+        fwrite(header, 1, colorRecordingWriteFileHeader(header), record);
+    }
+
+    // Plan und Fenster im dekodierten Bild, neu nur bei anderer Bildgröße
+    SamplingPlan plan;
+    int planWidth = 0, planHeight = 0;
+    std::vector<WindowRect> topRects, bottomRects, leftRects, rightRects;
+    std::vector<RGB> top, bottom, left, right;
+    plan.scale = 0;
+    FILE* out = colors == stdout ? stderr : stdout;
+
+    AmbilightFrameEncoder encoder;
+    encoder.setParityEnabled(fec);
+    encoder.setTimingEnabled(timing);
+    NullTransport transport;
+    std::vector<uint8_t> rgb;
+    int failed = 0;
+    uint32_t sequence = 0;
+    resetStageMetrics();
+    int64_t runStart = virtualCameraNowUs();
+
+    while (true) {
+        int64_t frameStart = metricsNowUs();
+        camera_fb_t* fb = esp_camera_fb_get();
+        if (!fb) {
+            break;
+        }
+        recordStage(STAGE_CAPTURE_WAIT, (uint32_t)(metricsNowUs() - frameStart));
+        int64_t captureUs = (int64_t)fb->timestamp.tv_sec * 1000000LL + fb->timestamp.tv_usec;
+
+        if (planWidth != (int)fb->width || planHeight != (int)fb->height) {
+            StageTimer geometryTimer(STAGE_GEOMETRY);
+            plan = buildSamplingPlan(s_corners, hSeg, vSeg, fb->width, fb->height,
+                                     scale ? 0 : minSamples, scale ? scale : REPLAY_MAX_SCALE);
+            topRects.clear();
+            bottomRects.clear();
+            leftRects.clear();
+            rightRects.clear();
+            calculateAmbilightWindows(plan.topLeft, plan.topRight, plan.botLeft, plan.botRight, hSeg, vSeg,
+                                      topRects, bottomRects, leftRects, rightRects);
+            geometryTimer.stop();
+            planWidth = fb->width;
+            planHeight = fb->height;
+            fprintf(out, "[replay] %dx%d: Dekodier-Skalierung %dx (%dx%d, min. %d Pixel je Fenster)\n",
+                    planWidth, planHeight, plan.scale, plan.width, plan.height, plan.samples);
+        }
+
+        int width = 0, height = 0;
+        StageTimer decodeTimer(STAGE_JPEG_DECODE);
+        bool decoded = hostDecodeJpeg(fb->buf, fb->len, plan.scale, rgb, &width, &height);
+        decodeTimer.stop();
+        if (!decoded) {
+            fprintf(stderr, "[replay] Frame %d: JPEG defekt\n", virtualCameraFrameIndex(fb));
+            failed++;
+            esp_camera_fb_return(fb);
+            continue;
+        }
+
+        StageTimer reductionTimer(STAGE_REDUCTION);
+        top.clear();
+        bottom.clear();
+        left.clear();
+        right.clear();
+        for (const auto& r : topRects) {
+            top.push_back(calculateMeanRGB2(rgb.data(), width, height, r.x1, r.y1, r.x2, r.y2));
+        }
+        for (const auto& r : bottomRects) {
+            bottom.push_back(calculateMeanRGB2(rgb.data(), width, height, r.x1, r.y1, r.x2, r.y2));
+        }
+        for (const auto& r : leftRects) {
+            left.push_back(calculateMeanRGB2(rgb.data(), width, height, r.x1, r.y1, r.x2, r.y2));
+        }
+        for (const auto& r : rightRects) {
+            right.push_back(calculateMeanRGB2(rgb.data(), width, height, r.x1, r.y1, r.x2, r.y2));
+        }
+        reductionTimer.stop();
+
+        AmbilightSides sides = { top.data(), (int)top.size(), right.data(), (int)right.size(),
+                                 bottom.data(), (int)bottom.size(), left.data(), (int)left.size() };
+        AmbilightFrameMeta meta = { ++sequence, (uint32_t)captureUs, 0 };
+        StageTimer serializeTimer(STAGE_SERIALIZE);
+        int packets = encoder.encode(hSeg, vSeg, sides, &meta);
+        serializeTimer.stop();
+        StageTimer transmitTimer(STAGE_TRANSMIT);
+        encoder.send(transport);
+        transmitTimer.stop();
+        recordStage(STAGE_FRAME_TOTAL, (uint32_t)(metricsNowUs() - frameStart));
+
+        if (record) {
+            // Geometrie ändert sich während eines Laufs nicht: geometryId 1
+            uint8_t frame[COLOR_RECORDING_MAX_FRAME];
+            size_t len = colorRecordingWriteFrame(frame, sizeof(frame), sequence, captureUs, 1, hSeg, vSeg, sides);
+            fwrite(frame, 1, len, record);
+        }
+        if (colors) {
+            fprintf(colors, "%d,%lld,%d,", virtualCameraFrameIndex(fb),
+                    (long long)virtualCameraRecordedUs(fb), packets);
+            int total = ambilightRectCount(hSeg, vSeg);
+            for (int k = 0; k < total; k++) {
+                RGB color = ambilightClockwiseColor(sides, k);
+                fprintf(colors, "%02x%02x%02x%s", color.r, color.g, color.b, k + 1 < total ? " " : "\n");
+            }
+        }
+        esp_camera_fb_return(fb);
+    }
+
+    int64_t runUs = virtualCameraNowUs() - runStart;
+    if (colors && colors != stdout) {
+        fclose(colors);
+    }
+    if (record) {
+        fclose(record);
+    }
+
+    // ========================================================================
+    // AUSGABE
+    // ========================================================================
+
+    VirtualCameraStats stats = getVirtualCameraStats();
+    size_t processed = getStageSummary(STAGE_FRAME_TOTAL).count;
+    double framesPerSecond = runUs > 0 ? processed * 1e6 / runUs : 0.0;
+
+    fprintf(out, "[replay] %s: %zu Frames verarbeitet (%u in der Quelle, %d Durchläufe, %s)\n",
+            source, processed, stats.frames, loops, pace == VCAM_FAST ? "fast" : "Echtzeit");
+    fprintf(out, "[replay] %.1f Frames/s, %u übersprungen, %d defekt\n",
+            framesPerSecond, stats.skipped, failed);
+    fprintf(out, "%-14s %10s %10s %10s %10s %10s\n", "Stufe", "p50 µs", "p95 µs", "p99 µs", "max µs", "Mittel µs");
+    for (int i = 0; i < STAGE_COUNT; i++) {
+        StageSummary s = getStageSummary((MetricStage)i);
+        if (s.count > 0) {
+            fprintf(out, "%-14s %10u %10u %10u %10u %10u\n", s.name, (unsigned)s.p50Us,
+                    (unsigned)s.p95Us, (unsigned)s.p99Us, (unsigned)s.maxUs, (unsigned)s.meanUs);
+        }
+    }
+
+    if (jsonPath) {
+        FILE* json = fopen(jsonPath, "w");
+        if (!json) {
+            fprintf(stderr, "[replay] %s nicht schreibbar\n", jsonPath);
+            return 1;
+        }
+        fprintf(json, "{\n  \"source\": \"%s\",\n  \"pace\": \"%s\",\n", source,
+                pace == VCAM_FAST ? "fast" : "realtime");
+        fprintf(json, "  \"scale\": %d,\n  \"scale_forced\": %s,\n  \"min_samples\": %d,\n  \"windows\": \"%dx%d\",\n",
+                plan.scale, scale ? "true" : "false", scale ? 0 : minSamples, hSeg, vSeg);
+        fprintf(json, "  \"frames\": %zu,\n  \"skipped\": %u,\n  \"failed\": %d,\n",
+                processed, stats.skipped, failed);
+        // Stufen im selben Format wie /api/metrics
+        std::string metrics(formatMetricsJson(nullptr, 0, nullptr, 0) + 1, '\0');
+        formatMetricsJson(&metrics[0], metrics.size(), nullptr, 0);
+        fprintf(json, "  \"frames_per_second\": %.2f,\n  \"metrics\": %s\n}\n", framesPerSecond, metrics.c_str());
+        fclose(json);
+    }
+
+    virtualCameraClose();
+    return processed > 0 && failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,802 @@
+// Ereignisgesteuerte Simulation der ganzen Kette auf einer virtuellen Uhr
+// (Ziel system_sim in CMakeLists.txt)
+//
+//   ./build/system_sim                                   # Standardwerte, 30 s
+//   ./build/system_sim --loss=0.05 --burst=3 --fec=1
+//   ./build/system_sim --sweep=period_ms=50,100,200 --sweep=smoothing_ms=0,80 --csv
+//   ./build/system_sim --video=clip.hrec --json=lauf.json    # Aufnahme statt Testbild
+//   ./build/system_sim --help                            # alle Parameter
+//
+// Fernseher → Kamera → Sucher → Funk → Leuchter → LEDs:
+//   - Fernseher: synthetisches Bild (Farbverlauf, Szenenwechsel, Rauschen)
+//     im TV-Takt, oder eine Aufnahme von :82/record bzw. JPEG-Dateien
+//   - Kamera: Bilder im Kamera-Takt, nach cam_latency_ms abholbereit;
+//     acquireFrame() bekommt wie beim Frame-Broker den nächsten neuen Frame
+//   - Sucher: Takt period_ms wie der Analyse-Task, echte Fenster
+//     (calculateAmbilightWindows), Reduktion (calculateMeanRGB2) und Pakete
+//     (AmbilightFrameEncoder). Rechenzeiten sind Parameter (decode_ms,
+//     analysis_ms, Werte aus /api/metrics), nicht die des Rechners.
+//   - Funk: Mindestabstand zwischen Fragmenten wie ESPNOW_PACKET_GAP_US,
+//     Bandbreite, Laufzeit mit Jitter (Umsortieren möglich), Verluste nach
+//     Gilbert-Elliott wie local_test/fec_sim.cpp
+//   - Leuchter: AmbilightReceiver (mit timing=1 Anzeige zum Deadline-
+//     Zeitpunkt), LED-Refresh led_hz mit Glättung smoothing_ms, 8-Bit-Ausgabe
+//
+// Ergebnis: Glass-to-LED-Latenz (Bild auf dem Fernseher bis zur ersten
+// LED-Ausgabe mit diesen Farben; bei Aufnahmen ab dem Capture-Zeitpunkt),
+// Einschwingzeit (bis alle LEDs trotz Glättung am Ziel sind), gezeigte Frames/s, Abstände zwischen Updates, Empfänger-Zähler und
+// Flackern (Richtungswechsel der LED-Helligkeit). Gleicher seed = gleiches
+// Ergebnis, --sweep läuft über alle Kombinationen.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <queue>
+#include <string>
+#include <vector>
+#include "ambilight_protocol.h"
+#include "color_math.h"
+#include "color_reduce.h"
+#include "window_geometry.h"
+
+#ifdef HANAWA_HAVE_JPEG
+#include "host_jpeg.h"
+#include "virtual_camera.h"
+#endif
+
+// Dekodiertes Kamerabild wie im Sucher (640x480, JPG_SCALE_2X)
+#define SIM_WIDTH   320
+#define SIM_HEIGHT  240
+
+// TV-Ecken im dekodierten Bild (testimage.jpg: 80,60 bis 560,420 in VGA)
+static const float TV_CORNERS[4][2] = { {40, 30}, {280, 30}, {280, 210}, {40, 210} };
+
+// ============================================================================
+// PARAMETER
+// ============================================================================
+
+enum ParamId {
+    P_DURATION_S, P_SEED,
+    P_TV_HZ, P_CUT_S, P_NOISE,
+    P_CAM_FPS, P_CAM_LATENCY_MS,
+    P_PERIOD_MS, P_DECODE_MS, P_ANALYSIS_MS, P_WINDOWS_H, P_WINDOWS_V, P_FEC, P_TIMING, P_DEADLINE_MS,
+    P_GAP_US, P_BANDWIDTH_KBPS, P_LATENCY_MS, P_JITTER_MS, P_LOSS, P_BURST,
+    P_LED_HZ, P_SMOOTHING_MS, P_ABORT_MS, P_FLICKER_STEP,
+    P_COUNT
+};
+
+struct Param {
+    const char* name;
+    double value;
+    const char* help;
+};
+
+static Param s_defaults[P_COUNT] = {
+    { "duration_s",     30,    "simulierte Dauer" },
+    { "seed",           1,     "Zufallsfolge (Rauschen, Szenen, Funk)" },
+    { "tv_hz",          60,    "Bildwechsel des Fernsehers" },
+    { "cut_s",          2,     "Szenenwechsel alle n Sekunden (0 = keine)" },
+    { "noise",          4,     "Sensorrauschen, Amplitude je Farbkanal" },
+    { "cam_fps",        25,    "Kamera-Takt (ohne --video)" },
+    { "cam_latency_ms", 40,    "Belichtung bis Frame abholbereit" },
+    { "period_ms",      100,   "Takt des Analyse-Tasks (ANALYSIS_PERIOD_MS)" },
+    { "decode_ms",      22,    "jpg2rgb565 auf dem ESP32" },
+    { "analysis_ms",    6,     "Fenster, Reduktion und Kodieren auf dem ESP32" },
+    { "windows_h",      10,    "Fenster oben/unten" },
+    { "windows_v",      8,     "Fenster links/rechts inkl. Ecken" },
+    { "fec",            0,     "XOR-Parität (ESPNOW_FEC_PARITY)" },
+    { "timing",         0,     "Timing-Erweiterung, Anzeige zur Deadline (ESPNOW_TIMING)" },
+    { "deadline_ms",    150,   "Anzeigezeitpunkt nach Capture (ESPNOW_DEADLINE_MS)" },
+    { "gap_us",         1500,  "Mindestabstand der Fragmente (ESPNOW_PACKET_GAP_US)" },
+    { "bandwidth_kbps", 1000,  "Nutzdatenrate des Funks" },
+    { "latency_ms",     2,     "feste Laufzeit je Paket" },
+    { "jitter_ms",      1,     "zusätzliche Laufzeit, exponentiell mit diesem Mittel" },
+    { "loss",           0,     "Paketverlust 0..1" },
+    { "burst",          1,     "mittlere Länge von Verlust-Bursts (1 = unabhängig)" },
+    { "led_hz",         60,    "LED-Refresh des Leuchters" },
+    { "smoothing_ms",   0,     "Glättung der LEDs (Zeitkonstante, 0 = aus)" },
+    { "abort_ms",       200,   "unvollständigen Frame nach dieser Pause verwerfen" },
+    { "flicker_step",   6,     "kleinster Helligkeitsschritt, der als Flackern zählt" },
+};
+
+// ============================================================================
+// ZUFALL
+// ============================================================================
+
+// xorshift32 wie fec_sim, Zustand pro Lauf
+struct Random {
+    uint32_t state;
+
+    explicit Random(uint32_t seed) : state(seed ? seed : 1) {}
+
+    double next() {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return (state & 0xFFFFFF) / (double)0x1000000;
+    }
+};
+
+// ============================================================================
+// QUELLEN
+// ============================================================================
+
+// Bild auf dem Fernseher zum Zeitpunkt t: Farbverlauf, der langsam wandert,
+// Szenenwechsel mit neuer Grundfarbe und Helligkeit
+static void tvColor(double u, double v, int64_t glassUs, const Param* p, uint8_t* r, uint8_t* g, uint8_t* b) {
+    double t = glassUs / 1e6;
+    int scene = p[P_CUT_S].value > 0 ? (int)(t / p[P_CUT_S].value) : 0;
+    uint32_t h = (uint32_t)scene * 2654435761u + (uint32_t)p[P_SEED].value;
+    double base = (h % 360) / 360.0;
+    double level = 0.35 + 0.65 * ((h >> 9) % 100) / 100.0;
+
+    double hue = fmod(base + 0.3 * u + 0.15 * v + t * 0.05, 1.0) * 6.0;
+    int sector = (int)hue;
+    double f = hue - sector;
+    double c[3];
+    switch (sector) {
+        case 0:  c[0] = 1;     c[1] = f;     c[2] = 0;     break;
+        case 1:  c[0] = 1 - f; c[1] = 1;     c[2] = 0;     break;
+        case 2:  c[0] = 0;     c[1] = 1;     c[2] = f;     break;
+        case 3:  c[0] = 0;     c[1] = 1 - f; c[2] = 1;     break;
+        case 4:  c[0] = f;     c[1] = 0;     c[2] = 1;     break;
+        default: c[0] = 1;     c[1] = 0;     c[2] = 1 - f; break;
+    }
+    *r = (uint8_t)(255 * level * c[0]);
+    *g = (uint8_t)(255 * level * c[1]);
+    *b = (uint8_t)(255 * level * c[2]);
+}
+
+// Kamerabild (RGB565, High-Byte zuerst wie jpg2rgb565) des Fernsehers zum
+// Zeitpunkt glassUs, TV im Rechteck von TV_CORNERS, drumherum dunkel
+static void renderSynthetic(int64_t glassUs, const Param* p, Random& rng, std::vector<uint8_t>& out) {
+    out.resize(SIM_WIDTH * SIM_HEIGHT * 2);
+    int x0 = (int)TV_CORNERS[0][0], y0 = (int)TV_CORNERS[0][1];
+    int x1 = (int)TV_CORNERS[2][0], y1 = (int)TV_CORNERS[2][1];
+    int noise = (int)p[P_NOISE].value;
+    for (int y = 0; y < SIM_HEIGHT; y++) {
+        for (int x = 0; x < SIM_WIDTH; x++) {
+            uint8_t c[3] = { 12, 12, 14 };
+            if (x >= x0 && x < x1 && y >= y0 && y < y1) {
+                tvColor((x - x0) / (double)(x1 - x0), (y - y0) / (double)(y1 - y0), glassUs, p, &c[0], &c[1], &c[2]);
+            }
+            if (noise > 0) {
+                for (int k = 0; k < 3; k++) {
+                    int n = c[k] + (int)((rng.next() * 2 - 1) * noise);
+                    c[k] = (uint8_t)(n < 0 ? 0 : n > 255 ? 255 : n);
+                }
+            }
+            uint16_t pixel = rgb565Pack(c[0], c[1], c[2]);
+            out[(y * SIM_WIDTH + x) * 2] = pixel >> 8;
+            out[(y * SIM_WIDTH + x) * 2 + 1] = pixel & 0xFF;
+        }
+    }
+}
+
+struct VideoFrame {
+    std::vector<uint8_t> jpeg;
+    int64_t offsetUs;   // relativ zum ersten Frame
+};
+
+static std::vector<VideoFrame> s_video;
+static int64_t s_videoPeriodUs = 0;
+
+#ifdef HANAWA_HAVE_JPEG
+// Lädt die Quelle einmal über die virtuelle Kamera (ohne Takt)
+static bool loadVideo(const char* path) {
+    if (!virtualCameraOpen(path, VCAM_FAST)) {
+        return false;
+    }
+    int64_t first = 0;
+    while (camera_fb_t* fb = esp_camera_fb_get()) {
+        VideoFrame frame;
+        frame.jpeg.assign(fb->buf, fb->buf + fb->len);
+        if (s_video.empty()) {
+            first = virtualCameraRecordedUs(fb);
+        }
+        frame.offsetUs = virtualCameraRecordedUs(fb) - first;
+        s_video.push_back(std::move(frame));
+        esp_camera_fb_return(fb);
+    }
+    s_videoPeriodUs = getVirtualCameraStats().durationUs;
+    virtualCameraClose();
+    return !s_video.empty();
+}
+#endif
+
+// ============================================================================
+// SIMULATION
+// ============================================================================
+
+// Kennzahlen einer simulierten Messreihe in µs, exakt aus allen Werten.
+// Simulierte Zeiten sind keine Messungen auf dem Gerät und laufen deshalb
+// nicht über stage_metrics.h (jeder Lauf eines Sweeps zählt für sich).
+struct LatencySummary {
+    int64_t p50, p95, max;
+    double mean;
+};
+
+static LatencySummary summarizeLatency(std::vector<int64_t> values) {
+    LatencySummary s = { 0, 0, 0, 0.0 };
+    if (values.empty()) {
+        return s;
+    }
+    std::sort(values.begin(), values.end());
+    double sum = 0;
+    for (int64_t v : values) {
+        sum += v;
+    }
+    s.p50 = values[(values.size() - 1) * 50 / 100];
+    s.p95 = values[(values.size() - 1) * 95 / 100];
+    s.max = values.back();
+    s.mean = sum / values.size();
+    return s;
+}
+
+enum EventType {
+    EV_ANALYSIS_TICK,    // Analyse-Task wacht auf und wartet auf einen Frame
+    EV_ANALYSIS_DONE,    // Farben berechnet, Pakete gehen raus
+    EV_PACKET_ARRIVE,    // Paket beim Leuchter
+    EV_PRESENT,          // Frame wird Ziel der LEDs (sofort oder zur Deadline)
+    EV_LED_REFRESH,
+};
+
+struct Event {
+    int64_t t;
+    uint64_t order;      // gleiche Zeit: Reihenfolge des Einplanens
+    EventType type;
+    int index;           // Paket bzw. Frame
+
+    bool operator>(const Event& other) const {
+        return t != other.t ? t > other.t : order > other.order;
+    }
+};
+
+struct InFlight {
+    std::vector<uint8_t> data;
+    int frame;           // Sucher-Frame, zu dem das Paket gehört
+};
+
+struct SentFrame {
+    int64_t glassUs;     // Bild auf dem Fernseher
+    std::vector<uint8_t> rgb;   // Farben im Uhrzeigersinn, erst beim Leuchter gefüllt
+    bool shown;
+};
+
+struct SimResult {
+    LatencySummary glassToLed;       // µs
+    LatencySummary settle;           // µs bis alle LEDs am Ziel sind (Glättung)
+    uint32_t framesSettled;
+    LatencySummary updateInterval;   // µs zwischen zwei neuen Zielen an den LEDs
+    double framesPerSecond;          // gezeigte Frames
+    uint32_t framesAnalysed;
+    uint32_t framesShown;
+    AmbilightReceiverStats receiver;
+    uint32_t packetsSent;
+    uint32_t packetsLost;
+    uint32_t overruns;               // Analyse länger als period_ms
+    double flickerPerLedS;           // Richtungswechsel je LED und Sekunde
+    double meanStep;                 // mittlere Helligkeitsänderung je LED und Refresh
+};
+
+class Simulation {
+public:
+    explicit Simulation(const Param* p) : m_p(p), m_rng((uint32_t)p[P_SEED].value), m_order(0) {}
+
+    SimResult run();
+
+private:
+    double p(ParamId id) const { return m_p[id].value; }
+
+    void schedule(int64_t t, EventType type, int index = 0) {
+        m_queue.push(Event{ t, m_order++, type, index });
+    }
+
+    bool nextCameraFrame(int64_t now, int64_t* captureUs, int64_t* readyUs, int* videoIndex);
+    void analyse(int64_t now);
+    void transmit(int64_t now, int frame);
+    void arrive(int64_t now, int packet);
+    void refresh(int64_t now);
+
+    const Param* m_p;
+    Random m_rng;
+    uint64_t m_order;
+    std::priority_queue<Event, std::vector<Event>, std::greater<Event>> m_queue;
+
+    // Sucher
+    std::vector<WindowRect> m_top, m_bottom, m_left, m_right;
+    std::vector<uint8_t> m_image;
+    AmbilightFrameEncoder m_encoder;
+    std::vector<SentFrame> m_frames;
+    int64_t m_lastCaptureUs = -1;
+    int64_t m_nextTickUs = 0;
+    int64_t m_linkFreeUs = 0;
+    int64_t m_lastSendUs = -1000000;
+    uint32_t m_overruns = 0;
+    bool m_bad = false;               // Gilbert-Elliott-Zustand
+
+    // Funk
+    std::vector<InFlight> m_packets;
+    uint32_t m_packetsSent = 0;
+    uint32_t m_packetsLost = 0;
+
+    // Leuchter
+    AmbilightReceiver m_receiver;
+    int64_t m_lastArrivalUs = 0;
+    std::vector<uint8_t> m_target;
+    int m_targetFrame = -1;
+    int m_shownFrame = -1;
+    std::vector<double> m_led;
+    std::vector<int> m_ledOut;
+    std::vector<int> m_lastSign;
+    std::vector<int64_t> m_lastSignUs;
+    std::vector<int64_t> m_glassToLed;
+    std::vector<int64_t> m_settle;
+    bool m_settling = false;
+    std::vector<int64_t> m_intervals;
+    int64_t m_lastUpdateUs = -1;
+    uint64_t m_reversals = 0;
+    double m_stepSum = 0;
+    uint64_t m_stepCount = 0;
+};
+
+// Nächster Frame, der nach now abholbereit wird (acquireFrame wartet auf einen neuen)
+bool Simulation::nextCameraFrame(int64_t now, int64_t* captureUs, int64_t* readyUs, int* videoIndex) {
+    int64_t latency = (int64_t)(p(P_CAM_LATENCY_MS) * 1000);
+    if (s_video.empty()) {
+        int64_t interval = (int64_t)(1e6 / p(P_CAM_FPS));
+        int64_t k = std::max<int64_t>(0, (now - latency + interval - 1) / interval);
+        *captureUs = k * interval;
+        while (*captureUs <= m_lastCaptureUs) {
+            *captureUs += interval;
+        }
+        *videoIndex = -1;
+    } else {
+        // Aufnahme in Schleife, Zeitstempel wie aufgenommen
+        int64_t loop = std::max<int64_t>(0, (now - latency) / s_videoPeriodUs);
+        for (;; loop++) {
+            for (size_t i = 0; i < s_video.size(); i++) {
+                int64_t t = loop * s_videoPeriodUs + s_video[i].offsetUs;
+                if (t + latency >= now && t > m_lastCaptureUs) {
+                    *captureUs = t;
+                    *videoIndex = (int)i;
+                    *readyUs = t + latency;
+                    return true;
+                }
+            }
+        }
+    }
+    *readyUs = *captureUs + latency;
+    return true;
+}
+
+void Simulation::analyse(int64_t tick) {
+    int64_t captureUs, readyUs;
+    int videoIndex;
+    nextCameraFrame(tick, &captureUs, &readyUs, &videoIndex);
+    m_lastCaptureUs = captureUs;
+
+    // Bild wie im Sucher: dekodiert in halber Auflösung
+    int width = SIM_WIDTH, height = SIM_HEIGHT;
+    if (videoIndex < 0) {
+        // Fernseher zeigt das Bild des letzten TV-Takts vor dem Capture
+        int64_t tvInterval = (int64_t)(1e6 / p(P_TV_HZ));
+        int64_t glass = captureUs / tvInterval * tvInterval;
+        renderSynthetic(glass, m_p, m_rng, m_image);
+        m_frames.push_back(SentFrame{ glass, {}, false });
+    } else {
+#ifdef HANAWA_HAVE_JPEG
+        const VideoFrame& frame = s_video[videoIndex];
+        hostDecodeJpeg(frame.jpeg.data(), frame.jpeg.size(), 2, m_image, &width, &height);
+#endif
+        m_frames.push_back(SentFrame{ captureUs, {}, false });
+    }
+
+    if (m_top.empty()) {
+        calculateAmbilightWindows(TV_CORNERS[0], TV_CORNERS[1], TV_CORNERS[3], TV_CORNERS[2],
+                                  (int)p(P_WINDOWS_H), (int)p(P_WINDOWS_V), m_top, m_bottom, m_left, m_right);
+    }
+    std::vector<RGB> top, bottom, left, right;
+    for (const auto& r : m_top) {
+        top.push_back(calculateMeanRGB2(m_image.data(), width, height, r.x1, r.y1, r.x2, r.y2));
+    }
+    for (const auto& r : m_bottom) {
+        bottom.push_back(calculateMeanRGB2(m_image.data(), width, height, r.x1, r.y1, r.x2, r.y2));
+    }
+    for (const auto& r : m_left) {
+        left.push_back(calculateMeanRGB2(m_image.data(), width, height, r.x1, r.y1, r.x2, r.y2));
+    }
+    for (const auto& r : m_right) {
+        right.push_back(calculateMeanRGB2(m_image.data(), width, height, r.x1, r.y1, r.x2, r.y2));
+    }
+    AmbilightSides sides = { top.data(), (int)top.size(), right.data(), (int)right.size(),
+                             bottom.data(), (int)bottom.size(), left.data(), (int)left.size() };
+    int frame = (int)m_frames.size() - 1;
+    AmbilightFrameMeta meta = { (uint32_t)frame + 1, (uint32_t)captureUs, (uint16_t)p(P_DEADLINE_MS) };
+    m_encoder.encode((int)p(P_WINDOWS_H), (int)p(P_WINDOWS_V), sides, &meta);
+
+    // Rechenzeit des ESP32, danach senden
+    int64_t doneUs = std::max(tick, readyUs) + (int64_t)((p(P_DECODE_MS) + p(P_ANALYSIS_MS)) * 1000);
+    schedule(doneUs, EV_ANALYSIS_DONE, frame);
+
+    // vTaskDelayUntil: fester Takt, bei Überlauf sofort weiter
+    int64_t period = (int64_t)(p(P_PERIOD_MS) * 1000);
+    m_nextTickUs = tick + period;
+    if (doneUs > m_nextTickUs) {
+        m_overruns++;
+        m_nextTickUs = doneUs;
+    }
+    schedule(m_nextTickUs, EV_ANALYSIS_TICK);
+}
+
+void Simulation::transmit(int64_t now, int frame) {
+    double loss = p(P_LOSS);
+    double burst = p(P_BURST);
+    double pBadToGood = burst > 1.0 ? 1.0 / burst : 1.0;
+    double pGoodToBad = loss >= 1.0 ? 1.0 : loss * pBadToGood / (1.0 - loss);
+
+    for (int i = 0; i < m_encoder.packetCount(); i++) {
+        // Pacing wie EspNowTransport::waitBetweenPackets(), dann Sendezeit
+        int64_t start = std::max({ now, m_linkFreeUs, m_lastSendUs + (int64_t)p(P_GAP_US) });
+        int64_t airtime = (int64_t)(m_encoder.packetLength(i) * 8 * 1000 / p(P_BANDWIDTH_KBPS));
+        m_lastSendUs = start;
+        m_linkFreeUs = start + airtime;
+        m_packetsSent++;
+
+        if (burst > 1.0) {
+            m_bad = m_bad ? (m_rng.next() >= pBadToGood) : (m_rng.next() < pGoodToBad);
+        } else {
+            m_bad = m_rng.next() < loss;
+        }
+        if (m_bad) {
+            m_packetsLost++;
+            continue;
+        }
+        double jitter = p(P_JITTER_MS) > 0 ? -log(1.0 - m_rng.next()) * p(P_JITTER_MS) : 0.0;
+        int64_t arrival = m_linkFreeUs + (int64_t)((p(P_LATENCY_MS) + jitter) * 1000);
+        const uint8_t* data = m_encoder.packet(i);
+        m_packets.push_back(InFlight{ std::vector<uint8_t>(data, data + m_encoder.packetLength(i)), frame });
+        schedule(arrival, EV_PACKET_ARRIVE, (int)m_packets.size() - 1);
+    }
+}
+
+void Simulation::arrive(int64_t now, int packet) {
+    // Pause zu lang: der Leuchter verwirft den angefangenen Frame
+    if (now - m_lastArrivalUs > (int64_t)(p(P_ABORT_MS) * 1000)) {
+        m_receiver.abortFrame();
+    }
+    m_lastArrivalUs = now;
+
+    InFlight& in = m_packets[packet];
+    if (!m_receiver.onPacket(in.data.data(), in.data.size(), (uint32_t)now)) {
+        in.data.clear();
+        in.data.shrink_to_fit();
+        return;
+    }
+    SentFrame& frame = m_frames[in.frame];
+    frame.rgb.assign(m_receiver.rgb(), m_receiver.rgb() + m_receiver.rectCount() * 3);
+    uint32_t presentUs;
+    int64_t at = now;
+    if (m_receiver.presentAtUs(&presentUs) && (int64_t)presentUs > now) {
+        at = presentUs;
+    }
+    schedule(at, EV_PRESENT, in.frame);
+    in.data.clear();
+    in.data.shrink_to_fit();
+}
+
+void Simulation::refresh(int64_t now) {
+    double dt = 1e6 / p(P_LED_HZ);
+    double alpha = p(P_SMOOTHING_MS) > 0 ? 1.0 - exp(-dt / (p(P_SMOOTHING_MS) * 1000)) : 1.0;
+    if (m_target.empty()) {
+        return;
+    }
+    if (m_led.size() != m_target.size()) {
+        m_led.assign(m_target.begin(), m_target.end());
+        m_ledOut.assign(m_target.size() / 3, 0);
+        m_lastSign.assign(m_target.size() / 3, 0);
+        m_lastSignUs.assign(m_target.size() / 3, 0);
+    }
+
+    // Erste Ausgabe mit den Farben eines neuen Frames
+    if (m_targetFrame != m_shownFrame) {
+        m_shownFrame = m_targetFrame;
+        m_glassToLed.push_back(now - m_frames[m_targetFrame].glassUs);
+        if (m_lastUpdateUs >= 0) {
+            m_intervals.push_back(now - m_lastUpdateUs);
+        }
+        m_lastUpdateUs = now;
+        m_settling = true;
+    }
+
+    double threshold = p(P_FLICKER_STEP);
+    bool settled = true;
+    for (size_t i = 0; i < m_led.size(); i++) {
+        m_led[i] += alpha * (m_target[i] - m_led[i]);
+        settled = settled && fabs(m_target[i] - m_led[i]) < threshold;
+    }
+    // Eingeschwungen: alle LEDs nahe am Ziel, bevor der nächste Frame kommt
+    if (m_settling && settled) {
+        m_settle.push_back(now - m_frames[m_targetFrame].glassUs);
+        m_settling = false;
+    }
+    for (size_t led = 0; led < m_ledOut.size(); led++) {
+        RGB c = { (uint8_t)lround(m_led[led * 3]), (uint8_t)lround(m_led[led * 3 + 1]), (uint8_t)lround(m_led[led * 3 + 2]) };
+        int luminance = rgbLuminance(c);
+        int step = luminance - m_ledOut[led];
+        m_ledOut[led] = luminance;
+        m_stepSum += abs(step);
+        m_stepCount++;
+        // Flackern: Helligkeit springt kurz hintereinander hin und her
+        if (abs(step) >= threshold) {
+            int sign = step > 0 ? 1 : -1;
+            if (m_lastSign[led] == -sign && now - m_lastSignUs[led] <= 250000) {
+                m_reversals++;
+            }
+            m_lastSign[led] = sign;
+            m_lastSignUs[led] = now;
+        }
+    }
+}
+
+SimResult Simulation::run() {
+    m_encoder.setParityEnabled(p(P_FEC) != 0);
+    m_encoder.setTimingEnabled(p(P_TIMING) != 0);
+    if (p(P_TIMING) != 0) {
+        m_receiver.setClockOffset(0);   // gemeinsame Uhr, wie nach der Uhrensynchronisation
+    }
+
+    int64_t endUs = (int64_t)(p(P_DURATION_S) * 1e6);
+    schedule(0, EV_ANALYSIS_TICK);
+    schedule(0, EV_LED_REFRESH);
+    int64_t ledInterval = (int64_t)(1e6 / p(P_LED_HZ));
+
+    while (!m_queue.empty()) {
+        Event ev = m_queue.top();
+        m_queue.pop();
+        if (ev.t > endUs) {
+            break;
+        }
+        switch (ev.type) {
+            case EV_ANALYSIS_TICK:
+                analyse(ev.t);
+                break;
+            case EV_ANALYSIS_DONE:
+                transmit(ev.t, ev.index);
+                break;
+            case EV_PACKET_ARRIVE:
+                arrive(ev.t, ev.index);
+                break;
+            case EV_PRESENT:
+                // Ältere Frames, die nach einem neueren fertig werden, nicht zeigen
+                if (ev.index > m_targetFrame) {
+                    m_targetFrame = ev.index;
+                    m_target = m_frames[ev.index].rgb;
+                }
+                break;
+            case EV_LED_REFRESH:
+                refresh(ev.t);
+                schedule(ev.t + ledInterval, EV_LED_REFRESH);
+                break;
+        }
+    }
+
+    SimResult r;
+    r.glassToLed = summarizeLatency(m_glassToLed);
+    r.settle = summarizeLatency(m_settle);
+    r.framesSettled = (uint32_t)m_settle.size();
+    r.updateInterval = summarizeLatency(m_intervals);
+    r.framesAnalysed = (uint32_t)m_frames.size();
+    r.framesShown = (uint32_t)m_glassToLed.size();
+    r.framesPerSecond = r.framesShown / p(P_DURATION_S);
+    r.receiver = m_receiver.stats();
+    r.packetsSent = m_packetsSent;
+    r.packetsLost = m_packetsLost;
+    r.overruns = m_overruns;
+    double ledSeconds = m_ledOut.size() * p(P_DURATION_S);
+    r.flickerPerLedS = ledSeconds > 0 ? m_reversals / ledSeconds : 0.0;
+    r.meanStep = m_stepCount ? m_stepSum / m_stepCount : 0.0;
+    return r;
+}
+
+// ============================================================================
+// AUSGABE
+// ============================================================================
+
+struct Sweep {
+    int param;
+    std::vector<double> values;
+};
+
+static int findParam(const std::string& name) {
+    for (int i = 0; i < P_COUNT; i++) {
+        if (name == s_defaults[i].name) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void usage() {
+    fprintf(stderr,
+        "system_sim [--name=wert ...] [--sweep=name=a,b,c ...] [--csv] [--json=DATEI]"
+#ifdef HANAWA_HAVE_JPEG
+        " [--video=AUFNAHME]"
+#endif
+        "\n\nParameter (Standardwert):\n");
+    for (int i = 0; i < P_COUNT; i++) {
+        fprintf(stderr, "  --%-16s %8g  %s\n", s_defaults[i].name, s_defaults[i].value, s_defaults[i].help);
+    }
+}
+
+static const char* COLUMNS =
+    "g2l_p50_ms,g2l_p95_ms,g2l_max_ms,g2l_mean_ms,settle_p50_ms,settle_p95_ms,settled,fps,interval_p95_ms,analysed,shown,complete,recovered,dropped,late,"
+    "packets,lost,overruns,flicker,step";
+
+static std::string formatResult(const SimResult& r, const char* sep) {
+    char line[512];
+    snprintf(line, sizeof(line),
+             "%.1f%s%.1f%s%.1f%s%.1f%s%.1f%s%.1f%s%u%s%.2f%s%.1f%s%u%s%u%s%u%s%u%s%u%s%u%s%u%s%u%s%u%s%.3f%s%.2f",
+             r.glassToLed.p50 / 1000.0, sep, r.glassToLed.p95 / 1000.0, sep, r.glassToLed.max / 1000.0, sep,
+             r.glassToLed.mean / 1000.0, sep, r.settle.p50 / 1000.0, sep, r.settle.p95 / 1000.0, sep, r.framesSettled, sep,
+             r.framesPerSecond, sep, r.updateInterval.p95 / 1000.0, sep,
+             r.framesAnalysed, sep, r.framesShown, sep, r.receiver.framesComplete, sep,
+             r.receiver.framesRecovered, sep, r.receiver.framesDropped, sep, r.receiver.framesLate, sep,
+             r.packetsSent, sep, r.packetsLost, sep, r.overruns, sep, r.flickerPerLedS, sep, r.meanStep);
+    return line;
+}
+
+int main(int argc, char** argv) {
+    Param params[P_COUNT];
+    memcpy(params, s_defaults, sizeof(params));
+    std::vector<Sweep> sweeps;
+    bool csv = false;
+    const char* jsonPath = nullptr;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            usage();
+            return 0;
+        } else if (arg == "--csv") {
+            csv = true;
+        } else if (arg.compare(0, 7, "--json=") == 0) {
+            jsonPath = argv[i] + 7;
+        } else if (arg.compare(0, 8, "--video=") == 0) {
+#ifdef HANAWA_HAVE_JPEG
+            if (!loadVideo(argv[i] + 8)) {
+                return 1;
+            }
+#else
+            fprintf(stderr, "[sim] --video braucht libjpeg\n");
+            return 2;
+#endif
+        } else if (arg.compare(0, 8, "--sweep=") == 0) {
+            size_t eq = arg.find('=', 8);
+            int param = eq == std::string::npos ? -1 : findParam(arg.substr(8, eq - 8));
+            if (param < 0) {
+                usage();
+                return 2;
+            }
+            Sweep sweep = { param, {} };
+            std::string list = arg.substr(eq + 1);
+            for (size_t pos = 0; pos <= list.size();) {
+                size_t comma = list.find(',', pos);
+                if (comma == std::string::npos) {
+                    comma = list.size();
+                }
+                sweep.values.push_back(atof(list.substr(pos, comma - pos).c_str()));
+                pos = comma + 1;
+            }
+            sweeps.push_back(sweep);
+        } else if (arg.compare(0, 2, "--") == 0 && arg.find('=') != std::string::npos) {
+            int param = findParam(arg.substr(2, arg.find('=') - 2));
+            if (param < 0) {
+                usage();
+                return 2;
+            }
+            params[param].value = atof(arg.c_str() + arg.find('=') + 1);
+        } else {
+            usage();
+            return 2;
+        }
+    }
+
+    // Alle Kombinationen der Sweeps, der erste ändert sich am langsamsten
+    size_t runs = 1;
+    for (const Sweep& sweep : sweeps) {
+        runs *= sweep.values.size();
+    }
+
+    std::string header;
+    for (const Sweep& sweep : sweeps) {
+        header += std::string(s_defaults[sweep.param].name) + ",";
+    }
+    header += COLUMNS;
+    if (csv) {
+        printf("%s\n", header.c_str());
+    }
+
+    FILE* json = nullptr;
+    if (jsonPath) {
+        json = fopen(jsonPath, "w");
+        if (!json) {
+            fprintf(stderr, "[sim] %s nicht schreibbar\n", jsonPath);
+            return 1;
+        }
+        fprintf(json, "[\n");
+    }
+
+    for (size_t run = 0; run < runs; run++) {
+        size_t rest = run;
+        std::string swept;
+        for (size_t s = sweeps.size(); s-- > 0;) {
+            const Sweep& sweep = sweeps[s];
+            params[sweep.param].value = sweep.values[rest % sweep.values.size()];
+            rest /= sweep.values.size();
+        }
+        for (const Sweep& sweep : sweeps) {
+            char value[32];
+            snprintf(value, sizeof(value), "%g,", params[sweep.param].value);
+            swept += value;
+        }
+        if (params[P_WINDOWS_H].value < 2 || params[P_WINDOWS_V].value < 3 ||
+            ambilightRectCount((int)params[P_WINDOWS_H].value, (int)params[P_WINDOWS_V].value) > AMBI_MAX_RECTANGLES ||
+            params[P_CAM_FPS].value <= 0 || params[P_TV_HZ].value <= 0 || params[P_LED_HZ].value <= 0 ||
+            params[P_PERIOD_MS].value <= 0 || params[P_BANDWIDTH_KBPS].value <= 0 || params[P_DURATION_S].value <= 0) {
+            fprintf(stderr, "[sim] Ungültige Parameter in Lauf %zu\n", run + 1);
+            return 2;
+        }
+
+        Simulation sim(params);
+        SimResult r = sim.run();
+
+        if (csv) {
+            printf("%s%s\n", swept.c_str(), formatResult(r, ",").c_str());
+        } else {
+            if (!swept.empty()) {
+                swept.pop_back();
+                printf("[sim] %s\n", swept.c_str());
+            }
+            printf("  Glass-to-LED   p50 %.1f ms, p95 %.1f ms, max %.1f ms, Mittel %.1f ms\n",
+                   r.glassToLed.p50 / 1000.0, r.glassToLed.p95 / 1000.0, r.glassToLed.max / 1000.0, r.glassToLed.mean / 1000.0);
+            printf("  Eingeschwungen p50 %.1f ms, p95 %.1f ms (%u von %u Frames)\n",
+                   r.settle.p50 / 1000.0, r.settle.p95 / 1000.0, r.framesSettled, r.framesShown);
+            printf("  Frames         %u analysiert, %u gezeigt (%.2f/s), Abstand p95 %.1f ms, Überläufe %u\n",
+                   r.framesAnalysed, r.framesShown, r.framesPerSecond, r.updateInterval.p95 / 1000.0, r.overruns);
+            printf("  Empfänger      %u vollständig, %u rekonstruiert, %u verworfen, %u zu spät, %u umsortiert\n",
+                   r.receiver.framesComplete, r.receiver.framesRecovered, r.receiver.framesDropped,
+                   r.receiver.framesLate, r.receiver.framesReordered);
+            printf("  Funk           %u Pakete, %u verloren\n", r.packetsSent, r.packetsLost);
+            printf("  LEDs           Flackern %.3f /LED/s, mittlerer Schritt %.2f\n", r.flickerPerLedS, r.meanStep);
+        }
+        if (json) {
+            fprintf(json, "  {");
+            for (const Sweep& sweep : sweeps) {
+                fprintf(json, "\"%s\": %g, ", s_defaults[sweep.param].name, params[sweep.param].value);
+            }
+            std::string values = formatResult(r, ",");
+            std::string columns = COLUMNS;
+            size_t vpos = 0, cpos = 0;
+            while (cpos < columns.size()) {
+                size_t cend = columns.find(',', cpos);
+                size_t vend = values.find(',', vpos);
+                cend = cend == std::string::npos ? columns.size() : cend;
+                vend = vend == std::string::npos ? values.size() : vend;
+                fprintf(json, "\"%s\": %s%s", columns.substr(cpos, cend - cpos).c_str(),
+                        values.substr(vpos, vend - vpos).c_str(), cend < columns.size() ? ", " : "");
+                cpos = cend + 1;
+                vpos = vend + 1;
+            }
+            fprintf(json, "}%s\n", run + 1 < runs ? "," : "");
+        }
+    }
+
+    if (json) {
+        fprintf(json, "]\n");
+        fclose(json);
+    }
+    return 0;
+}
@@ -0,0 +1,267 @@
+#include "virtual_camera.h"
+#include <dirent.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include "frame_recording.h"
+
+// ============================================================================
+// STATE
+// ============================================================================
+
+struct SourceFrame {
+    std::vector<uint8_t> jpeg;
+    int64_t recordedUs;
+    uint16_t width;
+    uint16_t height;
+};
+
+// Ausgegebener Frame; camera_fb_t steht vorn, damit fb zurückgerechnet werden kann
+struct VirtualFb {
+    camera_fb_t fb;
+    int index;
+    int64_t recordedUs;
+};
+
+static std::vector<SourceFrame> s_frames;
+static VirtualCameraPace s_pace = VCAM_FAST;
+static int s_loops = 1;
+static int64_t s_periodUs = 0;    // Länge eines Durchlaufs
+static int64_t s_startUs = -1;    // Uhrzeit des ersten Frames, -1 = noch nicht gestartet
+static long s_next = 0;           // nächster Frame über alle Durchläufe
+static VirtualCameraStats s_stats;
+
+// ============================================================================
+// HILFSFUNKTIONEN
+// ============================================================================
+
+int64_t virtualCameraNowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static bool readFile(const std::string& path, std::vector<uint8_t>& out) {
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) {
+        return false;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    out.resize(size > 0 ? size : 0);
+    bool ok = size > 0 && fread(out.data(), 1, size, f) == (size_t)size;
+    fclose(f);
+    return ok;
+}
+
+// Breite/Höhe aus dem SOF-Marker, 0 wenn keiner gefunden wird
+static void jpegSize(const std::vector<uint8_t>& jpeg, uint16_t* width, uint16_t* height) {
+    *width = *height = 0;
+    size_t i = 2;
+    while (i + 9 < jpeg.size()) {
+        if (jpeg[i] != 0xFF) {
+            return;
+        }
+        uint8_t marker = jpeg[i + 1];
+        size_t segment = (jpeg[i + 2] << 8) | jpeg[i + 3];
+        if (marker >= 0xC0 && marker <= 0xC3) {
+            *height = (jpeg[i + 5] << 8) | jpeg[i + 6];
+            *width = (jpeg[i + 7] << 8) | jpeg[i + 8];
+            return;
+        }
+        i += 2 + segment;
+    }
+}
+
+static bool hasJpegExtension(const std::string& name) {
+    size_t dot = name.rfind('.');
+    if (dot == std::string::npos) {
+        return false;
+    }
+    std::string ext = name.substr(dot + 1);
+    return strcasecmp(ext.c_str(), "jpg") == 0 || strcasecmp(ext.c_str(), "jpeg") == 0;
+}
+
+static bool addJpeg(std::vector<uint8_t>& data, int64_t recordedUs) {
+    SourceFrame frame;
+    frame.jpeg.swap(data);
+    frame.recordedUs = recordedUs;
+    jpegSize(frame.jpeg, &frame.width, &frame.height);
+    if (frame.width == 0) {
+        return false;
+    }
+    s_frames.push_back(std::move(frame));
+    return true;
+}
+
+// ============================================================================
+// LADEN
+// ============================================================================
+
+static bool loadRecording(const std::vector<uint8_t>& data) {
+    size_t pos = RECORDING_FILE_HEADER;
+    while (pos + RECORDING_FRAME_HEADER <= data.size()) {
+        RecordingFrameHeader header;
+        if (!recordingParseFrameHeader(&data[pos], data.size() - pos, &header)) {
+            fprintf(stderr, "[vcam] Ungültiger Frame-Header bei Byte %zu, Rest verworfen\n", pos);
+            break;
+        }
+        pos += RECORDING_FRAME_HEADER;
+        if (pos + header.len > data.size()) {
+            break;   // abgeschnittener letzter Frame (Verbindung abgebrochen)
+        }
+        SourceFrame frame;
+        frame.jpeg.assign(data.begin() + pos, data.begin() + pos + header.len);
+        frame.recordedUs = header.captureUs;
+        frame.width = header.width;
+        frame.height = header.height;
+        s_frames.push_back(std::move(frame));
+        pos += header.len;
+    }
+    return !s_frames.empty();
+}
+
+static bool loadDirectory(const std::string& path, int64_t intervalUs) {
+    DIR* dir = opendir(path.c_str());
+    if (!dir) {
+        return false;
+    }
+    std::vector<std::string> names;
+    while (dirent* entry = readdir(dir)) {
+        if (hasJpegExtension(entry->d_name)) {
+            names.push_back(entry->d_name);
+        }
+    }
+    closedir(dir);
+    std::sort(names.begin(), names.end());
+
+    for (const std::string& name : names) {
+        std::vector<uint8_t> data;
+        if (!readFile(path + "/" + name, data) ||
+            !addJpeg(data, (int64_t)s_frames.size() * intervalUs)) {
+            fprintf(stderr, "[vcam] %s übersprungen\n", name.c_str());
+        }
+    }
+    return !s_frames.empty();
+}
+
+// ============================================================================
+// API
+// ============================================================================
+
+bool virtualCameraOpen(const char* path, VirtualCameraPace pace, int loops, int fps) {
+    virtualCameraClose();
+    int64_t intervalUs = 1000000LL / (fps > 0 ? fps : 10);
+
+    DIR* dir = opendir(path);
+    if (dir) {
+        closedir(dir);
+        loadDirectory(path, intervalUs);
+    } else {
+        std::vector<uint8_t> data;
+        if (!readFile(path, data)) {
+            fprintf(stderr, "[vcam] %s nicht lesbar\n", path);
+            return false;
+        }
+        if (recordingParseFileHeader(data.data(), data.size())) {
+            loadRecording(data);
+        } else {
+            addJpeg(data, 0);
+        }
+    }
+    if (s_frames.empty()) {
+        fprintf(stderr, "[vcam] %s enthält keine Frames\n", path);
+        return false;
+    }
+
+    // Ein Durchlauf dauert bis zum letzten Frame plus einen mittleren Abstand
+    int64_t span = s_frames.back().recordedUs - s_frames.front().recordedUs;
+    int64_t avg = s_frames.size() > 1 ? span / (int64_t)(s_frames.size() - 1) : intervalUs;
+    s_periodUs = span + (avg > 0 ? avg : intervalUs);
+
+    s_pace = pace;
+    s_loops = loops > 0 ? loops : 1;
+    s_stats.frames = (uint32_t)s_frames.size();
+    s_stats.durationUs = s_periodUs;
+    return true;
+}
+
+void virtualCameraClose() {
+    s_frames.clear();
+    s_startUs = -1;
+    s_next = 0;
+    s_stats = VirtualCameraStats();
+}
+
+VirtualCameraStats getVirtualCameraStats() {
+    return s_stats;
+}
+
+// Fälligkeit von Frame n (über alle Durchläufe) relativ zum Start
+static int64_t dueOffsetUs(long n) {
+    long count = (long)s_frames.size();
+    const SourceFrame& frame = s_frames[n % count];
+    return (n / count) * s_periodUs + (frame.recordedUs - s_frames.front().recordedUs);
+}
+
+camera_fb_t* esp_camera_fb_get() {
+    long total = (long)s_frames.size() * s_loops;
+    if (s_next >= total) {
+        return nullptr;
+    }
+
+    int64_t now = virtualCameraNowUs();
+    int64_t captureUs = now;
+    if (s_pace == VCAM_REALTIME) {
+        if (s_startUs < 0) {
+            s_startUs = now;
+        }
+        // Neuesten fälligen Frame nehmen, ältere gelten als verpasst
+        while (s_next + 1 < total && s_startUs + dueOffsetUs(s_next + 1) <= now) {
+            s_next++;
+            s_stats.skipped++;
+        }
+        captureUs = s_startUs + dueOffsetUs(s_next);
+        if (captureUs > now) {
+            std::this_thread::sleep_for(std::chrono::microseconds(captureUs - now));
+        }
+    }
+
+    const SourceFrame& source = s_frames[s_next % (long)s_frames.size()];
+    VirtualFb* vfb = new VirtualFb();
+    vfb->fb.buf = const_cast<uint8_t*>(source.jpeg.data());
+    vfb->fb.len = source.jpeg.size();
+    vfb->fb.width = source.width;
+    vfb->fb.height = source.height;
+    vfb->fb.format = PIXFORMAT_JPEG;
+    vfb->fb.timestamp.tv_sec = captureUs / 1000000;
+    vfb->fb.timestamp.tv_usec = captureUs % 1000000;
+    vfb->index = (int)(s_next % (long)s_frames.size());
+    vfb->recordedUs = source.recordedUs;
+
+    s_next++;
+    s_stats.delivered++;
+    s_stats.outstanding++;
+    return &vfb->fb;
+}
+
+void esp_camera_fb_return(camera_fb_t* fb) {
+    if (!fb) {
+        return;
+    }
+    s_stats.outstanding--;
+    delete (VirtualFb*)fb;
+}
+
+int virtualCameraFrameIndex(const camera_fb_t* fb) {
+    return ((const VirtualFb*)fb)->index;
+}
+
+int64_t virtualCameraRecordedUs(const camera_fb_t* fb) {
+    return ((const VirtualFb*)fb)->recordedUs;
+}
@@ -0,0 +1,46 @@
+#ifndef VIRTUAL_CAMERA_H
+#define VIRTUAL_CAMERA_H
+
+// Virtuelle Kamera für den Host-Build: liefert über esp_camera_fb_get() die
+// Frames einer Aufnahme (.hrec, frame_recording.h), eines Ordners mit JPEGs
+// (nach Namen sortiert) oder eines einzelnen JPEG. Alles wird beim Öffnen in
+// den Speicher geladen, die Wiedergabe misst also keine Plattenzugriffe.
+//
+// VCAM_REALTIME: Frames werden im aufgenommenen Takt fällig, esp_camera_fb_get()
+// wartet darauf. Ist der Verbraucher zu langsam, gibt es wie mit
+// CAMERA_GRAB_LATEST den neuesten fälligen Frame, übersprungene werden gezählt.
+// VCAM_FAST: jeder Frame sofort, so schnell wie der Verbraucher abholt.
+//
+// Ein Verbraucher (ein Thread), wie der Capture-Task auf dem Gerät.
+
+#include <stdint.h>
+#include "esp_camera.h"
+
+enum VirtualCameraPace {
+    VCAM_REALTIME,
+    VCAM_FAST,
+};
+
+struct VirtualCameraStats {
+    uint32_t frames;       // Frames in der Quelle
+    uint32_t delivered;    // von esp_camera_fb_get() ausgegeben
+    uint32_t skipped;      // VCAM_REALTIME: nicht rechtzeitig abgeholt
+    uint32_t outstanding;  // ausgegeben, noch nicht zurückgegeben
+    int64_t durationUs;    // Länge der Quelle (letzter − erster Zeitstempel + ein Frame)
+};
+
+// Öffnet path. loops = Anzahl Durchläufe, fps = Takt für JPEG-Ordner und
+// Einzelbilder (Aufnahmen bringen ihre Zeitstempel mit).
+bool virtualCameraOpen(const char* path, VirtualCameraPace pace, int loops = 1, int fps = 10);
+void virtualCameraClose();
+
+VirtualCameraStats getVirtualCameraStats();
+
+// Uhr der virtuellen Kamera (µs, monoton), Basis von fb->timestamp
+int64_t virtualCameraNowUs();
+
+// Zum ausgegebenen Frame: Index in der Quelle und Zeitstempel der Aufnahme
+int virtualCameraFrameIndex(const camera_fb_t* fb);
+int64_t virtualCameraRecordedUs(const camera_fb_t* fb);
+
+#endif // VIRTUAL_CAMERA_H
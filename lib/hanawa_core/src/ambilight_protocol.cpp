@@ -0,0 +1,533 @@
+#include "ambilight_protocol.h"
+#include <string.h>
+
+// ============================================================================
+// HILFSFUNKTIONEN
+// ============================================================================
+
+int ambilightRectCount(int hSeg, int vSeg) {
+    int vertical = (vSeg > 2) ? (vSeg - 2) : 0;
+    return 2 * hSeg + 2 * vertical;
+}
+
+int ambilightPacketCount(int totalRects) {
+    int totalBytes = totalRects * 3;
+    if (totalRects <= 0 || totalBytes > AMBI_MAX_PAYLOAD) {
+        return 0;
+    }
+    if (totalBytes <= AMBI_FIRST_PAYLOAD) {
+        return 1;
+    }
+    int remaining = totalBytes - AMBI_FIRST_PAYLOAD;
+    return 1 + (remaining + AMBI_NEXT_PAYLOAD - 1) / AMBI_NEXT_PAYLOAD;
+}
+
+int ambilightV2HeaderSize(uint8_t flags) {
+    return AMBI_V2_HEADER + ((flags & AMBI_FLAG_TIMING) ? AMBI_V2_TIMING_EXT : 0);
+}
+
+int ambilightV2PayloadSize(uint8_t flags) {
+    return AMBI_MAX_PACKET_SIZE - ambilightV2HeaderSize(flags);
+}
+
+int ambilightPacketCountV2(int totalRects, uint8_t flags) {
+    int totalBytes = totalRects * 3;
+    int payload = ambilightV2PayloadSize(flags);
+    if (totalRects <= 0 || totalBytes > AMBI_MAX_PACKETS * payload) {
+        return 0;
+    }
+    return (totalBytes + payload - 1) / payload;
+}
+
+int ambilightSliceRgb(const uint8_t* rgb, int rectCount, const AmbilightIndexRange& range, uint8_t* out) {
+    int count = (range.count == 0) ? rectCount : range.count;
+    if (rectCount <= 0 || range.first < 0 || range.first >= rectCount || count < 0 || count > rectCount) {
+        return 0;
+    }
+    // Höchstens zwei zusammenhängende Stücke: bis zum Ende, dann ab Index 0
+    int head = rectCount - range.first;
+    if (head > count) head = count;
+    memcpy(out, rgb + range.first * 3, head * 3);
+    memcpy(out + head * 3, rgb, (count - head) * 3);
+    return count;
+}
+
+// Payload-Länge von v2-Datenpaket index bei totalBytes RGB-Bytes
+static size_t v2PayloadLength(int index, int totalBytes, int payload) {
+    int rest = totalBytes - index * payload;
+    if (rest <= 0) {
+        return 0;
+    }
+    return (rest > payload) ? payload : rest;
+}
+
+static void putU16(uint8_t* p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void putU32(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static uint16_t getU16(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t getU32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// Abstand zweier Sequenznummern mit Überlauf (> 0: a ist neuer als b)
+static int32_t sequenceDiff(uint32_t a, uint32_t b) {
+    return (int32_t)(a - b);
+}
+
+RGB ambilightClockwiseColor(const AmbilightSides& sides, int k) {
+    // Top (links → rechts)
+    if (k < sides.topCount) {
+        return sides.top[k];
+    }
+    k -= sides.topCount;
+
+    // Right (oben → unten)
+    if (k < sides.rightCount) {
+        return sides.right[k];
+    }
+    k -= sides.rightCount;
+
+    // Bottom (rechts → links, RÜCKWÄRTS!)
+    if (k < sides.bottomCount) {
+        return sides.bottom[sides.bottomCount - 1 - k];
+    }
+    k -= sides.bottomCount;
+
+    // Left (unten → oben, RÜCKWÄRTS!)
+    return sides.left[sides.leftCount - 1 - k];
+}
+
+// ============================================================================
+// FRAME-ENCODER
+// ============================================================================
+
+AmbilightFrameEncoder::AmbilightFrameEncoder()
+    : m_packetCount(0), m_parityEnabled(false), m_timingEnabled(false), m_frameId(0) {
+    for (int i = 0; i <= AMBI_MAX_PACKETS; i++) {
+        m_lengths[i] = 0;
+    }
+}
+
+// Schreibt die RGB-Bytes als durchgehenden Strom in die Fragmente.
+// Ein Tripel darf über eine Paketgrenze laufen (Empfänger hängt Payloads aneinander).
+// Liefert die Anzahl belegter Pakete.
+int AmbilightFrameEncoder::writePayload(int totalRects, const AmbilightSides& sides,
+                                        size_t firstHeader, size_t nextHeader) {
+    int pkt = 0;
+    size_t pos = firstHeader;
+    for (int k = 0; k < totalRects; k++) {
+        RGB c = ambilightClockwiseColor(sides, k);
+        const uint8_t bytes[3] = {c.r, c.g, c.b};
+        for (int j = 0; j < 3; j++) {
+            if (pos == AMBI_MAX_PACKET_SIZE) {
+                m_lengths[pkt] = pos;
+                pkt++;
+                pos = nextHeader;
+            }
+            m_packets[pkt][pos++] = bytes[j];
+        }
+    }
+    m_lengths[pkt] = pos;
+    return pkt + 1;
+}
+
+int AmbilightFrameEncoder::encode(int hSeg, int vSeg, const AmbilightSides& sides,
+                                  const AmbilightFrameMeta* meta) {
+    m_packetCount = 0;
+
+    // Header-Felder sind 1 Byte breit
+    if (hSeg <= 0 || hSeg > 255 || vSeg < 2 || vSeg > 255) {
+        return 0;
+    }
+
+    // Seitenlängen müssen zur Segmentierung passen, sonst stimmt die
+    // Zuordnung beim Empfänger nicht
+    int vertical = vSeg - 2;
+    if (sides.topCount != hSeg || sides.bottomCount != hSeg ||
+        sides.leftCount != vertical || sides.rightCount != vertical) {
+        return 0;
+    }
+
+    int totalRects = ambilightRectCount(hSeg, vSeg);
+    int totalPackets = ambilightPacketCount(totalRects);
+    if (totalPackets == 0) {
+        return 0;
+    }
+
+    // v2, wenn Timing gewünscht ist oder ein Mehrpaket-Frame Parität bekommt
+    uint8_t flags = 0;
+    if (m_timingEnabled && meta) {
+        flags |= AMBI_FLAG_TIMING;
+    }
+    if (m_parityEnabled && ambilightPacketCountV2(totalRects, flags) > 1) {
+        flags |= AMBI_FLAG_PARITY;
+    }
+    if (flags && ambilightPacketCountV2(totalRects, flags) > 0) {
+        return encodeV2(hSeg, vSeg, totalRects, sides, flags, meta);
+    }
+
+    // v1: Header aller Pakete
+    for (int p = 0; p < totalPackets; p++) {
+        m_packets[p][0] = (uint8_t)p;
+        m_packets[p][1] = (uint8_t)totalPackets;
+    }
+    m_packets[0][2] = (uint8_t)hSeg;
+    m_packets[0][3] = (uint8_t)vSeg;
+
+    writePayload(totalRects, sides, AMBI_HEADER_FIRST, AMBI_HEADER_NEXT);
+
+    m_packetCount = totalPackets;
+    return m_packetCount;
+}
+
+int AmbilightFrameEncoder::encodeV2(int hSeg, int vSeg, int totalRects, const AmbilightSides& sides,
+                                    uint8_t flags, const AmbilightFrameMeta* meta) {
+    int dataPackets = ambilightPacketCountV2(totalRects, flags);
+    int totalPackets = dataPackets + ((flags & AMBI_FLAG_PARITY) ? 1 : 0);
+    size_t header = ambilightV2HeaderSize(flags);
+
+    // frame_id = untere 8 Bit der Sequenznummer, sonst eigener Zähler
+    uint8_t frameId = (flags & AMBI_FLAG_TIMING) ? (uint8_t)meta->sequence : m_frameId++;
+
+    // Header in jedem Paket (inkl. Parität), damit jedes einzelne Paket
+    // den Frame vollständig beschreibt
+    for (int p = 0; p < totalPackets; p++) {
+        uint8_t* pkt = m_packets[p];
+        pkt[0] = AMBI_V2_MARKER | (uint8_t)p;
+        pkt[1] = (uint8_t)dataPackets;
+        pkt[2] = AMBI_V2_VERSION;
+        pkt[3] = flags;
+        pkt[4] = frameId;
+        pkt[5] = (uint8_t)hSeg;
+        pkt[6] = (uint8_t)vSeg;
+        if (flags & AMBI_FLAG_TIMING) {
+            putU32(pkt + AMBI_V2_HEADER, meta->sequence);
+            putU32(pkt + AMBI_V2_HEADER + 4, meta->captureUs);
+            putU16(pkt + AMBI_V2_HEADER + 8, meta->deadlineMs);
+        }
+    }
+
+    writePayload(totalRects, sides, header, header);
+
+    // XOR-Parität über alle Datenpakete (kürzere mit Nullen aufgefüllt)
+    if (flags & AMBI_FLAG_PARITY) {
+        uint8_t* parity = m_packets[dataPackets];
+        size_t parityLen = m_lengths[0];
+        memset(parity + header, 0, parityLen - header);
+        for (int p = 0; p < dataPackets; p++) {
+            for (size_t i = header; i < m_lengths[p]; i++) {
+                parity[i] ^= m_packets[p][i];
+            }
+        }
+        m_lengths[dataPackets] = parityLen;
+    }
+
+    m_packetCount = totalPackets;
+    return m_packetCount;
+}
+
+int AmbilightFrameEncoder::send(AmbilightTransport& transport) const {
+    int accepted = 0;
+    for (int p = 0; p < m_packetCount; p++) {
+        if (p > 0) {
+            transport.waitBetweenPackets();
+        }
+        if (transport.sendPacket(m_packets[p], m_lengths[p])) {
+            accepted++;
+        }
+    }
+    return accepted;
+}
+
+// ============================================================================
+// EMPFÄNGER
+// ============================================================================
+
+AmbilightReceiver::AmbilightReceiver()
+    : m_pending(false), m_dataPackets(0), m_nextPacket(0), m_offset(0),
+      m_frameId(-1), m_lastCompleteId(-1), m_hasParity(false),
+      m_pendingH(0), m_pendingV(0), m_pendingFlags(0),
+      m_haveSequence(false), m_lastSequence(0), m_lastStale(0),
+      m_haveTransit(false), m_minTransitUs(0),
+      m_haveClockOffset(false), m_clockOffsetUs(0),
+      m_rectCount(0), m_hSeg(0), m_vSeg(0) {
+    memset(m_have, 0, sizeof(m_have));
+    memset(&m_pendingMeta, 0, sizeof(m_pendingMeta));
+    memset(&m_meta, 0, sizeof(m_meta));
+    memset(&m_stats, 0, sizeof(m_stats));
+}
+
+void AmbilightReceiver::abortFrame() {
+    if (m_pending) {
+        m_stats.framesDropped++;
+    }
+    m_pending = false;
+    m_frameId = -1;
+}
+
+bool AmbilightReceiver::onPacket(const uint8_t* data, size_t len, uint32_t nowUs) {
+    m_stats.packetsReceived++;
+    if (len < AMBI_HEADER_NEXT) {
+        m_stats.packetsInvalid++;
+        return false;
+    }
+    if (data[0] & AMBI_V2_MARKER) {
+        return onPacketV2(data, len, nowUs);
+    }
+    return onPacketV1(data, len);
+}
+
+bool AmbilightReceiver::onPacketV1(const uint8_t* data, size_t len) {
+    int packetNum = data[0];
+    int totalPackets = data[1];
+
+    if (totalPackets == 0 || totalPackets > AMBI_MAX_PACKETS || packetNum >= totalPackets) {
+        m_stats.packetsInvalid++;
+        return false;
+    }
+
+    // === PAKET 0 (Neuer Frame) ===
+    if (packetNum == 0) {
+        if (len < AMBI_HEADER_FIRST) {
+            m_stats.packetsInvalid++;
+            return false;
+        }
+        int h = data[2], v = data[3];
+        int rects = ambilightRectCount(h, v);
+        if (h == 0 || v < 2 || ambilightPacketCount(rects) != totalPackets) {
+            m_stats.packetsInvalid++;
+            return false;
+        }
+        abortFrame();
+
+        size_t payload = len - AMBI_HEADER_FIRST;
+        memcpy(m_work, data + AMBI_HEADER_FIRST, payload);
+        m_offset = payload;
+        m_pendingH = h;
+        m_pendingV = v;
+        m_dataPackets = totalPackets;
+        m_nextPacket = 1;
+        m_pending = true;
+    } else {
+        // === FOLGEPAKET: strikte Reihenfolge ===
+        if (!m_pending || m_frameId != -1 ||
+            packetNum != m_nextPacket || totalPackets != m_dataPackets) {
+            abortFrame();
+            return false;
+        }
+        size_t payload = len - AMBI_HEADER_NEXT;
+        if (m_offset + payload > sizeof(m_work)) {
+            m_stats.packetsInvalid++;
+            abortFrame();
+            return false;
+        }
+        memcpy(m_work + m_offset, data + AMBI_HEADER_NEXT, payload);
+        m_offset += payload;
+        m_nextPacket++;
+    }
+
+    if (m_nextPacket < m_dataPackets) {
+        return false;
+    }
+
+    // === FRAME KOMPLETT ===
+    int rects = ambilightRectCount(m_pendingH, m_pendingV);
+    if (m_offset != (size_t)rects * 3) {
+        m_stats.packetsInvalid++;
+        abortFrame();
+        return false;
+    }
+    memcpy(m_rgb, m_work, m_offset);
+    m_rectCount = rects;
+    m_hSeg = m_pendingH;
+    m_vSeg = m_pendingV;
+    m_pending = false;
+    m_stats.framesComplete++;
+    return true;
+}
+
+bool AmbilightReceiver::onPacketV2(const uint8_t* data, size_t len, uint32_t nowUs) {
+    if (len < AMBI_V2_HEADER || data[2] != AMBI_V2_VERSION) {
+        m_stats.packetsInvalid++;
+        return false;
+    }
+
+    int index = data[0] & ~AMBI_V2_MARKER;
+    int dataPackets = data[1];
+    uint8_t flags = data[3];
+    bool hasParity = (flags & AMBI_FLAG_PARITY) != 0;
+    int frameId = data[4];
+    int h = data[5], v = data[6];
+    size_t header = ambilightV2HeaderSize(flags);
+    int payload = ambilightV2PayloadSize(flags);
+
+    int rects = ambilightRectCount(h, v);
+    int totalBytes = rects * 3;
+    if (len < header || h == 0 || v < 2 || dataPackets == 0 ||
+        ambilightPacketCountV2(rects, flags) != dataPackets ||
+        index > dataPackets || (index == dataPackets && !hasParity)) {
+        m_stats.packetsInvalid++;
+        return false;
+    }
+
+    // Paritätspaket hat die Länge des längsten (ersten) Datenpakets
+    size_t expected = v2PayloadLength(index == dataPackets ? 0 : index, totalBytes, payload);
+    if (len - header != expected) {
+        m_stats.packetsInvalid++;
+        return false;
+    }
+
+    AmbilightFrameMeta meta = {0, 0, 0};
+    bool timing = (flags & AMBI_FLAG_TIMING) != 0;
+    if (timing) {
+        meta.sequence = getU32(data + AMBI_V2_HEADER);
+        meta.captureUs = getU32(data + AMBI_V2_HEADER + 4);
+        meta.deadlineMs = getU16(data + AMBI_V2_HEADER + 8);
+
+        // Fragment eines älteren Frames: zu spät, nie wieder anzeigen
+        bool olderThanShown = m_haveSequence && sequenceDiff(meta.sequence, m_lastSequence) <= 0;
+        bool olderThanPending = m_pending && (m_pendingFlags & AMBI_FLAG_TIMING) &&
+                                sequenceDiff(meta.sequence, m_pendingMeta.sequence) < 0;
+        if (olderThanShown || olderThanPending) {
+            // Rest des zuletzt gezeigten Frames (z.B. Parität) ist kein Reorder
+            if (!(m_haveSequence && meta.sequence == m_lastSequence) &&
+                meta.sequence != m_lastStale) {
+                m_stats.framesReordered++;
+                m_lastStale = meta.sequence;
+            }
+            return false;
+        }
+    } else if (frameId == m_lastCompleteId) {
+        // Rest eines bereits fertigen Frames (z.B. Parität nach allen Daten)
+        return false;
+    }
+
+    if (!m_pending || frameId != m_frameId) {
+        abortFrame();
+        memset(m_have, 0, sizeof(m_have));
+        m_frameId = frameId;
+        m_dataPackets = dataPackets;
+        m_hasParity = hasParity;
+        m_pendingH = h;
+        m_pendingV = v;
+        m_pendingFlags = flags;
+        m_pendingMeta = meta;
+        m_pending = true;
+    }
+
+    if (m_have[index]) {
+        return false;  // Duplikat
+    }
+    memcpy(m_payload[index], data + header, expected);
+    m_have[index] = true;
+
+    return completeV2(nowUs);
+}
+
+bool AmbilightReceiver::completeV2(uint32_t nowUs) {
+    int missing = -1;
+    int missingCount = 0;
+    for (int p = 0; p < m_dataPackets; p++) {
+        if (!m_have[p]) {
+            missing = p;
+            missingCount++;
+        }
+    }
+
+    int totalBytes = ambilightRectCount(m_pendingH, m_pendingV) * 3;
+    int payload = ambilightV2PayloadSize(m_pendingFlags);
+
+    if (missingCount == 1 && m_hasParity && m_have[m_dataPackets]) {
+        // Fehlendes Datenpaket = Parität XOR alle anderen Datenpakete
+        size_t parityLen = v2PayloadLength(0, totalBytes, payload);
+        uint8_t* rebuilt = m_payload[missing];
+        memcpy(rebuilt, m_payload[m_dataPackets], parityLen);
+        for (int p = 0; p < m_dataPackets; p++) {
+            if (p == missing) continue;
+            size_t n = v2PayloadLength(p, totalBytes, payload);
+            for (size_t i = 0; i < n; i++) {
+                rebuilt[i] ^= m_payload[p][i];
+            }
+        }
+        m_have[missing] = true;
+        missingCount = 0;
+        m_stats.framesRecovered++;
+    }
+
+    if (missingCount > 0) {
+        return false;
+    }
+
+    // === FRAME KOMPLETT ===
+    m_lastCompleteId = m_frameId;
+    m_pending = false;
+    m_frameId = -1;
+
+    if (m_pendingFlags & AMBI_FLAG_TIMING) {
+        if (m_haveSequence) {
+            m_stats.framesLost += sequenceDiff(m_pendingMeta.sequence, m_lastSequence) - 1;
+        }
+        m_haveSequence = true;
+        m_lastSequence = m_pendingMeta.sequence;
+
+        if (isLate(nowUs)) {
+            m_stats.framesLate++;
+            return false;  // veraltete Farben nicht mehr zeigen
+        }
+    }
+    m_stats.framesComplete++;
+
+    size_t offset = 0;
+    for (int p = 0; p < m_dataPackets; p++) {
+        size_t n = v2PayloadLength(p, totalBytes, payload);
+        memcpy(m_rgb + offset, m_payload[p], n);
+        offset += n;
+    }
+    m_rectCount = totalBytes / 3;
+    m_hSeg = m_pendingH;
+    m_vSeg = m_pendingV;
+    m_meta = m_pendingMeta;
+    return true;
+}
+
+bool AmbilightReceiver::presentAtUs(uint32_t* localUs) const {
+    if (!m_haveClockOffset || m_meta.deadlineMs == 0 || !m_haveSequence) {
+        return false;
+    }
+    *localUs = m_meta.captureUs + (uint32_t)m_meta.deadlineMs * 1000 + (uint32_t)m_clockOffsetUs;
+    return true;
+}
+
+// Deadline-Prüfung. Mit bekanntem Uhrenversatz exakt gegen den gemeinsamen
+// Anzeigezeitpunkt. Ohne synchronisierte Uhren dient der kleinste beobachtete
+// Abstand (Ankunft - Capture) als Referenz für "pünktlich", alles darüber ist
+// zusätzliche Verzögerung gegenüber dem schnellsten Frame.
+bool AmbilightReceiver::isLate(uint32_t nowUs) {
+    if (m_pendingMeta.deadlineMs == 0 || nowUs == 0) {
+        return false;
+    }
+    if (m_haveClockOffset) {
+        uint32_t presentUs = m_pendingMeta.captureUs + (uint32_t)m_pendingMeta.deadlineMs * 1000 +
+                             (uint32_t)m_clockOffsetUs;
+        return (int32_t)(nowUs - presentUs) > 0;
+    }
+    int32_t transit = (int32_t)(nowUs - m_pendingMeta.captureUs);
+    if (!m_haveTransit || transit < m_minTransitUs) {
+        m_minTransitUs = transit;
+        m_haveTransit = true;
+    }
+    int32_t delayUs = transit - m_minTransitUs;
+    return delayUs > (int32_t)m_pendingMeta.deadlineMs * 1000;
+}
@@ -0,0 +1,221 @@
+#ifndef AMBILIGHT_PROTOCOL_H
+#define AMBILIGHT_PROTOCOL_H
+
+// Ambilight-Datenprotokoll (siehe doc/AMBILIGHT_PROTOCOL.md).
+// Plattformunabhängig: das eigentliche Senden übernimmt ein AmbilightTransport
+// (ESP-NOW auf dem Gerät, Loopback im Host-Test unter local_test/).
+//
+// v1: 4 Byte Header in Paket 0, 2 Byte in Folgepaketen, keine Redundanz.
+// v2: erweiterter Header in jedem Paket (packet_num mit gesetztem Bit 7),
+//     optional ein XOR-Paritätspaket pro Frame (FEC) und eine Timing-
+//     Erweiterung mit Sequenznummer, Capture-Zeitstempel und Deadline.
+
+#include <stddef.h>
+#include <stdint.h>
+#include "ambilight_types.h"
+
+#define AMBI_MAX_PACKET_SIZE   250  // ESP-NOW Maximum (ESP_NOW_MAX_DATA_LEN)
+#define AMBI_MAX_PACKETS       3    // Datenpakete pro Frame (Empfehlung: max. 2-3)
+
+// --- v1 ---
+#define AMBI_HEADER_FIRST      4    // packet_num, total_packets, h_segments, v_segments
+#define AMBI_HEADER_NEXT       2    // packet_num, total_packets
+#define AMBI_FIRST_PAYLOAD     (AMBI_MAX_PACKET_SIZE - AMBI_HEADER_FIRST)  // 246 Bytes
+#define AMBI_NEXT_PAYLOAD      (AMBI_MAX_PACKET_SIZE - AMBI_HEADER_NEXT)   // 248 Bytes
+#define AMBI_MAX_PAYLOAD       (AMBI_FIRST_PAYLOAD + (AMBI_MAX_PACKETS - 1) * AMBI_NEXT_PAYLOAD)
+#define AMBI_MAX_RECTANGLES    (AMBI_MAX_PAYLOAD / 3)
+
+// --- v2 ---
+#define AMBI_V2_MARKER         0x80 // Bit 7 in packet_num kennzeichnet v2 (v1-Empfänger verwerfen das Paket)
+#define AMBI_V2_VERSION        0x02
+#define AMBI_V2_HEADER         7    // packet_num|0x80, data_packets, version, flags, frame_id, h_segments, v_segments
+#define AMBI_V2_PAYLOAD        (AMBI_MAX_PACKET_SIZE - AMBI_V2_HEADER)     // 243 Bytes = 81 Rechtecke (ohne Erweiterung)
+#define AMBI_V2_MAX_PAYLOAD    (AMBI_MAX_PACKETS * AMBI_V2_PAYLOAD)
+#define AMBI_V2_TIMING_EXT     10   // sequence (u32), capture_us (u32), deadline_ms (u16), little endian
+
+// v2 Flags (Byte 3)
+#define AMBI_FLAG_PARITY       0x01 // Frame enthält ein XOR-Paritätspaket mit packet_num = data_packets
+#define AMBI_FLAG_TIMING       0x02 // Timing-Erweiterung folgt direkt auf den Header
+
+// Identität und Zeitstempel eines Frames (Sender-Uhr)
+struct AmbilightFrameMeta {
+    uint32_t sequence;     // fortlaufende Frame-Nummer der Veröffentlichung
+    uint32_t captureUs;    // Capture-Zeitpunkt (fb->timestamp) in µs, läuft über
+    uint16_t deadlineMs;   // Frame spätestens captureUs + deadlineMs zeigen, 0 = keine
+};
+
+// Transport-Schnittstelle für fertige Pakete
+class AmbilightTransport {
+public:
+    virtual ~AmbilightTransport() {}
+
+    // Übergibt ein Paket an den Transport. Der Puffer gehört dem Encoder und
+    // bleibt bis zum nächsten encode() gültig. false = Paket nicht gesendet.
+    virtual bool sendPacket(const uint8_t* data, size_t len) = 0;
+
+    // Wird vor jedem Folgepaket eines Frames aufgerufen, damit die Fragmente
+    // nicht direkt hintereinander in den Funk-Puffer laufen (Pacing).
+    virtual void waitBetweenPackets() {}
+};
+
+// Farben eines Ergebnisses, so wie windows.cpp sie berechnet
+// (top/bottom: links → rechts, left/right: oben → unten, ohne Ecken)
+struct AmbilightSides {
+    const RGB* top;    int topCount;
+    const RGB* right;  int rightCount;
+    const RGB* bottom; int bottomCount;
+    const RGB* left;   int leftCount;
+};
+
+// Anzahl Rechtecke: 2 * h + 2 * (v - 2)
+int ambilightRectCount(int hSeg, int vSeg);
+
+// Anzahl v1-Pakete für eine Rechteckanzahl (0 = passt nicht ins Protokoll)
+int ambilightPacketCount(int totalRects);
+
+// Header-Länge und Payload pro Paket in v2 (abhängig von den Flags)
+int ambilightV2HeaderSize(uint8_t flags);
+int ambilightV2PayloadSize(uint8_t flags);
+
+// Anzahl v2-Datenpakete (ohne Parität) für eine Rechteckanzahl (0 = passt nicht)
+int ambilightPacketCountV2(int totalRects, uint8_t flags = 0);
+
+// Liefert Farbe k im Uhrzeigersinn (Top →, Right ↓, Bottom ←, Left ↑)
+RGB ambilightClockwiseColor(const AmbilightSides& sides, int k);
+
+// Fan-out: Ausschnitt eines Leuchters aus dem Uhrzeigersinn-Array
+// (z.B. Seitenlampe = nur die rechte Kante). Ein Bereich darf über das Ende
+// hinaus wieder bei Index 0 weiterlaufen (Ecke oben links).
+struct AmbilightIndexRange {
+    int first;   // erster Index im Uhrzeigersinn
+    int count;   // Anzahl Rechtecke, 0 = alle
+};
+
+// Kopiert den Ausschnitt range aus rgb (rectCount Tripel) nach out.
+// Liefert die Anzahl kopierter Tripel, 0 bei ungültigem Bereich.
+int ambilightSliceRgb(const uint8_t* rgb, int rectCount, const AmbilightIndexRange& range, uint8_t* out);
+
+// Kodiert Frames direkt in einen festen Paketpuffer: die RGB-Tripel werden
+// beim Sortieren in den Uhrzeigersinn sofort an ihre endgültige Position im
+// jeweiligen Fragment geschrieben. Beim Senden wird nichts mehr kopiert.
+class AmbilightFrameEncoder {
+public:
+    AmbilightFrameEncoder();
+
+    // Mehrpaket-Frames mit XOR-Paritätspaket senden (v2). Einzelpaket-Frames
+    // bleiben v1, damit bestehende Leuchter sie weiter verstehen.
+    void setParityEnabled(bool enabled) { m_parityEnabled = enabled; }
+    bool parityEnabled() const { return m_parityEnabled; }
+
+    // Jeden Frame als v2 mit Timing-Erweiterung senden (benötigt meta in encode())
+    void setTimingEnabled(bool enabled) { m_timingEnabled = enabled; }
+    bool timingEnabled() const { return m_timingEnabled; }
+
+    // Kodiert einen Frame. Liefert die Paketanzahl (inkl. Parität),
+    // 0 bei ungültigen Eingaben.
+    int encode(int hSeg, int vSeg, const AmbilightSides& sides,
+               const AmbilightFrameMeta* meta = nullptr);
+
+    // Sendet alle Pakete des zuletzt kodierten Frames.
+    // Liefert die Anzahl der vom Transport angenommenen Pakete.
+    int send(AmbilightTransport& transport) const;
+
+    int packetCount() const { return m_packetCount; }
+    const uint8_t* packet(int index) const { return m_packets[index]; }
+    size_t packetLength(int index) const { return m_lengths[index]; }
+
+private:
+    int writePayload(int totalRects, const AmbilightSides& sides,
+                     size_t firstHeader, size_t nextHeader);
+    int encodeV2(int hSeg, int vSeg, int totalRects, const AmbilightSides& sides,
+                 uint8_t flags, const AmbilightFrameMeta* meta);
+
+    uint8_t m_packets[AMBI_MAX_PACKETS + 1][AMBI_MAX_PACKET_SIZE];  // + Paritätspaket
+    size_t m_lengths[AMBI_MAX_PACKETS + 1];
+    int m_packetCount;
+    bool m_parityEnabled;
+    bool m_timingEnabled;
+    uint8_t m_frameId;
+};
+
+// Zähler des Empfängers
+struct AmbilightReceiverStats {
+    uint32_t packetsReceived;
+    uint32_t packetsInvalid;   // zu kurz / unplausibler Header
+    uint32_t framesComplete;   // an die LEDs übergebene Frames
+    uint32_t framesRecovered;  // davon per Parität rekonstruiert
+    uint32_t framesDropped;    // unvollständig verworfen
+    uint32_t framesLost;       // Lücken in der Sequenz zwischen gezeigten Frames (alle Ursachen)
+    uint32_t framesReordered;  // Fragmente älterer Frames nach einem neueren (verworfen)
+    uint32_t framesLate;       // vollständig, aber nach der Deadline (nicht gezeigt)
+};
+
+// Empfänger für v1 und v2 (Referenz für den Leuchter und die Host-Simulationen)
+class AmbilightReceiver {
+public:
+    AmbilightReceiver();
+
+    // Verarbeitet ein Paket. true = mit diesem Paket wurde ein Frame vollständig
+    // und ist rechtzeitig, die Farben liegen dann in rgb() (Uhrzeigersinn,
+    // rectCount() Tripel). nowUs = Empfänger-Uhr, nur für die Deadline-Prüfung.
+    bool onPacket(const uint8_t* data, size_t len, uint32_t nowUs = 0);
+
+    // Unvollständigen Frame verwerfen (z.B. Timeout > 200 ms)
+    void abortFrame();
+
+    // Uhrenversatz zum Sender (eigene Uhr − Sender-Uhr, aus clock_sync.h).
+    // Ab dann gilt captureUs + deadlineMs als gemeinsamer Anzeigezeitpunkt.
+    void setClockOffset(int32_t offsetUs) { m_clockOffsetUs = offsetUs; m_haveClockOffset = true; }
+    bool hasClockOffset() const { return m_haveClockOffset; }
+
+    // Anzeigezeitpunkt des letzten Frames in der eigenen Uhr: so lange
+    // warten, dann umschalten. false = Frame hat keinen (sofort zeigen).
+    bool presentAtUs(uint32_t* localUs) const;
+
+    const uint8_t* rgb() const { return m_rgb; }
+    int rectCount() const { return m_rectCount; }
+    int hSegments() const { return m_hSeg; }
+    int vSegments() const { return m_vSeg; }
+    const AmbilightFrameMeta& meta() const { return m_meta; }  // nur mit Timing-Erweiterung
+    const AmbilightReceiverStats& stats() const { return m_stats; }
+
+private:
+    bool onPacketV1(const uint8_t* data, size_t len);
+    bool onPacketV2(const uint8_t* data, size_t len, uint32_t nowUs);
+    bool completeV2(uint32_t nowUs);
+    bool isLate(uint32_t nowUs);
+
+    // Zusammensetzen (v1: fortlaufend in m_work, v2: je Paketindex in m_payload)
+    uint8_t m_work[AMBI_MAX_PAYLOAD];
+    uint8_t m_payload[AMBI_MAX_PACKETS + 1][AMBI_V2_PAYLOAD];
+    bool m_have[AMBI_MAX_PACKETS + 1];
+    bool m_pending;         // Frame in Arbeit
+    int m_dataPackets;
+    int m_nextPacket;       // v1: erwartetes packet_num
+    size_t m_offset;        // v1: Schreibposition in m_work
+    int m_frameId;          // v2: aktuelle frame_id, -1 = keine
+    int m_lastCompleteId;   // v2: zuletzt vollständige frame_id
+    bool m_hasParity;
+    int m_pendingH, m_pendingV;
+    uint8_t m_pendingFlags;
+    AmbilightFrameMeta m_pendingMeta;
+
+    // Sequenz- und Laufzeit-Tracking (nur mit Timing-Erweiterung)
+    bool m_haveSequence;
+    uint32_t m_lastSequence;    // zuletzt abgeschlossener Frame
+    uint32_t m_lastStale;       // zuletzt als "reordered" gezählter Frame
+    bool m_haveTransit;
+    int32_t m_minTransitUs;     // min(Ankunft - Capture) ≈ Uhrenversatz + minimale Laufzeit
+    bool m_haveClockOffset;
+    int32_t m_clockOffsetUs;    // per Uhrensynchronisation bekannter Versatz
+
+    // Letzter vollständiger Frame
+    uint8_t m_rgb[AMBI_MAX_PAYLOAD];
+    int m_rectCount;
+    int m_hSeg, m_vSeg;
+    AmbilightFrameMeta m_meta;
+
+    AmbilightReceiverStats m_stats;
+};
+
+#endif // AMBILIGHT_PROTOCOL_H
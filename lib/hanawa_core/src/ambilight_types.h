@@ -0,0 +1,19 @@
+#ifndef AMBILIGHT_TYPES_H
+#define AMBILIGHT_TYPES_H
+
+// Plattformunabhängige Grundtypen (ohne Arduino.h), gemeinsam für beide
+// Firmwares und den Host-Build (CMakeLists.txt, local_test/).
+
+#include <stdint.h>
+
+// Struktur für Rechteck-Koordinaten
+struct WindowRect {
+    int x1, y1, x2, y2;
+};
+
+// Struktur für RGB-Farbwerte
+struct RGB {
+    uint8_t r, g, b;
+};
+
+#endif // AMBILIGHT_TYPES_H
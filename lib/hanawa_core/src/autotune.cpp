@@ -0,0 +1,215 @@
+#include "autotune.h"
+#include <algorithm>
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ============================================================================
+// AUFZÄHLEN
+// ============================================================================
+
+bool autotuneParseAxis(const char* text, AutotuneAxis* axis) {
+    axis->count = 0;
+    const char* p = text;
+    while (*p) {
+        char* end;
+        long value = strtol(p, &end, 10);
+        if (end == p || axis->count == AUTOTUNE_MAX_AXIS) {
+            return false;
+        }
+        axis->values[axis->count++] = (int)value;
+        p = end;
+        if (*p == ',') {
+            p++;
+        } else if (*p) {
+            return false;
+        }
+    }
+    return axis->count > 0;
+}
+
+int autotuneSettings(const AutotuneAxes& axes, AutotuneSetting* out, int cap) {
+    int total = axes.xclkMhz.count * axes.jpegQuality.count * axes.frameWidth.count * axes.decodeScale.count;
+    if (total == 0 || total > cap) {
+        return 0;
+    }
+    int n = 0;
+    for (int x = 0; x < axes.xclkMhz.count; x++) {
+        for (int q = 0; q < axes.jpegQuality.count; q++) {
+            for (int f = 0; f < axes.frameWidth.count; f++) {
+                for (int s = 0; s < axes.decodeScale.count; s++) {
+                    AutotuneSetting& setting = out[n++];
+                    setting.xclkMhz = axes.xclkMhz.values[x];
+                    setting.jpegQuality = axes.jpegQuality.values[q];
+                    setting.frameWidth = axes.frameWidth.values[f];
+                    setting.frameHeight = axes.frameWidth.values[f] * 3 / 4;
+                    setting.decodeScale = axes.decodeScale.values[s];
+                }
+            }
+        }
+    }
+    return n;
+}
+
+// ============================================================================
+// MESSEN
+// ============================================================================
+
+void AutotuneReference::reset() {
+    memset(m_sum, 0, sizeof(m_sum));
+    m_count = 0;
+    m_frames = 0;
+}
+
+bool AutotuneReference::add(const RGB* colors, int count) {
+    if (count <= 0 || count > AMBI_MAX_RECTANGLES || (m_frames > 0 && count != m_count)) {
+        return false;
+    }
+    for (int i = 0; i < count; i++) {
+        m_sum[i][0] += colors[i].r;
+        m_sum[i][1] += colors[i].g;
+        m_sum[i][2] += colors[i].b;
+    }
+    m_count = count;
+    m_frames++;
+    return true;
+}
+
+int AutotuneReference::finish(RGB* out) const {
+    if (m_frames == 0) {
+        return 0;
+    }
+    for (int i = 0; i < m_count; i++) {
+        out[i].r = (uint8_t)((m_sum[i][0] + m_frames / 2) / m_frames);
+        out[i].g = (uint8_t)((m_sum[i][1] + m_frames / 2) / m_frames);
+        out[i].b = (uint8_t)((m_sum[i][2] + m_frames / 2) / m_frames);
+    }
+    return m_count;
+}
+
+void AutotuneMeasurement::begin(const AutotuneSetting& setting) {
+    m_setting = setting;
+    m_frames = 0;
+    m_busySumUs = 0;
+    m_jpegSum = 0;
+    m_errorSum = 0;
+    m_errorCount = 0;
+}
+
+void AutotuneMeasurement::addFrame(uint32_t busyUs, uint32_t latencyUs, uint32_t jpegBytes,
+                                   const RGB* colors, const RGB* reference, int count) {
+    if (m_frames == AUTOTUNE_MAX_FRAMES) {
+        return;
+    }
+    m_latencies[m_frames++] = latencyUs;
+    m_busySumUs += busyUs;
+    m_jpegSum += jpegBytes;
+    if (reference) {
+        for (int i = 0; i < count; i++) {
+            int dr = colors[i].r - reference[i].r;
+            int dg = colors[i].g - reference[i].g;
+            int db = colors[i].b - reference[i].b;
+            m_errorSum += dr * dr + dg * dg + db * db;
+        }
+        m_errorCount += count * 3;
+    }
+}
+
+AutotuneResult AutotuneMeasurement::finish() {
+    AutotuneResult result = {};
+    result.setting = m_setting;
+    result.frames = m_frames;
+    if (m_frames == 0) {
+        return result;
+    }
+    result.fps = m_busySumUs ? (float)(1e6 * m_frames / (double)m_busySumUs) : 0;
+    result.jpegBytes = (uint32_t)(m_jpegSum / m_frames);
+    result.colorError = m_errorCount ? (float)sqrt(m_errorSum / m_errorCount) : 0;
+
+    // Perzentile nach dem Nearest-Rank-Verfahren
+    std::sort(m_latencies, m_latencies + m_frames);
+    result.latencyP50Us = m_latencies[(m_frames + 1) / 2 - 1];
+    result.latencyP95Us = m_latencies[(m_frames * 95 + 99) / 100 - 1];
+    return result;
+}
+
+// ============================================================================
+// AUSWÄHLEN
+// ============================================================================
+
+static bool meetsTarget(const AutotuneResult& r, const AutotuneTarget& target) {
+    return r.frames > 0 &&
+           (target.maxLatencyUs == 0 || r.latencyP95Us <= target.maxLatencyUs) &&
+           (target.minFps <= 0 || r.fps >= target.minFps);
+}
+
+int autotuneSelect(const AutotuneResult* results, int count, const AutotuneTarget& target) {
+    int best = -1;
+    for (int i = 0; i < count; i++) {
+        if (!meetsTarget(results[i], target)) {
+            continue;
+        }
+        if (best < 0 || results[i].colorError < results[best].colorError ||
+            (results[i].colorError == results[best].colorError &&
+             results[i].latencyP95Us < results[best].latencyP95Us)) {
+            best = i;
+        }
+    }
+    if (best >= 0) {
+        return best;
+    }
+
+    // Ziel unerreichbar: am nächsten dran
+    for (int i = 0; i < count; i++) {
+        if (results[i].frames == 0) {
+            continue;
+        }
+        bool better = best < 0 ||
+                      (target.maxLatencyUs ? results[i].latencyP95Us < results[best].latencyP95Us
+                                           : results[i].fps > results[best].fps);
+        if (better) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+// ============================================================================
+// TABELLE
+// ============================================================================
+
+struct TextOut {
+    char* buf;
+    size_t cap;
+    size_t len;
+};
+
+static void append(TextOut& out, const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    size_t room = out.len < out.cap ? out.cap - out.len : 0;
+    int n = vsnprintf(room ? out.buf + out.len : nullptr, room, fmt, args);
+    va_end(args);
+    if (n > 0) {
+        out.len += n;
+    }
+}
+
+size_t autotuneFormatCsv(char* buf, size_t cap, const AutotuneResult* results, int count) {
+    TextOut out = { buf, cap, 0 };
+    if (cap > 0) {
+        buf[0] = '\0';
+    }
+    append(out, "xclk_mhz,jpeg_quality,width,height,decode_scale,frames,fps,latency_p50_us,latency_p95_us,"
+                "jpeg_bytes,color_error\n");
+    for (int i = 0; i < count; i++) {
+        const AutotuneResult& r = results[i];
+        append(out, "%d,%d,%d,%d,%d,%d,%.2f,%u,%u,%u,%.2f\n",
+               r.setting.xclkMhz, r.setting.jpegQuality, r.setting.frameWidth, r.setting.frameHeight,
+               r.setting.decodeScale, r.frames, r.fps, (unsigned)r.latencyP50Us, (unsigned)r.latencyP95Us,
+               (unsigned)r.jpegBytes, r.colorError);
+    }
+    return out.len;
+}
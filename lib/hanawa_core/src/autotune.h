@@ -0,0 +1,114 @@
+#ifndef AUTOTUNE_H
+#define AUTOTUNE_H
+
+// Autotuner für die Kamera-Einstellungen: Kombinationen aus XCLK,
+// JPEG-Qualität, Bildgröße und Dekodier-Skalierung durchmessen (Gerät:
+// camera_tune.cpp in sucher2), je Kombination erreichbare Frames/s, Latenz
+// Capture → Ergebnis, JPEG-Größe und Farbfehler gegen ein Referenzbild.
+// Hier nur Aufzählen, Auswerten, Auswählen und die Tabelle; plattformunabhängig.
+
+#include <stddef.h>
+#include <stdint.h>
+#include "ambilight_types.h"
+#include "ambilight_protocol.h"
+
+#define AUTOTUNE_MAX_AXIS      6     // Werte je Achse
+#define AUTOTUNE_MAX_SETTINGS  96    // Kombinationen je Lauf
+#define AUTOTUNE_MAX_FRAMES    64    // gemessene Frames je Kombination
+
+struct AutotuneSetting {
+    int xclkMhz;           // Sensor-Takt
+    int jpegQuality;       // OV2640: 0-63, kleiner = besser und größer
+    int frameWidth;        // Bildgröße (Höhe = 3/4 der Breite)
+    int frameHeight;
+    int decodeScale;       // JPEG-Skalierung der Analyse (1, 2, 4, 8)
+};
+
+// Werte einer Achse, z.B. "10,20" für xclkMhz
+struct AutotuneAxis {
+    int values[AUTOTUNE_MAX_AXIS];
+    int count;
+};
+
+struct AutotuneAxes {
+    AutotuneAxis xclkMhz;
+    AutotuneAxis jpegQuality;
+    AutotuneAxis frameWidth;
+    AutotuneAxis decodeScale;
+};
+
+struct AutotuneResult {
+    AutotuneSetting setting;
+    int frames;            // gemessene Frames
+    float fps;             // erreichbar: 1 / mittlere Durchlaufzeit (inkl. Warten auf den Frame)
+    uint32_t latencyP50Us; // Capture → Ergebnis
+    uint32_t latencyP95Us;
+    uint32_t jpegBytes;    // mittlere JPEG-Größe
+    float colorError;      // RMS je Kanal gegen die Referenz (0-255)
+};
+
+// Ziel für autotuneSelect(), 0 = keine Vorgabe
+struct AutotuneTarget {
+    uint32_t maxLatencyUs; // p95 höchstens
+    float minFps;          // mindestens
+};
+
+// Kommagetrennte Zahlenliste → axis. false = leer, zu viele Werte oder keine Zahl.
+bool autotuneParseAxis(const char* text, AutotuneAxis* axis);
+
+// Alle Kombinationen (XCLK außen, Skalierung innen) nach out, höchstens cap.
+// Liefert die Anzahl, 0 wenn eine Achse leer ist oder cap nicht reicht.
+int autotuneSettings(const AutotuneAxes& axes, AutotuneSetting* out, int cap);
+
+// Mittelt die Farben mehrerer Frames zum Referenzbild
+class AutotuneReference {
+public:
+    AutotuneReference() { reset(); }
+
+    void reset();
+    // false = andere Fensterzahl als bisher oder mehr als AMBI_MAX_RECTANGLES
+    bool add(const RGB* colors, int count);
+    int frames() const { return m_frames; }
+    // Mittelwert nach out (count Farben). Liefert count, 0 ohne Frames.
+    int finish(RGB* out) const;
+
+private:
+    uint32_t m_sum[AMBI_MAX_RECTANGLES][3];
+    int m_count;
+    int m_frames;
+};
+
+// Messung einer Kombination
+class AutotuneMeasurement {
+public:
+    AutotuneMeasurement() { begin(AutotuneSetting()); }
+
+    void begin(const AutotuneSetting& setting);
+    // busyUs = Durchlauf inkl. Warten auf den Frame, latencyUs = Capture →
+    // Ergebnis. reference darf nullptr sein (kein Farbfehler).
+    void addFrame(uint32_t busyUs, uint32_t latencyUs, uint32_t jpegBytes,
+                  const RGB* colors, const RGB* reference, int count);
+    int frames() const { return m_frames; }
+    AutotuneResult finish();
+
+private:
+    AutotuneSetting m_setting;
+    uint32_t m_latencies[AUTOTUNE_MAX_FRAMES];
+    int m_frames;
+    uint64_t m_busySumUs;
+    uint64_t m_jpegSum;
+    double m_errorSum;     // Summe der quadrierten Abweichungen
+    uint32_t m_errorCount;
+};
+
+// Bester Eintrag für target: unter denen, die das Ziel erfüllen, der mit
+// dem kleinsten Farbfehler (bei Gleichstand kleinere Latenz). Erfüllt keiner
+// das Ziel, der mit der kleinsten Latenz (maxLatencyUs gesetzt) bzw. den
+// meisten Frames/s. -1 = keine Ergebnisse.
+int autotuneSelect(const AutotuneResult* results, int count, const AutotuneTarget& target);
+
+// Ergebnistabelle als CSV (Kopfzeile + eine Zeile je Ergebnis). Wie
+// formatMetricsJson(): mit buf = nullptr nur die Länge bestimmen.
+size_t autotuneFormatCsv(char* buf, size_t cap, const AutotuneResult* results, int count);
+
+#endif // AUTOTUNE_H
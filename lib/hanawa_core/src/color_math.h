@@ -0,0 +1,57 @@
+#ifndef COLOR_MATH_H
+#define COLOR_MATH_H
+
+// Farbumrechnungen für die Reduktion (color_reduce.cpp). Alles inline, damit
+// die Pixel-Schleifen ohne Funktionsaufruf auskommen.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <math.h>
+#include "ambilight_types.h"
+
+// RGB565-Pixel aus dem Puffer von jpg2rgb565(): High-Byte zuerst
+inline uint16_t rgb565At(const uint8_t* buf, size_t idx) {
+    return (uint16_t)((buf[idx] << 8) | buf[idx + 1]);
+}
+
+// Wie rgb565At(), aber Low-Byte zuerst (so liest die v1-Firmware den Puffer)
+inline uint16_t rgb565AtLowFirst(const uint8_t* buf, size_t idx) {
+    return (uint16_t)((buf[idx + 1] << 8) | buf[idx]);
+}
+
+// RGB565 → 8 Bit pro Kanal (untere Bits bleiben 0, wie in der Firmware)
+inline uint8_t rgb565Red(uint16_t pixel)   { return ((pixel >> 11) & 0x1F) << 3; }
+inline uint8_t rgb565Green(uint16_t pixel) { return ((pixel >> 5) & 0x3F) << 2; }
+inline uint8_t rgb565Blue(uint16_t pixel)  { return (pixel & 0x1F) << 3; }
+
+// 8 Bit pro Kanal → RGB565 (Gegenstück für Testbilder und den Host-Decoder)
+inline uint16_t rgb565Pack(uint8_t r, uint8_t g, uint8_t b) {
+    return (uint16_t)(((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3));
+}
+
+// sRGB (0-255) → linear RGB (0-1), siehe sucher2/esp32cam_webserver/local_test/linear.txt
+inline float srgbToLinear(uint8_t value) {
+    float v = value / 255.0f;
+    if (v <= 0.04045f) {
+        return v / 12.92f;
+    }
+    return pow((v + 0.055f) / 1.055f, 2.4f);
+}
+
+// linear RGB (0-1) → sRGB (0-255)
+inline uint8_t linearToSrgb(float value) {
+    float v;
+    if (value <= 0.0031308f) {
+        v = value * 12.92f;
+    } else {
+        v = 1.055f * pow(value, 1.0f / 2.4f) - 0.055f;
+    }
+    return (uint8_t)round(v * 255.0f);
+}
+
+// Helligkeit (Luminanz nach ITU-R BT.601), Ganzzahl wie in der v1-Firmware
+inline uint8_t rgbLuminance(const RGB& c) {
+    return (uint8_t)((c.r * 299 + c.g * 587 + c.b * 114) / 1000);
+}
+
+#endif // COLOR_MATH_H
@@ -0,0 +1,114 @@
+#include "color_recording.h"
+#include <string.h>
+
+// ============================================================================
+// HILFSFUNKTIONEN
+// ============================================================================
+
+static void putLe(uint8_t* out, uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; i++) {
+        out[i] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+static uint64_t getLe(const uint8_t* in, int bytes) {
+    uint64_t value = 0;
+    for (int i = 0; i < bytes; i++) {
+        value |= (uint64_t)in[i] << (8 * i);
+    }
+    return value;
+}
+
+// ============================================================================
+// SCHREIBEN
+// ============================================================================
+
+size_t colorRecordingWriteFileHeader(uint8_t out[COLOR_RECORDING_FILE_HEADER]) {
+    memcpy(out, COLOR_RECORDING_MAGIC, 4);
+    putLe(out + 4, COLOR_RECORDING_VERSION, 2);
+    putLe(out + 6, 0, 2);   // flags, noch keine
+    return COLOR_RECORDING_FILE_HEADER;
+}
+
+size_t colorRecordingWriteFrameHeader(uint8_t out[COLOR_RECORDING_FRAME_HEADER], const ColorRecordingFrameHeader& header) {
+    putLe(out, header.sequence, 4);
+    putLe(out + 4, (uint64_t)header.captureUs, 8);
+    putLe(out + 12, header.geometryId, 4);
+    out[16] = header.hSeg;
+    out[17] = header.vSeg;
+    putLe(out + 18, header.rectCount, 2);
+    return COLOR_RECORDING_FRAME_HEADER;
+}
+
+size_t colorRecordingWriteFrame(uint8_t* out, size_t cap, uint32_t sequence, int64_t captureUs,
+                                uint32_t geometryId, int hSeg, int vSeg, const AmbilightSides& sides) {
+    int rectCount = ambilightRectCount(hSeg, vSeg);
+    if (hSeg < 2 || vSeg < 2 || hSeg > 255 || vSeg > 255 || rectCount > AMBI_MAX_RECTANGLES ||
+        sides.topCount + sides.rightCount + sides.bottomCount + sides.leftCount != rectCount) {
+        return 0;
+    }
+    size_t len = COLOR_RECORDING_FRAME_HEADER + (size_t)rectCount * 3;
+    if (len > cap) {
+        return 0;
+    }
+
+    ColorRecordingFrameHeader header = { sequence, captureUs, geometryId,
+                                         (uint8_t)hSeg, (uint8_t)vSeg, (uint16_t)rectCount };
+    colorRecordingWriteFrameHeader(out, header);
+    uint8_t* rgb = out + COLOR_RECORDING_FRAME_HEADER;
+    for (int k = 0; k < rectCount; k++) {
+        RGB color = ambilightClockwiseColor(sides, k);
+        rgb[k * 3] = color.r;
+        rgb[k * 3 + 1] = color.g;
+        rgb[k * 3 + 2] = color.b;
+    }
+    return len;
+}
+
+// ============================================================================
+// LESEN
+// ============================================================================
+
+bool colorRecordingParseFileHeader(const uint8_t* in, size_t len) {
+    return len >= COLOR_RECORDING_FILE_HEADER &&
+           memcmp(in, COLOR_RECORDING_MAGIC, 4) == 0 &&
+           getLe(in + 4, 2) == COLOR_RECORDING_VERSION;
+}
+
+bool colorRecordingParseFrameHeader(const uint8_t* in, size_t len, ColorRecordingFrameHeader* header) {
+    if (len < COLOR_RECORDING_FRAME_HEADER) {
+        return false;
+    }
+    header->sequence = (uint32_t)getLe(in, 4);
+    header->captureUs = (int64_t)getLe(in + 4, 8);
+    header->geometryId = (uint32_t)getLe(in + 12, 4);
+    header->hSeg = in[16];
+    header->vSeg = in[17];
+    header->rectCount = (uint16_t)getLe(in + 18, 2);
+    return header->hSeg >= 2 && header->vSeg >= 2 &&
+           header->rectCount == ambilightRectCount(header->hSeg, header->vSeg) &&
+           header->rectCount <= AMBI_MAX_RECTANGLES;
+}
+
+AmbilightSides colorRecordingSides(const ColorRecordingFrameHeader& header, const uint8_t* rgb, RGB* scratch) {
+    int h = header.hSeg;
+    int v = header.vSeg - 2;
+    RGB* top = scratch;
+    RGB* right = top + h;
+    RGB* bottom = right + v;
+    RGB* left = bottom + h;
+    for (int k = 0; k < header.rectCount; k++) {
+        RGB color = { rgb[k * 3], rgb[k * 3 + 1], rgb[k * 3 + 2] };
+        if (k < h) {
+            top[k] = color;
+        } else if (k < h + v) {
+            right[k - h] = color;
+        } else if (k < 2 * h + v) {
+            bottom[2 * h + v - 1 - k] = color;      // rückwärts wie im Uhrzeigersinn
+        } else {
+            left[header.rectCount - 1 - k] = color;
+        }
+    }
+    AmbilightSides sides = { top, h, right, v, bottom, h, left, v };
+    return sides;
+}
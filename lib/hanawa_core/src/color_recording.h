@@ -0,0 +1,54 @@
+#ifndef COLOR_RECORDING_H
+#define COLOR_RECORDING_H
+
+// Farb-Log (.hcol): veröffentlichte Ergebnisse so, wie sie an die Leuchter
+// gehen. Geschrieben vom Gerät (/api/record, color_recorder.cpp in sucher2)
+// und von replay auf dem Rechner, abgespielt von colorplay (host/).
+//
+// Datei:  "HCOL" | version (u16) | flags (u16)
+// Frame:  sequence (u32) | captureUs (u64) | geometryId (u32) |
+//         hSeg (u8) | vSeg (u8) | rectCount (u16) | RGB (rectCount * 3 Bytes)
+//
+// Alle Zahlen little endian, RGB im Uhrzeigersinn wie ambilightClockwiseColor().
+// Wie bei frame_recording.h steht die Frame-Anzahl nirgends, gelesen wird
+// bis Dateiende, ein abgeschnittener letzter Frame wird verworfen.
+
+#include <stddef.h>
+#include <stdint.h>
+#include "ambilight_protocol.h"
+
+#define COLOR_RECORDING_MAGIC     "HCOL"
+#define COLOR_RECORDING_VERSION   1
+#define COLOR_RECORDING_FILE_HEADER  8
+#define COLOR_RECORDING_FRAME_HEADER 20
+#define COLOR_RECORDING_MAX_FRAME (COLOR_RECORDING_FRAME_HEADER + AMBI_MAX_RECTANGLES * 3)
+
+struct ColorRecordingFrameHeader {
+    uint32_t sequence;     // AmbilightResult::sequence
+    int64_t captureUs;     // Capture-Zeitpunkt (Sender-Uhr)
+    uint32_t geometryId;   // ändert sich mit den Fenstern (Gerät: AmbilightConfig::version)
+    uint8_t hSeg;
+    uint8_t vSeg;
+    uint16_t rectCount;    // = ambilightRectCount(hSeg, vSeg)
+};
+
+// Schreiben: liefern die Anzahl geschriebener Bytes
+size_t colorRecordingWriteFileHeader(uint8_t out[COLOR_RECORDING_FILE_HEADER]);
+size_t colorRecordingWriteFrameHeader(uint8_t out[COLOR_RECORDING_FRAME_HEADER], const ColorRecordingFrameHeader& header);
+
+// Header und Farben eines Ergebnisses nach out (höchstens cap Bytes).
+// Liefert die Länge des Frames, 0 wenn er nicht passt oder ungültig ist.
+size_t colorRecordingWriteFrame(uint8_t* out, size_t cap, uint32_t sequence, int64_t captureUs,
+                                uint32_t geometryId, int hSeg, int vSeg, const AmbilightSides& sides);
+
+// Lesen: false = kein gültiger Header (Kennung/Version, rectCount passt
+// nicht zu hSeg/vSeg oder nicht ins Protokoll)
+bool colorRecordingParseFileHeader(const uint8_t* in, size_t len);
+bool colorRecordingParseFrameHeader(const uint8_t* in, size_t len, ColorRecordingFrameHeader* header);
+
+// Teilt die Farben eines Frames (Uhrzeigersinn) wieder in die Seiten auf,
+// wie AmbilightFrameEncoder::encode() sie erwartet. scratch fasst rectCount
+// Farben und muss leben, solange die Seiten verwendet werden.
+AmbilightSides colorRecordingSides(const ColorRecordingFrameHeader& header, const uint8_t* rgb, RGB* scratch);
+
+#endif // COLOR_RECORDING_H
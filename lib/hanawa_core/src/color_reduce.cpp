@@ -0,0 +1,174 @@
+#include "color_reduce.h"
+#include <math.h>
+#include "color_math.h"
+
+// ============================================================================
+// HILFSFUNKTIONEN
+// ============================================================================
+
+static inline int clampInt(int value, int lo, int hi) {
+    return value < lo ? lo : (value > hi ? hi : value);
+}
+
+// Begrenzt das Rechteck auf das Bild; false = nichts übrig
+static bool clipRect(int width, int height, int& x1, int& y1, int& x2, int& y2) {
+    x1 = clampInt(x1, 0, width - 1);
+    x2 = clampInt(x2, 0, width - 1);
+    y1 = clampInt(y1, 0, height - 1);
+    y2 = clampInt(y2, 0, height - 1);
+    return x1 < x2 && y1 < y2;
+}
+
+// ============================================================================
+// REDUKTION
+// ============================================================================
+
+RGB calculateMeanRGB(const uint8_t* rgb_buf, int width, int height, int x1, int y1, int x2, int y2) {
+    if (!rgb_buf || !clipRect(width, height, x1, y1, x2, y2)) {
+        return {0, 0, 0};
+    }
+
+    // Sampling mit step=2 wie im Original
+    const int step = 2;
+    uint32_t sumR = 0, sumG = 0, sumB = 0;
+    int pixelCount = 0;
+
+    for (int y = y1; y < y2; y += step) {
+        for (int x = x1; x < x2; x += step) {
+            uint16_t pixel = rgb565At(rgb_buf, (size_t)(y * width + x) * 2);
+            uint8_t r = rgb565Red(pixel);
+            uint8_t g = rgb565Green(pixel);
+            uint8_t b = rgb565Blue(pixel);
+
+            // Quadratischer Mittelwert wie in Python
+            sumR += (uint32_t)r * r;
+            sumG += (uint32_t)g * g;
+            sumB += (uint32_t)b * b;
+            pixelCount++;
+        }
+    }
+
+    if (pixelCount == 0) {
+        return {128, 128, 128}; // Grau als Fallback
+    }
+
+    // Quadratische Wurzel des Durchschnitts (RMS), mit step-Korrektur
+    uint8_t r = (uint8_t)round(sqrt((float)(step * step * sumR) / pixelCount));
+    uint8_t g = (uint8_t)round(sqrt((float)(step * step * sumG) / pixelCount));
+    uint8_t b = (uint8_t)round(sqrt((float)(step * step * sumB) / pixelCount));
+
+    return {r, g, b};
+}
+
+RGB calculateMeanRGB2(const uint8_t* rgb_buf, int width, int height, int x1, int y1, int x2, int y2) {
+    if (!rgb_buf || !clipRect(width, height, x1, y1, x2, y2)) {
+        return {0, 0, 0};
+    }
+
+    // Sampling mit step=2
+    const int step = 2;
+    float sumLinearR = 0, sumLinearG = 0, sumLinearB = 0;
+    int pixelCount = 0;
+
+    for (int y = y1; y < y2; y += step) {
+        for (int x = x1; x < x2; x += step) {
+            uint16_t pixel = rgb565At(rgb_buf, (size_t)(y * width + x) * 2);
+
+            // Konvertiere zu linear und summiere
+            sumLinearR += srgbToLinear(rgb565Red(pixel));
+            sumLinearG += srgbToLinear(rgb565Green(pixel));
+            sumLinearB += srgbToLinear(rgb565Blue(pixel));
+            pixelCount++;
+        }
+    }
+
+    if (pixelCount == 0) {
+        return {128, 128, 128};
+    }
+
+    // Mittelwert im linearen Raum, zurück nach sRGB
+    return {
+        linearToSrgb(sumLinearR / pixelCount),
+        linearToSrgb(sumLinearG / pixelCount),
+        linearToSrgb(sumLinearB / pixelCount)
+    };
+}
+
+RGB calculateSegmentRms(const uint8_t* buffer, int width, int height, int x1, int y1, int x2, int y2) {
+    uint32_t totalR2 = 0, totalG2 = 0, totalB2 = 0;
+    int pixelCount = 0;
+
+    int xa = x1 < x2 ? x1 : x2;
+    int xb = x1 < x2 ? x2 : x1;
+    int ya = y1 < y2 ? y1 : y2;
+    int yb = y1 < y2 ? y2 : y1;
+
+    for (int y = ya; y <= yb; y++) {
+        for (int x = xa; x <= xb; x++) {
+            if (x >= 0 && x < width && y >= 0 && y < height) {
+                uint16_t pixel = rgb565AtLowFirst(buffer, (size_t)(y * width + x) * 2);
+                uint8_t r = rgb565Red(pixel);
+                uint8_t g = rgb565Green(pixel);
+                uint8_t b = rgb565Blue(pixel);
+
+                // RMS-Berechnung: Quadriere die Werte
+                totalR2 += r * r;
+                totalG2 += g * g;
+                totalB2 += b * b;
+                pixelCount++;
+            }
+        }
+    }
+
+    if (pixelCount == 0) {
+        return {0, 0, 0};
+    }
+
+    // RMS: Wurzel aus dem (ganzzahligen) Durchschnitt der Quadrate
+    return {
+        (uint8_t)sqrt(totalR2 / pixelCount),
+        (uint8_t)sqrt(totalG2 / pixelCount),
+        (uint8_t)sqrt(totalB2 / pixelCount)
+    };
+}
+
+// ============================================================================
+// AUFTEILUNG
+// ============================================================================
+
+void calculateMeanRGB2Rects(const uint8_t* rgb_buf, int width, int height,
+                            const WindowRect* rects, int count, RGB* out) {
+    for (int i = 0; i < count; i++) {
+        const WindowRect& r = rects[i];
+        out[i] = calculateMeanRGB2(rgb_buf, width, height, r.x1, r.y1, r.x2, r.y2);
+    }
+}
+
+static int64_t clippedArea(const WindowRect& r, int width, int height) {
+    int x1 = r.x1, y1 = r.y1, x2 = r.x2, y2 = r.y2;
+    if (!clipRect(width, height, x1, y1, x2, y2)) {
+        return 0;
+    }
+    return (int64_t)(x2 - x1) * (y2 - y1);
+}
+
+int splitRectsByArea(const WindowRect* rects, int count, int width, int height) {
+    int64_t total = 0;
+    for (int i = 0; i < count; i++) {
+        total += clippedArea(rects[i], width, height);
+    }
+
+    // Erster Index, ab dem die vordere Hälfte mindestens so groß ist wie die
+    // hintere; dann den der beiden Nachbarn nehmen, der besser ausgleicht
+    int64_t prefix = 0;
+    for (int i = 0; i < count; i++) {
+        int64_t next = prefix + clippedArea(rects[i], width, height);
+        if (2 * next >= total) {
+            int64_t before = total - 2 * prefix;   // Überhang hinten ohne rects[i]
+            int64_t after = 2 * next - total;      // Überhang vorne mit rects[i]
+            return after <= before ? i + 1 : i;
+        }
+        prefix = next;
+    }
+    return count;
+}
@@ -0,0 +1,33 @@
+#ifndef COLOR_REDUCE_H
+#define COLOR_REDUCE_H
+
+// Reduktion eines Rechtecks im RGB565-Puffer auf eine Farbe. Der Puffer
+// kommt auf dem Gerät von jpg2rgb565(), im Host-Build vom Benchmark oder
+// einem Test (width * height * 2 Bytes).
+
+#include <stdint.h>
+#include "ambilight_types.h"
+
+// Quadratischer Mittelwert (RMS), jedes zweite Pixel in x und y.
+// Entspricht mean_bgr() aus ambivios.py. Ecken halboffen: [x1, x2) × [y1, y2).
+RGB calculateMeanRGB(const uint8_t* rgb_buf, int width, int height, int x1, int y1, int x2, int y2);
+
+// Mittelwert im linearen Farbraum (sRGB → linear → sRGB), jedes zweite Pixel.
+// Visuell korrekt, siehe linear.txt; wird von der sucher2-Firmware verwendet.
+RGB calculateMeanRGB2(const uint8_t* rgb_buf, int width, int height, int x1, int y1, int x2, int y2);
+
+// RMS über alle Pixel wie analyzeSegment() der v1-Firmware: Ecken
+// eingeschlossen und in beliebiger Reihenfolge, Pixel außerhalb des Bildes
+// werden übersprungen, Low-Byte zuerst gelesen.
+RGB calculateSegmentRms(const uint8_t* buffer, int width, int height, int x1, int y1, int x2, int y2);
+
+// calculateMeanRGB2() für count Rechtecke hintereinander, Farben nach out
+void calculateMeanRGB2Rects(const uint8_t* rgb_buf, int width, int height,
+                            const WindowRect* rects, int count, RGB* out);
+
+// Teilt rects in zwei zusammenhängende Bereiche [0, split) und [split, count)
+// mit möglichst gleich vielen Pixeln (auf das Bild begrenzt), z.B. für die
+// Reduktion auf zwei Kernen. Liefert split (0..count).
+int splitRectsByArea(const WindowRect* rects, int count, int width, int height);
+
+#endif // COLOR_REDUCE_H
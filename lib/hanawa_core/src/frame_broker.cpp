@@ -0,0 +1,246 @@
+// Nur auf dem ESP32: der Host-Build (CMake) übersetzt die Datei leer
+#ifdef ESP_PLATFORM
+
+#include "frame_broker.h"
+#include <stdio.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#define FRAME_BROKER_RETRY_MS  10   // Pause nach esp_camera_fb_get() ohne Frame
+
+// ============================================================================
+// STATE
+// ============================================================================
+
+struct FrameConsumer {
+    const char* name;
+    SemaphoreHandle_t ready;   // vom Capture-Task gegeben, wenn mailbox gefüllt ist
+    bool waiting;              // wartet in acquireFrame()
+    camera_fb_t* mailbox;      // zugestellter, noch nicht abgeholter Frame
+};
+
+struct FrameSlot {
+    camera_fb_t* fb;           // nullptr = frei
+    int refs;
+};
+
+static TaskHandle_t s_captureTask = nullptr;
+
+// Schützt Verbraucher und Slots
+static SemaphoreHandle_t s_lock = nullptr;
+
+static FrameConsumer s_consumers[FRAME_BROKER_MAX_CONSUMERS];
+static int s_consumerCount = 0;
+static FrameSlot s_slots[FRAME_BROKER_MAX_FRAMES];
+
+static volatile FrameBrokerStats s_stats = {0, 0, 0, 0, 0, 0};
+static FrameBrokerHooks s_hooks = { nullptr, nullptr, nullptr };
+
+static void report(bool error, const char* message) {
+    if (s_hooks.log) {
+        s_hooks.log(error, message);
+    }
+}
+
+// ============================================================================
+// CAPTURE-TASK
+// ============================================================================
+
+// Aufrufer hält s_lock
+static bool anyWaitingLocked() {
+    for (int i = 0; i < s_consumerCount; i++) {
+        if (s_consumers[i].waiting && !s_consumers[i].mailbox) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Stellt fb allen wartenden Verbrauchern zu, liefert die Zahl der Referenzen
+static int deliver(camera_fb_t* fb) {
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    FrameSlot* slot = nullptr;
+    for (int i = 0; i < FRAME_BROKER_MAX_FRAMES; i++) {
+        if (!s_slots[i].fb) {
+            slot = &s_slots[i];
+            break;
+        }
+    }
+    int refs = 0;
+    if (slot) {
+        for (int i = 0; i < s_consumerCount; i++) {
+            FrameConsumer& c = s_consumers[i];
+            if (c.waiting && !c.mailbox) {
+                c.mailbox = fb;
+                refs++;
+                xSemaphoreGive(c.ready);
+            }
+        }
+        if (refs > 0) {
+            slot->fb = fb;
+            slot->refs = refs;
+            s_stats.framesInUse++;
+        }
+    }
+    xSemaphoreGive(s_lock);
+
+    if (!slot) {
+        report(true, "Kein freier Frame-Slot, FRAME_BROKER_MAX_FRAMES erhöhen");
+    }
+    return refs;
+}
+
+static void captureTask(void* arg) {
+    for (;;) {
+        xSemaphoreTake(s_lock, portMAX_DELAY);
+        bool waiting = anyWaitingLocked();
+        xSemaphoreGive(s_lock);
+        if (!waiting) {
+            // Schlafen, bis acquireFrame() weckt
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            continue;
+        }
+
+        int64_t begin = s_hooks.captureBegin ? s_hooks.captureBegin() : 0;
+        camera_fb_t* fb = esp_camera_fb_get();
+        if (s_hooks.captureEnd) {
+            s_hooks.captureEnd(begin);
+        }
+        if (!fb) {
+            s_stats.captureErrors++;
+            vTaskDelay(pdMS_TO_TICKS(FRAME_BROKER_RETRY_MS));
+            continue;
+        }
+        s_stats.framesCaptured++;
+
+        int refs = deliver(fb);
+        if (refs == 0) {
+            // Verbraucher hat inzwischen aufgegeben
+            esp_camera_fb_return(fb);
+            continue;
+        }
+        s_stats.deliveries += refs;
+        if (refs > 1) {
+            s_stats.framesShared++;
+        }
+    }
+}
+
+// ============================================================================
+// API
+// ============================================================================
+
+void setFrameBrokerHooks(const FrameBrokerHooks& hooks) {
+    s_hooks = hooks;
+}
+
+bool initFrameBroker() {
+    s_lock = xSemaphoreCreateMutex();
+    if (!s_lock) {
+        report(true, "Mutex konnte nicht erstellt werden");
+        return false;
+    }
+    if (xTaskCreatePinnedToCore(captureTask, "capture", 4096, nullptr, FRAME_BROKER_TASK_PRIORITY,
+                                &s_captureTask, FRAME_BROKER_TASK_CORE) != pdPASS) {
+        report(true, "Capture-Task konnte nicht gestartet werden");
+        return false;
+    }
+    report(false, "Capture-Task gestartet");
+    return true;
+}
+
+int registerFrameConsumer(const char* name) {
+    if (!s_lock) {
+        report(true, "initFrameBroker() wurde nicht aufgerufen");
+        return -1;
+    }
+    SemaphoreHandle_t ready = xSemaphoreCreateBinary();
+    if (!ready) {
+        return -1;
+    }
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    int id = -1;
+    if (s_consumerCount < FRAME_BROKER_MAX_CONSUMERS) {
+        id = s_consumerCount++;
+        s_consumers[id].name = name;
+        s_consumers[id].ready = ready;
+        s_consumers[id].waiting = false;
+        s_consumers[id].mailbox = nullptr;
+    }
+    xSemaphoreGive(s_lock);
+
+    char message[80];
+    if (id < 0) {
+        vSemaphoreDelete(ready);
+        snprintf(message, sizeof(message), "Kein Platz für Verbraucher '%s'", name);
+    } else {
+        snprintf(message, sizeof(message), "Verbraucher '%s' angemeldet (ID %d)", name, id);
+    }
+    report(id < 0, message);
+    return id;
+}
+
+camera_fb_t* acquireFrame(int consumer, uint32_t timeoutMs) {
+    if (consumer < 0 || consumer >= s_consumerCount) {
+        return nullptr;
+    }
+    FrameConsumer& c = s_consumers[consumer];
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    c.waiting = true;
+    xSemaphoreGive(s_lock);
+    xTaskNotifyGive(s_captureTask);
+
+    xSemaphoreTake(c.ready, pdMS_TO_TICKS(timeoutMs));
+
+    // Auch nach einem Timeout abholen, was inzwischen zugestellt wurde
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    camera_fb_t* fb = c.mailbox;
+    c.mailbox = nullptr;
+    c.waiting = false;
+    xSemaphoreGive(s_lock);
+    xSemaphoreTake(c.ready, 0);   // verspätetes Signal verwerfen
+
+    if (!fb) {
+        s_stats.waitTimeouts++;
+    }
+    return fb;
+}
+
+void releaseFrame(camera_fb_t* fb) {
+    if (!fb) {
+        return;
+    }
+    bool last = false;
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    for (int i = 0; i < FRAME_BROKER_MAX_FRAMES; i++) {
+        if (s_slots[i].fb == fb) {
+            if (--s_slots[i].refs == 0) {
+                s_slots[i].fb = nullptr;
+                s_stats.framesInUse--;
+                last = true;
+            }
+            break;
+        }
+    }
+    xSemaphoreGive(s_lock);
+
+    if (last) {
+        esp_camera_fb_return(fb);
+    }
+}
+
+FrameBrokerStats getFrameBrokerStats() {
+    FrameBrokerStats copy;
+    copy.framesCaptured = s_stats.framesCaptured;
+    copy.framesShared = s_stats.framesShared;
+    copy.deliveries = s_stats.deliveries;
+    copy.captureErrors = s_stats.captureErrors;
+    copy.waitTimeouts = s_stats.waitTimeouts;
+    copy.framesInUse = s_stats.framesInUse;
+    return copy;
+}
+
+#endif // ESP_PLATFORM
@@ -0,0 +1,60 @@
+#ifndef FRAME_BROKER_H
+#define FRAME_BROKER_H
+
+#include <stdint.h>
+#include "esp_camera.h"
+
+// Zentrale Frame-Verteilung: nur der Capture-Task ruft esp_camera_fb_get()
+// auf. Jeder Verbraucher (Analyse, Snapshot, Stream, Recorder, ...) meldet
+// sich einmal an und holt sich Frames in seinem eigenen Takt. Warten mehrere
+// Verbraucher gleichzeitig, bekommen alle denselben Frame (Referenzzähler);
+// der Puffer geht zurück an den Treiber, sobald die letzte Referenz
+// freigegeben ist. Ohne wartenden Verbraucher wird nichts aufgenommen.
+//
+// Gemeinsam für beide Firmwares, nur auf dem ESP32 (FreeRTOS). Meldungen und
+// Zeitleiste gehen über FrameBrokerHooks an die jeweilige Firmware.
+#define FRAME_BROKER_MAX_CONSUMERS  6
+#define FRAME_BROKER_MAX_FRAMES     4      // gleichzeitig ausgegebene Frames (>= fb_count)
+#define FRAME_BROKER_TASK_CORE      0
+#define FRAME_BROKER_TASK_PRIORITY  2      // über Stream/Live-Server, Aufnahme kurz halten
+
+struct FrameBrokerStats {
+    uint32_t framesCaptured;   // esp_camera_fb_get() erfolgreich
+    uint32_t framesShared;     // Frames, die an mehr als einen Verbraucher gingen
+    uint32_t deliveries;       // ausgegebene Referenzen
+    uint32_t captureErrors;    // esp_camera_fb_get() ohne Frame
+    uint32_t waitTimeouts;     // acquireFrame() ohne Frame zurückgekehrt
+    uint32_t framesInUse;      // aktuell nicht an den Treiber zurückgegeben
+};
+
+// Anbindung an die Firmware, jeder Eintrag darf nullptr sein
+struct FrameBrokerHooks {
+    // Meldung beim Start, Anmelden und bei fehlenden Slots (ohne Präfix/Zeilenende)
+    void (*log)(bool error, const char* message);
+    // Um jedes esp_camera_fb_get() im Capture-Task, z.B. für die Zeitleiste;
+    // der Rückgabewert von captureBegin geht an captureEnd
+    int64_t (*captureBegin)();
+    void (*captureEnd)(int64_t begin);
+};
+
+// Vor initFrameBroker() aufrufen
+void setFrameBrokerHooks(const FrameBrokerHooks& hooks);
+
+// Startet den Capture-Task. Nach esp_camera_init() und vor allen
+// Verbrauchern aufrufen.
+bool initFrameBroker();
+
+// Meldet einen Verbraucher an. Liefert die ID für acquireFrame(), -1 = voll.
+int registerFrameConsumer(const char* name);
+
+// Wartet auf den nächsten aufgenommenen Frame (höchstens timeoutMs).
+// nullptr = Timeout. Jeder Frame muss mit releaseFrame() zurückgegeben werden;
+// ein Verbraucher hält höchstens einen Frame gleichzeitig.
+camera_fb_t* acquireFrame(int consumer, uint32_t timeoutMs);
+
+// Gibt eine Referenz frei; die letzte gibt den Puffer an den Treiber zurück
+void releaseFrame(camera_fb_t* fb);
+
+FrameBrokerStats getFrameBrokerStats();
+
+#endif // FRAME_BROKER_H
@@ -0,0 +1,60 @@
+#include "frame_recording.h"
+#include <string.h>
+
+// ============================================================================
+// HILFSFUNKTIONEN
+// ============================================================================
+
+static void putLe(uint8_t* out, uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; i++) {
+        out[i] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+static uint64_t getLe(const uint8_t* in, int bytes) {
+    uint64_t value = 0;
+    for (int i = 0; i < bytes; i++) {
+        value |= (uint64_t)in[i] << (8 * i);
+    }
+    return value;
+}
+
+// ============================================================================
+// SCHREIBEN
+// ============================================================================
+
+size_t recordingWriteFileHeader(uint8_t out[RECORDING_FILE_HEADER]) {
+    memcpy(out, RECORDING_MAGIC, 4);
+    putLe(out + 4, RECORDING_VERSION, 2);
+    putLe(out + 6, 0, 2);   // flags, noch keine
+    return RECORDING_FILE_HEADER;
+}
+
+size_t recordingWriteFrameHeader(uint8_t out[RECORDING_FRAME_HEADER], const RecordingFrameHeader& header) {
+    putLe(out, (uint64_t)header.captureUs, 8);
+    putLe(out + 8, header.len, 4);
+    putLe(out + 12, header.width, 2);
+    putLe(out + 14, header.height, 2);
+    return RECORDING_FRAME_HEADER;
+}
+
+// ============================================================================
+// LESEN
+// ============================================================================
+
+bool recordingParseFileHeader(const uint8_t* in, size_t len) {
+    return len >= RECORDING_FILE_HEADER &&
+           memcmp(in, RECORDING_MAGIC, 4) == 0 &&
+           getLe(in + 4, 2) == RECORDING_VERSION;
+}
+
+bool recordingParseFrameHeader(const uint8_t* in, size_t len, RecordingFrameHeader* header) {
+    if (len < RECORDING_FRAME_HEADER) {
+        return false;
+    }
+    header->captureUs = (int64_t)getLe(in, 8);
+    header->len = (uint32_t)getLe(in + 8, 4);
+    header->width = (uint16_t)getLe(in + 12, 2);
+    header->height = (uint16_t)getLe(in + 14, 2);
+    return header->len > 0 && header->len <= RECORDING_MAX_FRAME;
+}
@@ -0,0 +1,39 @@
+#ifndef FRAME_RECORDING_H
+#define FRAME_RECORDING_H
+
+// Aufnahme-Container (.hrec) für Kamera-Frames mit Zeitstempel. Geschrieben
+// vom Gerät (http://<ip>:82/record, stream_server.cpp), gelesen von der
+// virtuellen Kamera im Host-Build (host/virtual_camera.cpp).
+//
+// Datei:  "HREC" | version (u16) | flags (u16)
+// Frame:  captureUs (u64) | len (u32) | width (u16) | height (u16) | JPEG (len Bytes)
+//
+// Alle Zahlen little endian. Die Frame-Anzahl steht nirgends: gelesen wird
+// bis Dateiende, damit das Gerät ohne Puffer direkt auf den Socket schreiben
+// kann. Ein abgeschnittener letzter Frame wird verworfen.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define RECORDING_MAGIC          "HREC"
+#define RECORDING_VERSION        1
+#define RECORDING_FILE_HEADER    8
+#define RECORDING_FRAME_HEADER   16
+#define RECORDING_MAX_FRAME      (512 * 1024)   // Plausibilitätsgrenze für len
+
+struct RecordingFrameHeader {
+    int64_t captureUs;     // fb->timestamp in µs (esp_timer-Basis des Geräts)
+    uint32_t len;          // Länge des JPEG
+    uint16_t width;
+    uint16_t height;
+};
+
+// Schreiben: liefern die Anzahl geschriebener Bytes
+size_t recordingWriteFileHeader(uint8_t out[RECORDING_FILE_HEADER]);
+size_t recordingWriteFrameHeader(uint8_t out[RECORDING_FRAME_HEADER], const RecordingFrameHeader& header);
+
+// Lesen: false = kein gültiger Header (falsche Kennung/Version, unplausible Länge)
+bool recordingParseFileHeader(const uint8_t* in, size_t len);
+bool recordingParseFrameHeader(const uint8_t* in, size_t len, RecordingFrameHeader* header);
+
+#endif // FRAME_RECORDING_H
@@ -0,0 +1,158 @@
+#include "sensor_window.h"
+#include <math.h>
+
+// ============================================================================
+// HILFSFUNKTIONEN
+// ============================================================================
+
+static void modeSize(int mode, int* width, int* height) {
+    if (mode == OV2640_MODE_SVGA) {
+        *width = OV2640_SVGA_WIDTH;
+        *height = OV2640_SVGA_HEIGHT;
+    } else {
+        *width = OV2640_UXGA_WIDTH;
+        *height = OV2640_UXGA_HEIGHT;
+    }
+}
+
+static int alignUp(int value) {
+    return (value + OV2640_WINDOW_ALIGN - 1) / OV2640_WINDOW_ALIGN * OV2640_WINDOW_ALIGN;
+}
+
+static float clamp01(float value) {
+    return value < 0 ? 0 : (value > 1 ? 1 : value);
+}
+
+// Eine Achse: [lo, hi] (normiert) in Pixeln des Modus, auf 4 ausgerichtet,
+// mindestens output groß, gleichmäßig nach beiden Seiten erweitert
+static void planAxis(float lo, float hi, int size, int output, int* offset, int* length) {
+    int start = (int)floorf(lo * size);
+    int end = (int)ceilf(hi * size);
+    int len = alignUp(end - start);
+    if (len < output) {
+        len = output;
+    }
+    if (len > size) {
+        len = size;
+    }
+    start -= (len - (end - start)) / 2;
+    if (start + len > size) {
+        start = size - len;
+    }
+    if (start < 0) {
+        start = 0;
+    }
+    *offset = start;
+    *length = len;
+}
+
+// ============================================================================
+// AUSSCHNITT
+// ============================================================================
+
+SensorWindow planSensorWindow(const float normalized[4][2], float margin, int outputWidth, int outputHeight) {
+    float x0 = 1, y0 = 1, x1 = 0, y1 = 0;
+    for (int i = 0; i < 4; i++) {
+        x0 = fminf(x0, normalized[i][0]);
+        x1 = fmaxf(x1, normalized[i][0]);
+        y0 = fminf(y0, normalized[i][1]);
+        y1 = fmaxf(y1, normalized[i][1]);
+    }
+    x0 = clamp01(x0 - margin);
+    y0 = clamp01(y0 - margin);
+    x1 = clamp01(x1 + margin);
+    y1 = clamp01(y1 + margin);
+
+    SensorWindow window;
+    window.outputWidth = outputWidth / OV2640_WINDOW_ALIGN * OV2640_WINDOW_ALIGN;
+    window.outputHeight = outputHeight / OV2640_WINDOW_ALIGN * OV2640_WINDOW_ALIGN;
+    if (window.outputWidth < OV2640_WINDOW_ALIGN) {
+        window.outputWidth = OV2640_WINDOW_ALIGN;
+    }
+    if (window.outputHeight < OV2640_WINDOW_ALIGN) {
+        window.outputHeight = OV2640_WINDOW_ALIGN;
+    }
+    if (window.outputWidth > OV2640_UXGA_WIDTH) {
+        window.outputWidth = OV2640_UXGA_WIDTH;
+    }
+    if (window.outputHeight > OV2640_UXGA_HEIGHT) {
+        window.outputHeight = OV2640_UXGA_HEIGHT;
+    }
+
+    // Gebinnter Modus genügt, solange der DSP dort nur verkleinern muss
+    bool svga = (x1 - x0) * OV2640_SVGA_WIDTH >= window.outputWidth &&
+                (y1 - y0) * OV2640_SVGA_HEIGHT >= window.outputHeight;
+    window.mode = svga ? OV2640_MODE_SVGA : OV2640_MODE_UXGA;
+
+    int width, height;
+    modeSize(window.mode, &width, &height);
+    planAxis(x0, x1, width, window.outputWidth, &window.offsetX, &window.width);
+    planAxis(y0, y1, height, window.outputHeight, &window.offsetY, &window.height);
+
+    window.view[0] = (float)window.offsetX / width;
+    window.view[1] = (float)window.offsetY / height;
+    window.view[2] = (float)(window.offsetX + window.width) / width;
+    window.view[3] = (float)(window.offsetY + window.height) / height;
+    return window;
+}
+
+SensorWindow fullSensorWindow() {
+    SensorWindow window = { OV2640_MODE_SVGA, 0, 0, OV2640_SVGA_WIDTH, OV2640_SVGA_HEIGHT, 0, 0, { 0, 0, 1, 1 } };
+    return window;
+}
+
+bool sensorWindowValid(const SensorWindow& window) {
+    if (window.mode != OV2640_MODE_UXGA && window.mode != OV2640_MODE_SVGA) {
+        return false;
+    }
+    int width, height;
+    modeSize(window.mode, &width, &height);
+    const int sizes[4] = { window.width, window.height, window.outputWidth, window.outputHeight };
+    for (int size : sizes) {
+        if (size <= 0 || size % OV2640_WINDOW_ALIGN != 0) {
+            return false;
+        }
+    }
+    return window.offsetX >= 0 && window.offsetY >= 0 &&
+           window.offsetX <= OV2640_MAX_OFFSET && window.offsetY <= OV2640_MAX_OFFSET &&
+           window.offsetX + window.width <= width && window.offsetY + window.height <= height &&
+           window.outputWidth <= window.width && window.outputHeight <= window.height &&
+           window.outputWidth <= OV2640_MAX_OUTPUT_W && window.outputHeight <= OV2640_MAX_OUTPUT_H;
+}
+
+// ============================================================================
+// UMRECHNUNG
+// ============================================================================
+
+void cropCorners(const SensorWindow& window, const float in[4][2], float out[4][2]) {
+    float w = window.view[2] - window.view[0];
+    float h = window.view[3] - window.view[1];
+    for (int i = 0; i < 4; i++) {
+        out[i][0] = (in[i][0] - window.view[0]) / w;
+        out[i][1] = (in[i][1] - window.view[1]) / h;
+    }
+}
+
+void uncropCorners(const SensorWindow& window, const float in[4][2], float out[4][2]) {
+    float w = window.view[2] - window.view[0];
+    float h = window.view[3] - window.view[1];
+    for (int i = 0; i < 4; i++) {
+        out[i][0] = window.view[0] + in[i][0] * w;
+        out[i][1] = window.view[1] + in[i][1] * h;
+    }
+}
+
+// ============================================================================
+// SENSOR
+// ============================================================================
+
+bool applySensorWindow(SensorWindowPort& port, const SensorWindow& window) {
+    if (window.outputWidth == 0) {
+        return port.resetWindow();
+    }
+    if (!sensorWindowValid(window)) {
+        return false;
+    }
+    return port.setWindow(window.mode, window.offsetX, window.offsetY, window.width, window.height,
+                          window.outputWidth, window.outputHeight);
+}
@@ -0,0 +1,76 @@
+#ifndef SENSOR_WINDOW_H
+#define SENSOR_WINDOW_H
+
+// Ausschnitt auf dem Sensor (OV2640): statt des ganzen Raumes liefert die
+// Kamera nur das Rechteck um die kalibrierten TV-Ecken plus Rand, vom DSP
+// auf eine kleine Ausgabegröße skaliert. Weniger JPEG-Daten je Frame, mehr
+// Pixel auf dem Fernseher. Gerechnet wird hier, die Register setzt ein
+// SensorWindowPort (sensor_t aus esp32-camera auf dem Gerät, Mock im Test).
+//
+// Alle normierten Angaben beziehen sich auf das volle Sensorbild, wie die
+// Ecken aus buildSamplingPlan() (oben links, oben rechts, unten rechts,
+// unten links).
+
+// Sensor-Modi wie ov2640_sensor_mode_t, beide mit vollem Bildfeld
+#define OV2640_MODE_UXGA     0      // 1600x1200, bis 15 Bilder/s
+#define OV2640_MODE_SVGA     1      // 800x600 (2x2 gebinnt), bis 30 Bilder/s
+#define OV2640_UXGA_WIDTH    1600
+#define OV2640_UXGA_HEIGHT   1200
+#define OV2640_SVGA_WIDTH    800
+#define OV2640_SVGA_HEIGHT   600
+#define OV2640_WINDOW_ALIGN  4      // HSIZE/VSIZE/ZMOW/ZMOH zählen in 4er-Schritten
+#define OV2640_MAX_OFFSET    2047   // XOFF/YOFF: 11 Bit
+#define OV2640_MAX_OUTPUT_W  4092   // ZMOW: 10 Bit * 4
+#define OV2640_MAX_OUTPUT_H  2044   // ZMOH: 9 Bit * 4
+
+struct SensorWindow {
+    int mode;              // OV2640_MODE_*
+    int offsetX;           // Ausschnitt in Pixeln des Modus
+    int offsetY;
+    int width;
+    int height;
+    int outputWidth;       // nach dem DSP, so kommt das JPEG
+    int outputHeight;
+    float view[4];         // Ausschnitt normiert: x0, y0, x1, y1
+};
+
+// Ausschnitt um die normierten Ecken mit margin (Anteil am vollen Bild) Rand
+// auf jeder Seite, ausgegeben in outputWidth x outputHeight (auf Vielfache
+// von 4 abgerundet). Der DSP verkleinert nur: SVGA, solange der Ausschnitt
+// dort mindestens so groß wie die Ausgabe ist, sonst UXGA; reicht auch das
+// nicht, wird der Ausschnitt um seine Mitte auf die Ausgabegröße erweitert.
+// Die Seitenverhältnisse von Ausschnitt und Ausgabe dürfen verschieden sein.
+SensorWindow planSensorWindow(const float normalized[4][2], float margin, int outputWidth, int outputHeight);
+
+// Volles Bild ohne Ausschnitt (view = 0, 0, 1, 1, outputWidth = 0)
+SensorWindow fullSensorWindow();
+
+// true = window hält die Grenzen des OV2640 ein (Modus, Ausrichtung,
+// Registerbreiten, Ausgabe nicht größer als der Ausschnitt)
+bool sensorWindowValid(const SensorWindow& window);
+
+// Normierte Ecken des vollen Bildes → normiert auf den Ausschnitt (das
+// gelieferte JPEG), und zurück. in und out dürfen gleich sein.
+void cropCorners(const SensorWindow& window, const float in[4][2], float out[4][2]);
+void uncropCorners(const SensorWindow& window, const float in[4][2], float out[4][2]);
+
+// Zugriff auf den Sensor
+class SensorWindowPort {
+public:
+    virtual ~SensorWindowPort() {}
+
+    // Ausschnitt setzen, Parameter wie set_res_raw() des OV2640 in
+    // esp32-camera (Modus, Versatz und Größe in Pixeln des Modus,
+    // Ausgabegröße). false = Sensor hat abgelehnt.
+    virtual bool setWindow(int mode, int offsetX, int offsetY, int width, int height,
+                           int outputWidth, int outputHeight) = 0;
+
+    // Zurück auf das volle Bild in der Startauflösung
+    virtual bool resetWindow() = 0;
+};
+
+// Prüft window und setzt es über port; ein Fenster ohne Ausgabegröße
+// (fullSensorWindow()) setzt den Sensor zurück. false = ungültig oder abgelehnt.
+bool applySensorWindow(SensorWindowPort& port, const SensorWindow& window);
+
+#endif // SENSOR_WINDOW_H
@@ -0,0 +1,262 @@
+#include "stage_metrics.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef ESP_PLATFORM
+#include <esp_timer.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+static portMUX_TYPE s_metricsMux = portMUX_INITIALIZER_UNLOCKED;
+#define METRICS_LOCK()    taskENTER_CRITICAL(&s_metricsMux)
+#define METRICS_UNLOCK()  taskEXIT_CRITICAL(&s_metricsMux)
+#else
+#include <chrono>
+#include <mutex>
+static std::mutex s_metricsMutex;
+#define METRICS_LOCK()    s_metricsMutex.lock()
+#define METRICS_UNLOCK()  s_metricsMutex.unlock()
+#endif
+
+// ============================================================================
+// STATE
+// ============================================================================
+
+static const char* const STAGE_NAMES[STAGE_COUNT] = {
+    "capture_wait",
+    "jpeg_decode",
+    "geometry",
+    "reduction",
+    "reduction_core0",
+    "reduction_core1",
+    "serialize",
+    "transmit",
+    "frame_total",
+    "api_json",
+};
+
+static const uint32_t BOUNDS_US[METRICS_BOUNDS] = {
+    10, 15, 20, 30, 50, 70,
+    100, 150, 200, 300, 500, 700,
+    1000, 1500, 2000, 3000, 5000, 7000,
+    10000, 15000, 20000, 30000, 50000, 70000,
+    100000, 150000, 200000, 300000, 500000, 700000,
+    1000000, 1500000, 2000000, 3000000, 5000000, 7000000,
+};
+
+struct StageHistogram {
+    uint32_t buckets[METRICS_BUCKETS];
+    uint32_t count;
+    uint64_t sumUs;
+    uint32_t maxUs;
+};
+
+static StageHistogram s_histograms[STAGE_COUNT];
+static StageHook volatile s_stageHook = nullptr;
+
+// ============================================================================
+// ERFASSUNG
+// ============================================================================
+
+const char* metricStageName(MetricStage stage) {
+    return (stage >= 0 && stage < STAGE_COUNT) ? STAGE_NAMES[stage] : "unknown";
+}
+
+int64_t metricsNowUs() {
+#ifdef ESP_PLATFORM
+    return esp_timer_get_time();
+#else
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+static int bucketIndex(uint32_t us) {
+    // Binäre Suche nach der ersten Grenze >= us
+    int lo = 0;
+    int hi = METRICS_BOUNDS;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (BOUNDS_US[mid] < us) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;   // METRICS_BOUNDS = Überlauf
+}
+
+void recordStage(MetricStage stage, uint32_t us) {
+    if (stage < 0 || stage >= STAGE_COUNT) {
+        return;
+    }
+    int bucket = bucketIndex(us);
+    METRICS_LOCK();
+    StageHistogram& h = s_histograms[stage];
+    h.buckets[bucket]++;
+    h.count++;
+    h.sumUs += us;
+    if (us > h.maxUs) {
+        h.maxUs = us;
+    }
+    METRICS_UNLOCK();
+
+    StageHook hook = s_stageHook;
+    if (hook) {
+        hook(stage, us);
+    }
+}
+
+void setStageHook(StageHook hook) {
+    s_stageHook = hook;
+}
+
+#if defined(ALLOC_TRACKING) && ALLOC_TRACKING
+static thread_local MetricStage t_currentStage = STAGE_COUNT;
+
+MetricStage currentStage() {
+    return t_currentStage;
+}
+
+MetricStage enterStage(MetricStage stage) {
+    MetricStage previous = t_currentStage;
+    t_currentStage = stage;
+    return previous;
+}
+
+void leaveStage(MetricStage previous) {
+    t_currentStage = previous;
+}
+#endif
+
+void resetStageMetrics() {
+    METRICS_LOCK();
+    memset(s_histograms, 0, sizeof(s_histograms));
+    METRICS_UNLOCK();
+}
+
+// ============================================================================
+// AUSWERTUNG
+// ============================================================================
+
+static uint32_t percentile(const StageHistogram& h, uint32_t permille) {
+    if (h.count == 0) {
+        return 0;
+    }
+    // Rang des gesuchten Werts (1-basiert, aufgerundet)
+    uint64_t rank = ((uint64_t)h.count * permille + 999) / 1000;
+    if (rank == 0) {
+        rank = 1;
+    }
+    uint64_t seen = 0;
+    for (int i = 0; i < METRICS_BUCKETS; i++) {
+        uint32_t n = h.buckets[i];
+        if (n == 0 || seen + n < rank) {
+            seen += n;
+            continue;
+        }
+        uint32_t lower = i == 0 ? 0 : BOUNDS_US[i - 1];
+        uint32_t upper = i < METRICS_BOUNDS ? BOUNDS_US[i] : h.maxUs;
+        if (upper > h.maxUs) {
+            upper = h.maxUs;   // nie über dem gemessenen Maximum
+        }
+        if (upper < lower) {
+            return upper;
+        }
+        return lower + (uint32_t)((uint64_t)(upper - lower) * (rank - seen) / n);
+    }
+    return h.maxUs;
+}
+
+StageSummary getStageSummary(MetricStage stage) {
+    StageSummary s;
+    memset(&s, 0, sizeof(s));
+    s.name = metricStageName(stage);
+    if (stage < 0 || stage >= STAGE_COUNT) {
+        return s;
+    }
+
+    METRICS_LOCK();
+    StageHistogram h = s_histograms[stage];
+    METRICS_UNLOCK();
+
+    s.count = h.count;
+    s.sumUs = h.sumUs;
+    s.meanUs = h.count ? (uint32_t)(h.sumUs / h.count) : 0;
+    s.p50Us = percentile(h, 500);
+    s.p95Us = percentile(h, 950);
+    s.p99Us = percentile(h, 990);
+    s.maxUs = h.maxUs;
+    return s;
+}
+
+// ============================================================================
+// AUSGABE
+// ============================================================================
+
+// Hängt formatierten Text an, zählt aber auch über cap hinaus weiter
+struct TextOut {
+    char* buf;
+    size_t cap;
+    size_t len;
+};
+
+static void append(TextOut& out, const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    size_t room = out.len < out.cap ? out.cap - out.len : 0;
+    int n = vsnprintf(room ? out.buf + out.len : nullptr, room, fmt, args);
+    va_end(args);
+    if (n > 0) {
+        out.len += n;
+    }
+}
+
+size_t formatMetricsJson(char* buf, size_t cap, const MetricValue* extras, int extraCount) {
+    TextOut out = { buf, cap, 0 };
+    if (cap > 0) {
+        buf[0] = '\0';
+    }
+    append(out, "{\"stages\":{");
+    for (int i = 0; i < STAGE_COUNT; i++) {
+        StageSummary s = getStageSummary((MetricStage)i);
+        append(out, "%s\"%s\":{\"count\":%u,\"mean_us\":%u,\"p50_us\":%u,\"p95_us\":%u,\"p99_us\":%u,\"max_us\":%u}",
+               i ? "," : "", s.name, (unsigned)s.count, (unsigned)s.meanUs, (unsigned)s.p50Us,
+               (unsigned)s.p95Us, (unsigned)s.p99Us, (unsigned)s.maxUs);
+    }
+    append(out, "}");
+    for (int i = 0; i < extraCount; i++) {
+        append(out, ",\"%s\":%.0f", extras[i].name, extras[i].value);
+    }
+    append(out, "}");
+    return out.len;
+}
+
+size_t formatMetricsPrometheus(char* buf, size_t cap, const MetricValue* extras, int extraCount) {
+    TextOut out = { buf, cap, 0 };
+    if (cap > 0) {
+        buf[0] = '\0';
+    }
+    append(out, "# HELP hanawa_stage_duration_us Laufzeit je Verarbeitungsschritt in Mikrosekunden\n"
+                "# TYPE hanawa_stage_duration_us summary\n");
+    for (int i = 0; i < STAGE_COUNT; i++) {
+        StageSummary s = getStageSummary((MetricStage)i);
+        append(out, "hanawa_stage_duration_us{stage=\"%s\",quantile=\"0.5\"} %u\n", s.name, (unsigned)s.p50Us);
+        append(out, "hanawa_stage_duration_us{stage=\"%s\",quantile=\"0.95\"} %u\n", s.name, (unsigned)s.p95Us);
+        append(out, "hanawa_stage_duration_us{stage=\"%s\",quantile=\"0.99\"} %u\n", s.name, (unsigned)s.p99Us);
+        append(out, "hanawa_stage_duration_us_sum{stage=\"%s\"} %llu\n", s.name, (unsigned long long)s.sumUs);
+        append(out, "hanawa_stage_duration_us_count{stage=\"%s\"} %u\n", s.name, (unsigned)s.count);
+    }
+    append(out, "# HELP hanawa_stage_duration_max_us Längste Laufzeit je Verarbeitungsschritt\n"
+                "# TYPE hanawa_stage_duration_max_us gauge\n");
+    for (int i = 0; i < STAGE_COUNT; i++) {
+        StageSummary s = getStageSummary((MetricStage)i);
+        append(out, "hanawa_stage_duration_max_us{stage=\"%s\"} %u\n", s.name, (unsigned)s.maxUs);
+    }
+    for (int i = 0; i < extraCount; i++) {
+        const MetricValue& m = extras[i];
+        append(out, "# HELP hanawa_%s %s\n# TYPE hanawa_%s %s\nhanawa_%s %.0f\n",
+               m.name, m.help, m.name, m.counter ? "counter" : "gauge", m.name, m.value);
+    }
+    return out.len;
+}
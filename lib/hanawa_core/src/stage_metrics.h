@@ -0,0 +1,104 @@
+#ifndef STAGE_METRICS_H
+#define STAGE_METRICS_H
+
+// Laufzeit je Verarbeitungsschritt als Histogramm mit festen Buckets
+// (p50/p95/p99/max), Ausgabe als JSON und im Prometheus-Textformat.
+// Plattformunabhängig: auf dem ESP32 mit esp_timer und Spinlock, auf dem
+// Rechner mit std::chrono und std::mutex. sucher2 und die Host-Werkzeuge
+// (replay, colorplay) melden damit dieselben Stufennamen, Buckets und
+// Perzentile.
+
+#include <stddef.h>
+#include <stdint.h>
+
+enum MetricStage {
+    STAGE_CAPTURE_WAIT,   // acquireFrame() bis der Frame da ist
+    STAGE_JPEG_DECODE,    // jpg2rgb565()
+    STAGE_GEOMETRY,       // calculateAmbilightWindows()
+    STAGE_REDUCTION,      // Mittelwerte aller Fenster (Wandzeit)
+    STAGE_REDUCTION_CORE0,  // davon Hilfs-Task auf Core 0 (sucher2: reduce_worker.h)
+    STAGE_REDUCTION_CORE1,  // davon Analyse-Task auf Core 1
+    STAGE_SERIALIZE,      // Pakete kodieren (ESP-NOW, UDP, Live-WebSocket)
+    STAGE_TRANSMIT,       // Pakete senden (ESP-NOW, UDP)
+    STAGE_FRAME_TOTAL,    // ganzer Analyse-Durchlauf inkl. Listener
+    STAGE_API_JSON,       // /api/ambilight serialisieren
+    STAGE_COUNT
+};
+
+// Bucket-Obergrenzen in µs: 1-1,5-2-3-5-7-Reihe von 10 µs bis 7 s,
+// dazu ein Überlauf-Bucket
+#define METRICS_BOUNDS   36
+#define METRICS_BUCKETS  (METRICS_BOUNDS + 1)
+
+struct StageSummary {
+    const char* name;     // z. B. "jpeg_decode"
+    uint32_t count;
+    uint64_t sumUs;
+    uint32_t meanUs;
+    uint32_t p50Us;       // Perzentile linear im Bucket interpoliert
+    uint32_t p95Us;
+    uint32_t p99Us;
+    uint32_t maxUs;       // exakt
+};
+
+// Zusätzlicher Zähler/Messwert für die Ausgabe (Heap, Drops, ...)
+struct MetricValue {
+    const char* name;     // snake_case, in JSON und Prometheus gleich
+    const char* help;
+    bool counter;         // true = monoton steigend, false = Momentanwert
+    double value;
+};
+
+const char* metricStageName(MetricStage stage);
+
+// Monotone Zeit in µs (esp_timer_get_time() bzw. steady_clock)
+int64_t metricsNowUs();
+
+void recordStage(MetricStage stage, uint32_t us);
+
+// Wird nach jedem recordStage() aufgerufen (z. B. vom Tracing), nullptr = aus
+typedef void (*StageHook)(MetricStage stage, uint32_t us);
+void setStageHook(StageHook hook);
+StageSummary getStageSummary(MetricStage stage);
+void resetStageMetrics();
+
+#if defined(ALLOC_TRACKING) && ALLOC_TRACKING
+// Laufende Stufe des aufrufenden Tasks für alloc_tracker (STAGE_COUNT = keine)
+MetricStage currentStage();
+MetricStage enterStage(MetricStage stage);   // liefert die vorherige
+void leaveStage(MetricStage previous);
+#endif
+
+// Misst vom Konstruktor bis zum Destruktor (oder bis stop())
+class StageTimer {
+public:
+    explicit StageTimer(MetricStage stage) : m_stage(stage), m_startUs(metricsNowUs()), m_running(true) {
+#if defined(ALLOC_TRACKING) && ALLOC_TRACKING
+        m_prevStage = enterStage(stage);
+#endif
+    }
+    ~StageTimer() { stop(); }
+    void stop() {
+        if (m_running) {
+            recordStage(m_stage, (uint32_t)(metricsNowUs() - m_startUs));
+            m_running = false;
+#if defined(ALLOC_TRACKING) && ALLOC_TRACKING
+            leaveStage(m_prevStage);
+#endif
+        }
+    }
+private:
+    MetricStage m_stage;
+    int64_t m_startUs;
+    bool m_running;
+#if defined(ALLOC_TRACKING) && ALLOC_TRACKING
+    MetricStage m_prevStage;
+#endif
+};
+
+// Schreiben alle Stufen plus extras nach buf (nullterminiert, abgeschnitten
+// wenn cap nicht reicht). Liefert die benötigte Länge ohne Nullbyte.
+size_t formatMetricsJson(char* buf, size_t cap, const MetricValue* extras, int extraCount);
+size_t formatMetricsPrometheus(char* buf, size_t cap, const MetricValue* extras, int extraCount);
+
+#endif // STAGE_METRICS_H
@@ -0,0 +1,188 @@
+#include "window_geometry.h"
+#include <math.h>
+
+// ============================================================================
+// SUCHER2
+// ============================================================================
+
+void calculateAmbilightWindows(
+    const float topLeft[], const float topRight[], const float botLeft[], const float botRight[],
+    int xwindows, int ywindows,
+    std::vector<WindowRect>& topRects, std::vector<WindowRect>& bottomRects,
+    std::vector<WindowRect>& leftRects, std::vector<WindowRect>& rightRects)
+{
+    // Fensterbreiten und -höhen berechnen
+    float xtopwinwidth = (topRight[0] - topLeft[0]) / xwindows;
+    float xbotwinwidth = (botRight[0] - botLeft[0]) / xwindows;
+    float yleftwinheight = (botLeft[1] - topLeft[1]) / ywindows;
+    float yrightwinheight = (botRight[1] - topRight[1]) / ywindows;
+
+    // Slopes für Trapez-Verzerrung
+    float topslope = (topRight[1] - topLeft[1]) / xwindows;
+    float bottomslope = (botRight[1] - botLeft[1]) / xwindows;
+    float leftslope = (botLeft[0] - topLeft[0]) / ywindows;
+    float rightslope = (botRight[0] - topRight[0]) / ywindows;
+
+    // Horizontale Fenster (top und bottom)
+    for (int i = 0; i < xwindows; i++) {
+        // Top - Höhe interpoliert zwischen links und rechts
+        int tx1 = topLeft[0] + round(i * xtopwinwidth);
+        int ty1 = topLeft[1] + round(i * topslope);
+        int tx2 = tx1 + round(xtopwinwidth);
+        // Lineare Interpolation der Fensterhöhe zwischen yleftwinheight und yrightwinheight
+        float ty2 = ty1 + (1.0 - (float(i) / (xwindows - 1))) * yleftwinheight + (float(i) / (xwindows - 1)) * yrightwinheight;
+        topRects.push_back({tx1, ty1, tx2, (int)ty2});
+
+        // Bottom - Höhe interpoliert zwischen links und rechts
+        int bx1 = botLeft[0] + round(i * xbotwinwidth);
+        float by1 = botLeft[1] + round(i * bottomslope) - (1.0 - (float(i) / (xwindows - 1))) * yleftwinheight - (float(i) / (xwindows - 1)) * yrightwinheight;
+        int bx2 = bx1 + round(xbotwinwidth);
+        int by2 = botLeft[1] + round(i * bottomslope);
+        bottomRects.push_back({bx1, (int)by1, bx2, by2});
+    }
+
+    // Vertikale Fenster (left und right) - Ecken werden übersprungen (i startet bei 1 und endet bei ywindows-2)
+    for (int i = 1; i < (ywindows - 1); i++) {
+        // Left - Breite interpoliert zwischen oben und unten
+        int lx1 = topLeft[0] + round(i * leftslope);
+        int ly1 = topLeft[1] + round(i * yleftwinheight);
+        // Lineare Interpolation der Fensterbreite zwischen xtopwinwidth und xbotwinwidth
+        float lx2 = lx1 + (1.0 - (float(i) / (ywindows - 1))) * xtopwinwidth + (float(i) / (ywindows - 1)) * xbotwinwidth;
+        int ly2 = ly1 + round(yleftwinheight);
+        leftRects.push_back({lx1, ly1, (int)lx2, ly2});
+
+        // Right - Breite interpoliert zwischen oben und unten
+        float rx1 = topRight[0] + round(i * rightslope) - (1.0 - (float(i) / (ywindows - 1))) * xtopwinwidth - (float(i) / (ywindows - 1)) * xbotwinwidth;
+        int ry1 = topRight[1] + round(i * yrightwinheight);
+        int rx2 = topRight[0] + round(i * rightslope);
+        int ry2 = ry1 + round(yrightwinheight);
+        rightRects.push_back({(int)rx1, ry1, rx2, ry2});
+    }
+}
+
+// ============================================================================
+// DEKODIER-SKALIERUNG
+// ============================================================================
+
+// Pixel, die calculateMeanRGB2() in r mittelt (gleiche Begrenzung und Schrittweite)
+static int sampleCount(WindowRect r, int width, int height) {
+    r.x1 = r.x1 < 0 ? 0 : r.x1 > width - 1 ? width - 1 : r.x1;
+    r.x2 = r.x2 < 0 ? 0 : r.x2 > width - 1 ? width - 1 : r.x2;
+    r.y1 = r.y1 < 0 ? 0 : r.y1 > height - 1 ? height - 1 : r.y1;
+    r.y2 = r.y2 < 0 ? 0 : r.y2 > height - 1 ? height - 1 : r.y2;
+    if (r.x1 >= r.x2 || r.y1 >= r.y2) {
+        return 0;
+    }
+    return ((r.x2 - r.x1 + 1) / 2) * ((r.y2 - r.y1 + 1) / 2);
+}
+
+int planDecodeScale(const float topLeft[], const float topRight[], const float botLeft[], const float botRight[],
+                    int xwindows, int ywindows, int frameWidth, int frameHeight,
+                    int minSamples, int maxScale, int* samples)
+{
+    std::vector<WindowRect> top, bottom, left, right;
+    for (int scale = 8; scale >= 1; scale /= 2) {
+        if (scale > maxScale && scale > 1) {
+            continue;
+        }
+        const float* in[4] = { topLeft, topRight, botLeft, botRight };
+        float c[4][2];
+        for (int i = 0; i < 4; i++) {
+            c[i][0] = in[i][0] / scale;
+            c[i][1] = in[i][1] / scale;
+        }
+        top.clear();
+        bottom.clear();
+        left.clear();
+        right.clear();
+        calculateAmbilightWindows(c[0], c[1], c[2], c[3], xwindows, ywindows, top, bottom, left, right);
+
+        int least = -1;
+        for (const std::vector<WindowRect>* side : { &top, &bottom, &left, &right }) {
+            for (const WindowRect& r : *side) {
+                int n = sampleCount(r, frameWidth / scale, frameHeight / scale);
+                least = least < 0 || n < least ? n : least;
+            }
+        }
+        if (least >= minSamples || scale == 1) {
+            if (samples) {
+                *samples = least < 0 ? 0 : least;
+            }
+            return scale;
+        }
+    }
+    return 1;
+}
+
+void denormalizeCorners(const float normalized[4][2], float width, float height, float out[4][2]) {
+    for (int i = 0; i < 4; i++) {
+        out[i][0] = normalized[i][0] * width;
+        out[i][1] = normalized[i][1] * height;
+    }
+}
+
+SamplingPlan buildSamplingPlan(const float normalized[4][2], int xwindows, int ywindows,
+                               int frameWidth, int frameHeight, int minSamples, int maxScale) {
+    float px[4][2];
+    denormalizeCorners(normalized, frameWidth, frameHeight, px);
+
+    SamplingPlan plan;
+    plan.scale = planDecodeScale(px[0], px[1], px[3], px[2], xwindows, ywindows,
+                                 frameWidth, frameHeight, minSamples, maxScale, &plan.samples);
+    plan.width = frameWidth / plan.scale;
+    plan.height = frameHeight / plan.scale;
+    float* out[4] = { plan.topLeft, plan.topRight, plan.botRight, plan.botLeft };
+    for (int i = 0; i < 4; i++) {
+        out[i][0] = px[i][0] / plan.scale;
+        out[i][1] = px[i][1] / plan.scale;
+    }
+    return plan;
+}
+
+// ============================================================================
+// V1
+// ============================================================================
+
+int calculateEdgeSegments(const int corners[4][2], int hDiv, int vDiv, WindowRect* out, int cap) {
+    const int* tl = corners[0];
+    const int* tr = corners[1];
+    const int* br = corners[2];
+    const int* bl = corners[3];
+    if (hDiv <= 0 || vDiv <= 0 || 2 * (hDiv + vDiv) > cap) {
+        return 0;
+    }
+    int n = 0;
+
+    // Horizontale Segmente (oben und unten), Tiefe aus der vertikalen Teilung
+    int depth = (bl[1] - tl[1]) / vDiv;
+    for (int i = 0; i < hDiv; i++) {
+        // Obere Kante
+        int x1 = tl[0] + (tr[0] - tl[0]) * i / hDiv;
+        int y1 = tl[1] + (tr[1] - tl[1]) * i / hDiv;
+        int x2 = tl[0] + (tr[0] - tl[0]) * (i + 1) / hDiv;
+        out[n++] = {x1, y1, x2, y1 + depth};
+
+        // Untere Kante
+        x1 = bl[0] + (br[0] - bl[0]) * i / hDiv;
+        y1 = bl[1] + (br[1] - bl[1]) * i / hDiv;
+        x2 = bl[0] + (br[0] - bl[0]) * (i + 1) / hDiv;
+        out[n++] = {x1, y1 - depth, x2, y1};
+    }
+
+    // Vertikale Segmente (links und rechts), Tiefe aus der horizontalen Teilung
+    depth = (tr[0] - tl[0]) / hDiv;
+    for (int i = 0; i < vDiv; i++) {
+        // Linke Kante
+        int x1 = tl[0] + (bl[0] - tl[0]) * i / vDiv;
+        int y1 = tl[1] + (bl[1] - tl[1]) * i / vDiv;
+        int y2 = tl[1] + (bl[1] - tl[1]) * (i + 1) / vDiv;
+        out[n++] = {x1, y1, x1 + depth, y2};
+
+        // Rechte Kante
+        x1 = tr[0] + (br[0] - tr[0]) * i / vDiv;
+        y1 = tr[1] + (br[1] - tr[1]) * i / vDiv;
+        y2 = tr[1] + (br[1] - tr[1]) * (i + 1) / vDiv;
+        out[n++] = {x1 - depth, y1, x1, y2};
+    }
+    return n;
+}
@@ -0,0 +1,60 @@
+#ifndef WINDOW_GEOMETRY_H
+#define WINDOW_GEOMETRY_H
+
+// Lage der Ambilight-Fenster im Kamerabild aus den vier TV-Ecken.
+
+#include <vector>
+#include "ambilight_types.h"
+
+// sucher2: Fenster entlang der Kanten eines (verzerrten) Vierecks, entspricht
+// ambivios.py (Zeilen 86-120). Ecken als {x, y} in Pixeln des dekodierten
+// Bildes. top/bottom: xwindows Fenster links → rechts, left/right:
+// ywindows - 2 Fenster oben → unten (die Ecken gehören zu top/bottom).
+// Die Vektoren werden angehängt, nicht geleert.
+void calculateAmbilightWindows(
+    const float topLeft[], const float topRight[], const float botLeft[], const float botRight[],
+    int xwindows, int ywindows,
+    std::vector<WindowRect>& topRects, std::vector<WindowRect>& bottomRects,
+    std::vector<WindowRect>& leftRects, std::vector<WindowRect>& rightRects);
+
+// Gröbste JPEG-Skalierung (1, 2, 4 oder 8, höchstens maxScale), bei der
+// jedes Fenster in calculateMeanRGB2() noch mindestens minSamples Pixel
+// liefert (jedes zweite in x und y, auf das Bild begrenzt). Ecken wie oben,
+// aber in Pixeln des unskalierten Kamerabildes (frameWidth x frameHeight).
+// Reicht selbst 1 nicht, liefert sie 1. samples = kleinste Pixelzahl eines
+// Fensters bei der gewählten Skalierung (nullptr erlaubt).
+int planDecodeScale(const float topLeft[], const float topRight[], const float botLeft[], const float botRight[],
+                    int xwindows, int ywindows, int frameWidth, int frameHeight,
+                    int minSamples, int maxScale = 8, int* samples = nullptr);
+
+// Kalibrierung unabhängig von der Auflösung: Ecken normiert auf [0, 1]
+// (Anteil an Breite bzw. Höhe des Kamerabildes) in der Reihenfolge oben
+// links, oben rechts, unten rechts, unten links.
+struct SamplingPlan {
+    int scale;             // JPEG-Skalierung aus planDecodeScale()
+    int width;             // dekodiertes Bild
+    int height;
+    int samples;           // kleinste Pixelzahl eines Fensters
+    float topLeft[2];      // Ecken in Pixeln des dekodierten Bildes
+    float topRight[2];
+    float botRight[2];
+    float botLeft[2];
+};
+
+// Normierte Ecken → Pixel eines width x height großen Rasters
+void denormalizeCorners(const float normalized[4][2], float width, float height, float out[4][2]);
+
+// Bildet die normierten Ecken auf das aktuelle Kamerabild ab und wählt die
+// Dekodier-Skalierung. Nach jeder Änderung von Konfiguration, Bildgröße oder
+// maxScale neu aufrufen, eine neue Kalibrierung ist dafür nicht nötig.
+SamplingPlan buildSamplingPlan(const float normalized[4][2], int xwindows, int ywindows,
+                               int frameWidth, int frameHeight, int minSamples, int maxScale = 8);
+
+// v1-Firmware: Streifen entlang der Kanten mit ganzzahliger Interpolation.
+// corners = {x, y} in der Reihenfolge oben links, oben rechts, unten rechts,
+// unten links. Schreibt 2 * (hDiv + vDiv) Rechtecke nach out, je Index
+// abwechselnd oben/unten, danach links/rechts (Reihenfolge der v1-Pakete).
+// Liefert die Anzahl, 0 wenn cap nicht reicht.
+int calculateEdgeSegments(const int corners[4][2], int hDiv, int vDiv, WindowRect* out, int cap);
+
+#endif // WINDOW_GEOMETRY_H
@@ -0,0 +1,410 @@
+// Host-Test: Geometrie, Farbreduktion und Farbumrechnung des Analyse-Kerns
+//
+// Über CMake (ctest) oder direkt (im Ordner lib/hanawa_core):
+//   g++ -std=c++11 -O2 -Wall -Isrc test/core_test.cpp src/*.cpp -o core_test
+//   ./core_test
+//
+// Hält das Verhalten fest, das beide Firmwares vor der Aufteilung hatten,
+// damit Optimierungen an den Kerneln (siehe bench/core_bench.cpp) nichts
+// am Ergebnis ändern.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+#include <cstring>
+#include "autotune.h"
+#include "color_math.h"
+#include "color_reduce.h"
+#include "sensor_window.h"
+#include "window_geometry.h"
+#include "test_check.h"
+
+static bool sameRect(const WindowRect& r, int x1, int y1, int x2, int y2) {
+    return r.x1 == x1 && r.y1 == y1 && r.x2 == x2 && r.y2 == y2;
+}
+
+// Einfarbiges Bild, lowFirst = Byte-Reihenfolge der v1-Firmware
+static std::vector<uint8_t> uniformFrame(int width, int height, uint8_t r, uint8_t g, uint8_t b, bool lowFirst) {
+    std::vector<uint8_t> buf((size_t)width * height * 2);
+    uint16_t pixel = rgb565Pack(r, g, b);
+    for (size_t i = 0; i < buf.size(); i += 2) {
+        buf[i] = lowFirst ? (pixel & 0xFF) : (pixel >> 8);
+        buf[i + 1] = lowFirst ? (pixel >> 8) : (pixel & 0xFF);
+    }
+    return buf;
+}
+
+static void testAmbilightWindows() {
+    // Standard-Konfiguration aus windows.cpp (320x240)
+    const float topLeft[2] = {25, 25};
+    const float topRight[2] = {295, 25};
+    const float botRight[2] = {295, 215};
+    const float botLeft[2] = {25, 215};
+    std::vector<WindowRect> top, bottom, left, right;
+    calculateAmbilightWindows(topLeft, topRight, botLeft, botRight, 10, 8, top, bottom, left, right);
+
+    CHECK(top.size() == 10 && bottom.size() == 10, "top/bottom %zu/%zu", top.size(), bottom.size());
+    CHECK(left.size() == 6 && right.size() == 6, "left/right %zu/%zu", left.size(), right.size());
+    CHECK(sameRect(top[0], 25, 25, 52, 48), "top[0] %d,%d,%d,%d", top[0].x1, top[0].y1, top[0].x2, top[0].y2);
+    CHECK(sameRect(top[9], 268, 25, 295, 48), "top[9] %d,%d,%d,%d", top[9].x1, top[9].y1, top[9].x2, top[9].y2);
+    CHECK(sameRect(bottom[0], 25, 191, 52, 215), "bottom[0] %d,%d,%d,%d", bottom[0].x1, bottom[0].y1, bottom[0].x2, bottom[0].y2);
+    CHECK(sameRect(left[0], 25, 49, 52, 73), "left[0] %d,%d,%d,%d", left[0].x1, left[0].y1, left[0].x2, left[0].y2);
+    CHECK(sameRect(right[5], 268, 168, 295, 192), "right[5] %d,%d,%d,%d", right[5].x1, right[5].y1, right[5].x2, right[5].y2);
+
+    // Vektoren werden angehängt
+    calculateAmbilightWindows(topLeft, topRight, botLeft, botRight, 10, 8, top, bottom, left, right);
+    CHECK(top.size() == 20, "nicht angehängt");
+}
+
+static void testEdgeSegments() {
+    const int corners[4][2] = { {80, 60}, {560, 60}, {560, 420}, {80, 420} };
+    WindowRect rects[2 * (10 + 8)];
+    int n = calculateEdgeSegments(corners, 10, 8, rects, 36);
+    CHECK(n == 36, "Anzahl %d", n);
+    CHECK(sameRect(rects[0], 80, 60, 128, 105), "oben[0] %d,%d,%d,%d", rects[0].x1, rects[0].y1, rects[0].x2, rects[0].y2);
+    CHECK(sameRect(rects[1], 80, 375, 128, 420), "unten[0] %d,%d,%d,%d", rects[1].x1, rects[1].y1, rects[1].x2, rects[1].y2);
+    CHECK(sameRect(rects[20], 80, 60, 128, 105), "links[0] %d,%d,%d,%d", rects[20].x1, rects[20].y1, rects[20].x2, rects[20].y2);
+    CHECK(sameRect(rects[35], 512, 375, 560, 420), "rechts[7] %d,%d,%d,%d", rects[35].x1, rects[35].y1, rects[35].x2, rects[35].y2);
+    CHECK(calculateEdgeSegments(corners, 10, 8, rects, 35) == 0, "cap zu klein");
+    CHECK(calculateEdgeSegments(corners, 0, 8, rects, 36) == 0, "hDiv 0");
+}
+
+static void testColorMath() {
+    for (int v = 0; v < 256; v++) {
+        uint8_t back = linearToSrgb(srgbToLinear((uint8_t)v));
+        CHECK(back == v, "sRGB %d -> %d", v, back);
+    }
+    uint16_t pixel = rgb565Pack(200, 100, 50);
+    CHECK(rgb565Red(pixel) == 200 && rgb565Green(pixel) == 100 && rgb565Blue(pixel) == 48, "RGB565");
+    RGB white = {255, 255, 255};
+    CHECK(rgbLuminance(white) == 255, "Luminanz weiß %u", rgbLuminance(white));
+    RGB green = {0, 200, 0};
+    CHECK(rgbLuminance(green) == 117, "Luminanz grün %u", rgbLuminance(green));
+}
+
+static void testReducers() {
+    const int W = 64, H = 48;
+    std::vector<uint8_t> frame = uniformFrame(W, H, 200, 100, 50, false);
+
+    RGB c = calculateMeanRGB2(frame.data(), W, H, 4, 4, 40, 30);
+    CHECK(c.r == 200 && c.g == 100 && c.b == 48, "gamma %u,%u,%u", c.r, c.g, c.b);
+
+    // Rechteck wird auf das Bild begrenzt, leer ergibt Schwarz
+    c = calculateMeanRGB2(frame.data(), W, H, -10, -10, 500, 500);
+    CHECK(c.r == 200 && c.g == 100 && c.b == 48, "gamma begrenzt %u,%u,%u", c.r, c.g, c.b);
+    c = calculateMeanRGB2(frame.data(), W, H, 10, 10, 10, 20);
+    CHECK(c.r == 0 && c.g == 0 && c.b == 0, "gamma leer");
+    c = calculateMeanRGB(frame.data(), W, H, 30, 10, 20, 20);
+    CHECK(c.r == 0 && c.g == 0 && c.b == 0, "rms leer");
+    c = calculateMeanRGB2(nullptr, W, H, 0, 0, 10, 10);
+    CHECK(c.r == 0 && c.g == 0 && c.b == 0, "ohne Puffer");
+
+    // RMS liegt über dem linearen Mittel, gamma dazwischen
+    std::vector<uint8_t> split = uniformFrame(W, H, 0, 0, 0, false);
+    std::vector<uint8_t> white = uniformFrame(W, H, 248, 252, 248, false);
+    for (int y = 0; y < H; y++) {
+        for (int x = W / 2; x < W; x++) {
+            size_t idx = ((size_t)y * W + x) * 2;
+            split[idx] = white[idx];
+            split[idx + 1] = white[idx + 1];
+        }
+    }
+    RGB gamma = calculateMeanRGB2(split.data(), W, H, 0, 0, W, H);
+    CHECK(gamma.r > 124 && gamma.r < 248, "gamma halb %u", gamma.r);
+
+    // v1: Low-Byte zuerst, Ecken eingeschlossen und vertauschbar
+    std::vector<uint8_t> v1 = uniformFrame(W, H, 200, 100, 50, true);
+    c = calculateSegmentRms(v1.data(), W, H, 40, 30, 4, 4);
+    CHECK(c.r == 200 && c.g == 100 && c.b == 48, "v1 %u,%u,%u", c.r, c.g, c.b);
+    c = calculateSegmentRms(v1.data(), W, H, W - 2, H - 2, W + 20, H + 20);
+    CHECK(c.r == 200, "v1 Rand %u", c.r);
+    c = calculateSegmentRms(v1.data(), W, H, W, H, W + 20, H + 20);
+    CHECK(c.r == 0 && c.g == 0 && c.b == 0, "v1 außerhalb");
+}
+
+static void testDecodeScale() {
+    // Standard-Konfiguration in Kamera-Pixeln (640x480): bei 2x 27x23 Pixel
+    // je Fenster, also 14 * 12 Stichproben
+    const float topLeft[2] = {50, 50};
+    const float topRight[2] = {590, 50};
+    const float botRight[2] = {590, 430};
+    const float botLeft[2] = {50, 430};
+    int samples = 0;
+    int scale = planDecodeScale(topLeft, topRight, botLeft, botRight, 10, 8, 640, 480, 64, 8, &samples);
+    CHECK(scale == 2 && samples >= 64, "Standard %d (%d)", scale, samples);
+
+    // Wenige Fenster vertragen 8x, maxScale begrenzt
+    scale = planDecodeScale(topLeft, topRight, botLeft, botRight, 4, 3, 640, 480, 64, 8, &samples);
+    CHECK(scale == 4 || scale == 8, "wenige Fenster %d (%d)", scale, samples);
+    CHECK(planDecodeScale(topLeft, topRight, botLeft, botRight, 4, 3, 640, 480, 4, 4) == 4, "maxScale");
+
+    // Kleiner Fernseher weit weg: volle Auflösung, auch wenn es nicht reicht
+    const float smallTL[2] = {300, 220}, smallTR[2] = {380, 220}, smallBR[2] = {380, 280}, smallBL[2] = {300, 280};
+    scale = planDecodeScale(smallTL, smallTR, smallBL, smallBR, 10, 8, 640, 480, 64, 8, &samples);
+    CHECK(scale == 1 && samples < 64, "klein %d (%d)", scale, samples);
+
+    // Gleiche Stichproben wie in calculateMeanRGB2() gezählt
+    scale = planDecodeScale(topLeft, topRight, botLeft, botRight, 10, 8, 640, 480, 1, 8, &samples);
+    CHECK(scale == 8 && samples > 0, "8x %d (%d)", scale, samples);
+}
+
+static void testSamplingPlan() {
+    // Standard-Konfiguration normiert: bei VGA dieselben Fenster wie bisher
+    const float norm[4][2] = { {50.0f / 640, 50.0f / 480}, {590.0f / 640, 50.0f / 480},
+                               {590.0f / 640, 430.0f / 480}, {50.0f / 640, 430.0f / 480} };
+    SamplingPlan plan = buildSamplingPlan(norm, 10, 8, 640, 480, 64);
+    CHECK(plan.scale == 2 && plan.width == 320 && plan.height == 240, "VGA %d %dx%d", plan.scale, plan.width, plan.height);
+    std::vector<WindowRect> top, bottom, left, right;
+    calculateAmbilightWindows(plan.topLeft, plan.topRight, plan.botLeft, plan.botRight, 10, 8, top, bottom, left, right);
+    CHECK(sameRect(top[0], 25, 25, 52, 48), "VGA top[0] %d,%d,%d,%d", top[0].x1, top[0].y1, top[0].x2, top[0].y2);
+
+    // Andere Bildgröße, gleiche Kalibrierung: Fenster liegen anteilig gleich
+    plan = buildSamplingPlan(norm, 10, 8, 1280, 960, 64);
+    CHECK(plan.scale == 4 && plan.width == 320, "SXGA %d %dx%d", plan.scale, plan.width, plan.height);
+    top.clear(); bottom.clear(); left.clear(); right.clear();
+    calculateAmbilightWindows(plan.topLeft, plan.topRight, plan.botLeft, plan.botRight, 10, 8, top, bottom, left, right);
+    CHECK(sameRect(top[0], 25, 25, 52, 48), "SXGA top[0] %d,%d,%d,%d", top[0].x1, top[0].y1, top[0].x2, top[0].y2);
+
+    // maxScale begrenzt; ohne Mindestzahl reicht 8x (nur DC-Koeffizienten)
+    plan = buildSamplingPlan(norm, 10, 8, 640, 480, 1000, 1);
+    CHECK(plan.scale == 1 && plan.topRight[0] == 590.0f, "1x %d %.1f", plan.scale, plan.topRight[0]);
+    plan = buildSamplingPlan(norm, 10, 8, 640, 480, 0, 8);
+    CHECK(plan.scale == 8 && plan.width == 80 && plan.botRight[1] > 53.7f && plan.botRight[1] < 53.8f,
+          "8x %d %dx%d %.2f", plan.scale, plan.width, plan.height, plan.botRight[1]);
+}
+
+// Mock des OV2640: schreibt die DSP-Register wie set_window() in
+// esp32-camera (ov2640.c) und liest sie zurück, damit abgeschnittene Bits
+// auffallen
+class MockSensor : public SensorWindowPort {
+public:
+    uint8_t hsize = 0, vsize = 0, xoffl = 0, yoffl = 0, vhyx = 0, test = 0, zmow = 0, zmoh = 0, zmhh = 0;
+    int mode = -1;
+    int windows = 0;
+    int resets = 0;
+
+    bool setWindow(int m, int offsetX, int offsetY, int width, int height, int outputWidth, int outputHeight) override {
+        int maxX = width / 4, maxY = height / 4, w = outputWidth / 4, h = outputHeight / 4;
+        mode = m;
+        hsize = maxX & 0xFF;
+        vsize = maxY & 0xFF;
+        xoffl = offsetX & 0xFF;
+        yoffl = offsetY & 0xFF;
+        vhyx = ((maxY >> 1) & 0x80) | ((offsetY >> 4) & 0x70) | ((maxX >> 5) & 0x08) | ((offsetX >> 8) & 0x07);
+        test = (maxX >> 2) & 0x80;
+        zmow = w & 0xFF;
+        zmoh = h & 0xFF;
+        zmhh = ((h >> 6) & 0x04) | ((w >> 8) & 0x03);
+        windows++;
+        return true;
+    }
+
+    bool resetWindow() override {
+        resets++;
+        return true;
+    }
+
+    int offsetX() const { return xoffl | ((vhyx & 0x07) << 8); }
+    int offsetY() const { return yoffl | ((vhyx & 0x70) << 4); }
+    int width() const { return (hsize | ((vhyx & 0x08) << 5) | ((test & 0x80) << 2)) * 4; }
+    int height() const { return (vsize | ((vhyx & 0x80) << 1)) * 4; }
+    int outputWidth() const { return (zmow | ((zmhh & 0x03) << 8)) * 4; }
+    int outputHeight() const { return (zmoh | ((zmhh & 0x04) << 6)) * 4; }
+};
+
+static bool insideView(const SensorWindow& window, const float corners[4][2]) {
+    float cropped[4][2];
+    cropCorners(window, corners, cropped);
+    for (int i = 0; i < 4; i++) {
+        if (cropped[i][0] < 0 || cropped[i][0] > 1 || cropped[i][1] < 0 || cropped[i][1] > 1) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void testSensorWindow() {
+    // Standard-Kalibrierung: großer Ausschnitt, gebinnter Modus reicht
+    const float norm[4][2] = { {50.0f / 640, 50.0f / 480}, {590.0f / 640, 50.0f / 480},
+                               {590.0f / 640, 430.0f / 480}, {50.0f / 640, 430.0f / 480} };
+    SensorWindow window = planSensorWindow(norm, 0.05f, 320, 240);
+    CHECK(window.mode == OV2640_MODE_SVGA && sensorWindowValid(window), "VGA Modus %d", window.mode);
+    CHECK(window.offsetX == 22 && window.width == 756 && window.offsetY == 32 && window.height == 536,
+          "VGA %d+%d %d+%d", window.offsetX, window.width, window.offsetY, window.height);
+    CHECK(insideView(window, norm), "VGA Ecken außerhalb");
+
+    // Hin und zurück: Ecken des vollen Bildes bleiben gleich
+    float cropped[4][2], back[4][2];
+    cropCorners(window, norm, cropped);
+    uncropCorners(window, cropped, back);
+    float err = 0;
+    for (int i = 0; i < 4; i++) {
+        err = fmaxf(err, fmaxf(fabsf(back[i][0] - norm[i][0]), fabsf(back[i][1] - norm[i][1])));
+    }
+    CHECK(err < 1e-5f, "zurück %.6f", err);
+
+    // Kleiner Fernseher weit weg: UXGA, Ausschnitt um die Mitte auf die
+    // Ausgabe erweitert (DSP vergrößert nicht)
+    const float small[4][2] = { {0.45f, 0.45f}, {0.55f, 0.45f}, {0.55f, 0.55f}, {0.45f, 0.55f} };
+    window = planSensorWindow(small, 0, 320, 240);
+    CHECK(window.mode == OV2640_MODE_UXGA && sensorWindowValid(window), "klein Modus %d", window.mode);
+    CHECK(window.width == 320 && window.height == 240 && window.offsetX == 640 && window.offsetY == 480,
+          "klein %d+%d %d+%d", window.offsetX, window.width, window.offsetY, window.height);
+    CHECK(insideView(window, small), "klein Ecken außerhalb");
+
+    // Am Bildrand: Ausschnitt bleibt im Sensor, Ausgabe auf 4 abgerundet
+    const float edge[4][2] = { {0.8f, 0.0f}, {1.0f, 0.0f}, {1.0f, 0.2f}, {0.8f, 0.2f} };
+    window = planSensorWindow(edge, 0.05f, 162, 122);
+    CHECK(window.mode == OV2640_MODE_SVGA && window.outputWidth == 160 && window.outputHeight == 120 &&
+          sensorWindowValid(window), "Rand Modus %d Ausgabe %dx%d", window.mode, window.outputWidth, window.outputHeight);
+    CHECK(window.offsetX + window.width == OV2640_SVGA_WIDTH && window.offsetY == 0 && insideView(window, edge),
+          "Rand %d+%d %d+%d", window.offsetX, window.width, window.offsetY, window.height);
+
+    // Register im Mock: nichts abgeschnitten, auch über 8 Bit
+    MockSensor sensor;
+    window = planSensorWindow(small, 0.2f, 640, 480);
+    CHECK(applySensorWindow(sensor, window) && sensor.windows == 1 && sensor.mode == window.mode,
+          "setzen %d %d", sensor.windows, sensor.mode);
+    CHECK(sensor.offsetX() == window.offsetX && sensor.offsetY() == window.offsetY &&
+          sensor.width() == window.width && sensor.height() == window.height,
+          "Register %d+%d %d+%d", sensor.offsetX(), sensor.width(), sensor.offsetY(), sensor.height());
+    CHECK(sensor.outputWidth() == 640 && sensor.outputHeight() == 480,
+          "Register Ausgabe %dx%d", sensor.outputWidth(), sensor.outputHeight());
+
+    // Ungültig kommt nicht beim Sensor an, volles Bild setzt zurück
+    SensorWindow bad = window;
+    bad.outputWidth = bad.width + 4;
+    CHECK(!applySensorWindow(sensor, bad) && sensor.windows == 1, "ungültig gesetzt");
+    bad = window;
+    bad.offsetX = OV2640_UXGA_WIDTH - bad.width + 4;
+    CHECK(!applySensorWindow(sensor, bad) && sensor.windows == 1, "außerhalb gesetzt");
+    CHECK(applySensorWindow(sensor, fullSensorWindow()) && sensor.resets == 1, "zurücksetzen");
+    CHECK(insideView(fullSensorWindow(), norm), "volles Bild");
+}
+
+static void testAutotune() {
+    // Achsen und Kombinationen (Skalierung läuft innen)
+    AutotuneAxes axes;
+    CHECK(autotuneParseAxis("10,20", &axes.xclkMhz) && axes.xclkMhz.count == 2, "xclk %d", axes.xclkMhz.count);
+    CHECK(autotuneParseAxis("12", &axes.jpegQuality), "quality");
+    CHECK(autotuneParseAxis("320,640", &axes.frameWidth), "width");
+    CHECK(autotuneParseAxis("1,2,4", &axes.decodeScale), "scale");
+    AutotuneAxis bad;
+    CHECK(!autotuneParseAxis("", &bad) && !autotuneParseAxis("10,x", &bad) && !autotuneParseAxis("1,2,3,4,5,6,7", &bad),
+          "ungültige Liste angenommen");
+    AutotuneSetting settings[AUTOTUNE_MAX_SETTINGS];
+    int n = autotuneSettings(axes, settings, AUTOTUNE_MAX_SETTINGS);
+    CHECK(n == 12, "Kombinationen %d", n);
+    CHECK(settings[1].decodeScale == 2 && settings[3].frameWidth == 640 && settings[3].frameHeight == 480 &&
+          settings[6].xclkMhz == 20, "Reihenfolge %d %d %d", settings[1].decodeScale, settings[3].frameWidth, settings[6].xclkMhz);
+    CHECK(autotuneSettings(axes, settings, 11) == 0, "cap zu klein");
+
+    // Referenz aus zwei Frames, Messung gegen sie
+    RGB a[2] = { {100, 100, 100}, {0, 0, 0} };
+    RGB b[2] = { {102, 100, 100}, {0, 0, 4} };
+    AutotuneReference reference;
+    CHECK(reference.add(a, 2) && reference.add(b, 2) && !reference.add(a, 1), "Referenz");
+    RGB ref[2];
+    CHECK(reference.finish(ref) == 2 && ref[0].r == 101 && ref[1].b == 2, "Referenz %d %d", ref[0].r, ref[1].b);
+
+    AutotuneMeasurement m;
+    m.begin(settings[4]);
+    for (int i = 1; i <= 20; i++) {
+        m.addFrame(50000, i * 1000, 8000 + i, a, a, 2);
+    }
+    RGB off[2] = { {106, 100, 100}, {0, 0, 0} };
+    m.addFrame(50000, 21000, 8021, off, a, 2);
+    AutotuneResult r = m.finish();
+    CHECK(r.frames == 21 && r.fps > 19.99f && r.fps < 20.01f, "fps %d %.3f", r.frames, r.fps);
+    CHECK(r.latencyP50Us == 11000 && r.latencyP95Us == 20000, "Latenz %u %u", r.latencyP50Us, r.latencyP95Us);
+    CHECK(r.jpegBytes == 8011 && r.setting.decodeScale == settings[4].decodeScale, "JPEG %u", r.jpegBytes);
+    // 6² in einem von 21 * 6 Werten
+    CHECK(fabsf(r.colorError - sqrtf(36.0f / 126)) < 1e-4f, "Farbfehler %.4f", r.colorError);
+
+    // Auswahl: bestes Bild innerhalb des Ziels, sonst am nächsten dran
+    AutotuneResult results[3] = {};
+    results[0].frames = results[1].frames = results[2].frames = 10;
+    results[0].fps = 8;  results[0].latencyP95Us = 150000; results[0].colorError = 1;
+    results[1].fps = 12; results[1].latencyP95Us = 90000;  results[1].colorError = 3;
+    results[2].fps = 25; results[2].latencyP95Us = 40000;  results[2].colorError = 6;
+    AutotuneTarget target = { 0, 0 };
+    CHECK(autotuneSelect(results, 3, target) == 0, "ohne Ziel %d", autotuneSelect(results, 3, target));
+    target.maxLatencyUs = 100000;
+    CHECK(autotuneSelect(results, 3, target) == 1, "Latenz %d", autotuneSelect(results, 3, target));
+    target.minFps = 20;
+    CHECK(autotuneSelect(results, 3, target) == 2, "fps %d", autotuneSelect(results, 3, target));
+    target.maxLatencyUs = 10000;
+    CHECK(autotuneSelect(results, 3, target) == 2, "unerreichbar %d", autotuneSelect(results, 3, target));
+    target = { 0, 50 };
+    CHECK(autotuneSelect(results, 3, target) == 2, "fps unerreichbar %d", autotuneSelect(results, 3, target));
+    CHECK(autotuneSelect(results, 0, target) == -1, "leer");
+
+    // Tabelle: Länge vorab, Kopf und eine Zeile je Ergebnis
+    size_t len = autotuneFormatCsv(nullptr, 0, results, 3);
+    std::vector<char> csv(len + 1);
+    CHECK(autotuneFormatCsv(csv.data(), csv.size(), results, 3) == len && strlen(csv.data()) == len, "CSV-Länge");
+    CHECK(strncmp(csv.data(), "xclk_mhz,", 9) == 0 && std::count(csv.begin(), csv.end(), '\n') == 4, "CSV-Zeilen");
+}
+
+static void testSplit() {
+    const int W = 320, H = 240;
+    std::vector<uint8_t> frame = uniformFrame(W, H, 200, 100, 50, false);
+
+    // Gleich große Fenster: genau in der Mitte
+    std::vector<WindowRect> rects;
+    for (int i = 0; i < 10; i++) {
+        rects.push_back({i * 20, 0, i * 20 + 20, 10});
+    }
+    CHECK(splitRectsByArea(rects.data(), 10, W, H) == 5, "gleich %d", splitRectsByArea(rects.data(), 10, W, H));
+
+    // Ein großes Fenster vorne wiegt die kleinen auf
+    rects[0] = {0, 0, 200, 100};
+    int split = splitRectsByArea(rects.data(), 10, W, H);
+    CHECK(split == 1, "groß vorne %d", split);
+
+    // Außerhalb des Bildes zählt nicht
+    rects.assign(4, WindowRect{0, 0, 10, 10});
+    rects[0] = {400, 300, 500, 400};
+    rects[1] = {400, 300, 500, 400};
+    CHECK(splitRectsByArea(rects.data(), 4, W, H) == 3, "außerhalb %d", splitRectsByArea(rects.data(), 4, W, H));
+
+    CHECK(splitRectsByArea(rects.data(), 0, W, H) == 0, "leer");
+    split = splitRectsByArea(rects.data(), 1, W, H);
+    CHECK(split == 0 || split == 1, "eins %d", split);
+
+    // Beide Hälften zusammen = eine Schleife über alle Fenster
+    std::vector<WindowRect> top, bottom, left, right;
+    const float tl[2] = {40, 30}, tr[2] = {280, 30}, bl[2] = {40, 210}, br[2] = {280, 210};
+    calculateAmbilightWindows(tl, tr, bl, br, 20, 12, top, bottom, left, right);
+    std::vector<WindowRect> all(top);
+    all.insert(all.end(), right.begin(), right.end());
+    all.insert(all.end(), bottom.begin(), bottom.end());
+    all.insert(all.end(), left.begin(), left.end());
+    int n = (int)all.size();
+    split = splitRectsByArea(all.data(), n, W, H);
+    CHECK(split > 0 && split < n, "Fenster %d von %d", split, n);
+    std::vector<RGB> colors(n);
+    calculateMeanRGB2Rects(frame.data(), W, H, all.data(), split, colors.data());
+    calculateMeanRGB2Rects(frame.data(), W, H, all.data() + split, n - split, colors.data() + split);
+    int mismatches = 0;
+    for (int i = 0; i < n; i++) {
+        RGB c = calculateMeanRGB2(frame.data(), W, H, all[i].x1, all[i].y1, all[i].x2, all[i].y2);
+        mismatches += c.r != colors[i].r || c.g != colors[i].g || c.b != colors[i].b;
+    }
+    CHECK(mismatches == 0, "aufgeteilt %d Abweichungen", mismatches);
+}
+
+int main() {
+    testAmbilightWindows();
+    testEdgeSegments();
+    testColorMath();
+    testReducers();
+    testDecodeScale();
+    testSamplingPlan();
+    testSensorWindow();
+    testAutotune();
+    testSplit();
+
+    return testSummary("core_test");
+}
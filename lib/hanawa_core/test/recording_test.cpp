@@ -0,0 +1,236 @@
+// Host-Test: Aufnahme-Container (.hrec), Farb-Log (.hcol) und virtuelle Kamera
+//
+// Über CMake (ctest) oder direkt (im Ordner lib/hanawa_core):
+//   g++ -std=c++11 -O2 -Wall -Isrc -Ihost test/recording_test.cpp src/frame_recording.cpp src/color_recording.cpp src/ambilight_protocol.cpp host/virtual_camera.cpp -o recording_test
+//   ./recording_test
+//
+// Die Frames sind keine echten JPEGs: die virtuelle Kamera liest nur den
+// SOF-Marker (Bildgröße), dekodiert wird erst in replay.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include "color_recording.h"
+#include "frame_recording.h"
+#include "virtual_camera.h"
+#include "test_check.h"
+
+// ============================================================================
+// HILFSFUNKTIONEN
+// ============================================================================
+
+// SOI, SOF0 mit Bildgröße, EOI; id landet im Puffer, um Frames zu unterscheiden
+static std::vector<uint8_t> fakeJpeg(uint16_t width, uint16_t height, uint8_t id) {
+    std::vector<uint8_t> jpeg = {
+        0xFF, 0xD8,
+        0xFF, 0xC0, 0x00, 0x0B, 0x08,
+        (uint8_t)(height >> 8), (uint8_t)height, (uint8_t)(width >> 8), (uint8_t)width,
+        0x01, 0x01, 0x11, 0x00,
+        0xFF, 0xD9, id,
+    };
+    return jpeg;
+}
+
+static void appendFrame(std::vector<uint8_t>& file, int64_t captureUs, const std::vector<uint8_t>& jpeg) {
+    RecordingFrameHeader header = { captureUs, (uint32_t)jpeg.size(), 640, 480 };
+    uint8_t buf[RECORDING_FRAME_HEADER];
+    recordingWriteFrameHeader(buf, header);
+    file.insert(file.end(), buf, buf + RECORDING_FRAME_HEADER);
+    file.insert(file.end(), jpeg.begin(), jpeg.end());
+}
+
+static void writeFile(const std::string& path, const std::vector<uint8_t>& data) {
+    FILE* f = fopen(path.c_str(), "wb");
+    fwrite(data.data(), 1, data.size(), f);
+    fclose(f);
+}
+
+// Aufnahme mit vier Frames im Abstand stepUs, der letzte abgeschnitten angehängt
+static std::vector<uint8_t> makeRecording(int64_t stepUs) {
+    std::vector<uint8_t> file(RECORDING_FILE_HEADER);
+    recordingWriteFileHeader(file.data());
+    for (int i = 0; i < 4; i++) {
+        appendFrame(file, 5000000 + i * stepUs, fakeJpeg(640, 480, (uint8_t)i));
+    }
+    std::vector<uint8_t> partial;
+    appendFrame(partial, 5000000 + 4 * stepUs, fakeJpeg(640, 480, 4));
+    file.insert(file.end(), partial.begin(), partial.end() - 5);
+    return file;
+}
+
+// ============================================================================
+// TESTS
+// ============================================================================
+
+static void testContainer() {
+    uint8_t file[RECORDING_FILE_HEADER];
+    CHECK(recordingWriteFileHeader(file) == RECORDING_FILE_HEADER, "Dateiheader-Länge");
+    CHECK(memcmp(file, "HREC", 4) == 0 && file[4] == 1 && file[5] == 0, "Kennung/Version");
+    CHECK(recordingParseFileHeader(file, sizeof(file)), "Dateiheader gültig");
+    CHECK(!recordingParseFileHeader(file, 4), "zu kurz");
+    file[4] = 2;
+    CHECK(!recordingParseFileHeader(file, sizeof(file)), "fremde Version");
+
+    RecordingFrameHeader in = { 0x0102030405060708LL, 12345, 640, 480 };
+    uint8_t buf[RECORDING_FRAME_HEADER];
+    CHECK(recordingWriteFrameHeader(buf, in) == RECORDING_FRAME_HEADER, "Frameheader-Länge");
+    CHECK(buf[0] == 0x08 && buf[7] == 0x01 && buf[8] == 0x39 && buf[9] == 0x30, "little endian");
+    RecordingFrameHeader out;
+    CHECK(recordingParseFrameHeader(buf, sizeof(buf), &out), "Frameheader gültig");
+    CHECK(out.captureUs == in.captureUs && out.len == in.len &&
+          out.width == 640 && out.height == 480, "Round-Trip");
+    CHECK(!recordingParseFrameHeader(buf, sizeof(buf) - 1, &out), "zu kurz");
+
+    in.len = RECORDING_MAX_FRAME + 1;
+    recordingWriteFrameHeader(buf, in);
+    CHECK(!recordingParseFrameHeader(buf, sizeof(buf), &out), "unplausible Länge");
+}
+
+static void testColorLog() {
+    uint8_t file[COLOR_RECORDING_FILE_HEADER];
+    colorRecordingWriteFileHeader(file);
+    CHECK(memcmp(file, "HCOL", 4) == 0 && colorRecordingParseFileHeader(file, sizeof(file)), "Dateiheader");
+    CHECK(!recordingParseFileHeader(file, sizeof(file)), "keine Kamera-Aufnahme");
+
+    // 4x4 Fenster: 4 oben, 2 rechts, 4 unten, 2 links = 12
+    const int H = 4, V = 4;
+    RGB top[H], bottom[H], left[V - 2], right[V - 2];
+    for (int i = 0; i < H; i++) {
+        top[i] = {(uint8_t)(10 + i), 1, 2};
+        bottom[i] = {(uint8_t)(20 + i), 3, 4};
+    }
+    for (int i = 0; i < V - 2; i++) {
+        right[i] = {(uint8_t)(30 + i), 5, 6};
+        left[i] = {(uint8_t)(40 + i), 7, 8};
+    }
+    AmbilightSides sides = { top, H, right, V - 2, bottom, H, left, V - 2 };
+
+    uint8_t frame[COLOR_RECORDING_MAX_FRAME];
+    size_t len = colorRecordingWriteFrame(frame, sizeof(frame), 77, 0x123456789LL, 5, H, V, sides);
+    CHECK(len == COLOR_RECORDING_FRAME_HEADER + 12 * 3, "Länge %zu", len);
+    CHECK(colorRecordingWriteFrame(frame, len - 1, 77, 0, 5, H, V, sides) == 0, "passt nicht");
+    CHECK(colorRecordingWriteFrame(frame, sizeof(frame), 77, 0, 5, H + 1, V, sides) == 0, "Seiten passen nicht");
+
+    ColorRecordingFrameHeader header;
+    CHECK(colorRecordingParseFrameHeader(frame, len, &header), "Frameheader gültig");
+    CHECK(header.sequence == 77 && header.captureUs == 0x123456789LL && header.geometryId == 5 &&
+          header.hSeg == H && header.vSeg == V && header.rectCount == 12, "Round-Trip");
+
+    // Uhrzeigersinn: oben →, rechts ↓, unten ←, links ↑
+    const uint8_t* rgb = frame + COLOR_RECORDING_FRAME_HEADER;
+    CHECK(rgb[0] == 10 && rgb[3 * 4] == 30 && rgb[3 * 6] == 23 && rgb[3 * 10] == 41, "Reihenfolge");
+
+    RGB scratch[12];
+    AmbilightSides back = colorRecordingSides(header, rgb, scratch);
+    bool same = back.topCount == H && back.rightCount == V - 2 && back.bottomCount == H && back.leftCount == V - 2;
+    for (int k = 0; same && k < 12; k++) {
+        RGB a = ambilightClockwiseColor(sides, k);
+        RGB b = ambilightClockwiseColor(back, k);
+        same = a.r == b.r && a.g == b.g && a.b == b.b;
+    }
+    CHECK(same, "Seiten aus dem Log");
+
+    frame[18] = 13;   // rectCount passt nicht zu 4x4
+    CHECK(!colorRecordingParseFrameHeader(frame, len, &header), "rectCount geprüft");
+}
+
+static void testFast(const std::string& path) {
+    CHECK(virtualCameraOpen(path.c_str(), VCAM_FAST, 2), "öffnen");
+    VirtualCameraStats stats = getVirtualCameraStats();
+    CHECK(stats.frames == 4, "abgeschnittener Frame verworfen: %u", stats.frames);
+    CHECK(stats.durationUs == 400000, "Dauer %lld", (long long)stats.durationUs);
+
+    int count = 0;
+    while (camera_fb_t* fb = esp_camera_fb_get()) {
+        CHECK(virtualCameraFrameIndex(fb) == count % 4, "Reihenfolge %d", count);
+        CHECK(virtualCameraRecordedUs(fb) == 5000000 + (count % 4) * 100000, "Zeitstempel %d", count);
+        CHECK(fb->buf[fb->len - 1] == count % 4 && fb->width == 640 && fb->height == 480, "Inhalt %d", count);
+        CHECK(fb->format == PIXFORMAT_JPEG, "Format");
+        CHECK(getVirtualCameraStats().outstanding == 1, "ausgegeben");
+        esp_camera_fb_return(fb);
+        count++;
+    }
+    stats = getVirtualCameraStats();
+    CHECK(count == 8 && stats.delivered == 8 && stats.skipped == 0, "zwei Durchläufe: %d", count);
+    CHECK(stats.outstanding == 0, "alle zurückgegeben");
+    virtualCameraClose();
+}
+
+static void testRealtime(const std::string& path) {
+    CHECK(virtualCameraOpen(path.c_str(), VCAM_REALTIME), "öffnen");
+    int64_t start = virtualCameraNowUs();
+
+    camera_fb_t* fb = esp_camera_fb_get();
+    CHECK(fb && virtualCameraFrameIndex(fb) == 0, "erster Frame sofort");
+    int64_t first = (int64_t)fb->timestamp.tv_sec * 1000000LL + fb->timestamp.tv_usec;
+    esp_camera_fb_return(fb);
+
+    // Verbraucher zu langsam: Frame 1 (100 ms) verpasst, Frame 2 (200 ms) fällig
+    std::this_thread::sleep_for(std::chrono::milliseconds(250));
+    fb = esp_camera_fb_get();
+    CHECK(fb && virtualCameraFrameIndex(fb) == 2, "neuester fälliger Frame");
+    esp_camera_fb_return(fb);
+
+    // Frame 3 ist erst bei 300 ms fällig: esp_camera_fb_get() wartet
+    fb = esp_camera_fb_get();
+    int64_t now = virtualCameraNowUs();
+    CHECK(fb && virtualCameraFrameIndex(fb) == 3, "letzter Frame");
+    int64_t capture = (int64_t)fb->timestamp.tv_sec * 1000000LL + fb->timestamp.tv_usec;
+    CHECK(capture - first == 300000, "Zeitstempel im Aufnahmetakt: %lld", (long long)(capture - first));
+    CHECK(now - start >= 300000, "gewartet: %lld µs", (long long)(now - start));
+    esp_camera_fb_return(fb);
+
+    CHECK(esp_camera_fb_get() == nullptr, "Ende");
+    CHECK(getVirtualCameraStats().skipped == 1, "übersprungen: %u", getVirtualCameraStats().skipped);
+    virtualCameraClose();
+}
+
+static void testDirectory(const std::string& dir) {
+    writeFile(dir + "/b.jpg", fakeJpeg(320, 240, 1));
+    writeFile(dir + "/a.jpeg", fakeJpeg(320, 240, 0));
+    writeFile(dir + "/notiz.txt", std::vector<uint8_t>(3, 'x'));
+
+    CHECK(virtualCameraOpen(dir.c_str(), VCAM_FAST, 1, 20), "Ordner öffnen");
+    CHECK(getVirtualCameraStats().frames == 2, "nur JPEGs: %u", getVirtualCameraStats().frames);
+    for (int i = 0; i < 2; i++) {
+        camera_fb_t* fb = esp_camera_fb_get();
+        CHECK(fb && fb->buf[fb->len - 1] == i, "nach Namen sortiert %d", i);
+        CHECK(fb && fb->width == 320 && fb->height == 240, "Größe aus SOF");
+        CHECK(fb && virtualCameraRecordedUs(fb) == i * 50000, "Takt aus fps");
+        esp_camera_fb_return(fb);
+    }
+    virtualCameraClose();
+
+    CHECK(!virtualCameraOpen((dir + "/fehlt.hrec").c_str(), VCAM_FAST), "fehlende Datei");
+}
+
+int main() {
+    char dirTemplate[] = "/tmp/recording_test_XXXXXX";
+    std::string dir = mkdtemp(dirTemplate);
+    std::string recording = dir + "/clip.hrec";
+    writeFile(recording, makeRecording(100000));
+
+    testContainer();
+    testColorLog();
+    testFast(recording);
+    testRealtime(recording);
+
+    std::string jpegDir = dir + "/bilder";
+    mkdir(jpegDir.c_str(), 0700);
+    testDirectory(jpegDir);
+
+    unlink((jpegDir + "/a.jpeg").c_str());
+    unlink((jpegDir + "/b.jpg").c_str());
+    unlink((jpegDir + "/notiz.txt").c_str());
+    rmdir(jpegDir.c_str());
+    unlink(recording.c_str());
+    rmdir(dir.c_str());
+
+    return testSummary("recording_test");
+}
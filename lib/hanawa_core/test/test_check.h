@@ -0,0 +1,32 @@
+#ifndef TEST_CHECK_H
+#define TEST_CHECK_H
+
+// Gemeinsames Gerüst der Host-Tests (lib/hanawa_core/test und
+// sucher2/esp32cam_webserver/local_test): CHECK() meldet einen Fehler mit
+// Datei und Zeile und macht weiter, testSummary() gibt das Ergebnis aus und
+// liefert den Rückgabewert für main(). Jeder Test ist eine eigene
+// Übersetzungseinheit, der Zähler daher static.
+
+#include <cstdio>
+
+static int g_failures = 0;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        printf("FEHLER %s:%d: ", __FILE__, __LINE__); \
+        printf(__VA_ARGS__); \
+        printf("\n"); \
+        g_failures++; \
+    } \
+} while (0)
+
+static int testSummary(const char* name) {
+    if (g_failures == 0) {
+        printf("%s: OK\n", name);
+        return 0;
+    }
+    printf("%s: %d Fehler\n", name, g_failures);
+    return 1;
+}
+
+#endif // TEST_CHECK_H
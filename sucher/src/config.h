@@ -23,10 +23,15 @@
 #define LEUCHTER_PORT 8888
 #define SUCHER_PORT 8889
 
+// Fan-out an mehrere Leuchter: ein Multicast-Paket statt Unicast an LEUCHTER_IP.
+// Jeder Leuchter tritt der Gruppe bei und nimmt sich seinen Ausschnitt aus "colors".
+#define LEUCHTER_FANOUT 0
+#define LEUCHTER_MULTICAST_IP "239.0.0.81"
+
 // Kamera-Konfiguration
 #define CAMERA_FRAME_SIZE FRAMESIZE_QQVGA  // 160x120
-#define CAMERA_FORMAT PIXFORMAT_RGB565
-#define CAMERA_JPEG_QUALITY 80
+#define CAMERA_FORMAT PIXFORMAT_JPEG  // Stream sendet die Sensor-JPEGs unverändert
+#define CAMERA_JPEG_QUALITY 12        // 0-63, kleiner = besser
 #define CAMERA_FB_COUNT 1
 
 // Standard-Teilungen
@@ -36,5 +41,10 @@
 // Performance-Einstellungen
 #define ANALYSIS_FPS 10  // Frames pro Sekunde für Farbanalyse
 #define UDP_BUFFER_SIZE 2048
+#define FRAME_DEADLINE_MS 150  // Frame spätestens so lange nach dem Capture anzeigen, 0 = keine Deadline
+
+// Live-Vorschau per WebSocket (ws://<SUCHER_IP>:LIVE_WS_PORT/ws)
+#define LIVE_WS_PORT 81
+#define LIVE_WS_MAX_CLIENTS 4
 
 #endif
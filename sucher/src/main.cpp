@@ -19,6 +19,10 @@
 #include "WiFiUdp.h"
 #include "config.h"
 #include "webpage.h"
+#include "frame_broker.h"
+#include "window_geometry.h"
+#include "color_reduce.h"
+#include "color_math.h"
 
 #define PART_BOUNDARY "123456789000000000000987654321"
 
@@ -71,19 +75,45 @@ bool calibrationMode = true;
 
 ColorData* colorSegments = nullptr;
 Segment* visualSegments = nullptr;
+WindowRect* segmentRects = nullptr;
+WindowRect* decodeRects = nullptr;  // dieselben Segmente im verkleinert dekodierten Bild
 int totalSegments = 0;
 int currentPoint = 0;
 
+// Frame-Identität für den Leuchter (Sequenz + Capture-Zeitpunkt)
+uint32_t frameSequence = 0;
+int64_t frameCaptureUs = 0;
+
+// UDP-Zähler (werden über /status ausgeliefert)
+uint32_t udpFramesSent = 0;
+uint32_t udpSendErrors = 0;
+uint32_t udpFramesLate = 0;
+
+// Frame-Verbraucher (Kamera gehört allein dem Frame-Broker)
+int streamConsumer = -1;
+int analysisConsumer = -1;
+#define STREAM_FRAME_TIMEOUT_MS 1000
+#define ANALYSIS_FRAME_TIMEOUT_MS 200
+
+// JPEG-Frames werden für die Analyse verkleinert dekodiert (VGA → 320x240),
+// in einen Puffer, der einmal im PSRAM angelegt wird und bleibt
+#define ANALYSIS_JPEG_SCALE JPG_SCALE_2X
+#define ANALYSIS_JPEG_DIVISOR 2
+uint8_t* analysisRgbBuffer = nullptr;
+size_t analysisRgbCapacity = 0;
+
+// Konfigurationsversion: ändert sich bei Kalibrierung, Parametern und Reset
+uint16_t configVersion = 1;
+
 // Funktionsdeklarationen
 void setupWebServer();
+String buildStatusJson();
+void startLiveServer();
+void pushLiveColors();
+void pushLiveStatus();
 void calculateSegments();
 void analyzeColors();
-void analyzeSegment(uint8_t* buffer, int width, int height, int x1, int y1, int x2, int y2, ColorData* colorData);
 void sendColorData();
-void drawSegmentsOnImage(uint8_t* buffer, int width, int height);
-void drawQuadrilateral(uint8_t* buffer, int width, int height);
-void drawLine(uint8_t* buffer, int width, int height, int x1, int y1, int x2, int y2, uint8_t r, uint8_t g, uint8_t b);
-void drawRectangle(uint8_t* buffer, int width, int height, int x1, int y1, int x2, int y2, uint8_t r, uint8_t g, uint8_t b, bool filled);
 
 static const char* _STREAM_CONTENT_TYPE = "multipart/x-mixed-replace;boundary=" PART_BOUNDARY;
 static const char* _STREAM_BOUNDARY = "\r\n--" PART_BOUNDARY "\r\n";
@@ -91,115 +121,55 @@ static const char* _STREAM_PART = "Content-Type: image/jpeg\r\nContent-Length: %
 
 httpd_handle_t stream_httpd = NULL;
 
+// Sendet die JPEG-Frames des Sensors unverändert (kein Dekodieren, kein
+// Einzeichnen, kein Neukodieren). Quadrat und Segmente zeichnet die Webseite
+// selbst auf ein Canvas, Geometrie und Farben kommen über den Live-WebSocket.
 static esp_err_t stream_handler(httpd_req_t *req){
   if (DEBUG_STREAM) Serial.println("=== STREAM HANDLER START ===");
   
   camera_fb_t * fb = NULL;
   esp_err_t res = ESP_OK;
-  size_t _jpg_buf_len = 0;
-  uint8_t * _jpg_buf = NULL;
-  char * part_buf[64];
+  char part_buf[64];
 
-  if (DEBUG_STREAM) Serial.println("Setze Content-Type...");
   res = httpd_resp_set_type(req, _STREAM_CONTENT_TYPE);
   if(res != ESP_OK){
     if (DEBUG_STREAM) Serial.printf("Content-Type Set fehlgeschlagen: 0x%x\n", res);
     return res;
   }
-  if (DEBUG_STREAM) Serial.println("Content-Type erfolgreich gesetzt");
 
   int frame_count = 0;
   while(true){
-    frame_count++;
-    if (DEBUG_STREAM) Serial.printf("--- Frame %d ---\n", frame_count);
-    
-    if (DEBUG_STREAM) Serial.println("Hole Kamera-Frame...");
-    fb = esp_camera_fb_get();
+    fb = acquireFrame(streamConsumer, STREAM_FRAME_TIMEOUT_MS);
     if (!fb) {
       if (DEBUG_STREAM) Serial.println("❌ Camera capture failed");
       res = ESP_FAIL;
-    } else {
-      if (DEBUG_STREAM) Serial.printf("✅ Frame erhalten: %dx%d, Format: %d, Länge: %d\n", 
-                   fb->width, fb->height, fb->format, fb->len);
-      uint8_t* rgb_buf = nullptr;
-
-      if(fb->format == PIXFORMAT_RGB565){
-        // Direkt auf Frame-Buffer zeichnen
-        rgb_buf = fb->buf;
-      } else {
-        // Falls Kamera trotzdem JPEG liefert
-        if (DEBUG_STREAM) Serial.println("JPEG -> RGB565 konvertieren...");
-        rgb_buf = (uint8_t*)malloc(fb->width * fb->height * 2);
-        jpg2rgb565(fb->buf, fb->len, rgb_buf, JPG_SCALE_NONE);
-      }
-
-      // Visualisierung einzeichnen
-      if (!calibrationMode) {
-        drawQuadrilateral(rgb_buf, fb->width, fb->height);
-        drawSegmentsOnImage(rgb_buf, fb->width, fb->height);
-      }
-
-      // RGB565 -> JPEG kodieren
-      if (DEBUG_STREAM) Serial.println("RGB565 -> JPEG komprimieren...");
-      bool ok = fmt2jpg(rgb_buf, fb->width * fb->height * 2,
-                        fb->width, fb->height, PIXFORMAT_RGB565,
-                        80, &_jpg_buf, &_jpg_buf_len);
-      if(!ok){
-        if (DEBUG_STREAM) Serial.println("❌ fmt2jpg fehlgeschlagen");
-        res = ESP_FAIL;
-      }
-      
-      // Aufgeräumt
-      if(fb->format != PIXFORMAT_RGB565){
-        free(rgb_buf);
-      }
-      esp_camera_fb_return(fb);
-      fb = NULL;
-      }
+    } else if (fb->format != PIXFORMAT_JPEG) {
+      if (DEBUG_STREAM) Serial.println("❌ Kamera liefert kein JPEG (CAMERA_FORMAT prüfen)");
+      res = ESP_FAIL;
+    }
     
     if(res == ESP_OK){
-      if (DEBUG_STREAM) Serial.println("Sende HTTP Header...");
-      size_t hlen = snprintf((char *)part_buf, 64, _STREAM_PART, _jpg_buf_len);
-      res = httpd_resp_send_chunk(req, (const char *)part_buf, hlen);
-      if(res != ESP_OK && DEBUG_STREAM) {
-        Serial.printf("❌ Header senden fehlgeschlagen: 0x%x\n", res);
-      }
+      size_t hlen = snprintf(part_buf, sizeof(part_buf), _STREAM_PART, fb->len);
+      res = httpd_resp_send_chunk(req, part_buf, hlen);
     }
-    
     if(res == ESP_OK){
-      if (DEBUG_STREAM) Serial.printf("Sende JPEG-Daten (%d Bytes)...\n", _jpg_buf_len);
-      res = httpd_resp_send_chunk(req, (const char *)_jpg_buf, _jpg_buf_len);
-      if(res != ESP_OK && DEBUG_STREAM) {
-        Serial.printf("❌ JPEG-Daten senden fehlgeschlagen: 0x%x\n", res);
-      }
+      res = httpd_resp_send_chunk(req, (const char *)fb->buf, fb->len);
     }
-    
     if(res == ESP_OK){
-      if (DEBUG_STREAM) Serial.println("Sende Boundary...");
       res = httpd_resp_send_chunk(req, _STREAM_BOUNDARY, strlen(_STREAM_BOUNDARY));
-      if(res != ESP_OK && DEBUG_STREAM) {
-        Serial.printf("❌ Boundary senden fehlgeschlagen: 0x%x\n", res);
-      }
     }
     
-    if(fb){
-      if (DEBUG_STREAM) Serial.println("Gebe Frame Buffer frei...");
-      esp_camera_fb_return(fb);
-      fb = NULL;
-      _jpg_buf = NULL;
-    } else if(_jpg_buf){
-      if (DEBUG_STREAM) Serial.println("Gebe JPEG Buffer frei...");
-      free(_jpg_buf);
-      _jpg_buf = NULL;
-    }
+    // Erst nach dem Senden freigeben: der Puffer geht direkt auf den Socket
+    releaseFrame(fb);
+    fb = NULL;
     
     if(res != ESP_OK){
       if (DEBUG_STREAM) Serial.printf("❌ Stream-Fehler: 0x%x\n", res);
       break;
     }
     
-    if (DEBUG_STREAM) Serial.printf("✅ Frame %d erfolgreich gesendet\n", frame_count);
-    delay(100); // Kleine Pause zwischen Frames
+    frame_count++;
+    if (DEBUG_STREAM) Serial.printf("✅ Frame %d gesendet\n", frame_count);
   }
   
   if (DEBUG_STREAM) Serial.println("=== STREAM HANDLER ENDE ===");
@@ -232,6 +202,248 @@ void startCameraServer(){
   if (DEBUG_SERIAL) Serial.println("=== CAMERA SERVER GESTARTET ===");
 }
 
+// ============================================================================
+// LIVE-WEBSOCKET (Port LIVE_WS_PORT)
+// ============================================================================
+// Der WebServer auf Port 80 kann keine WebSockets, daher ein eigener
+// esp_http_server. Gepusht wird immer nur der neueste Stand: ist noch ein
+// Push in der Warteschlange, wird er beim Senden einfach mit den neuesten
+// Daten ausgeführt (Drop-to-latest). Wer nicht innerhalb von 1 s abnimmt,
+// wird getrennt.
+
+#define LIVE_MSG_COLORS 0x01
+#define LIVE_MSG_RECTS 0x02
+#define LIVE_COLORS_HEADER 11
+#define LIVE_RECTS_HEADER 5
+#define LIVE_MAX_SEGMENTS (2 * (50 + 30))  // max. Teilungen der Webseite
+#define LIVE_COLORS_MAX (LIVE_COLORS_HEADER + 3 * LIVE_MAX_SEGMENTS)
+#define LIVE_RECTS_MAX (LIVE_RECTS_HEADER + 8 * LIVE_MAX_SEGMENTS)
+
+httpd_handle_t live_httpd = NULL;
+static SemaphoreHandle_t liveMutex = NULL;
+static int liveClients[LIVE_WS_MAX_CLIENTS];
+static uint16_t liveClientVersion[LIVE_WS_MAX_CLIENTS];  // zuletzt gesendeter Status
+static uint16_t liveClientRects[LIVE_WS_MAX_CLIENTS];    // zuletzt gesendete Rechtecke
+static uint8_t liveColorBuf[LIVE_COLORS_MAX];
+static size_t liveColorLen = 0;
+static uint8_t liveRectsBuf[LIVE_RECTS_MAX];
+static size_t liveRectsLen = 0;
+static uint16_t liveRectsVersion = 0;  // configVersion der Rechtecke, 0 = noch keine
+static String liveStatus;
+static bool livePushQueued = false;
+uint32_t liveFramesDropped = 0;
+
+static int liveClientCount() {
+  int n = 0;
+  for (int i = 0; i < LIVE_WS_MAX_CLIENTS; i++) {
+    if (liveClients[i] >= 0) n++;
+  }
+  return n;
+}
+
+static void liveRemoveClient(int fd) {
+  xSemaphoreTake(liveMutex, portMAX_DELAY);
+  for (int i = 0; i < LIVE_WS_MAX_CLIENTS; i++) {
+    if (liveClients[i] == fd) liveClients[i] = -1;
+  }
+  xSemaphoreGive(liveMutex);
+}
+
+static void liveSend(int fd, httpd_ws_type_t type, const uint8_t* data, size_t len) {
+  httpd_ws_frame_t frame;
+  memset(&frame, 0, sizeof(frame));
+  frame.final = true;
+  frame.type = type;
+  frame.payload = (uint8_t*)data;
+  frame.len = len;
+  if (httpd_ws_send_frame_async(live_httpd, fd, &frame) != ESP_OK) {
+    if (DEBUG_SERIAL) Serial.printf("Live-WebSocket: Client %d getrennt\n", fd);
+    liveRemoveClient(fd);
+    httpd_sess_trigger_close(live_httpd, fd);
+  }
+}
+
+// Läuft im Task des Live-Servers
+static void livePushWork(void* arg) {
+  static uint8_t colors[LIVE_COLORS_MAX];
+  static uint8_t rects[LIVE_RECTS_MAX];
+  size_t colorLen;
+  size_t rectsLen;
+  String status;
+  uint16_t version;
+  int clients[LIVE_WS_MAX_CLIENTS];
+  bool needStatus[LIVE_WS_MAX_CLIENTS];
+  bool needRects[LIVE_WS_MAX_CLIENTS];
+
+  xSemaphoreTake(liveMutex, portMAX_DELAY);
+  livePushQueued = false;
+  colorLen = liveColorLen;
+  memcpy(colors, liveColorBuf, colorLen);
+  rectsLen = liveRectsLen;
+  memcpy(rects, liveRectsBuf, rectsLen);
+  status = liveStatus;
+  version = configVersion;
+  for (int i = 0; i < LIVE_WS_MAX_CLIENTS; i++) {
+    clients[i] = liveClients[i];
+    needStatus[i] = liveClients[i] >= 0 && liveClientVersion[i] != version;
+    if (needStatus[i]) liveClientVersion[i] = version;
+    needRects[i] = liveClients[i] >= 0 && rectsLen > 0 && liveClientRects[i] != liveRectsVersion;
+    if (needRects[i]) liveClientRects[i] = liveRectsVersion;
+  }
+  xSemaphoreGive(liveMutex);
+
+  for (int i = 0; i < LIVE_WS_MAX_CLIENTS; i++) {
+    if (clients[i] < 0) continue;
+    if (needStatus[i] && status.length() > 0) {
+      liveSend(clients[i], HTTPD_WS_TYPE_TEXT, (const uint8_t*)status.c_str(), status.length());
+    }
+    if (needRects[i]) {
+      liveSend(clients[i], HTTPD_WS_TYPE_BINARY, rects, rectsLen);
+    }
+    if (colorLen > 0) {
+      liveSend(clients[i], HTTPD_WS_TYPE_BINARY, colors, colorLen);
+    }
+  }
+}
+
+// Muss mit gehaltenem liveMutex aufgerufen werden
+static void liveQueuePush() {
+  if (livePushQueued) {
+    liveFramesDropped++;
+    return;
+  }
+  if (httpd_queue_work(live_httpd, livePushWork, NULL) == ESP_OK) {
+    livePushQueued = true;
+  }
+}
+
+static esp_err_t live_ws_handler(httpd_req_t *req) {
+  if (req->method == HTTP_GET) {
+    // Handshake abgeschlossen: Client eintragen, Status sofort schicken
+    int fd = httpd_req_to_sockfd(req);
+    xSemaphoreTake(liveMutex, portMAX_DELAY);
+    int slot = -1;
+    for (int i = 0; i < LIVE_WS_MAX_CLIENTS; i++) {
+      if (liveClients[i] < 0 && slot < 0) slot = i;
+    }
+    if (slot >= 0) {
+      liveClients[slot] = fd;
+      liveClientVersion[slot] = 0;
+      liveClientRects[slot] = 0;
+      liveQueuePush();
+    }
+    xSemaphoreGive(liveMutex);
+    if (DEBUG_SERIAL) Serial.printf("Live-WebSocket: Client %d %s\n", fd, slot >= 0 ? "verbunden" : "abgelehnt (voll)");
+    return slot >= 0 ? ESP_OK : ESP_FAIL;
+  }
+
+  // Eingehende Frames (z.B. Ping vom Browser) lesen und verwerfen
+  uint8_t buf[32];
+  httpd_ws_frame_t frame;
+  memset(&frame, 0, sizeof(frame));
+  frame.payload = buf;
+  esp_err_t res = httpd_ws_recv_frame(req, &frame, 0);
+  if (res == ESP_OK && frame.len <= sizeof(buf)) {
+    res = httpd_ws_recv_frame(req, &frame, frame.len);
+  }
+  return res;
+}
+
+static void live_close_fn(httpd_handle_t hd, int fd) {
+  liveRemoveClient(fd);
+  close(fd);
+}
+
+void startLiveServer() {
+  liveMutex = xSemaphoreCreateMutex();
+  for (int i = 0; i < LIVE_WS_MAX_CLIENTS; i++) liveClients[i] = -1;
+  liveStatus = buildStatusJson();
+
+  httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+  config.server_port = LIVE_WS_PORT;
+  config.ctrl_port = LIVE_WS_PORT + 32768;  // muss sich vom Stream-Server unterscheiden
+  config.max_open_sockets = LIVE_WS_MAX_CLIENTS + 1;
+  config.lru_purge_enable = true;
+  config.send_wait_timeout = 1;
+  config.close_fn = live_close_fn;
+
+  httpd_uri_t ws_uri = {
+    .uri          = "/ws",
+    .method       = HTTP_GET,
+    .handler      = live_ws_handler,
+    .user_ctx     = NULL,
+    .is_websocket = true
+  };
+
+  if (httpd_start(&live_httpd, &config) == ESP_OK) {
+    httpd_register_uri_handler(live_httpd, &ws_uri);
+    if (DEBUG_SERIAL) Serial.printf("✅ Live-WebSocket auf Port %d\n", LIVE_WS_PORT);
+  } else {
+    if (DEBUG_SERIAL) Serial.println("❌ Live-WebSocket starten fehlgeschlagen");
+  }
+}
+
+// Farben des aktuellen Frames an alle Clients, bei neuer Konfiguration
+// vorher die Rechtecke (binär, siehe README)
+void pushLiveColors() {
+  size_t len = LIVE_COLORS_HEADER + totalSegments * 3;
+  if (!live_httpd || totalSegments == 0 || len > LIVE_COLORS_MAX) return;
+  xSemaphoreTake(liveMutex, portMAX_DELAY);
+  if (liveClientCount() == 0) {
+    xSemaphoreGive(liveMutex);
+    return;
+  }
+  uint8_t* p = liveColorBuf;
+  p[0] = LIVE_MSG_COLORS;
+  memcpy(p + 1, &frameSequence, 4);       // little endian
+  memcpy(p + 5, &configVersion, 2);
+  p[7] = (uint8_t)horizontalDivisions;
+  p[8] = (uint8_t)verticalDivisions;
+  uint16_t count = (uint16_t)totalSegments;
+  memcpy(p + 9, &count, 2);
+  for (int i = 0; i < totalSegments; i++) {
+    p[LIVE_COLORS_HEADER + i * 3] = colorSegments[i].r;
+    p[LIVE_COLORS_HEADER + i * 3 + 1] = colorSegments[i].g;
+    p[LIVE_COLORS_HEADER + i * 3 + 2] = colorSegments[i].b;
+  }
+  liveColorLen = len;
+  
+  // Rechtecke nur nach einer Konfigurationsänderung neu kodieren
+  if (liveRectsVersion != configVersion) {
+    uint8_t* r = liveRectsBuf;
+    r[0] = LIVE_MSG_RECTS;
+    memcpy(r + 1, &configVersion, 2);
+    memcpy(r + 3, &count, 2);
+    for (int i = 0; i < totalSegments; i++) {
+      int16_t xy[4] = {(int16_t)visualSegments[i].x1, (int16_t)visualSegments[i].y1,
+                       (int16_t)visualSegments[i].x2, (int16_t)visualSegments[i].y2};
+      memcpy(r + LIVE_RECTS_HEADER + i * 8, xy, 8);
+    }
+    liveRectsLen = LIVE_RECTS_HEADER + totalSegments * 8;
+    liveRectsVersion = configVersion;
+  }
+  liveQueuePush();
+  xSemaphoreGive(liveMutex);
+}
+
+// Status-JSON an alle Clients, nach jeder Konfigurationsänderung aufrufen
+void pushLiveStatus() {
+  if (!live_httpd) return;
+  configVersion++;
+  String status = buildStatusJson();
+  xSemaphoreTake(liveMutex, portMAX_DELAY);
+  liveStatus = status;
+  liveColorLen = 0;  // alte Farben und Rechtecke passen nicht mehr zur neuen Einteilung
+  liveRectsLen = 0;
+  if (liveClientCount() > 0) liveQueuePush();
+  xSemaphoreGive(liveMutex);
+}
+
+// Meldungen des Frame-Brokers (lib/hanawa_core) auf die Konsole
+static void brokerLog(bool error, const char* message) {
+  if (DEBUG_SERIAL) Serial.printf("%s Frame-Broker: %s\n", error ? "❌" : "✅", message);
+}
+
 void setup() {
   Serial.begin(115200);
   Serial.setDebugOutput(DEBUG_SERIAL);
@@ -306,6 +518,13 @@ void setup() {
   
   if (DEBUG_SERIAL) Serial.println("✅ Kamera-Initialisierung erfolgreich!");
   
+  // Capture-Task starten, Stream und Analyse holen Frames nur noch über den Broker
+  FrameBrokerHooks brokerHooks = { brokerLog, nullptr, nullptr };
+  setFrameBrokerHooks(brokerHooks);
+  initFrameBroker();
+  streamConsumer = registerFrameConsumer("stream");
+  analysisConsumer = registerFrameConsumer("analysis");
+  
   // WLAN verbinden
   if (DEBUG_SERIAL) {
     Serial.println("=== WLAN-VERBINDUNG ===");
@@ -356,6 +575,7 @@ void setup() {
   
   // Streaming Web Server starten
   startCameraServer();
+  startLiveServer();
   
   // Web-Server Routen
   setupWebServer();
@@ -378,6 +598,7 @@ void loop() {
   if (!calibrationMode && totalSegments > 0) {
     analyzeColors();
     sendColorData();
+    pushLiveColors();
     delay(1000 / ANALYSIS_FPS); // Konfigurierbare FPS
   }
   
@@ -391,6 +612,9 @@ void loop() {
     Serial.printf("Uptime: %lu Sekunden\n", millis() / 1000);
     Serial.printf("Kalibrierungsmodus: %s\n", calibrationMode ? "Ja" : "Nein");
     Serial.printf("Segmente: %d\n", totalSegments);
+    FrameBrokerStats broker = getFrameBrokerStats();
+    Serial.printf("Frame-Broker: %u aufgenommen, %u geteilt, Timeouts %u\n",
+                  broker.framesCaptured, broker.framesShared, broker.waitTimeouts);
     Serial.println("====================");
     lastStatus = millis();
   }
@@ -454,6 +678,7 @@ void setupWebServer() {
       if (DEBUG_SERIAL) Serial.printf("Ungültiger Punkt-Index: %d\n", pointIndex);
     }
     
+    pushLiveStatus();
     server.send(200, "application/json", "{\"status\":\"ok\"}");
   });
   
@@ -474,28 +699,14 @@ void setupWebServer() {
     if (!calibrationMode) {
       calculateSegments();
     }
+    pushLiveStatus();
     
     server.send(200, "application/json", "{\"status\":\"ok\"}");
   });
   
   // Status
   server.on("/status", HTTP_GET, []() {
-    DynamicJsonDocument doc(1024);
-    doc["calibrationMode"] = calibrationMode;
-    doc["horizontalDivisions"] = horizontalDivisions;
-    doc["verticalDivisions"] = verticalDivisions;
-    doc["totalSegments"] = totalSegments;
-    doc["fps"] = ANALYSIS_FPS;
-    
-    for (int i = 0; i < 4; i++) {
-      doc["corners"][i]["x"] = tvCorners[i].x;
-      doc["corners"][i]["y"] = tvCorners[i].y;
-      doc["corners"][i]["set"] = tvCorners[i].set;
-    }
-    
-    String response;
-    serializeJson(doc, response);
-    server.send(200, "application/json", response);
+    server.send(200, "application/json", buildStatusJson());
   });
   
   // Reset-Kalibrierung
@@ -509,6 +720,7 @@ void setupWebServer() {
     calibrationMode = true;
     currentPoint = 0;
     
+    pushLiveStatus();
     if (DEBUG_SERIAL) Serial.println("✅ Kalibrierung zurückgesetzt");
     server.send(200, "application/json", "{\"status\":\"ok\"}");
   });
@@ -517,6 +729,32 @@ void setupWebServer() {
   if (DEBUG_SERIAL) Serial.println("✅ Web-Server gestartet");
 }
 
+String buildStatusJson() {
+  DynamicJsonDocument doc(1024);
+  doc["calibrationMode"] = calibrationMode;
+  doc["horizontalDivisions"] = horizontalDivisions;
+  doc["verticalDivisions"] = verticalDivisions;
+  doc["totalSegments"] = totalSegments;
+  doc["fps"] = ANALYSIS_FPS;
+  doc["sequence"] = frameSequence;
+  doc["configVersion"] = configVersion;
+  doc["udpSent"] = udpFramesSent;
+  doc["udpErrors"] = udpSendErrors;
+  doc["udpLate"] = udpFramesLate;
+  doc["udpTarget"] = LEUCHTER_FANOUT ? LEUCHTER_MULTICAST_IP : LEUCHTER_IP;
+  doc["liveDropped"] = liveFramesDropped;
+  
+  for (int i = 0; i < 4; i++) {
+    doc["corners"][i]["x"] = tvCorners[i].x;
+    doc["corners"][i]["y"] = tvCorners[i].y;
+    doc["corners"][i]["set"] = tvCorners[i].set;
+  }
+  
+  String response;
+  serializeJson(doc, response);
+  return response;
+}
+
 void calculateSegments() {
   if (DEBUG_SERIAL) Serial.println("=== BERECHNE SEGMENTE ===");
   
@@ -543,279 +781,105 @@ void calculateSegments() {
   }
   visualSegments = new Segment[totalSegments];
   
+  // Rechtecke, die analyzeColors() pro Frame neu berechnet
+  if (segmentRects != nullptr) {
+    delete[] segmentRects;
+  }
+  segmentRects = new WindowRect[totalSegments];
+  if (decodeRects != nullptr) {
+    delete[] decodeRects;
+  }
+  decodeRects = new WindowRect[totalSegments];
+  
   if (DEBUG_SERIAL) {
     Serial.printf("✅ Segmente berechnet: %d\n", totalSegments);
-    Serial.printf("Speicher alloziiert: %d Bytes\n", totalSegments * (sizeof(ColorData) + sizeof(Segment)));
+    Serial.printf("Speicher alloziiert: %d Bytes\n", totalSegments * (sizeof(ColorData) + sizeof(Segment) + sizeof(WindowRect)));
   }
 }
 
 void analyzeColors() {
-  camera_fb_t * fb = esp_camera_fb_get();
+  camera_fb_t * fb = acquireFrame(analysisConsumer, ANALYSIS_FRAME_TIMEOUT_MS);
   if (!fb) return;
   
-  // Konvertiere zu RGB565 falls nötig
-  uint8_t* rgb_buffer = nullptr;
+  // Capture-Zeitpunkt (esp_timer-Basis) und Sequenz für sendColorData() merken
+  frameCaptureUs = (int64_t)fb->timestamp.tv_sec * 1000000LL + fb->timestamp.tv_usec;
+  frameSequence++;
+  
+  // JPEG verkleinert nach RGB565 dekodieren, RGB565-Frames direkt lesen
+  uint8_t* rgb_buffer = fb->buf;
+  int width = fb->width;
+  int height = fb->height;
+  int divisor = 1;
   if (fb->format == PIXFORMAT_JPEG) {
-    // JPEG zu RGB konvertieren
-    rgb_buffer = (uint8_t*)malloc(fb->width * fb->height * 2);
-    jpg2rgb565(fb->buf, fb->len, rgb_buffer, JPG_SCALE_NONE);
-  } else {
-    rgb_buffer = fb->buf;
+    divisor = ANALYSIS_JPEG_DIVISOR;
+    width = fb->width / divisor;
+    height = fb->height / divisor;
+    size_t needed = (size_t)width * height * 2;
+    if (needed > analysisRgbCapacity) {
+      // Nur beim ersten Frame bzw. größerer Auflösung
+      free(analysisRgbBuffer);
+      analysisRgbBuffer = (uint8_t*)(psramFound() ? ps_malloc(needed) : malloc(needed));
+      analysisRgbCapacity = analysisRgbBuffer ? needed : 0;
+    }
+    rgb_buffer = analysisRgbBuffer;
+    if (!rgb_buffer || !jpg2rgb565(fb->buf, fb->len, rgb_buffer, ANALYSIS_JPEG_SCALE)) {
+      if (DEBUG_SERIAL) Serial.println(rgb_buffer ? "JPEG-Dekodierung fehlgeschlagen" : "Kein Speicher für RGB565-Puffer");
+      releaseFrame(fb);
+      return;
+    }
   }
   
-  // Berechne Steigungen für automatische Skalierung
-  float topSlope = (tvCorners[1].y - tvCorners[0].y) / (float)horizontalDivisions;
-  float bottomSlope = (tvCorners[2].y - tvCorners[3].y) / (float)horizontalDivisions;
-  float leftSlope = (tvCorners[3].x - tvCorners[0].x) / (float)verticalDivisions;
-  float rightSlope = (tvCorners[2].x - tvCorners[1].x) / (float)verticalDivisions;
+  // Segment-Geometrie und Farbreduktion aus lib/hanawa_core; Ecken für das
+  // dekodierte Bild mitskalieren, die Webseite bekommt Frame-Koordinaten
+  int corners[4][2];
+  int decodeCorners[4][2];
+  for (int c = 0; c < 4; c++) {
+    corners[c][0] = tvCorners[c].x;
+    corners[c][1] = tvCorners[c].y;
+    decodeCorners[c][0] = tvCorners[c].x / divisor;
+    decodeCorners[c][1] = tvCorners[c].y / divisor;
+  }
+  int count = calculateEdgeSegments(corners, horizontalDivisions, verticalDivisions, segmentRects, totalSegments);
+  calculateEdgeSegments(decodeCorners, horizontalDivisions, verticalDivisions, decodeRects, totalSegments);
   
   // Analysiere jedes Segment
-  int segmentIndex = 0;
-  
-  // Horizontale Segmente (oben und unten)
-  for (int i = 0; i < horizontalDivisions; i++) {
-    // Obere Kante
-    int x1 = tvCorners[0].x + (tvCorners[1].x - tvCorners[0].x) * i / horizontalDivisions;
-    int y1 = tvCorners[0].y + (tvCorners[1].y - tvCorners[0].y) * i / horizontalDivisions;
-    int x2 = tvCorners[0].x + (tvCorners[1].x - tvCorners[0].x) * (i + 1) / horizontalDivisions;
-    int y2 = tvCorners[0].y + (tvCorners[1].y - tvCorners[0].y) * (i + 1) / horizontalDivisions;
-    
-    // Tiefe basiert auf vertikaler Teilung
-    int depth = (tvCorners[3].y - tvCorners[0].y) / verticalDivisions;
-    
-    analyzeSegment(rgb_buffer, fb->width, fb->height, x1, y1, x2, y1 + depth, &colorSegments[segmentIndex]);
-    
-    // Speichere Segment für Visualisierung
-    visualSegments[segmentIndex].x1 = x1;
-    visualSegments[segmentIndex].y1 = y1;
-    visualSegments[segmentIndex].x2 = x2;
-    visualSegments[segmentIndex].y2 = y1 + depth;
-    visualSegments[segmentIndex].color = colorSegments[segmentIndex];
-    segmentIndex++;
-    
-    // Untere Kante
-    x1 = tvCorners[3].x + (tvCorners[2].x - tvCorners[3].x) * i / horizontalDivisions;
-    y1 = tvCorners[3].y + (tvCorners[2].y - tvCorners[3].y) * i / horizontalDivisions;
-    x2 = tvCorners[3].x + (tvCorners[2].x - tvCorners[3].x) * (i + 1) / horizontalDivisions;
-    y2 = tvCorners[3].y + (tvCorners[2].y - tvCorners[3].y) * (i + 1) / horizontalDivisions;
-    
-    analyzeSegment(rgb_buffer, fb->width, fb->height, x1, y1 - depth, x2, y1, &colorSegments[segmentIndex]);
+  for (int i = 0; i < count; i++) {
+    const WindowRect& rect = segmentRects[i];
+    const WindowRect& d = decodeRects[i];
+    RGB color = calculateSegmentRms(rgb_buffer, width, height, d.x1, d.y1, d.x2, d.y2);
+    colorSegments[i].r = color.r;
+    colorSegments[i].g = color.g;
+    colorSegments[i].b = color.b;
+    colorSegments[i].brightness = rgbLuminance(color);
     
     // Speichere Segment für Visualisierung
-    visualSegments[segmentIndex].x1 = x1;
-    visualSegments[segmentIndex].y1 = y1 - depth;
-    visualSegments[segmentIndex].x2 = x2;
-    visualSegments[segmentIndex].y2 = y1;
-    visualSegments[segmentIndex].color = colorSegments[segmentIndex];
-    segmentIndex++;
-  }
-  
-  // Vertikale Segmente (links und rechts)
-  for (int i = 0; i < verticalDivisions; i++) {
-    // Linke Kante
-    int x1 = tvCorners[0].x + (tvCorners[3].x - tvCorners[0].x) * i / verticalDivisions;
-    int y1 = tvCorners[0].y + (tvCorners[3].y - tvCorners[0].y) * i / verticalDivisions;
-    int x2 = tvCorners[0].x + (tvCorners[3].x - tvCorners[0].x) * (i + 1) / verticalDivisions;
-    int y2 = tvCorners[0].y + (tvCorners[3].y - tvCorners[0].y) * (i + 1) / verticalDivisions;
-    
-    // Tiefe basiert auf horizontaler Teilung
-    int depth = (tvCorners[1].x - tvCorners[0].x) / horizontalDivisions;
-    
-    analyzeSegment(rgb_buffer, fb->width, fb->height, x1, y1, x1 + depth, y2, &colorSegments[segmentIndex]);
-    
-    // Speichere Segment für Visualisierung
-    visualSegments[segmentIndex].x1 = x1;
-    visualSegments[segmentIndex].y1 = y1;
-    visualSegments[segmentIndex].x2 = x1 + depth;
-    visualSegments[segmentIndex].y2 = y2;
-    visualSegments[segmentIndex].color = colorSegments[segmentIndex];
-    segmentIndex++;
-    
-    // Rechte Kante
-    x1 = tvCorners[1].x + (tvCorners[2].x - tvCorners[1].x) * i / verticalDivisions;
-    y1 = tvCorners[1].y + (tvCorners[2].y - tvCorners[1].y) * i / verticalDivisions;
-    x2 = tvCorners[1].x + (tvCorners[2].x - tvCorners[1].x) * (i + 1) / verticalDivisions;
-    y2 = tvCorners[1].y + (tvCorners[2].y - tvCorners[1].y) * (i + 1) / verticalDivisions;
-    
-    analyzeSegment(rgb_buffer, fb->width, fb->height, x1 - depth, y1, x1, y2, &colorSegments[segmentIndex]);
-    
-    // Speichere Segment für Visualisierung
-    visualSegments[segmentIndex].x1 = x1 - depth;
-    visualSegments[segmentIndex].y1 = y1;
-    visualSegments[segmentIndex].x2 = x1;
-    visualSegments[segmentIndex].y2 = y2;
-    visualSegments[segmentIndex].color = colorSegments[segmentIndex];
-    segmentIndex++;
-  }
-  
-  // Visualisierung wird jetzt im Stream-Handler gezeichnet
-  
-  if (fb->format == PIXFORMAT_JPEG && rgb_buffer != fb->buf) {
-    free(rgb_buffer);
+    visualSegments[i].x1 = rect.x1;
+    visualSegments[i].y1 = rect.y1;
+    visualSegments[i].x2 = rect.x2;
+    visualSegments[i].y2 = rect.y2;
+    visualSegments[i].color = colorSegments[i];
   }
   
-  esp_camera_fb_return(fb);
-}
-
-void analyzeSegment(uint8_t* buffer, int width, int height, int x1, int y1, int x2, int y2, ColorData* colorData) {
-  uint32_t totalR2 = 0, totalG2 = 0, totalB2 = 0;
-  int pixelCount = 0;
-  
-  // Durchlaufe alle Pixel im Segment
-  for (int y = min(y1, y2); y <= max(y1, y2); y++) {
-    for (int x = min(x1, x2); x <= max(x1, x2); x++) {
-      if (x >= 0 && x < width && y >= 0 && y < height) {
-        int pixelIndex = (y * width + x) * 2;
-        uint16_t pixel = (buffer[pixelIndex + 1] << 8) | buffer[pixelIndex];
-        
-        // RGB565 zu RGB888 konvertieren
-        uint8_t r = ((pixel >> 11) & 0x1F) << 3;
-        uint8_t g = ((pixel >> 5) & 0x3F) << 2;
-        uint8_t b = (pixel & 0x1F) << 3;
-        
-        // RMS-Berechnung: Quadriere die Werte
-        totalR2 += r * r;
-        totalG2 += g * g;
-        totalB2 += b * b;
-        pixelCount++;
-      }
-    }
-  }
+  // Visualisierung zeichnet die Webseite (Rechtecke per Live-WebSocket)
   
-  if (pixelCount > 0) {
-    // RMS: Wurzel aus dem Durchschnitt der Quadrate
-    colorData->r = sqrt(totalR2 / pixelCount);
-    colorData->g = sqrt(totalG2 / pixelCount);
-    colorData->b = sqrt(totalB2 / pixelCount);
-    
-    // Helligkeit berechnen (Luminance)
-    colorData->brightness = (colorData->r * 299 + colorData->g * 587 + colorData->b * 114) / 1000;
-  } else {
-    colorData->r = colorData->g = colorData->b = colorData->brightness = 0;
-  }
+  releaseFrame(fb);
 }
 
-void drawQuadrilateral(uint8_t* buffer, int width, int height) {
-  // Prüfe ob alle Punkte gesetzt sind
-  bool allSet = true;
-  for (int i = 0; i < 4; i++) {
-    if (!tvCorners[i].set) {
-      allSet = false;
-      if (DEBUG_SERIAL) Serial.printf("Punkt %d nicht gesetzt\n", i);
-      break;
-    }
-  }
+void sendColorData() {
+  if (totalSegments == 0) return;
   
-  if (!allSet) {
-    if (DEBUG_SERIAL) Serial.println("Nicht alle Punkte gesetzt, zeichne kein Viereck");
+  // Frames, die ihre Deadline schon vor dem Senden verpasst haben, verwerfen
+  int64_t ageUs = esp_timer_get_time() - frameCaptureUs;
+  if (FRAME_DEADLINE_MS > 0 && ageUs > (int64_t)FRAME_DEADLINE_MS * 1000) {
+    udpFramesLate++;
     return;
   }
   
-  if (DEBUG_SERIAL) {
-    Serial.println("Zeichne Viereck zwischen Punkten:");
-    for (int i = 0; i < 4; i++) {
-      Serial.printf("Punkt %d: (%d, %d)\n", i, tvCorners[i].x, tvCorners[i].y);
-    }
-  }
-  
-  // Zeichne Linien zwischen den 4 Punkten (Viereck)
-  if (DEBUG_SERIAL) {
-    Serial.println("Zeichne Linien:");
-    Serial.printf("Linie 1: (%d,%d) -> (%d,%d)\n", tvCorners[0].x, tvCorners[0].y, tvCorners[1].x, tvCorners[1].y);
-    Serial.printf("Linie 2: (%d,%d) -> (%d,%d)\n", tvCorners[1].x, tvCorners[1].y, tvCorners[2].x, tvCorners[2].y);
-    Serial.printf("Linie 3: (%d,%d) -> (%d,%d)\n", tvCorners[2].x, tvCorners[2].y, tvCorners[3].x, tvCorners[3].y);
-    Serial.printf("Linie 4: (%d,%d) -> (%d,%d)\n", tvCorners[3].x, tvCorners[3].y, tvCorners[0].x, tvCorners[0].y);
-  }
-  
-  drawLine(buffer, width, height, tvCorners[0].x, tvCorners[0].y, tvCorners[1].x, tvCorners[1].y, 0, 255, 0); // Oben
-  drawLine(buffer, width, height, tvCorners[1].x, tvCorners[1].y, tvCorners[2].x, tvCorners[2].y, 0, 255, 0); // Rechts
-  drawLine(buffer, width, height, tvCorners[2].x, tvCorners[2].y, tvCorners[3].x, tvCorners[3].y, 0, 255, 0); // Unten
-  drawLine(buffer, width, height, tvCorners[3].x, tvCorners[3].y, tvCorners[0].x, tvCorners[0].y, 0, 255, 0); // Links
-  
-  if (DEBUG_SERIAL) Serial.println("✅ Viereck gezeichnet");
-}
-
-void drawSegmentsOnImage(uint8_t* buffer, int width, int height) {
-  for (int i = 0; i < totalSegments; i++) {
-    // Zeichne Segment als gefülltes Rechteck in der analysierten Farbe
-    drawRectangle(buffer, width, height, 
-                 visualSegments[i].x1, visualSegments[i].y1, 
-                 visualSegments[i].x2, visualSegments[i].y2,
-                 visualSegments[i].color.r, 
-                 visualSegments[i].color.g, 
-                 visualSegments[i].color.b, 
-                 true);
-  }
-}
-
-void drawLine(uint8_t* buffer, int width, int height, int x1, int y1, int x2, int y2, uint8_t r, uint8_t g, uint8_t b) {
-  // Bresenham-Linienalgorithmus mit dickerer Linie
-  int dx = abs(x2 - x1);
-  int dy = abs(y2 - y1);
-  int sx = (x1 < x2) ? 1 : -1;
-  int sy = (y1 < y2) ? 1 : -1;
-  int err = dx - dy;
-  
-  int x = x1, y = y1;
-  
-  while (true) {
-    // Zeichne 3x3 Pixel für dickere Linie
-    for (int dy_offset = -1; dy_offset <= 1; dy_offset++) {
-      for (int dx_offset = -1; dx_offset <= 1; dx_offset++) {
-        int draw_x = x + dx_offset;
-        int draw_y = y + dy_offset;
-        
-        if (draw_x >= 0 && draw_x < width && draw_y >= 0 && draw_y < height) {
-          int pixelIndex = (draw_y * width + draw_x) * 2;
-          // RGB888 zu RGB565 konvertieren
-          uint16_t pixel = ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3);
-          buffer[pixelIndex] = pixel & 0xFF;
-          buffer[pixelIndex + 1] = (pixel >> 8) & 0xFF;
-        }
-      }
-    }
-    
-    if (x == x2 && y == y2) break;
-    
-    int e2 = 2 * err;
-    if (e2 > -dy) {
-      err -= dy;
-      x += sx;
-    }
-    if (e2 < dx) {
-      err += dx;
-      y += sy;
-    }
-  }
-}
-
-void drawRectangle(uint8_t* buffer, int width, int height, int x1, int y1, int x2, int y2, uint8_t r, uint8_t g, uint8_t b, bool filled) {
-  int minX = min(x1, x2);
-  int maxX = max(x1, x2);
-  int minY = min(y1, y2);
-  int maxY = max(y1, y2);
-  
-  // RGB888 zu RGB565 konvertieren
-  uint16_t pixel = ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3);
-  uint8_t pixelLow = pixel & 0xFF;
-  uint8_t pixelHigh = (pixel >> 8) & 0xFF;
-  
-  for (int y = minY; y <= maxY; y++) {
-    for (int x = minX; x <= maxX; x++) {
-      if (x >= 0 && x < width && y >= 0 && y < height) {
-        int pixelIndex = (y * width + x) * 2;
-        buffer[pixelIndex] = pixelLow;
-        buffer[pixelIndex + 1] = pixelHigh;
-      }
-    }
-  }
-}
-
-void sendColorData() {
-  if (totalSegments == 0) return;
-  
   DynamicJsonDocument doc(UDP_BUFFER_SIZE);
   doc["segments"] = totalSegments;
+  doc["seq"] = frameSequence;
+  doc["ts"] = (uint32_t)frameCaptureUs;  // µs, läuft nach ~71 min über
+  doc["deadline"] = FRAME_DEADLINE_MS;
   
   JsonArray colors = doc.createNestedArray("colors");
   for (int i = 0; i < totalSegments; i++) {
@@ -829,9 +893,14 @@ void sendColorData() {
   String jsonString;
   serializeJson(doc, jsonString);
   
-  udp.beginPacket(LEUCHTER_IP, LEUCHTER_PORT);
-  udp.write((uint8_t*)jsonString.c_str(), jsonString.length());
-  udp.endPacket();
+  const char* target = LEUCHTER_FANOUT ? LEUCHTER_MULTICAST_IP : LEUCHTER_IP;
+  if (udp.beginPacket(target, LEUCHTER_PORT) &&
+      udp.write((uint8_t*)jsonString.c_str(), jsonString.length()) == jsonString.length() &&
+      udp.endPacket()) {
+    udpFramesSent++;
+  } else {
+    udpSendErrors++;
+  }
   
   if (DEBUG_FPS) {
     static unsigned long lastSend = 0;
@@ -88,21 +88,12 @@ const char MAIN_page[] PROGMEM = R"rawliteral(
             display: none;
             z-index: 5;
         }
-        .segment-grid {
+        #overlay {
             position: absolute;
+            top: 3px;
+            left: 3px;
             pointer-events: none;
-            display: none;
-        }
-        .segment {
-            position: absolute;
-            border: 1px solid rgba(255, 255, 0, 0.5);
-            background: rgba(255, 255, 0, 0.1);
-            font-size: 10px;
-            color: white;
-            text-shadow: 1px 1px 1px black;
-            display: flex;
-            align-items: center;
-            justify-content: center;
+            z-index: 4;
         }
         button {
             background: #007cba;
@@ -168,7 +159,7 @@ const char MAIN_page[] PROGMEM = R"rawliteral(
                         <div class="calibration-point" id="point4" style="bottom: 10px; left: 10px;"></div>
                     </div>
                     <div id="calibrationBox" class="calibration-box"></div>
-                    <div id="segmentGrid" class="segment-grid"></div>
+                    <canvas id="overlay" width="640" height="480"></canvas>
                 </div>
             </div>
             
@@ -176,6 +167,7 @@ const char MAIN_page[] PROGMEM = R"rawliteral(
                 <div class="status">
                     <strong>Status:</strong> <span id="statusText">Kalibrierung läuft...</span><br>
                     <strong>Punkt:</strong> <span id="currentPoint">1</span> von 4
+                    <br><strong>Live:</strong> <span id="liveText">nicht verbunden</span>
                 </div>
                 
                 <div class="coordinates">
@@ -293,8 +285,10 @@ const char MAIN_page[] PROGMEM = R"rawliteral(
             document.getElementById('point' + currentPoint).classList.add('current');
             document.getElementById('point' + currentPoint).style.display = 'block';
             
-            // Segment-Grid und Box ausblenden
-            document.getElementById('segmentGrid').style.display = 'none';
+            // Overlay und Box ausblenden
+            liveRects = null;
+            liveColors = null;
+            drawOverlay();
             document.getElementById('calibrationBox').style.display = 'none';
             
             // Buttons zurücksetzen
@@ -376,27 +370,60 @@ const char MAIN_page[] PROGMEM = R"rawliteral(
             updateSegmentGrid();
         }
         
-        // Segment-Grid aktualisieren
+        // Segment-Overlay: Rechtecke und Farben kommen vom Sucher
         function updateSegmentGrid() {
+            drawOverlay();
+        }
+        
+        // === OVERLAY (Canvas über dem Stream) ===
+        // Der Stream liefert die Sensor-JPEGs unverändert, Viereck und
+        // Segmente werden hier gezeichnet statt im Sucher.
+        let liveRects = null;    // { version, rects: Int16Array [x1,y1,x2,y2,...] }
+        let liveColors = null;   // { sequence, version, rgb: Uint8Array }
+        let overlayScheduled = false;
+        
+        function scheduleOverlay() {
+            if (overlayScheduled) return;
+            overlayScheduled = true;
+            requestAnimationFrame(function() {
+                overlayScheduled = false;
+                drawOverlay();
+            });
+        }
+        
+        function drawOverlay() {
+            const canvas = document.getElementById('overlay');
+            const ctx = canvas.getContext('2d');
+            ctx.clearRect(0, 0, canvas.width, canvas.height);
             if (!calibrationComplete) return;
             
-            const grid = document.getElementById('segmentGrid');
-            grid.innerHTML = '';
-            grid.style.display = 'block';
-            
-            const totalSegments = (horizontalDivisions * 2) + (verticalDivisions * 2);
+            // Klick-Koordinaten sind auf 640x480 bezogen
+            ctx.strokeStyle = 'rgb(0, 255, 0)';
+            ctx.lineWidth = 2;
+            ctx.beginPath();
+            for (let i = 0; i <= 4; i++) {
+                const p = pointCoordinates[i % 4];
+                if (i === 0) ctx.moveTo(p.x, p.y); else ctx.lineTo(p.x, p.y);
+            }
+            ctx.stroke();
             
-            // Hier würden die Segmente basierend auf den Kalibrierungspunkten gezeichnet
-            // Vereinfachte Darstellung für Demo
-            for (let i = 0; i < totalSegments; i++) {
-                const segment = document.createElement('div');
-                segment.className = 'segment';
-                segment.textContent = i + 1;
-                segment.style.left = (10 + (i * 5) % 620) + 'px';
-                segment.style.top = (10 + Math.floor(i / 20) * 10) + 'px';
-                segment.style.width = '20px';
-                segment.style.height = '20px';
-                grid.appendChild(segment);
+            // Segmente nur zeichnen, wenn Farben und Rechtecke zusammenpassen
+            if (!liveRects || !liveColors || liveRects.version !== liveColors.version) return;
+            const video = document.getElementById('video');
+            const scaleX = canvas.width / (video.naturalWidth || 640);
+            const scaleY = canvas.height / (video.naturalHeight || 480);
+            const count = Math.min(liveRects.rects.length / 4, liveColors.rgb.length / 3);
+            for (let k = 0; k < count; k++) {
+                const x1 = liveRects.rects[k * 4] * scaleX;
+                const y1 = liveRects.rects[k * 4 + 1] * scaleY;
+                const x2 = liveRects.rects[k * 4 + 2] * scaleX;
+                const y2 = liveRects.rects[k * 4 + 3] * scaleY;
+                const c = liveColors.rgb;
+                ctx.fillStyle = `rgb(${c[k * 3]}, ${c[k * 3 + 1]}, ${c[k * 3 + 2]})`;
+                ctx.fillRect(x1, y1, x2 - x1, y2 - y1);
+                ctx.strokeStyle = 'rgba(255, 255, 0, 0.5)';
+                ctx.lineWidth = 1;
+                ctx.strokeRect(x1, y1, x2 - x1, y2 - y1);
             }
         }
         
@@ -407,8 +434,6 @@ const char MAIN_page[] PROGMEM = R"rawliteral(
             document.getElementById('stopBtn').disabled = false;
             document.getElementById('statusText').textContent = 'Farbanalyse läuft...';
             
-            // Hier würde die Analyse gestartet
-            updateStatus();
         }
         
         // Farbanalyse stoppen
@@ -419,17 +444,67 @@ const char MAIN_page[] PROGMEM = R"rawliteral(
             document.getElementById('statusText').textContent = 'Farbanalyse gestoppt';
         }
         
-        // Status aktualisieren
-        function updateStatus() {
-            if (analysisRunning) {
-                fetch('/status')
-                    .then(response => response.json())
-                    .then(data => {
-                        // Status-Updates hier
-                    });
-                
-                setTimeout(updateStatus, 1000);
+        // Live-Daten per WebSocket (ersetzt das Status-Polling)
+        // Text = Status-JSON bei Konfigurationsänderung, binär = Rechtecke
+        // (nach Konfigurationsänderung) und Farben (pro Frame)
+        function handleStatus(data) {
+            // Ecken vom Sucher übernehmen (z.B. von einem anderen Browser gesetzt)
+            if (data.corners) {
+                for (let i = 0; i < 4; i++) {
+                    if (data.corners[i] && data.corners[i].set) {
+                        pointCoordinates[i] = { x: data.corners[i].x, y: data.corners[i].y, set: true };
+                    }
+                }
+            }
+            if (data.calibrationMode !== undefined) {
+                if (!data.calibrationMode && !calibrationComplete) {
+                    // Kalibrierung wurde extern abgeschlossen
+                    calibrationComplete = true;
+                    document.getElementById('statusText').textContent = 'Kalibrierung abgeschlossen!';
+                    document.getElementById('startBtn').disabled = false;
+                    updateSettings();
+                }
             }
+            scheduleOverlay();
+        }
+        
+        function handleBinary(buffer) {
+            const view = new DataView(buffer);
+            const type = view.getUint8(0);
+            if (type === 2) {
+                const count = view.getUint16(3, true);
+                const rects = new Int16Array(count * 4);
+                for (let i = 0; i < count * 4; i++) {
+                    rects[i] = view.getInt16(5 + i * 2, true);
+                }
+                liveRects = { version: view.getUint16(1, true), rects: rects };
+            } else if (type === 1) {
+                const sequence = view.getUint32(1, true);
+                const count = view.getUint16(9, true);
+                liveColors = {
+                    sequence: sequence,
+                    version: view.getUint16(5, true),
+                    rgb: new Uint8Array(buffer, 11, count * 3)
+                };
+                document.getElementById('liveText').textContent = 'Frame ' + sequence + ', ' + count + ' Segmente';
+                scheduleOverlay();
+            }
+        }
+        
+        function connectLive() {
+            const socket = new WebSocket('ws://' + location.hostname + ':81/ws');
+            socket.binaryType = 'arraybuffer';
+            socket.onmessage = function(event) {
+                if (typeof event.data === 'string') {
+                    handleStatus(JSON.parse(event.data));
+                } else {
+                    handleBinary(event.data);
+                }
+            };
+            socket.onclose = function() {
+                document.getElementById('liveText').textContent = 'nicht verbunden';
+                setTimeout(connectLive, 2000);
+            };
         }
         
         // Initialisierung
@@ -441,24 +516,8 @@ const char MAIN_page[] PROGMEM = R"rawliteral(
             // Koordinaten initialisieren
             updateCoordinates();
             
-            // Status regelmäßig aktualisieren
-            setInterval(function() {
-                if (!analysisRunning) {
-                    fetch('/status')
-                        .then(response => response.json())
-                        .then(data => {
-                            if (data.calibrationMode !== undefined) {
-                                if (!data.calibrationMode && !calibrationComplete) {
-                                    // Kalibrierung wurde extern abgeschlossen
-                                    calibrationComplete = true;
-                                    document.getElementById('statusText').textContent = 'Kalibrierung abgeschlossen!';
-                                    document.getElementById('startBtn').disabled = false;
-                                    updateSettings();
-                                }
-                            }
-                        });
-                }
-            }, 2000);
+            // Live-Verbindung aufbauen
+            connectLive();
         });
     </script>
 </body>
@@ -0,0 +1,170 @@
+// Host-Test: Allokationszähler und "keine Allokation im eingeschwungenen Zustand"
+//
+// Übersetzen und ausführen (im Ordner local_test):
+//   g++ -std=c++11 -O2 -Wall -pthread -DALLOC_TRACKING=1 -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc -I../src -I../../../lib/hanawa_core/src -I../../../lib/hanawa_core/test alloc_test.cpp ../src/alloc_tracker.cpp ../../../lib/hanawa_core/src/stage_metrics.cpp ../src/deferred_log.cpp -o alloc_test
+//   ./alloc_test
+//
+// Prüft die Zuordnung zu Stufen (StageTimer) und Routen (ALLOC_SCOPE), das
+// Warm-up, die Meldung mit Aufrufer-Adresse und die Werte für /api/metrics.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "alloc_tracker.h"
+#include "deferred_log.h"
+#include "test_check.h"
+
+// Hält Zeiger fest, damit der Compiler malloc/free nicht wegoptimiert
+static void* volatile g_sink;
+
+static const AllocScopeStats* findScope(const AllocScopeStats* scopes, int n, const char* name) {
+    for (int i = 0; i < n; i++) {
+        if (strcmp(scopes[i].name, name) == 0) {
+            return &scopes[i];
+        }
+    }
+    return nullptr;
+}
+
+// Frame wie in calculateAmbilightContinuous(): Puffer werden wiederverwendet
+static std::vector<int> s_colors;
+
+static void steadyFrame() {
+    ALLOC_FRAME_BEGIN();
+    StageTimer reduction(STAGE_REDUCTION);
+    s_colors.clear();   // behält die Kapazität
+    for (int i = 0; i < 32; i++) {
+        s_colors.push_back(i);
+    }
+    reduction.stop();
+    ALLOC_FRAME_END();
+}
+
+__attribute__((noinline)) static void leakyFrame() {
+    ALLOC_FRAME_BEGIN();
+    void* p = malloc(320 * 240 * 2);   // wie der RGB-Puffer pro Frame
+    g_sink = p;
+    free(p);
+    ALLOC_FRAME_END();
+}
+
+static void testAttribution() {
+    resetAllocStats();
+    {
+        StageTimer t(STAGE_GEOMETRY);
+        std::vector<int> rects;
+        for (int i = 0; i < 100; i++) {
+            rects.push_back(i);   // wächst mehrfach
+        }
+        g_sink = rects.data();
+    }
+    {
+        ALLOC_SCOPE("/api/ambilight");
+        std::string json(200, 'x');
+        g_sink = &json[0];
+        {
+            // Stufe innerhalb der Route gewinnt
+            StageTimer t(STAGE_API_JSON);
+            g_sink = malloc(64);
+            free(g_sink);
+        }
+    }
+    g_sink = calloc(4, 16);
+    free(g_sink);
+
+    AllocScopeStats scopes[ALLOC_MAX_SCOPES];
+    int n = getAllocScopes(scopes, ALLOC_MAX_SCOPES);
+    const AllocScopeStats* geometry = findScope(scopes, n, "geometry");
+    const AllocScopeStats* route = findScope(scopes, n, "/api/ambilight");
+    const AllocScopeStats* json = findScope(scopes, n, "api_json");
+    const AllocScopeStats* other = findScope(scopes, n, "other");
+    CHECK(geometry && geometry->allocs >= 5 && geometry->bytes >= 400, "geometry %u/%u",
+          geometry ? geometry->allocs : 0, geometry ? geometry->bytes : 0);
+    CHECK(route && route->allocs == 1 && route->bytes >= 201, "Route %u/%u",
+          route ? route->allocs : 0, route ? route->bytes : 0);
+    CHECK(json && json->allocs == 1 && json->bytes == 64, "api_json");
+    CHECK(other && other->allocs == 1 && other->bytes == 64, "calloc nicht unter other");
+
+    AllocStats stats = getAllocStats();
+    CHECK(stats.allocs == geometry->allocs + 3, "gesamt %u", stats.allocs);
+    CHECK(stats.steadyAllocs == 0, "steady ohne Frame-Schleife");
+}
+
+static void testSteadyState() {
+    allocRestartWarmup();
+    resetAllocStats();
+
+    // Warm-up: der erste Frame lässt die Puffer wachsen, das ist erlaubt
+    for (int i = 0; i < ALLOC_WARMUP_FRAMES; i++) {
+        steadyFrame();
+    }
+    CHECK(getAllocStats().allocs > 0, "Warm-up ohne Allokation");
+    CHECK(getAllocStats().frames == ALLOC_WARMUP_FRAMES, "frames %u", getAllocStats().frames);
+
+    for (int i = 0; i < 100; i++) {
+        steadyFrame();
+    }
+    CHECK(getAllocStats().steadyAllocs == 0, "steady %u", getAllocStats().steadyAllocs);
+
+    LogCursor cursor = logCursorLast(0);
+    leakyFrame();
+    leakyFrame();
+
+    AllocStats stats = getAllocStats();
+    CHECK(stats.steadyAllocs == 2 && stats.steadyBytes == 2 * 320 * 240 * 2, "steady %u/%u",
+          stats.steadyAllocs, stats.steadyBytes);
+
+    AllocFlag flags[ALLOC_MAX_FLAGGED];
+    int n = getAllocFlags(flags, ALLOC_MAX_FLAGGED);
+    CHECK(n == 1, "Meldungen %d", n);
+    if (n == 1) {
+        const char* fn = (const char*)(void*)&leakyFrame;
+        const char* caller = (const char*)flags[0].caller;
+        CHECK(caller > fn && caller < fn + 512, "Aufrufer %p nicht in leakyFrame %p", flags[0].caller, (void*)fn);
+        CHECK(flags[0].count == 2 && strcmp(flags[0].scope, "other") == 0, "count %u scope %s",
+              flags[0].count, flags[0].scope);
+    }
+
+    // Meldung steht (einmal) im Log
+    LogEntry entry;
+    char text[160];
+    int logged = 0;
+    while (logReadNext(&cursor, &entry, nullptr)) {
+        logFormat(entry, text, sizeof(text));
+        if (strstr(text, "[alloc] Allokation in der Frame-Schleife: 153600 B in other")) {
+            logged++;
+        }
+    }
+    CHECK(logged == 1, "Log-Meldungen %d", logged);
+
+    // Neue Konfiguration: Warm-up beginnt von vorn
+    allocRestartWarmup();
+    leakyFrame();
+    CHECK(getAllocStats().steadyAllocs == 2, "während Warm-up gemeldet");
+}
+
+static void testMetrics() {
+    MetricValue values[48];
+    int n = getAllocMetricValues(values, 48);
+    bool total = false;
+    bool route = false;
+    bool bytes = false;
+    for (int i = 0; i < n; i++) {
+        total |= strcmp(values[i].name, "alloc_steady_total") == 0 && values[i].value == 2 && values[i].counter;
+        route |= strcmp(values[i].name, "alloc_api_ambilight_total") == 0;
+        bytes |= strcmp(values[i].name, "alloc_reduction_bytes_total") == 0;
+    }
+    CHECK(total, "alloc_steady_total fehlt");
+    CHECK(route, "alloc_api_ambilight_total fehlt");
+    CHECK(bytes, "alloc_reduction_bytes_total fehlt");
+}
+
+int main() {
+    testAttribution();
+    testSteadyState();
+    testMetrics();
+
+    return testSummary("alloc_test");
+}
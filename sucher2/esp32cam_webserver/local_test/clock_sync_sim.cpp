@@ -0,0 +1,189 @@
+// Host-Simulation: Uhrensynchronisation mit zwei Leuchtern
+//
+// Übersetzen und ausführen (im Ordner local_test):
+//   g++ -std=c++11 -O2 -Wall -I../src -I../../../lib/hanawa_core/src clock_sync_sim.cpp ../src/clock_sync.cpp ../../../lib/hanawa_core/src/ambilight_protocol.cpp -o clock_sync_sim
+//   ./clock_sync_sim [Jitter-ms] [Sekunden] [Drift-ppm]
+//
+// Ein Sucher treibt zwei Leuchter mit eigenen, versetzten und driftenden Uhren.
+// Jedes Paket bekommt eine Grundlaufzeit plus exponentiell verteilten Jitter
+// (unabhängig pro Richtung und Empfänger). Verwendet werden die echten
+// Firmware-Klassen: AmbilightFrameEncoder/-Receiver mit Timing-Erweiterung
+// und ClockSyncSender/-Receiver.
+//
+// Ausgegeben wird der Versatz zwischen den beiden Umschaltzeitpunkten
+// (echte Zeit) pro Frame: einmal "bei Ankunft zeigen" wie bisher, einmal
+// zum gemeinsamen Anzeigezeitpunkt nach der Synchronisation.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "ambilight_protocol.h"
+#include "clock_sync.h"
+
+#define SIM_FPS            10
+#define SIM_PING_MS        1000   // Ping-Intervall
+#define SIM_BASE_DELAY_US  1500   // Grundlaufzeit pro Paket
+#define SIM_ANALYSIS_US    20000  // Capture → Senden (Analyse im Sucher)
+#define SIM_PROCESSING_US  200    // Ping → Pong im Leuchter
+#define SIM_DEADLINE_MS    150
+#define SIM_HSEG           50
+#define SIM_VSEG           30
+
+// Einfacher, reproduzierbarer Zufallsgenerator (xorshift32)
+static uint32_t s_rng = 12345;
+static double nextRandom() {
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return ((s_rng & 0xFFFFFF) + 0.5) / (double)0x1000000;
+}
+
+// Einweg-Laufzeit in µs (echte Zeit)
+static double packetDelay(double jitterUs) {
+    return SIM_BASE_DELAY_US - jitterUs * std::log(nextRandom());
+}
+
+// Leuchter mit eigener Uhr: lokal = base + t * (1 + drift)
+struct FakeLeuchter {
+    double baseUs;
+    double drift;
+    AmbilightReceiver rx;
+    ClockSyncReceiver sync;
+
+    FakeLeuchter(uint8_t id, double base, double driftPpm)
+        : baseUs(base), drift(driftPpm * 1e-6), sync(id) {}
+
+    uint32_t clock(double t) const { return (uint32_t)(int64_t)(baseUs + t * (1.0 + drift)); }
+    double trueOffset(double t) const { return baseUs + t * drift; }
+
+    // Lokalen Zeitpunkt in echte Zeit zurückrechnen (nahe Referenz t)
+    double toTrue(uint32_t local, double t) const {
+        int32_t diff = (int32_t)(local - clock(t));
+        return t + diff / (1.0 + drift);
+    }
+};
+
+struct Stats {
+    std::vector<double> skew;
+    void print(const char* name) {
+        if (skew.empty()) {
+            printf("%-28s %8s\n", name, "-");
+            return;
+        }
+        std::sort(skew.begin(), skew.end());
+        double sum = 0;
+        for (size_t i = 0; i < skew.size(); i++) sum += skew[i];
+        printf("%-28s %8zu %9.0f %9.0f %9.0f %9.0f\n", name, skew.size(),
+               sum / skew.size(), skew[skew.size() / 2],
+               skew[(size_t)(skew.size() * 0.95)], skew.back());
+    }
+};
+
+int main(int argc, char** argv) {
+    double jitterUs = ((argc > 1) ? atof(argv[1]) : 3.0) * 1000.0;
+    int seconds = (argc > 2) ? atoi(argv[2]) : 120;
+    double driftPpm = (argc > 3) ? atof(argv[3]) : 30.0;
+
+    // Sender-Uhr = echte Zeit, Leuchter beliebig versetzt und gegenläufig driftend
+    FakeLeuchter leuchter[2] = {
+        FakeLeuchter(1, 123456789.0, driftPpm),
+        FakeLeuchter(2, 3987654321.0, -driftPpm)
+    };
+    ClockSyncSender sync;
+
+    static AmbilightFrameEncoder encoder;
+    encoder.setTimingEnabled(true);
+    int vert = SIM_VSEG - 2;
+    std::vector<RGB> top(SIM_HSEG), bottom(SIM_HSEG), right(vert), left(vert);
+    AmbilightSides sides = {top.data(), SIM_HSEG, right.data(), vert, bottom.data(), SIM_HSEG, left.data(), vert};
+
+    Stats onArrival, synced;
+    double maxOffsetError = 0;
+    uint32_t late = 0;
+    uint8_t buf[CLOCK_SYNC_PING_MAX];
+    uint8_t pong[CLOCK_SYNC_PONG_SIZE];
+
+    double frameUs = 1e6 / SIM_FPS;
+    int frames = seconds * SIM_FPS;
+    for (int f = 0; f < frames; f++) {
+        double capture = f * frameUs;
+
+        // Ping zu Beginn jeder Sekunde (alle Pongs sind vor dem nächsten Ping da)
+        if (f % (SIM_PING_MS * SIM_FPS / 1000) == 0) {
+            size_t len = sync.buildPing((uint32_t)capture, buf, sizeof(buf));
+            for (int i = 0; i < 2; i++) {
+                FakeLeuchter& l = leuchter[i];
+                double arrive = capture + packetDelay(jitterUs);
+                double reply = arrive + SIM_PROCESSING_US;
+                size_t n = l.sync.onPing(buf, len, l.clock(arrive), l.clock(reply), pong, sizeof(pong));
+                double back = reply + packetDelay(jitterUs);
+                sync.onPong(pong, n, (uint32_t)back);
+                if (l.sync.synced()) {
+                    l.rx.setClockOffset(l.sync.offsetUs());
+                    uint32_t trueOffset = (uint32_t)(int64_t)l.trueOffset(capture);
+                    double err = std::fabs((double)(int32_t)((uint32_t)l.sync.offsetUs() - trueOffset));
+                    if (f >= 2 * SIM_FPS) maxOffsetError = std::max(maxOffsetError, err);
+                }
+            }
+        }
+
+        // Frame kodieren und an beide Leuchter senden
+        top[0].r = (uint8_t)f;
+        AmbilightFrameMeta meta = {(uint32_t)f + 1, (uint32_t)capture, SIM_DEADLINE_MS};
+        int packets = encoder.encode(SIM_HSEG, SIM_VSEG, sides, &meta);
+        double send = capture + SIM_ANALYSIS_US;
+
+        double shownArrival[2], shownSynced[2];
+        bool both = true, bothSynced = true;
+        for (int i = 0; i < 2; i++) {
+            FakeLeuchter& l = leuchter[i];
+            // Fragmente in Ankunftsreihenfolge zustellen (Pacing wie ESPNOW_PACKET_GAP_US)
+            std::vector<std::pair<double, int> > arrivals;
+            for (int p = 0; p < packets; p++) {
+                arrivals.push_back(std::make_pair(send + p * 1500 + packetDelay(jitterUs), p));
+            }
+            std::sort(arrivals.begin(), arrivals.end());
+            bool complete = false;
+            for (size_t k = 0; k < arrivals.size(); k++) {
+                int p = arrivals[k].second;
+                complete |= l.rx.onPacket(encoder.packet(p), encoder.packetLength(p), l.clock(arrivals[k].first));
+                shownArrival[i] = arrivals[k].first;
+            }
+            if (!complete) {
+                both = bothSynced = false;
+                continue;
+            }
+            uint32_t presentLocal;
+            if (l.rx.presentAtUs(&presentLocal)) {
+                shownSynced[i] = l.toTrue(presentLocal, shownArrival[i]);
+            } else {
+                bothSynced = false;
+            }
+        }
+        if (both) {
+            onArrival.skew.push_back(std::fabs(shownArrival[0] - shownArrival[1]));
+        }
+        if (bothSynced) {
+            synced.skew.push_back(std::fabs(shownSynced[0] - shownSynced[1]));
+        }
+    }
+    late = leuchter[0].rx.stats().framesLate + leuchter[1].rx.stats().framesLate;
+
+    printf("2 Leuchter, %d s @ %d FPS, Jitter %.1f ms (exponentiell), Drift ±%.0f ppm, Deadline %d ms\n\n",
+           seconds, SIM_FPS, jitterUs / 1000.0, driftPpm, SIM_DEADLINE_MS);
+    printf("%-28s %8s %9s %9s %9s %9s\n", "Versatz der Umschaltung [µs]", "Frames", "Mittel", "p50", "p95", "max");
+    printf("---------------------------------------------------------------------------\n");
+    onArrival.print("bei Ankunft zeigen");
+    synced.print("gemeinsamer Anzeigezeitpunkt");
+    printf("\nmax. Offset-Fehler nach Einschwingen: %.0f µs, verspätete Frames: %u\n", maxOffsetError, late);
+    for (int i = 0; i < 2; i++) {
+        const ClockSyncPeer* p = sync.findPeer(leuchter[i].sync.id());
+        if (p) {
+            printf("Leuchter %d: Offset %d µs, bester Round-Trip %u µs, %u Pongs\n",
+                   p->id, p->offsetUs, p->delayUs, p->pongs);
+        }
+    }
+    return 0;
+}
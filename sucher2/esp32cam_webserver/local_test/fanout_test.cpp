@@ -0,0 +1,225 @@
+// Host-Test: Fan-out an mehrere Leuchter per UDP-Multicast (Loopback)
+//
+// Übersetzen und ausführen (im Ordner local_test, Linux/macOS):
+//   g++ -std=c++11 -Wall -I../src -I../../../lib/hanawa_core/src -I../../../lib/hanawa_core/test fanout_test.cpp ../../../lib/hanawa_core/src/ambilight_protocol.cpp -o fanout_test
+//   ./fanout_test
+//
+// Der AmbilightFrameEncoder sendet jeden Frame einmal an eine Multicast-Gruppe
+// auf 127.0.0.1. 1, 2, 4 und 8 Empfänger-Sockets treten der Gruppe bei, jeder
+// mit eigenem AmbilightReceiver und eigenem Ausschnitt (AmbilightIndexRange).
+// Geprüft wird, dass jeder Empfänger genau seinen Ausschnitt bekommt und dass
+// Pakete und Bytes pro Frame nicht von der Zahl der Empfänger abhängen.
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "ambilight_protocol.h"
+#include "test_check.h"
+
+#define FANOUT_GROUP  "239.0.0.81"
+#define FANOUT_PORT   18888
+#define FANOUT_FRAMES 20
+#define FANOUT_HSEG   50
+#define FANOUT_VSEG   30
+
+// Multicast-Transport über einen echten UDP-Socket
+class MulticastTransport : public AmbilightTransport {
+public:
+    MulticastTransport() : packets(0), bytes(0) {
+        m_fd = socket(AF_INET, SOCK_DGRAM, 0);
+        in_addr iface;
+        iface.s_addr = inet_addr("127.0.0.1");
+        setsockopt(m_fd, IPPROTO_IP, IP_MULTICAST_IF, &iface, sizeof(iface));
+        unsigned char loop = 1;
+        setsockopt(m_fd, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop));
+        memset(&m_dest, 0, sizeof(m_dest));
+        m_dest.sin_family = AF_INET;
+        m_dest.sin_port = htons(FANOUT_PORT);
+        m_dest.sin_addr.s_addr = inet_addr(FANOUT_GROUP);
+    }
+    ~MulticastTransport() { close(m_fd); }
+
+    bool sendPacket(const uint8_t* data, size_t len) override {
+        if (sendto(m_fd, data, len, 0, (const sockaddr*)&m_dest, sizeof(m_dest)) != (ssize_t)len) {
+            return false;
+        }
+        packets++;
+        bytes += len;
+        return true;
+    }
+
+    uint32_t packets, bytes;
+
+private:
+    int m_fd;
+    sockaddr_in m_dest;
+};
+
+// Ein Leuchter: Socket in der Gruppe + Empfänger + Ausschnitt
+struct FakeLeuchter {
+    int fd;
+    AmbilightReceiver rx;
+    AmbilightIndexRange range;
+    uint32_t framesOk;
+
+    explicit FakeLeuchter(AmbilightIndexRange r) : fd(-1), range(r), framesOk(0) {}
+
+    bool open() {
+        fd = socket(AF_INET, SOCK_DGRAM, 0);
+        int one = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+#ifdef SO_REUSEPORT
+        setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one));
+#endif
+        sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(FANOUT_PORT);
+        addr.sin_addr.s_addr = htonl(INADDR_ANY);
+        if (bind(fd, (const sockaddr*)&addr, sizeof(addr)) != 0) {
+            return false;
+        }
+        ip_mreq mreq;
+        mreq.imr_multiaddr.s_addr = inet_addr(FANOUT_GROUP);
+        mreq.imr_interface.s_addr = inet_addr("127.0.0.1");
+        return setsockopt(fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) == 0;
+    }
+
+    // Alle anstehenden Datagramme verarbeiten, true = Frame vollständig
+    bool drain() {
+        bool complete = false;
+        uint8_t buf[AMBI_MAX_PACKET_SIZE];
+        pollfd p = {fd, POLLIN, 0};
+        while (poll(&p, 1, 50) > 0) {
+            ssize_t n = recv(fd, buf, sizeof(buf), 0);
+            if (n <= 0) break;
+            complete |= rx.onPacket(buf, (size_t)n);
+        }
+        return complete;
+    }
+};
+
+// Aufteilung des Rings auf n Leuchter, um shift versetzt (letzter läuft über Index 0)
+static std::vector<AmbilightIndexRange> splitRing(int rects, int n, int shift) {
+    std::vector<AmbilightIndexRange> ranges;
+    for (int i = 0; i < n; i++) {
+        int begin = i * rects / n;
+        int end = (i + 1) * rects / n;
+        AmbilightIndexRange r = {(begin + shift) % rects, end - begin};
+        ranges.push_back(r);
+    }
+    return ranges;
+}
+
+struct RunResult {
+    double packetsPerFrame;
+    double bytesPerFrame;
+};
+
+static RunResult runFanout(int receivers) {
+    int rects = ambilightRectCount(FANOUT_HSEG, FANOUT_VSEG);
+    int vert = FANOUT_VSEG - 2;
+    std::vector<RGB> top(FANOUT_HSEG), bottom(FANOUT_HSEG), right(vert), left(vert);
+    AmbilightSides sides = {top.data(), FANOUT_HSEG, right.data(), vert, bottom.data(), FANOUT_HSEG, left.data(), vert};
+
+    std::vector<AmbilightIndexRange> ranges = splitRing(rects, receivers, 7);
+    std::vector<FakeLeuchter*> leuchter;
+    for (int i = 0; i < receivers; i++) {
+        leuchter.push_back(new FakeLeuchter(ranges[i]));
+        CHECK(leuchter.back()->open(), "Empfänger %d: Multicast-Socket fehlgeschlagen", i);
+    }
+
+    static AmbilightFrameEncoder encoder;
+    MulticastTransport transport;
+    std::vector<uint8_t> expected(rects * 3), slice(rects * 3), clockwise(rects * 3);
+
+    for (int f = 0; f < FANOUT_FRAMES; f++) {
+        // Inhalt pro Frame ändern
+        for (int i = 0; i < FANOUT_HSEG; i++) {
+            RGB t = {(uint8_t)f, (uint8_t)i, 1};
+            RGB b = {(uint8_t)f, (uint8_t)i, 3};
+            top[i] = t;
+            bottom[i] = b;
+        }
+        for (int i = 0; i < vert; i++) {
+            RGB r = {(uint8_t)f, (uint8_t)i, 2};
+            RGB l = {(uint8_t)f, (uint8_t)i, 4};
+            right[i] = r;
+            left[i] = l;
+        }
+        for (int k = 0; k < rects; k++) {
+            RGB c = ambilightClockwiseColor(sides, k);
+            clockwise[k * 3] = c.r;
+            clockwise[k * 3 + 1] = c.g;
+            clockwise[k * 3 + 2] = c.b;
+        }
+
+        encoder.encode(FANOUT_HSEG, FANOUT_VSEG, sides);
+        encoder.send(transport);
+
+        for (int i = 0; i < receivers; i++) {
+            FakeLeuchter* l = leuchter[i];
+            if (!l->drain()) {
+                continue;
+            }
+            int n = ambilightSliceRgb(l->rx.rgb(), l->rx.rectCount(), l->range, slice.data());
+            ambilightSliceRgb(clockwise.data(), rects, l->range, expected.data());
+            if (n == l->range.count && memcmp(slice.data(), expected.data(), n * 3) == 0) {
+                l->framesOk++;
+            }
+        }
+    }
+
+    for (int i = 0; i < receivers; i++) {
+        CHECK(leuchter[i]->framesOk == FANOUT_FRAMES, "%d Empfänger: Empfänger %d hat %u/%d Frames korrekt",
+              receivers, i, leuchter[i]->framesOk, FANOUT_FRAMES);
+        close(leuchter[i]->fd);
+        delete leuchter[i];
+    }
+
+    RunResult r;
+    r.packetsPerFrame = (double)transport.packets / FANOUT_FRAMES;
+    r.bytesPerFrame = (double)transport.bytes / FANOUT_FRAMES;
+    return r;
+}
+
+// Ausschnitte inkl. Umlauf über das Ende des Rings
+static void testSlice() {
+    uint8_t rgb[5 * 3], out[5 * 3];
+    for (int i = 0; i < 15; i++) rgb[i] = (uint8_t)i;
+
+    AmbilightIndexRange mid = {1, 2};
+    CHECK(ambilightSliceRgb(rgb, 5, mid, out) == 2 && out[0] == 3 && out[5] == 8, "Ausschnitt Mitte");
+    AmbilightIndexRange wrap = {4, 3};
+    CHECK(ambilightSliceRgb(rgb, 5, wrap, out) == 3 && out[0] == 12 && out[3] == 0 && out[8] == 5, "Ausschnitt mit Umlauf");
+    AmbilightIndexRange all = {0, 0};
+    CHECK(ambilightSliceRgb(rgb, 5, all, out) == 5 && memcmp(rgb, out, 15) == 0, "Ausschnitt alles");
+    AmbilightIndexRange bad = {5, 1};
+    CHECK(ambilightSliceRgb(rgb, 5, bad, out) == 0, "ungültiger Start");
+    AmbilightIndexRange tooMany = {0, 6};
+    CHECK(ambilightSliceRgb(rgb, 5, tooMany, out) == 0, "zu viele");
+}
+
+int main() {
+    testSlice();
+
+    printf("%-10s %14s %14s\n", "Empfänger", "Pakete/Frame", "Bytes/Frame");
+    const int counts[] = {1, 2, 4, 8};
+    RunResult first = {0, 0};
+    for (size_t i = 0; i < sizeof(counts) / sizeof(counts[0]); i++) {
+        RunResult r = runFanout(counts[i]);
+        printf("%-10d %14.1f %14.1f\n", counts[i], r.packetsPerFrame, r.bytesPerFrame);
+        if (i == 0) {
+            first = r;
+        }
+        CHECK(r.packetsPerFrame == first.packetsPerFrame && r.bytesPerFrame == first.bytesPerFrame,
+              "Sendeaufwand hängt von der Empfängerzahl ab");
+    }
+
+    return testSummary("fanout_test");
+}
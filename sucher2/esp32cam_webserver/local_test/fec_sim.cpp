@@ -0,0 +1,130 @@
+// Host-Simulation: effektive Frame-Rate mit und ohne XOR-Parität (FEC)
+//
+// Übersetzen und ausführen (im Ordner local_test):
+//   g++ -std=c++11 -O2 -Wall -I../src -I../../../lib/hanawa_core/src fec_sim.cpp ../../../lib/hanawa_core/src/ambilight_protocol.cpp -o fec_sim
+//   ./fec_sim [hSeg] [vSeg] [Verlust-%] [Burst-Länge] [Frames]
+//
+// Ohne Verlust-Angabe wird eine Tabelle über mehrere Verlustraten ausgegeben.
+// Burst-Länge > 1 simuliert gebündelte Verluste (Gilbert-Elliott-Modell mit
+// gleicher mittlerer Verlustrate), wie sie bei Störungen im 2,4-GHz-Band auftreten.
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "ambilight_protocol.h"
+
+#define SIM_FPS 10
+
+// Einfacher, reproduzierbarer Zufallsgenerator (xorshift32)
+static uint32_t s_rng = 12345;
+static double nextRandom() {
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return (s_rng & 0xFFFFFF) / (double)0x1000000;
+}
+
+// Verlustbehafteter Transport, liefert direkt an einen Empfänger
+class LossyTransport : public AmbilightTransport {
+public:
+    LossyTransport(AmbilightReceiver& rx, double loss, double burst)
+        : m_rx(rx), m_loss(loss), m_bursty(burst > 1.0), m_bad(false), sent(0), lost(0) {
+        // Gilbert-Elliott: im "bad"-Zustand geht alles verloren.
+        // Mittlere Burst-Länge = 1 / pBadToGood, stationär P(bad) = loss.
+        m_pBadToGood = m_bursty ? 1.0 / burst : 1.0;
+        m_pGoodToBad = (loss >= 1.0) ? 1.0 : loss * m_pBadToGood / (1.0 - loss);
+    }
+
+    bool sendPacket(const uint8_t* data, size_t len) override {
+        if (m_bursty) {
+            m_bad = m_bad ? (nextRandom() >= m_pBadToGood) : (nextRandom() < m_pGoodToBad);
+        } else {
+            m_bad = nextRandom() < m_loss;  // unabhängige Verluste
+        }
+        sent++;
+        if (m_bad) {
+            lost++;
+        } else {
+            m_rx.onPacket(data, len);
+        }
+        return true;
+    }
+
+private:
+    AmbilightReceiver& m_rx;
+    double m_loss;
+    bool m_bursty;
+    double m_pGoodToBad, m_pBadToGood;
+    bool m_bad;
+
+public:
+    uint32_t sent, lost;
+};
+
+struct SimResult {
+    double fps;
+    double packetLoss;
+    uint32_t recovered;
+    int packetsPerFrame;
+};
+
+static SimResult simulate(int hSeg, int vSeg, bool parity, double loss, double burst, int frames) {
+    int vert = vSeg - 2;
+    std::vector<RGB> top(hSeg), bottom(hSeg), right(vert), left(vert);
+    AmbilightSides sides = {top.data(), hSeg, right.data(), vert, bottom.data(), hSeg, left.data(), vert};
+
+    static AmbilightFrameEncoder encoder;
+    encoder.setParityEnabled(parity);
+    AmbilightReceiver rx;
+    LossyTransport transport(rx, loss, burst);
+
+    s_rng = 12345;  // gleiche Verlustfolge für beide Varianten
+    int packets = 0;
+    for (int f = 0; f < frames; f++) {
+        top[0].r = (uint8_t)f;  // Inhalt ändert sich pro Frame
+        packets = encoder.encode(hSeg, vSeg, sides);
+        encoder.send(transport);
+        // Frame-Grenze: der Leuchter verwirft nach Timeout unvollständige Frames
+        rx.abortFrame();
+    }
+
+    SimResult r;
+    r.fps = SIM_FPS * (double)rx.stats().framesComplete / frames;
+    r.packetLoss = transport.sent ? (double)transport.lost / transport.sent : 0.0;
+    r.recovered = rx.stats().framesRecovered;
+    r.packetsPerFrame = packets;
+    return r;
+}
+
+int main(int argc, char** argv) {
+    int hSeg = (argc > 1) ? atoi(argv[1]) : 50;
+    int vSeg = (argc > 2) ? atoi(argv[2]) : 30;
+    double burst = (argc > 4) ? atof(argv[4]) : 1.0;
+    int frames = (argc > 5) ? atoi(argv[5]) : 100000;
+
+    std::vector<double> losses;
+    if (argc > 3) {
+        losses.push_back(atof(argv[3]) / 100.0);
+    } else {
+        const double sweep[] = {0.0, 0.01, 0.02, 0.05, 0.10, 0.20};
+        losses.assign(sweep, sweep + sizeof(sweep) / sizeof(sweep[0]));
+    }
+
+    int rects = ambilightRectCount(hSeg, vSeg);
+    printf("Segmente %dx%d = %d Rechtecke, %d Frames @ %d FPS, Burst-Länge %.1f\n",
+           hSeg, vSeg, rects, frames, SIM_FPS, burst);
+    printf("\n%8s | %-24s | %-32s\n", "", "ohne FEC (v1)", "mit XOR-Parität (v2)");
+    printf("%8s | %6s %8s %8s | %6s %8s %8s %8s\n",
+           "Verlust", "Pakete", "FPS", "Frames", "Pakete", "FPS", "Frames", "rekonstr.");
+    printf("---------+--------------------------+----------------------------------\n");
+
+    for (size_t i = 0; i < losses.size(); i++) {
+        SimResult plain = simulate(hSeg, vSeg, false, losses[i], burst, frames);
+        SimResult fec = simulate(hSeg, vSeg, true, losses[i], burst, frames);
+        printf("%7.1f%% | %6d %8.2f %7.1f%% | %6d %8.2f %7.1f%% %8u\n",
+               plain.packetLoss * 100.0,
+               plain.packetsPerFrame, plain.fps, plain.fps * 100.0 / SIM_FPS,
+               fec.packetsPerFrame, fec.fps, fec.fps * 100.0 / SIM_FPS, fec.recovered);
+    }
+    return 0;
+}
@@ -0,0 +1,233 @@
+// Lastwerkzeug: misst den Takt-Jitter der Analyse unter HTTP-Flut
+//
+// Übersetzen und ausführen (im Ordner local_test, Linux/macOS):
+//   g++ -std=c++11 -O2 -Wall -pthread http_flood.cpp -o http_flood
+//   ./http_flood 192.168.1.120            # 16 Clients + 2 langsame, je 30 s
+//   ./http_flood 192.168.1.120 32 60 4    # 32 Clients + 4 langsame, je 60 s
+//
+// Ablauf: zuerst eine Ruhephase ohne Last, dann die Flut. Vor jeder Phase wird
+// die Takt-Statistik der Firmware mit /api/timing?reset=1 zurückgesetzt und
+// danach mit /api/timing gelesen. Während der Flut rufen die schnellen Clients
+// reihum /, /api/ambilight, /api/snapshot und /api/timing ab; die langsamen
+// Clients schicken ihren Request-Header byteweise (ein Byte alle 200 ms).
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define FLOOD_DEFAULT_PORT 80
+#define FLOOD_TIMEOUT_S   5
+#define SLOW_BYTE_MS      200
+
+static std::string g_host;
+static int g_port = FLOOD_DEFAULT_PORT;
+static std::atomic<bool> g_running(false);
+static std::atomic<uint32_t> g_responses(0);
+static std::atomic<uint32_t> g_errors(0);
+static std::atomic<uint64_t> g_latencySumUs(0);
+static std::atomic<uint32_t> g_latencyMaxUs(0);
+
+static uint64_t nowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static int connectHost() {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    timeval tv = { FLOOD_TIMEOUT_S, 0 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(g_port);
+    addr.sin_addr.s_addr = inet_addr(g_host.c_str());
+    if (connect(fd, (const sockaddr*)&addr, sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Einfacher GET mit Connection: close, liefert den Body ("" bei Fehler)
+static bool httpGet(const char* path, std::string* body) {
+    int fd = connectHost();
+    if (fd < 0) {
+        return false;
+    }
+    char request[256];
+    int len = snprintf(request, sizeof(request),
+                       "GET %s HTTP/1.1\r\nHost: %s\r\nConnection: close\r\n\r\n", path, g_host.c_str());
+    if (send(fd, request, len, 0) != len) {
+        close(fd);
+        return false;
+    }
+
+    std::string response;
+    char buf[4096];
+    ssize_t n;
+    while ((n = recv(fd, buf, sizeof(buf), 0)) > 0) {
+        response.append(buf, n);
+    }
+    close(fd);
+
+    if (response.compare(0, 12, "HTTP/1.1 200") != 0) {
+        return false;
+    }
+    if (body) {
+        size_t start = response.find("\r\n\r\n");
+        *body = start == std::string::npos ? "" : response.substr(start + 4);
+    }
+    return true;
+}
+
+static void fastClient(int index) {
+    static const char* paths[] = { "/", "/api/ambilight", "/api/snapshot", "/api/timing" };
+    int next = index;
+    while (g_running) {
+        uint64_t start = nowUs();
+        bool ok = httpGet(paths[next++ % 4], nullptr);
+        uint32_t latencyUs = nowUs() - start;
+        if (!ok) {
+            g_errors++;
+            continue;
+        }
+        g_responses++;
+        g_latencySumUs += latencyUs;
+        uint32_t prev = g_latencyMaxUs;
+        while (latencyUs > prev && !g_latencyMaxUs.compare_exchange_weak(prev, latencyUs)) {}
+    }
+}
+
+// Hält eine Verbindung offen, indem der Header byteweise eintrifft
+static void slowClient() {
+    static const char request[] = "GET /api/ambilight HTTP/1.1\r\nHost: flood\r\nX-Slow: aaaaaaaaaaaaaaaa\r\n\r\n";
+    while (g_running) {
+        int fd = connectHost();
+        if (fd < 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(SLOW_BYTE_MS));
+            continue;
+        }
+        for (size_t i = 0; i < sizeof(request) - 1 && g_running; i++) {
+            if (send(fd, &request[i], 1, MSG_NOSIGNAL) != 1) {
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(SLOW_BYTE_MS));
+        }
+        close(fd);
+    }
+}
+
+struct Timing {
+    bool valid;
+    long frames, overruns, periodMeanUs, periodStddevUs, periodMinUs, periodMaxUs, busyMeanUs, busyMaxUs;
+};
+
+static long jsonField(const std::string& json, const char* key) {
+    std::string pattern = std::string("\"") + key + "\":";
+    size_t pos = json.find(pattern);
+    return pos == std::string::npos ? -1 : atol(json.c_str() + pos + pattern.size());
+}
+
+static Timing readTiming() {
+    Timing t;
+    memset(&t, 0, sizeof(t));
+    std::string body;
+    bool ok = false;
+    for (int attempt = 0; attempt < 3 && !ok; attempt++) {   // unter Last kann ein Versuch scheitern
+        ok = httpGet("/api/timing", &body);
+    }
+    if (!ok) {
+        return t;
+    }
+    t.valid = true;
+    t.frames = jsonField(body, "frames");
+    t.overruns = jsonField(body, "overruns");
+    t.periodMeanUs = jsonField(body, "periodMeanUs");
+    t.periodStddevUs = jsonField(body, "periodStddevUs");
+    t.periodMinUs = jsonField(body, "periodMinUs");
+    t.periodMaxUs = jsonField(body, "periodMaxUs");
+    t.busyMeanUs = jsonField(body, "busyMeanUs");
+    t.busyMaxUs = jsonField(body, "busyMaxUs");
+    return t;
+}
+
+static void printTiming(const char* phase, const Timing& t) {
+    if (!t.valid) {
+        printf("%-6s  /api/timing nicht erreichbar\n", phase);
+        return;
+    }
+    printf("%-6s  %6ld  %8.1f  %7.1f  %8.1f  %8.1f  %8.1f  %8.1f  %5ld\n", phase, t.frames,
+           t.periodMeanUs / 1000.0, t.periodStddevUs / 1000.0, t.periodMinUs / 1000.0,
+           t.periodMaxUs / 1000.0, t.busyMeanUs / 1000.0, t.busyMaxUs / 1000.0, t.overruns);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        printf("Aufruf: %s <ip[:port]> [clients=16] [sekunden=30] [langsame=2]\n", argv[0]);
+        return 1;
+    }
+    g_host = argv[1];
+    size_t colon = g_host.find(':');
+    if (colon != std::string::npos) {
+        g_port = atoi(g_host.c_str() + colon + 1);
+        g_host.resize(colon);
+    }
+    int clients = argc > 2 ? atoi(argv[2]) : 16;
+    int seconds = argc > 3 ? atoi(argv[3]) : 30;
+    int slow = argc > 4 ? atoi(argv[4]) : 2;
+
+    std::string body;
+    if (!httpGet("/api/timing?reset=1", &body)) {
+        printf("FEHLER: http://%s:%d/api/timing nicht erreichbar\n", g_host.c_str(), g_port);
+        return 1;
+    }
+
+    // Phase 1: Ruhe
+    printf("Ruhephase %d s ...\n", seconds);
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+    Timing idle = readTiming();
+
+    // Phase 2: Flut
+    printf("Flut %d s mit %d Clients + %d langsamen ...\n", seconds, clients, slow);
+    httpGet("/api/timing?reset=1", nullptr);
+    g_running = true;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < clients; i++) {
+        threads.emplace_back(fastClient, i);
+    }
+    for (int i = 0; i < slow; i++) {
+        threads.emplace_back(slowClient);
+    }
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+    Timing flood = readTiming();   // noch unter Last lesen
+    g_running = false;
+    for (std::thread& t : threads) {
+        t.join();
+    }
+
+    printf("\nAnalyse-Takt (ms)\n");
+    printf("Phase   Frames   Periode   Jitter       min       max   Rechnen       max  Überläufe\n");
+    printTiming("Ruhe", idle);
+    printTiming("Flut", flood);
+
+    uint32_t responses = g_responses;
+    printf("\nHTTP: %u Antworten (%.1f/s), %u Fehler, Latenz Mittel %.1f ms / max %.1f ms\n",
+           responses, (double)responses / seconds, (unsigned)g_errors,
+           responses ? g_latencySumUs / 1000.0 / responses : 0.0, g_latencyMaxUs / 1000.0);
+    return 0;
+}
@@ -0,0 +1,159 @@
+// Host-Test: verzögerter Ringpuffer-Logger (deferred_log)
+//
+// Übersetzen und ausführen (im Ordner local_test):
+//   g++ -std=c++11 -O2 -Wall -pthread -I../src -I../../../lib/hanawa_core/src -I../../../lib/hanawa_core/test log_test.cpp ../src/deferred_log.cpp ../../../lib/hanawa_core/src/stage_metrics.cpp -o log_test
+//   ./log_test
+//
+// Prüft das nachträgliche Formatieren (Ganzzahlen, Gleitkomma, Strings,
+// Abschneiden), das Überholen eines langsamen Lesers, mehrere Schreiber
+// gleichzeitig und misst die Kosten eines Log-Aufrufs gegenüber snprintf.
+
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "deferred_log.h"
+#include "test_check.h"
+
+// Liest alles ab einem frischen Cursor und liefert den zuletzt formatierten Text
+static bool readLast(char* text, size_t cap) {
+    LogCursor cursor = logCursorLast(1);
+    LogEntry entry;
+    if (!logReadNext(&cursor, &entry, nullptr)) {
+        return false;
+    }
+    logFormat(entry, text, cap);
+    return true;
+}
+
+static void testFormat() {
+    char text[128];
+
+    LOG_I("[calc] Top=%u/%u, Left=%d", (size_t)10, 10u, -3);
+    CHECK(readLast(text, sizeof(text)) && strcmp(text, "[calc] Top=10/10, Left=-3") == 0, "'%s'", text);
+
+    LOG_I("[x] %ld %lld %llu %02x %c", -5L, -6000000000LL, 18000000000ULL, 0xab, 'Q');
+    CHECK(readLast(text, sizeof(text)) && strcmp(text, "[x] -5 -6000000000 18000000000 ab Q") == 0, "'%s'", text);
+
+    LOG_I("[f] %.2f %5.1f%% %s", 3.14159, 2.0f, "ok");
+    CHECK(readLast(text, sizeof(text)) && strcmp(text, "[f] 3.14   2.0% ok") == 0, "'%s'", text);
+
+    // Zu wenige Argumente: Konvertierung bleibt stehen statt abzustürzen
+    LOG_I("[a] %d %d", 1);
+    CHECK(readLast(text, sizeof(text)) && strcmp(text, "[a] 1 %d") == 0, "'%s'", text);
+
+    // Abschneiden wie snprintf: Rückgabe = volle Länge
+    LOG_I("[long] %s und noch mehr Text", "ein langer Parameter");
+    LogCursor cursor = logCursorLast(1);
+    LogEntry entry;
+    CHECK(logReadNext(&cursor, &entry, nullptr), "kein Eintrag");
+    char small[10];
+    int len = logFormat(entry, small, sizeof(small));
+    CHECK(len == (int)strlen("[long] ein langer Parameter und noch mehr Text"), "Länge %d", len);
+    CHECK(strcmp(small, "[long] ei") == 0, "'%s'", small);
+
+    // Unter LOG_COMPILE_LEVEL (INFO) wird nichts geschrieben
+    uint32_t before = getLogStats().written;
+    LOG_D("[debug] %d", 1);
+    CHECK(getLogStats().written == before, "LOG_D geschrieben");
+}
+
+static void testOverflow() {
+    LogCursor cursor = logCursorLast(0);
+    for (int i = 0; i < LOG_RING_SIZE + 40; i++) {
+        LOG_W("[overflow] %d", i);
+    }
+
+    // Der Leser war zu langsam: die ältesten 40 sind weg, der Rest ist vollständig
+    LogEntry entry;
+    uint32_t lost = 0;
+    int read = 0;
+    int first = -1;
+    int last = -1;
+    while (logReadNext(&cursor, &entry, &lost)) {
+        int value = (int)(int64_t)entry.args[0];
+        if (first < 0) {
+            first = value;
+        }
+        CHECK(last < 0 || value == last + 1, "Lücke %d -> %d", last, value);
+        last = value;
+        read++;
+    }
+    CHECK(lost == 40, "lost %u", lost);
+    CHECK(read == LOG_RING_SIZE, "gelesen %d", read);
+    CHECK(first == 40 && last == LOG_RING_SIZE + 39, "Bereich %d..%d", first, last);
+
+    // Leerer Puffer: nichts mehr zu lesen
+    CHECK(!logReadNext(&cursor, &entry, &lost), "Eintrag nach dem Ende");
+}
+
+static void testThreads() {
+    const int THREADS = 4;
+    const int PER_THREAD = 20000;
+    LogCursor cursor = logCursorLast(0);
+    uint32_t start = getLogStats().written;
+
+    std::vector<std::thread> writers;
+    for (int t = 0; t < THREADS; t++) {
+        writers.emplace_back([t]() {
+            for (int i = 0; i < PER_THREAD; i++) {
+                LOG_I("[thread] %d %d %d", t, i, t * 1000000 + i);
+            }
+        });
+    }
+
+    // Leser läuft parallel und prüft jeden Eintrag auf Konsistenz
+    uint32_t lost = 0;
+    uint32_t read = 0;
+    uint32_t torn = 0;
+    LogEntry entry;
+    auto drain = [&]() {
+        while (logReadNext(&cursor, &entry, &lost)) {
+            int64_t t = (int64_t)entry.args[0];
+            int64_t i = (int64_t)entry.args[1];
+            if (entry.argc != 3 || (int64_t)entry.args[2] != t * 1000000 + i) {
+                torn++;
+            }
+            read++;
+        }
+    };
+    for (auto& w : writers) {
+        while (w.joinable()) {
+            drain();
+            w.join();
+        }
+    }
+    drain();
+
+    CHECK(getLogStats().written - start == THREADS * PER_THREAD, "geschrieben %u", getLogStats().written - start);
+    CHECK(torn == 0, "%u zerrissene Einträge", torn);
+    CHECK(read + lost == THREADS * PER_THREAD, "gelesen %u + verloren %u", read, lost);
+}
+
+static void benchmark() {
+    const int N = 1000000;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < N; i++) {
+        LOG_I("[bench] Top=%u, Left=%u, Right=%u", (unsigned)i, 8u, 8u);
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    char buf[96];
+    volatile int sink = 0;
+    for (int i = 0; i < N; i++) {
+        sink += snprintf(buf, sizeof(buf), "[bench] Top=%u, Left=%u, Right=%u", (unsigned)i, 8u, 8u);
+    }
+    auto t2 = std::chrono::steady_clock::now();
+    double logNs = std::chrono::duration<double, std::nano>(t1 - t0).count() / N;
+    double printfNs = std::chrono::duration<double, std::nano>(t2 - t1).count() / N;
+    printf("log_test: LOG_I %.1f ns/Aufruf, snprintf %.1f ns/Aufruf\n", logNs, printfNs);
+}
+
+int main() {
+    testFormat();
+    testOverflow();
+    testThreads();
+    benchmark();
+
+    return testSummary("log_test");
+}
@@ -0,0 +1,124 @@
+// Host-Test: Stufen-Histogramme und /api/metrics-Ausgabe
+//
+// Übersetzen und ausführen (im Ordner local_test):
+//   g++ -std=c++11 -Wall -I../../../lib/hanawa_core/src -I../../../lib/hanawa_core/test metrics_test.cpp ../../../lib/hanawa_core/src/stage_metrics.cpp -o metrics_test
+//   ./metrics_test
+//
+// Prüft Perzentile gegen bekannte Verteilungen, Maximum und Mittelwert,
+// Reset, StageTimer sowie JSON- und Prometheus-Ausgabe (inkl. Abschneiden
+// bei zu kleinem Puffer).
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include "stage_metrics.h"
+#include "test_check.h"
+
+// Perzentil liegt im richtigen Bucket (Buckets sind höchstens 1,67x breit)
+static bool near(uint32_t actual, uint32_t expected) {
+    return actual >= expected * 6 / 10 && actual <= expected * 15 / 10 + 1;
+}
+
+static void testEmpty() {
+    resetStageMetrics();
+    StageSummary s = getStageSummary(STAGE_JPEG_DECODE);
+    CHECK(strcmp(s.name, "jpeg_decode") == 0, "Name %s", s.name);
+    CHECK(s.count == 0 && s.p50Us == 0 && s.p99Us == 0 && s.maxUs == 0, "leeres Histogramm nicht 0");
+}
+
+static void testUniform() {
+    resetStageMetrics();
+    // 1..10000 µs gleichverteilt
+    for (uint32_t us = 1; us <= 10000; us++) {
+        recordStage(STAGE_REDUCTION, us);
+    }
+    StageSummary s = getStageSummary(STAGE_REDUCTION);
+    CHECK(s.count == 10000, "count %u", s.count);
+    CHECK(s.maxUs == 10000, "max %u", s.maxUs);
+    CHECK(s.meanUs == 5000, "mean %u", s.meanUs);
+    CHECK(near(s.p50Us, 5000), "p50 %u", s.p50Us);
+    CHECK(near(s.p95Us, 9500), "p95 %u", s.p95Us);
+    CHECK(near(s.p99Us, 9900), "p99 %u", s.p99Us);
+    CHECK(s.p50Us <= s.p95Us && s.p95Us <= s.p99Us && s.p99Us <= s.maxUs, "Perzentile nicht monoton");
+
+    // Andere Stufen bleiben unberührt
+    CHECK(getStageSummary(STAGE_GEOMETRY).count == 0, "geometry nicht leer");
+}
+
+static void testTail() {
+    resetStageMetrics();
+    // 98 % schnell (~40 ms Decode), 2 % Ausreißer (~250 ms)
+    for (int i = 0; i < 980; i++) {
+        recordStage(STAGE_JPEG_DECODE, 40000);
+    }
+    for (int i = 0; i < 20; i++) {
+        recordStage(STAGE_JPEG_DECODE, 250000);
+    }
+    StageSummary s = getStageSummary(STAGE_JPEG_DECODE);
+    CHECK(near(s.p50Us, 40000), "p50 %u", s.p50Us);
+    CHECK(near(s.p95Us, 40000), "p95 %u", s.p95Us);
+    CHECK(near(s.p99Us, 250000), "p99 %u", s.p99Us);
+    CHECK(s.maxUs == 250000, "max %u", s.maxUs);
+
+    // Überlauf-Bucket: Werte über 7 s
+    recordStage(STAGE_TRANSMIT, 9000000);
+    CHECK(getStageSummary(STAGE_TRANSMIT).p99Us == 9000000, "Überlauf p99 %u", getStageSummary(STAGE_TRANSMIT).p99Us);
+}
+
+static void testTimer() {
+    resetStageMetrics();
+    {
+        StageTimer t(STAGE_GEOMETRY);
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    StageTimer early(STAGE_SERIALIZE);
+    early.stop();
+    early.stop();   // zweites stop() zählt nicht
+    StageSummary g = getStageSummary(STAGE_GEOMETRY);
+    CHECK(g.count == 1 && g.maxUs >= 5000 && g.maxUs < 500000, "StageTimer %u µs", g.maxUs);
+    CHECK(getStageSummary(STAGE_SERIALIZE).count == 1, "stop() doppelt gezählt");
+}
+
+static void testFormat() {
+    resetStageMetrics();
+    recordStage(STAGE_CAPTURE_WAIT, 1200);
+    MetricValue extras[] = {
+        { "free_heap_bytes", "Freier Heap", false, 123456 },
+        { "frames_dropped_total", "Verworfene Frames", true, 7 },
+    };
+
+    char json[4096];
+    size_t len = formatMetricsJson(json, sizeof(json), extras, 2);
+    CHECK(len == strlen(json), "JSON-Länge %zu != %zu", len, strlen(json));
+    CHECK(strstr(json, "\"capture_wait\":{\"count\":1,") != nullptr, "capture_wait fehlt: %s", json);
+    CHECK(strstr(json, "\"api_json\":{\"count\":0,") != nullptr, "api_json fehlt");
+    CHECK(strstr(json, "\"free_heap_bytes\":123456") != nullptr, "Extra fehlt");
+    CHECK(json[0] == '{' && json[len - 1] == '}', "JSON nicht geschlossen");
+
+    char prom[8192];
+    len = formatMetricsPrometheus(prom, sizeof(prom), extras, 2);
+    CHECK(len == strlen(prom), "Prometheus-Länge");
+    CHECK(strstr(prom, "hanawa_stage_duration_us{stage=\"capture_wait\",quantile=\"0.99\"} 1200\n") != nullptr,
+          "Quantil fehlt:\n%s", prom);
+    CHECK(strstr(prom, "hanawa_stage_duration_us_count{stage=\"capture_wait\"} 1\n") != nullptr, "count fehlt");
+    CHECK(strstr(prom, "# TYPE hanawa_frames_dropped_total counter\nhanawa_frames_dropped_total 7\n") != nullptr,
+          "Counter fehlt");
+    CHECK(strstr(prom, "# TYPE hanawa_free_heap_bytes gauge\n") != nullptr, "Gauge fehlt");
+
+    // Zu kleiner Puffer: abgeschnitten, nullterminiert, benötigte Länge gemeldet
+    char small[32];
+    size_t need = formatMetricsJson(small, sizeof(small), extras, 2);
+    CHECK(need == strlen(json), "benötigte Länge %zu", need);
+    CHECK(strlen(small) == sizeof(small) - 1, "nicht abgeschnitten");
+}
+
+int main() {
+    testEmpty();
+    testUniform();
+    testTail();
+    testTimer();
+    testFormat();
+
+    return testSummary("metrics_test");
+}
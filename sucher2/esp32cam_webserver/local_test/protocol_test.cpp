@@ -0,0 +1,286 @@
+// Host-Test für den Ambilight-Protokoll-Encoder (src/ambilight_protocol.cpp)
+// und die Uhrensynchronisation (src/clock_sync.cpp)
+//
+// Übersetzen und ausführen (im Ordner local_test):
+//   g++ -std=c++11 -Wall -I../src -I../../../lib/hanawa_core/src -I../../../lib/hanawa_core/test protocol_test.cpp ../../../lib/hanawa_core/src/ambilight_protocol.cpp ../src/clock_sync.cpp -o protocol_test
+//   ./protocol_test
+//
+// Der Encoder sendet über einen Loopback-Transport an den AmbilightReceiver,
+// der die Regeln aus doc/AMBILIGHT_PROTOCOL.md umsetzt. Geprüft werden
+// Fragmentierung, Header, Uhrzeigersinn-Reihenfolge, die Rekonstruktion
+// verlorener Fragmente über das v2-Paritätspaket sowie Sequenz-, Reorder-
+// und Deadline-Zähler der Timing-Erweiterung und der Ping/Pong-Austausch.
+
+#include <cstdio>
+#include <vector>
+#include "ambilight_protocol.h"
+#include "clock_sync.h"
+#include "test_check.h"
+
+// Loopback-Transport: merkt sich alle Pakete in Sende-Reihenfolge
+class LoopbackTransport : public AmbilightTransport {
+public:
+    std::vector<std::vector<uint8_t> > packets;
+    int pauses = 0;
+
+    bool sendPacket(const uint8_t* data, size_t len) override {
+        packets.push_back(std::vector<uint8_t>(data, data + len));
+        return true;
+    }
+    void waitBetweenPackets() override { pauses++; }
+};
+
+// Farbe aus Seite und Index eindeutig kodieren
+static RGB tag(int side, int i) {
+    RGB c = {(uint8_t)side, (uint8_t)i, (uint8_t)(side * 16 + i)};
+    return c;
+}
+
+struct TestFrame {
+    std::vector<RGB> top, right, bottom, left;
+    std::vector<RGB> clockwise;  // erwartete Reihenfolge beim Empfänger
+    AmbilightSides sides;
+
+    TestFrame(int hSeg, int vSeg) {
+        int vert = vSeg - 2;
+        for (int i = 0; i < hSeg; i++) { top.push_back(tag(1, i)); bottom.push_back(tag(3, i)); }
+        for (int i = 0; i < vert; i++) { right.push_back(tag(2, i)); left.push_back(tag(4, i)); }
+        AmbilightSides s = {top.data(), hSeg, right.data(), vert, bottom.data(), hSeg, left.data(), vert};
+        sides = s;
+
+        // Top →, Right ↓, Bottom ←, Left ↑
+        for (int i = 0; i < hSeg; i++) clockwise.push_back(top[i]);
+        for (int i = 0; i < vert; i++) clockwise.push_back(right[i]);
+        for (int i = hSeg - 1; i >= 0; i--) clockwise.push_back(bottom[i]);
+        for (int i = vert - 1; i >= 0; i--) clockwise.push_back(left[i]);
+    }
+};
+
+static bool sameColors(const AmbilightReceiver& rx, const TestFrame& f) {
+    if (rx.rectCount() != (int)f.clockwise.size()) return false;
+    for (int k = 0; k < rx.rectCount(); k++) {
+        const uint8_t* b = rx.rgb() + k * 3;
+        if (b[0] != f.clockwise[k].r || b[1] != f.clockwise[k].g || b[2] != f.clockwise[k].b) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void testSegmentation(int hSeg, int vSeg) {
+    TestFrame f(hSeg, vSeg);
+
+    static AmbilightFrameEncoder encoder;
+    encoder.setParityEnabled(false);
+    int packets = encoder.encode(hSeg, vSeg, f.sides);
+    int rects = ambilightRectCount(hSeg, vSeg);
+    CHECK(packets == ambilightPacketCount(rects), "%dx%d: %d Pakete", hSeg, vSeg, packets);
+
+    LoopbackTransport loop;
+    CHECK(encoder.send(loop) == packets, "%dx%d: nicht alle Pakete gesendet", hSeg, vSeg);
+    CHECK(loop.pauses == packets - 1, "%dx%d: %d Pausen", hSeg, vSeg, loop.pauses);
+
+    AmbilightReceiver rx;
+    bool complete = false;
+    for (size_t i = 0; i < loop.packets.size(); i++) {
+        CHECK(loop.packets[i].size() <= AMBI_MAX_PACKET_SIZE, "Paket %zu zu groß", i);
+        CHECK(!(loop.packets[i][0] & AMBI_V2_MARKER), "%dx%d: v1 erwartet", hSeg, vSeg);
+        complete = rx.onPacket(loop.packets[i].data(), loop.packets[i].size());
+    }
+    CHECK(complete, "%dx%d: Frame beim Empfänger unvollständig", hSeg, vSeg);
+    CHECK(rx.hSegments() == hSeg && rx.vSegments() == vSeg, "%dx%d: Header %dx%d",
+          hSeg, vSeg, rx.hSegments(), rx.vSegments());
+    CHECK(sameColors(rx, f), "%dx%d: Farben/Reihenfolge falsch", hSeg, vSeg);
+}
+
+// Mit Parität muss jedes einzelne verlorene Paket rekonstruierbar sein
+static void testParity(int hSeg, int vSeg) {
+    TestFrame f(hSeg, vSeg);
+    AmbilightFrameEncoder encoder;
+    encoder.setParityEnabled(true);
+
+    int v1Packets = ambilightPacketCount(ambilightRectCount(hSeg, vSeg));
+    for (int lost = -1; lost < 4; lost++) {
+        int packets = encoder.encode(hSeg, vSeg, f.sides);
+        LoopbackTransport loop;
+        encoder.send(loop);
+
+        if (v1Packets == 1) {
+            CHECK(packets == 1, "%dx%d: Einzelpaket-Frame soll v1 bleiben", hSeg, vSeg);
+        } else {
+            CHECK(packets == ambilightPacketCountV2(ambilightRectCount(hSeg, vSeg)) + 1,
+                  "%dx%d: %d Pakete mit Parität", hSeg, vSeg, packets);
+        }
+        if (lost >= packets || (packets == 1 && lost >= 0)) continue;
+
+        AmbilightReceiver rx;
+        bool complete = false;
+        for (int i = 0; i < packets; i++) {
+            if (i == lost) continue;
+            complete |= rx.onPacket(loop.packets[i].data(), loop.packets[i].size());
+        }
+        CHECK(complete, "%dx%d: Frame ohne Paket %d nicht vollständig", hSeg, vSeg, lost);
+        CHECK(sameColors(rx, f), "%dx%d: Farben ohne Paket %d falsch", hSeg, vSeg, lost);
+        bool recovered = lost >= 0 && lost < packets - 1;
+        CHECK(rx.stats().framesRecovered == (recovered ? 1u : 0u),
+              "%dx%d: framesRecovered=%u (Paket %d verloren)", hSeg, vSeg,
+              rx.stats().framesRecovered, lost);
+    }
+
+    // Zwei verlorene Datenpakete sind nicht rekonstruierbar
+    if (v1Packets > 1) {
+        int packets = encoder.encode(hSeg, vSeg, f.sides);
+        LoopbackTransport loop;
+        encoder.send(loop);
+        AmbilightReceiver rx;
+        bool complete = false;
+        for (int i = 2; i < packets; i++) {
+            complete |= rx.onPacket(loop.packets[i].data(), loop.packets[i].size());
+        }
+        CHECK(!complete || packets <= 2, "%dx%d: Frame trotz 2 Verlusten vollständig", hSeg, vSeg);
+    }
+}
+
+// Sequenznummern, Capture-Zeitstempel und Deadline (Timing-Erweiterung)
+static void testTiming() {
+    TestFrame f(50, 10);  // 116 Rechtecke → 2 Datenpakete
+    AmbilightFrameEncoder encoder;
+    encoder.setTimingEnabled(true);
+    encoder.setParityEnabled(true);
+    AmbilightReceiver rx;
+
+    // Frames 100..104 encodieren, Pakete aufheben
+    std::vector<std::vector<std::vector<uint8_t> > > frames;
+    for (uint32_t seq = 100; seq < 105; seq++) {
+        AmbilightFrameMeta meta = {seq, seq * 100000u, 50};
+        int packets = encoder.encode(50, 10, f.sides, &meta);
+        CHECK(packets == 3, "Timing+Parität: %d Pakete", packets);
+        LoopbackTransport loop;
+        encoder.send(loop);
+        CHECK(loop.packets[0].size() == (size_t)ambilightV2HeaderSize(AMBI_FLAG_TIMING | AMBI_FLAG_PARITY) +
+              ambilightV2PayloadSize(AMBI_FLAG_TIMING), "Paketgröße mit Timing");
+        frames.push_back(loop.packets);
+    }
+
+    // Frame 100 pünktlich (Laufzeit 2 ms)
+    uint32_t now = 100 * 100000u + 2000;
+    bool shown = false;
+    for (size_t i = 0; i < frames[0].size(); i++) {
+        shown |= rx.onPacket(frames[0][i].data(), frames[0][i].size(), now);
+    }
+    CHECK(shown && rx.meta().sequence == 100, "Frame 100 nicht gezeigt");
+    CHECK(rx.meta().captureUs == 100 * 100000u && rx.meta().deadlineMs == 50, "Meta falsch");
+    CHECK(sameColors(rx, f), "Farben mit Timing-Erweiterung falsch");
+
+    // Frame 101 fehlt komplett, Frame 102 kommt an → 1 verloren
+    now = 102 * 100000u + 2500;
+    for (size_t i = 0; i < frames[2].size(); i++) {
+        rx.onPacket(frames[2][i].data(), frames[2][i].size(), now);
+    }
+    CHECK(rx.stats().framesLost == 1, "framesLost=%u", rx.stats().framesLost);
+
+    // Verspätetes Fragment von 101 nach 102 → reordered, kein neuer Frame
+    CHECK(!rx.onPacket(frames[1][0].data(), frames[1][0].size(), now), "altes Fragment gezeigt");
+    CHECK(!rx.onPacket(frames[1][1].data(), frames[1][1].size(), now), "altes Fragment gezeigt");
+    CHECK(rx.stats().framesReordered == 1, "framesReordered=%u", rx.stats().framesReordered);
+    CHECK(rx.meta().sequence == 102, "Sequenz nach Reorder %u", rx.meta().sequence);
+
+    // Frame 103 mit 80 ms Zusatzverzögerung > 50 ms Deadline → late
+    now = 103 * 100000u + 2000 + 80000;
+    uint32_t completeBefore = rx.stats().framesComplete;
+    shown = false;
+    for (size_t i = 0; i < frames[3].size(); i++) {
+        shown |= rx.onPacket(frames[3][i].data(), frames[3][i].size(), now);
+    }
+    CHECK(!shown && rx.stats().framesLate == 1, "framesLate=%u", rx.stats().framesLate);
+    CHECK(rx.stats().framesComplete == completeBefore, "verspäteter Frame als komplett gezählt");
+    CHECK(rx.meta().sequence == 102, "verspäteter Frame wurde übernommen");
+
+    // Frame 104: Fragmente vertauscht + erstes Datenpaket verloren → per Parität
+    now = 104 * 100000u + 3000;
+    shown = rx.onPacket(frames[4][2].data(), frames[4][2].size(), now);
+    shown |= rx.onPacket(frames[4][1].data(), frames[4][1].size(), now);
+    CHECK(shown && rx.meta().sequence == 104, "Frame 104 nicht rekonstruiert");
+    CHECK(rx.stats().framesLost == 1, "framesLost=%u nach 104", rx.stats().framesLost);
+}
+
+// Ping/Pong mit symmetrischer Laufzeit liefert den exakten Versatz
+static void testClockSync() {
+    ClockSyncSender sender;
+    ClockSyncReceiver rx(7);
+    uint8_t ping[CLOCK_SYNC_PING_MAX];
+    uint8_t pong[CLOCK_SYNC_PONG_SIZE];
+    const uint32_t offset = 0xFFFFF000u;  // Empfänger-Uhr liegt 4096 µs zurück (mit Überlauf)
+
+    // Runde 1: Laufzeit 2000 µs je Richtung, 300 µs Verarbeitung
+    uint32_t t1 = 1000000;
+    size_t len = sender.buildPing(t1, ping, sizeof(ping));
+    CHECK(len == CLOCK_SYNC_PING_HEADER && ambilightIsSyncPacket(ping, len), "Ping-Länge %zu", len);
+    size_t n = rx.onPing(ping, len, t1 + 2000 + offset, t1 + 2300 + offset, pong, sizeof(pong));
+    CHECK(n == CLOCK_SYNC_PONG_SIZE && !rx.synced(), "Pong %zu", n);
+    CHECK(sender.onPong(pong, n, t1 + 4300), "Pong abgelehnt");
+    const ClockSyncPeer* peer = sender.findPeer(7);
+    CHECK(peer && peer->offsetUs == (int32_t)offset && peer->delayUs == 4000,
+          "Offset %d, Delay %u", peer ? peer->offsetUs : 0, peer ? peer->delayUs : 0);
+
+    // Runde 2: Ping verteilt den Offset, alter Pong wird abgelehnt
+    uint32_t rejected = sender.pongsRejected();
+    t1 = 2000000;
+    len = sender.buildPing(t1, ping, sizeof(ping));
+    CHECK(len == CLOCK_SYNC_PING_HEADER + CLOCK_SYNC_PING_ENTRY, "Ping mit Tabelle %zu", len);
+    CHECK(!sender.onPong(pong, n, t1 + 100) && sender.pongsRejected() == rejected + 1, "alter Pong angenommen");
+    rx.onPing(ping, len, t1 + 2000 + offset, t1 + 2300 + offset, pong, sizeof(pong));
+    CHECK(rx.synced() && rx.offsetUs() == (int32_t)offset, "Empfänger-Offset %d", rx.offsetUs());
+    CHECK(rx.toLocal(5000) == 5000 + offset, "toLocal");
+
+    // Gemeinsamer Anzeigezeitpunkt im AmbilightReceiver
+    TestFrame f(10, 8);
+    AmbilightFrameEncoder encoder;
+    encoder.setTimingEnabled(true);
+    AmbilightReceiver frameRx;
+    frameRx.setClockOffset(rx.offsetUs());
+    AmbilightFrameMeta meta = {1, 3000000, 100};
+    encoder.encode(10, 8, f.sides, &meta);
+    uint32_t present = 0;
+    CHECK(frameRx.onPacket(encoder.packet(0), encoder.packetLength(0), 3050000 + offset), "Frame nicht gezeigt");
+    CHECK(frameRx.presentAtUs(&present) && present == 3100000 + offset, "Anzeigezeitpunkt %u", present);
+    meta.sequence = 2;
+    encoder.encode(10, 8, f.sides, &meta);
+    CHECK(!frameRx.onPacket(encoder.packet(0), encoder.packetLength(0), 3100001 + offset) &&
+          frameRx.stats().framesLate == 1, "Frame nach Anzeigezeitpunkt nicht verworfen");
+}
+
+int main() {
+    // Kapazitäts-Tabelle aus dem Protokoll
+    CHECK(ambilightPacketCount(32) == 1, "32 Rechtecke");
+    CHECK(ambilightPacketCount(82) == 1, "82 Rechtecke");
+    CHECK(ambilightPacketCount(83) == 2, "83 Rechtecke");
+    CHECK(ambilightPacketCount(164) == 2, "164 Rechtecke");
+    CHECK(ambilightPacketCount(166) == 3, "166 Rechtecke");
+    CHECK(ambilightPacketCount(AMBI_MAX_RECTANGLES + 1) == 0, "Überlauf");
+    CHECK(ambilightRectCount(10, 8) == 32, "10x8");
+
+    testSegmentation(10, 8);   // 1 Paket
+    testSegmentation(1, 2);    // Minimalfall ohne vertikale Rechtecke
+    testSegmentation(50, 10);  // 2 Pakete
+    testSegmentation(41, 2);   // genau 82 Rechtecke
+    testSegmentation(60, 24);  // 164 Rechtecke, 2 volle Pakete
+    testSegmentation(100, 25); // 3 Pakete, Tripel über Paketgrenze
+
+    testParity(10, 8);         // Einzelpaket → v1 ohne Parität
+    testParity(50, 10);        // 2 Datenpakete + Parität
+    testParity(60, 24);        // 2 volle Datenpakete + Parität
+    testParity(100, 23);       // 3 Datenpakete + Parität
+
+    testTiming();
+    testClockSync();
+
+    // Ungültige Eingaben werden abgewiesen
+    AmbilightFrameEncoder encoder;
+    RGB dummy[1] = {{0, 0, 0}};
+    AmbilightSides bad = {dummy, 1, dummy, 1, dummy, 1, dummy, 1};
+    CHECK(encoder.encode(1, 8, bad) == 0, "Seitenlängen passen nicht zur Segmentierung");
+    CHECK(encoder.encode(0, 8, bad) == 0, "hSeg = 0");
+
+    return testSummary("protocol_test");
+}
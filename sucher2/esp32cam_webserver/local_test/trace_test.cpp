@@ -0,0 +1,147 @@
+// Host-Test: Spannen-Ring und Chrome-Trace-Export (trace)
+//
+// Übersetzen und ausführen (im Ordner local_test):
+//   g++ -std=c++11 -O2 -Wall -pthread -I../src -I../../../lib/hanawa_core/src -I../../../lib/hanawa_core/test trace_test.cpp ../src/trace.cpp ../../../lib/hanawa_core/src/stage_metrics.cpp -o trace_test
+//   ./trace_test                 # Tests und Kosten pro Spanne
+//   ./trace_test trace.json      # zusätzlich Beispiel-Trace für ui.perfetto.dev
+//
+// Prüft Zeitfenster, Übernahme der Stufen aus recordStage(), Thread-Namen,
+// das Überschreiben alter Einträge und mehrere Schreiber gleichzeitig.
+
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include "trace.h"
+#include "test_check.h"
+
+static bool appendString(void* ctx, const char* data, size_t len) {
+    ((std::string*)ctx)->append(data, len);
+    return true;
+}
+
+static std::string exportTrace(uint32_t windowMs, uint32_t* count) {
+    std::string json;
+    *count = exportTraceJson(windowMs, appendString, &json);
+    return json;
+}
+
+static size_t countOf(const std::string& text, const char* needle) {
+    size_t n = 0;
+    for (size_t pos = text.find(needle); pos != std::string::npos; pos = text.find(needle, pos + 1)) {
+        n++;
+    }
+    return n;
+}
+
+static void testSpans() {
+    TRACE_THREAD_NAME("analysis");
+    int64_t now = metricsNowUs();
+    traceComplete("analysis", "old", now - 5000000, 100);   // außerhalb von 2 s
+    {
+        TRACE_SPAN("analysis", "frame");
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    recordStage(STAGE_JPEG_DECODE, 1500);   // über den Stage-Hook
+
+    uint32_t count = 0;
+    std::string json = exportTrace(2000, &count);
+    CHECK(count == 2, "count %u", count);
+    CHECK(json.compare(0, 15, "{\"displayTimeUn") == 0 && json.compare(json.size() - 2, 2, "]}") == 0,
+          "Rahmen: %s", json.c_str());
+    CHECK(json.find("\"name\":\"old\"") == std::string::npos, "altes Ereignis exportiert");
+    CHECK(json.find("{\"name\":\"frame\",\"cat\":\"analysis\",\"ph\":\"X\"") != std::string::npos, "frame fehlt: %s", json.c_str());
+    CHECK(json.find("{\"name\":\"jpeg_decode\",\"cat\":\"stage\",\"ph\":\"X\"") != std::string::npos, "Stufe fehlt");
+    CHECK(json.find("\"dur\":1500,") != std::string::npos, "Dauer der Stufe");
+    CHECK(json.find("\"args\":{\"name\":\"analysis\"}") != std::string::npos, "Thread-Name fehlt");
+
+    // Größeres Fenster enthält auch das alte Ereignis
+    exportTrace(10000, &count);
+    CHECK(count == 3, "count mit 10 s %u", count);
+}
+
+static void testOverwrite() {
+    for (int i = 0; i < TRACE_RING_EVENTS + 100; i++) {
+        traceComplete("test", "fill", metricsNowUs(), 1);
+    }
+    uint32_t count = 0;
+    std::string json = exportTrace(60000, &count);
+    CHECK(count == TRACE_RING_EVENTS, "count %u", count);
+    CHECK(countOf(json, "\"name\":\"fill\"") == TRACE_RING_EVENTS, "fill %zu", countOf(json, "\"name\":\"fill\""));
+}
+
+static void testThreads() {
+    const int THREADS = 4;
+    const char* names[THREADS] = { "capture", "api", "live", "espnow" };
+    std::vector<std::thread> writers;
+    for (int t = 0; t < THREADS; t++) {
+        writers.emplace_back([t, &names]() {
+            TRACE_THREAD_NAME(names[t]);
+            for (int i = 0; i < 1000; i++) {
+                TRACE_SPAN("test", "work");
+            }
+        });
+    }
+    // Export läuft parallel zu den Schreibern
+    uint32_t count = 0;
+    std::string during = exportTrace(60000, &count);
+    CHECK(during.compare(during.size() - 2, 2, "]}") == 0, "Export während des Schreibens");
+    for (auto& w : writers) {
+        w.join();
+    }
+
+    std::string json = exportTrace(60000, &count);
+    CHECK(count == TRACE_RING_EVENTS, "count %u", count);
+    for (int t = 0; t < THREADS; t++) {
+        std::string meta = std::string("\"args\":{\"name\":\"") + names[t] + "\"}";
+        CHECK(json.find(meta) != std::string::npos, "Thread %s fehlt", names[t]);
+    }
+}
+
+static void benchmark() {
+    const int N = 1000000;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < N; i++) {
+        TRACE_SPAN("bench", "span");
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / N;
+    printf("trace_test: TRACE_SPAN %.1f ns/Spanne\n", ns);
+}
+
+int main(int argc, char** argv) {
+    CHECK(getTraceStats().capacity == 0, "vor initTrace() schon aktiv");
+    traceComplete("test", "ignored", 0, 1);   // ohne Puffer: nichts passiert
+    CHECK(getTraceStats().recorded == 0, "ohne Puffer aufgezeichnet");
+    CHECK(initTrace(), "initTrace");
+
+    testSpans();
+    testOverwrite();
+    testThreads();
+    benchmark();
+
+    if (argc > 1) {
+        // Beispiel mit echten Stufennamen zum Ansehen in Perfetto; vorher
+        // warten, damit die Benchmark-Spannen aus dem Zeitfenster fallen
+        std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+        TRACE_THREAD_NAME("analysis");
+        for (int frame = 0; frame < 20; frame++) {
+            TRACE_SPAN("analysis", "frame");
+            { StageTimer t(STAGE_CAPTURE_WAIT); std::this_thread::sleep_for(std::chrono::milliseconds(3)); }
+            { StageTimer t(STAGE_JPEG_DECODE); std::this_thread::sleep_for(std::chrono::milliseconds(8)); }
+            { StageTimer t(STAGE_REDUCTION); std::this_thread::sleep_for(std::chrono::milliseconds(2)); }
+        }
+        uint32_t count = 0;
+        std::string json = exportTrace(1000, &count);
+        FILE* f = fopen(argv[1], "w");
+        if (f) {
+            fwrite(json.data(), 1, json.size(), f);
+            fclose(f);
+            printf("trace_test: %u Spannen nach %s geschrieben\n", count, argv[1]);
+        }
+    }
+
+    return testSummary("trace_test");
+}
@@ -0,0 +1,354 @@
+#include "alloc_tracker.h"
+
+#if ALLOC_TRACKING
+
+#include <stdlib.h>
+#include <string.h>
+#include <new>
+#include "deferred_log.h"
+
+#ifdef ESP_PLATFORM
+#include <esp_heap_caps.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+static portMUX_TYPE s_allocMux = portMUX_INITIALIZER_UNLOCKED;
+#define ALLOC_LOCK()    taskENTER_CRITICAL(&s_allocMux)
+#define ALLOC_UNLOCK()  taskEXIT_CRITICAL(&s_allocMux)
+#else
+#include <mutex>
+static std::mutex s_allocMutex;
+#define ALLOC_LOCK()    s_allocMutex.lock()
+#define ALLOC_UNLOCK()  s_allocMutex.unlock()
+#endif
+
+// Originale, vom Linker per --wrap umgeleitet
+extern "C" {
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+#ifdef ESP_PLATFORM
+void* __real_heap_caps_malloc(size_t size, uint32_t caps);
+void* __real__Znwj(size_t size);   // operator new(unsigned int)
+void* __real__Znaj(size_t size);   // operator new[](unsigned int)
+#endif
+}
+
+// ============================================================================
+// STATE
+// ============================================================================
+
+struct ScopeEntry {
+    const char* name;
+    uint32_t allocs;
+    uint32_t bytes;
+    char metricAllocs[40];   // alloc_<name>_total
+    char metricBytes[48];    // alloc_<name>_bytes_total
+};
+
+static ScopeEntry s_scopes[ALLOC_MAX_SCOPES];
+static int s_scopeCount = 0;
+static AllocFlag s_flags[ALLOC_MAX_FLAGGED];
+static int s_flagCount = 0;
+static AllocStats s_stats = {0, 0, 0, 0, 0};
+
+static thread_local const char* t_scope = nullptr;
+static thread_local bool t_inFrame = false;
+static thread_local bool t_inHook = false;   // verschachtelte Allokationen nicht doppelt zählen
+
+// ============================================================================
+// ERFASSUNG
+// ============================================================================
+
+// "/api/ambilight" -> "api_ambilight" (Aufrufer hält den Lock, kein Heap)
+static void metricName(char* out, size_t cap, const char* prefix, const char* name, const char* suffix) {
+    size_t n = 0;
+    for (const char* p = prefix; *p && n + 1 < cap; p++) {
+        out[n++] = *p;
+    }
+    bool lastUnderscore = true;
+    for (const char* p = name; *p && n + 1 < cap; p++) {
+        char c = *p;
+        bool alnum = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9');
+        if (alnum) {
+            out[n++] = (c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c;
+            lastUnderscore = false;
+        } else if (!lastUnderscore) {
+            out[n++] = '_';
+            lastUnderscore = true;
+        }
+    }
+    if (n > 0 && out[n - 1] == '_') {
+        n--;
+    }
+    for (const char* p = suffix; *p && n + 1 < cap; p++) {
+        out[n++] = *p;
+    }
+    out[n] = '\0';
+}
+
+static void record(size_t size, void* caller) {
+    const char* scope = t_scope ? t_scope : "other";
+    MetricStage stage = currentStage();
+    if (stage != STAGE_COUNT) {
+        scope = metricStageName(stage);   // Stufe ist genauer als die Route
+    }
+
+    bool report = false;
+    ALLOC_LOCK();
+    s_stats.allocs++;
+    s_stats.bytes += size;
+
+    int i = 0;
+    while (i < s_scopeCount && s_scopes[i].name != scope) {
+        i++;
+    }
+    if (i == s_scopeCount && s_scopeCount < ALLOC_MAX_SCOPES) {
+        ScopeEntry& e = s_scopes[s_scopeCount++];
+        e.name = scope;
+        e.allocs = 0;
+        e.bytes = 0;
+        metricName(e.metricAllocs, sizeof(e.metricAllocs), "alloc_", scope, "_total");
+        metricName(e.metricBytes, sizeof(e.metricBytes), "alloc_", scope, "_bytes_total");
+    }
+    if (i < s_scopeCount) {
+        s_scopes[i].allocs++;
+        s_scopes[i].bytes += size;
+    }
+
+    if (t_inFrame && s_stats.frames >= ALLOC_WARMUP_FRAMES) {
+        s_stats.steadyAllocs++;
+        s_stats.steadyBytes += size;
+        int f = 0;
+        while (f < s_flagCount && s_flags[f].caller != caller) {
+            f++;
+        }
+        if (f < s_flagCount) {
+            s_flags[f].count++;
+        } else if (s_flagCount < ALLOC_MAX_FLAGGED) {
+            AllocFlag& flag = s_flags[s_flagCount++];
+            flag.caller = caller;
+            flag.scope = scope;
+            flag.bytes = size;
+            flag.count = 1;
+            report = true;
+        }
+    }
+    ALLOC_UNLOCK();
+
+    if (report) {
+        LOG_W("[alloc] Allokation in der Frame-Schleife: %u B in %s, Aufrufer %p", (unsigned)size, scope, caller);
+    }
+}
+
+static void* trackedMalloc(size_t size, void* caller) {
+    if (t_inHook) {
+        return __real_malloc(size);
+    }
+    t_inHook = true;
+    void* p = __real_malloc(size);
+    if (p) {
+        record(size, caller);
+    }
+    t_inHook = false;
+    return p;
+}
+
+extern "C" void* __wrap_malloc(size_t size) {
+    return trackedMalloc(size, __builtin_return_address(0));
+}
+
+extern "C" void* __wrap_calloc(size_t count, size_t size) {
+    if (t_inHook) {
+        return __real_calloc(count, size);
+    }
+    t_inHook = true;
+    void* p = __real_calloc(count, size);
+    if (p) {
+        record(count * size, __builtin_return_address(0));
+    }
+    t_inHook = false;
+    return p;
+}
+
+extern "C" void* __wrap_realloc(void* ptr, size_t size) {
+    if (t_inHook || size == 0) {
+        return __real_realloc(ptr, size);
+    }
+    t_inHook = true;
+    void* p = __real_realloc(ptr, size);
+    if (p) {
+        record(size, __builtin_return_address(0));
+    }
+    t_inHook = false;
+    return p;
+}
+
+#ifdef ESP_PLATFORM
+
+extern "C" void* __wrap_heap_caps_malloc(size_t size, uint32_t caps) {
+    if (t_inHook) {
+        return __real_heap_caps_malloc(size, caps);
+    }
+    t_inHook = true;
+    void* p = __real_heap_caps_malloc(size, caps);
+    if (p) {
+        record(size, __builtin_return_address(0));
+    }
+    t_inHook = false;
+    return p;
+}
+
+// operator new: Aufrufer ist der Code mit dem new, nicht libstdc++
+extern "C" void* __wrap__Znwj(size_t size) {
+    if (t_inHook) {
+        return __real__Znwj(size);
+    }
+    t_inHook = true;
+    void* p = __real__Znwj(size);
+    record(size, __builtin_return_address(0));
+    t_inHook = false;
+    return p;
+}
+
+extern "C" void* __wrap__Znaj(size_t size) {
+    if (t_inHook) {
+        return __real__Znaj(size);
+    }
+    t_inHook = true;
+    void* p = __real__Znaj(size);
+    record(size, __builtin_return_address(0));
+    t_inHook = false;
+    return p;
+}
+
+#else
+
+// Auf dem Rechner liegt operator new in der libstdc++.so, --wrap greift dort
+// nicht; deshalb hier ersetzen
+void* operator new(size_t size) {
+    void* p = trackedMalloc(size, __builtin_return_address(0));
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void* operator new[](size_t size) {
+    void* p = trackedMalloc(size, __builtin_return_address(0));
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    free(p);
+}
+
+#endif
+
+// ============================================================================
+// API
+// ============================================================================
+
+AllocScope::AllocScope(const char* name) : m_prev(t_scope) {
+    t_scope = name;
+}
+
+AllocScope::~AllocScope() {
+    t_scope = m_prev;
+}
+
+void allocFrameBegin() {
+    t_inFrame = true;
+}
+
+void allocFrameEnd() {
+    t_inFrame = false;
+    ALLOC_LOCK();
+    s_stats.frames++;
+    ALLOC_UNLOCK();
+}
+
+void allocRestartWarmup() {
+    ALLOC_LOCK();
+    s_stats.frames = 0;
+    ALLOC_UNLOCK();
+}
+
+AllocStats getAllocStats() {
+    ALLOC_LOCK();
+    AllocStats stats = s_stats;
+    ALLOC_UNLOCK();
+    return stats;
+}
+
+int getAllocScopes(AllocScopeStats* out, int cap) {
+    int n = 0;
+    ALLOC_LOCK();
+    for (int i = 0; i < s_scopeCount && n < cap; i++) {
+        out[n].name = s_scopes[i].name;
+        out[n].allocs = s_scopes[i].allocs;
+        out[n].bytes = s_scopes[i].bytes;
+        n++;
+    }
+    ALLOC_UNLOCK();
+    return n;
+}
+
+int getAllocFlags(AllocFlag* out, int cap) {
+    int n = 0;
+    ALLOC_LOCK();
+    for (int i = 0; i < s_flagCount && n < cap; i++) {
+        out[n++] = s_flags[i];
+    }
+    ALLOC_UNLOCK();
+    return n;
+}
+
+int getAllocMetricValues(MetricValue* out, int cap) {
+    AllocStats stats = getAllocStats();
+    const MetricValue totals[] = {
+        { "alloc_total",              "Heap-Allokationen",                          true,  (double)stats.allocs },
+        { "alloc_bytes_total",        "Angeforderte Bytes",                         true,  (double)stats.bytes },
+        { "alloc_steady_total",       "Allokationen in der Frame-Schleife nach dem Warm-up", true, (double)stats.steadyAllocs },
+        { "alloc_steady_bytes_total", "Bytes in der Frame-Schleife nach dem Warm-up", true, (double)stats.steadyBytes },
+    };
+    int n = 0;
+    for (const MetricValue& v : totals) {
+        if (n < cap) {
+            out[n++] = v;
+        }
+    }
+
+    ALLOC_LOCK();
+    for (int i = 0; i < s_scopeCount; i++) {
+        if (n + 2 > cap) {
+            break;
+        }
+        out[n++] = { s_scopes[i].metricAllocs, "Heap-Allokationen je Verursacher", true, (double)s_scopes[i].allocs };
+        out[n++] = { s_scopes[i].metricBytes, "Angeforderte Bytes je Verursacher", true, (double)s_scopes[i].bytes };
+    }
+    ALLOC_UNLOCK();
+    return n;
+}
+
+void resetAllocStats() {
+    ALLOC_LOCK();
+    for (int i = 0; i < s_scopeCount; i++) {
+        s_scopes[i].allocs = 0;
+        s_scopes[i].bytes = 0;
+    }
+    s_flagCount = 0;
+    s_stats.allocs = 0;
+    s_stats.bytes = 0;
+    s_stats.steadyAllocs = 0;
+    s_stats.steadyBytes = 0;
+    ALLOC_UNLOCK();
+}
+
+#endif // ALLOC_TRACKING
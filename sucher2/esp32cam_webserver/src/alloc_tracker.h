@@ -0,0 +1,94 @@
+#ifndef ALLOC_TRACKER_H
+#define ALLOC_TRACKER_H
+
+// Debug-Modus "keine Allokation im eingeschwungenen Zustand": zählt jede
+// Heap-Allokation (malloc/calloc/realloc/heap_caps_malloc/new) nach
+// Verursacher – laufende Stufe aus stage_metrics.h, sonst ALLOC_SCOPE()
+// (z. B. HTTP-Route). Nach ALLOC_WARMUP_FRAMES Analyse-Frames wird jede
+// Allokation innerhalb der Frame-Schleife mit Aufrufer-Adresse gemeldet
+// (LOG_W, einmal je Adresse).
+//
+// Aktivieren per build_flags (env:esp32cam-alloc in platformio.ini):
+//   -DALLOC_TRACKING=1 -Wl,--wrap=malloc -Wl,--wrap=calloc -Wl,--wrap=realloc
+//   -Wl,--wrap=heap_caps_malloc -Wl,--wrap=_Znwj -Wl,--wrap=_Znaj
+// Ohne ALLOC_TRACKING sind alle Makros leer. Auf dem Rechner ersetzt der
+// Tracker operator new, malloc & Co. werden ebenfalls per --wrap umgeleitet.
+
+#include <stddef.h>
+#include <stdint.h>
+#include "stage_metrics.h"
+
+#ifndef ALLOC_TRACKING
+#define ALLOC_TRACKING 0
+#endif
+
+#define ALLOC_WARMUP_FRAMES   50   // 5 s bei 10 FPS
+#define ALLOC_MAX_SCOPES      16
+#define ALLOC_MAX_FLAGGED     16   // gemeldete Aufrufer-Adressen
+
+struct AllocScopeStats {
+    const char* name;     // Stufe ("reduction") oder ALLOC_SCOPE-Name
+    uint32_t allocs;
+    uint32_t bytes;
+};
+
+struct AllocFlag {
+    void* caller;         // Rücksprungadresse (addr2line -e firmware.elf)
+    const char* scope;
+    uint32_t bytes;       // Größe der ersten gemeldeten Allokation
+    uint32_t count;       // Allokationen von dieser Adresse seit Warm-up
+};
+
+struct AllocStats {
+    uint32_t allocs;          // insgesamt
+    uint32_t bytes;
+    uint32_t frames;          // Analyse-Frames seit dem letzten Warm-up-Start
+    uint32_t steadyAllocs;    // in der Frame-Schleife nach dem Warm-up
+    uint32_t steadyBytes;
+};
+
+#if ALLOC_TRACKING
+
+// Zählt Allokationen im Block zum angegebenen Verursacher (Literal)
+class AllocScope {
+public:
+    explicit AllocScope(const char* name);
+    ~AllocScope();
+private:
+    const char* m_prev;
+};
+
+#define ALLOC_CONCAT2(a, b) a##b
+#define ALLOC_CONCAT(a, b) ALLOC_CONCAT2(a, b)
+#define ALLOC_SCOPE(name) AllocScope ALLOC_CONCAT(allocScope_, __LINE__)(name)
+
+// Klammern einen Analyse-Frame (nur der Analyse-Task)
+void allocFrameBegin();
+void allocFrameEnd();
+
+// Neue Konfiguration: Puffer dürfen wachsen, Warm-up beginnt von vorn
+void allocRestartWarmup();
+
+AllocStats getAllocStats();
+int getAllocScopes(AllocScopeStats* out, int cap);
+int getAllocFlags(AllocFlag* out, int cap);
+
+// Zähler als MetricValue für /api/metrics (Namen bleiben gültig)
+int getAllocMetricValues(MetricValue* out, int cap);
+
+void resetAllocStats();
+
+#define ALLOC_FRAME_BEGIN()      allocFrameBegin()
+#define ALLOC_FRAME_END()        allocFrameEnd()
+#define ALLOC_RESTART_WARMUP()   allocRestartWarmup()
+
+#else
+
+#define ALLOC_SCOPE(name)        ((void)0)
+#define ALLOC_FRAME_BEGIN()      ((void)0)
+#define ALLOC_FRAME_END()        ((void)0)
+#define ALLOC_RESTART_WARMUP()   ((void)0)
+
+#endif // ALLOC_TRACKING
+
+#endif // ALLOC_TRACKER_H
@@ -0,0 +1,142 @@
+#include "analysis_task.h"
+#include <esp_timer.h>
+#include <cmath>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "windows.h"
+#include "stage_metrics.h"
+#include "alloc_tracker.h"
+
+// ============================================================================
+// STATE
+// ============================================================================
+
+static TaskHandle_t s_analysisTask = nullptr;
+
+// Summen für Mittelwert/Streuung, nur der Analyse-Task schreibt
+struct TimingAccumulator {
+    uint32_t frames;
+    uint32_t periods;
+    uint32_t overruns;
+    uint64_t periodSumUs;
+    uint64_t periodSumSqUs;   // für die Standardabweichung (100 ms² passt > 10⁹ mal)
+    uint32_t periodMinUs;
+    uint32_t periodMaxUs;
+    uint64_t busySumUs;
+    uint32_t busyMaxUs;
+};
+
+// Schützt s_timing beim Lesen aus einem anderen Task (64-Bit-Felder)
+static portMUX_TYPE s_timingMux = portMUX_INITIALIZER_UNLOCKED;
+static TimingAccumulator s_timing = {};
+static volatile bool s_resetRequested = false;
+
+// ============================================================================
+// TASK
+// ============================================================================
+
+// Aufrufer hält s_timingMux
+static void clearTimingLocked() {
+    s_timing = {};
+    s_timing.periodMinUs = UINT32_MAX;
+}
+
+static void recordFrame(int64_t startUs, int64_t lastStartUs, int64_t busyUs) {
+    taskENTER_CRITICAL(&s_timingMux);
+    if (s_resetRequested) {
+        clearTimingLocked();
+        s_resetRequested = false;
+        lastStartUs = 0;   // Periode über den Reset hinweg nicht werten
+    }
+    s_timing.frames++;
+    if (busyUs > (int64_t)ANALYSIS_PERIOD_MS * 1000) {
+        s_timing.overruns++;
+    }
+    s_timing.busySumUs += busyUs;
+    if (busyUs > s_timing.busyMaxUs) {
+        s_timing.busyMaxUs = busyUs;
+    }
+    if (lastStartUs > 0) {
+        uint32_t periodUs = startUs - lastStartUs;
+        s_timing.periods++;
+        s_timing.periodSumUs += periodUs;
+        s_timing.periodSumSqUs += (uint64_t)periodUs * periodUs;
+        if (periodUs < s_timing.periodMinUs) {
+            s_timing.periodMinUs = periodUs;
+        }
+        if (periodUs > s_timing.periodMaxUs) {
+            s_timing.periodMaxUs = periodUs;
+        }
+    }
+    taskEXIT_CRITICAL(&s_timingMux);
+}
+
+static void analysisTask(void* arg) {
+    TickType_t lastWake = xTaskGetTickCount();
+    int64_t lastStartUs = 0;
+    for (;;) {
+        vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(ANALYSIS_PERIOD_MS));
+
+        int64_t startUs = esp_timer_get_time();
+        ALLOC_FRAME_BEGIN();
+        calculateAmbilightContinuous();
+        ALLOC_FRAME_END();
+        int64_t busyUs = esp_timer_get_time() - startUs;
+
+        recordFrame(startUs, lastStartUs, busyUs);
+        recordStage(STAGE_FRAME_TOTAL, busyUs);
+        lastStartUs = startUs;
+
+        // Nach einem Überlauf nicht alle verpassten Takte nachholen
+        TickType_t now = xTaskGetTickCount();
+        if ((TickType_t)(now - lastWake) > pdMS_TO_TICKS(ANALYSIS_PERIOD_MS)) {
+            lastWake = now;
+        }
+    }
+}
+
+// ============================================================================
+// API
+// ============================================================================
+
+bool initAnalysisTask() {
+    taskENTER_CRITICAL(&s_timingMux);
+    clearTimingLocked();
+    taskEXIT_CRITICAL(&s_timingMux);
+
+    if (xTaskCreatePinnedToCore(analysisTask, "analysis", ANALYSIS_TASK_STACK, nullptr,
+                                ANALYSIS_TASK_PRIORITY, &s_analysisTask, ANALYSIS_TASK_CORE) != pdPASS) {
+        Serial.println("[analysis] ERROR: Task konnte nicht gestartet werden");
+        return false;
+    }
+    Serial.printf("[analysis] Task gestartet (alle %d ms, Core %d, Priorität %d)\n",
+                  ANALYSIS_PERIOD_MS, ANALYSIS_TASK_CORE, ANALYSIS_TASK_PRIORITY);
+    return true;
+}
+
+AnalysisTimingStats getAnalysisTimingStats() {
+    taskENTER_CRITICAL(&s_timingMux);
+    TimingAccumulator t = s_timing;
+    taskEXIT_CRITICAL(&s_timingMux);
+
+    AnalysisTimingStats stats = {};
+    stats.frames = t.frames;
+    stats.overruns = t.overruns;
+    if (t.frames > 0) {
+        stats.busyMeanUs = t.busySumUs / t.frames;
+        stats.busyMaxUs = t.busyMaxUs;
+    }
+    if (t.periods > 0) {
+        double mean = (double)t.periodSumUs / t.periods;
+        double variance = (double)t.periodSumSqUs / t.periods - mean * mean;
+        stats.periodMeanUs = (uint32_t)mean;
+        stats.periodStddevUs = variance > 0 ? (uint32_t)sqrt(variance) : 0;
+        stats.periodMinUs = t.periodMinUs;
+        stats.periodMaxUs = t.periodMaxUs;
+    }
+    return stats;
+}
+
+void resetAnalysisTimingStats() {
+    s_resetRequested = true;
+}
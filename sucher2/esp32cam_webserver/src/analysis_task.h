@@ -0,0 +1,35 @@
+#ifndef ANALYSIS_TASK_H
+#define ANALYSIS_TASK_H
+
+#include <Arduino.h>
+
+// Kontinuierliche Ambilight-Berechnung auf eigenem Task mit festem Takt.
+// Die HTTP-Server laufen alle mit niedrigerer Priorität, ein langsamer Client
+// kann den nächsten Analyse-Frame damit nicht mehr verzögern.
+#define ANALYSIS_PERIOD_MS       100   // 10 FPS für den Leuchter
+#define ANALYSIS_TASK_CORE       1
+#define ANALYSIS_TASK_PRIORITY   3     // über allen HTTP-Tasks und loop()
+#define ANALYSIS_TASK_STACK      8192
+
+// Takt-Statistik seit dem letzten Reset (Jitter = Streuung der Periode)
+struct AnalysisTimingStats {
+    uint32_t frames;          // Durchläufe von calculateAmbilightContinuous()
+    uint32_t overruns;        // Durchläufe, die länger als ANALYSIS_PERIOD_MS gerechnet haben
+    uint32_t periodMeanUs;    // mittlerer Abstand zweier Frame-Starts
+    uint32_t periodStddevUs;  // Standardabweichung des Abstands
+    uint32_t periodMinUs;
+    uint32_t periodMaxUs;
+    uint32_t busyMeanUs;      // mittlere Rechenzeit pro Durchlauf
+    uint32_t busyMaxUs;
+};
+
+// Startet den Analyse-Task. Nach initFrameBroker() und den Ergebnis-Listenern
+// (ESP-NOW, UDP, Live-WebSocket) aufrufen.
+bool initAnalysisTask();
+
+AnalysisTimingStats getAnalysisTimingStats();
+
+// Setzt die Statistik zurück (z. B. vor einer Messung), wirkt ab dem nächsten Frame
+void resetAnalysisTimingStats();
+
+#endif // ANALYSIS_TASK_H
@@ -0,0 +1,821 @@
+#include "api_server.h"
+#include <WiFi.h>
+#include <ArduinoJson.h>
+#include <esp_http_server.h>
+#include "img_converters.h"
+#include "index_html.h"
+#include "windows.h"
+#include "frame_broker.h"
+#include "analysis_task.h"
+#include "snapshot_cache.h"
+#include "stage_metrics.h"
+#include "deferred_log.h"
+#include "trace.h"
+#include "alloc_tracker.h"
+#include "espnow_sender.h"
+#include "live_socket.h"
+#include "stream_server.h"
+#include "color_recorder.h"
+#include "reduce_worker.h"
+#include "sensor_crop.h"
+#include "capture_mode.h"
+#include "camera_tune.h"
+
+#define SNAPSHOT_FRAME_TIMEOUT_MS 1000
+#define SNAPSHOT_MAX_AGE_MS       500    // älter = Analyse liefert gerade nicht, neu holen
+#define SNAPSHOT_WAIT_MS          300    // nach Pause: so lange auf die nächste Kopie warten
+#define SNAPSHOT_DETAIL_WAIT_MS   800    // zwei Auflösungen: so lange auf einen großen Frame warten
+#define SNAPSHOT_THUMB_QUALITY    80
+
+// ============================================================================
+// STATE
+// ============================================================================
+
+static httpd_handle_t s_apiHttpd = nullptr;
+
+// Frame-Verbraucher für /api/snapshot
+static int s_snapshotConsumer = -1;
+
+// Zuletzt erzeugtes Vorschaubild (?scale=). Nur der API-Task greift darauf
+// zu, der httpd bearbeitet Requests nacheinander.
+static uint8_t* s_thumbJpeg = nullptr;
+static size_t s_thumbLen = 0;
+static char s_thumbEtag[40] = "";
+
+static volatile ApiServerStats s_stats = {0, 0, 0, 0, 0};
+
+// ============================================================================
+// HILFSFUNKTIONEN
+// ============================================================================
+
+// Request-Logger - wird für JEDEN Request aufgerufen. Geloggt wird die
+// registrierte Route (user_ctx, String-Literal), req->uri lebt nicht lange
+// genug für das verzögerte Formatieren.
+static void logRequest(httpd_req_t* req) {
+    s_stats.requests++;
+    LOG_I("[REQUEST] %s %s (fd %d)",
+          req->method == HTTP_GET ? "GET" : "POST", (const char*)req->user_ctx, httpd_req_to_sockfd(req));
+}
+
+// Am Anfang jedes Handlers: zählen und loggen, Zeitleiste und Allokationen
+// der Route zuordnen
+#define BEGIN_REQUEST(req) \
+    logRequest(req); \
+    TRACE_SPAN("http", (const char*)(req)->user_ctx); \
+    ALLOC_SCOPE((const char*)(req)->user_ctx)
+
+// Liest den kompletten POST-Body. Bei Fehler ist die Antwort schon gesendet.
+static bool readBody(httpd_req_t* req, String& body) {
+    if (req->content_len == 0) {
+        s_stats.badRequests++;
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "No body");
+        return false;
+    }
+    if (req->content_len > API_MAX_BODY) {
+        s_stats.badRequests++;
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Body too large");
+        return false;
+    }
+
+    char buf[256];
+    size_t remaining = req->content_len;
+    body.reserve(remaining);
+    while (remaining > 0) {
+        int n = httpd_req_recv(req, buf, min(remaining, sizeof(buf)));
+        if (n == HTTPD_SOCK_ERR_TIMEOUT) {
+            continue;
+        }
+        if (n <= 0) {
+            // Verbindung weg, httpd schließt die Session
+            return false;
+        }
+        body.concat(buf, n);
+        remaining -= n;
+    }
+    return true;
+}
+
+static esp_err_t sendJson(httpd_req_t* req, const String& json) {
+    httpd_resp_set_type(req, "application/json");
+    return httpd_resp_send(req, json.c_str(), json.length());
+}
+
+// ============================================================================
+// HANDLER
+// ============================================================================
+
+static esp_err_t handle_root(httpd_req_t* req)
+{
+    BEGIN_REQUEST(req);
+    LOG_D("[handle_root] Root page requested");
+    httpd_resp_set_type(req, "text/html");
+    return httpd_resp_send(req, INDEX_HTML, HTTPD_RESP_USE_STRLEN);
+}
+
+// Verkleinert ein JPEG um 2, 4 oder 8 (Dekodieren mit Skalierung, neu kodieren)
+static bool scaleJpeg(const uint8_t* jpeg, size_t len, int width, int height, int scale,
+                      uint8_t** out, size_t* outLen)
+{
+    jpg_scale_t jpgScale = scale == 8 ? JPG_SCALE_8X : scale == 4 ? JPG_SCALE_4X : JPG_SCALE_2X;
+    int w = width / scale;
+    int h = height / scale;
+    size_t rgbLen = w * h * 2;
+    uint8_t* rgb = (uint8_t*)(psramFound() ? ps_malloc(rgbLen) : malloc(rgbLen));
+    if (!rgb) {
+        return false;
+    }
+    bool ok = jpg2rgb565(jpeg, len, rgb, jpgScale) &&
+              fmt2jpg(rgb, rgbLen, w, h, PIXFORMAT_RGB565, SNAPSHOT_THUMB_QUALITY, out, outLen);
+    free(rgb);
+    return ok;
+}
+
+// Sendet ein JPEG mit Validierungs-Headern; ?scale= liefert ein Vorschaubild
+static esp_err_t sendSnapshot(httpd_req_t* req, const uint8_t* jpeg, size_t len, int width, int height,
+                              int scale, uint32_t sequence, int64_t captureUs)
+{
+    char etag[40];
+    snprintf(etag, sizeof(etag), "\"%lld-%d\"", (long long)captureUs, scale);
+    char seqStr[12];
+    char tsStr[24];
+    snprintf(seqStr, sizeof(seqStr), "%u", sequence);
+    snprintf(tsStr, sizeof(tsStr), "%lld", (long long)captureUs);
+
+    httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
+    httpd_resp_set_hdr(req, "Access-Control-Expose-Headers", "ETag, X-Sequence, X-Timestamp");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-cache");   // immer nachfragen, 304 wenn unverändert
+    httpd_resp_set_hdr(req, "ETag", etag);
+    httpd_resp_set_hdr(req, "X-Sequence", seqStr);
+    httpd_resp_set_hdr(req, "X-Timestamp", tsStr);
+
+    char ifNoneMatch[40];
+    if (httpd_req_get_hdr_value_str(req, "If-None-Match", ifNoneMatch, sizeof(ifNoneMatch)) == ESP_OK &&
+        strcmp(ifNoneMatch, etag) == 0) {
+        s_stats.notModified++;
+        httpd_resp_set_status(req, "304 Not Modified");
+        return httpd_resp_send(req, nullptr, 0);
+    }
+
+    if (scale > 1) {
+        if (strcmp(s_thumbEtag, etag) != 0) {
+            free(s_thumbJpeg);
+            s_thumbJpeg = nullptr;
+            s_thumbEtag[0] = '\0';
+            if (!scaleJpeg(jpeg, len, width, height, scale, &s_thumbJpeg, &s_thumbLen)) {
+                LOG_E("[snapshot] ERROR: Vorschaubild fehlgeschlagen");
+                httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Scaling failed");
+                return ESP_OK;
+            }
+            strcpy(s_thumbEtag, etag);
+        }
+        jpeg = s_thumbJpeg;
+        len = s_thumbLen;
+    }
+
+    httpd_resp_set_type(req, "image/jpeg");
+    return httpd_resp_send(req, (const char *)jpeg, len);
+}
+
+// Sendet einzelnes JPEG-Snapshot (Einzelbild; der Live-Stream läuft über stream_server.cpp).
+// Normalerweise der zuletzt analysierte Frame aus dem Snapshot-Cache, ohne
+// eigene Aufnahme; nur wenn die Analyse keine Frames holt (z. B. ungültige
+// Konfiguration), wird über den Frame-Broker aufgenommen.
+static esp_err_t handle_snapshot(httpd_req_t* req)
+{
+    BEGIN_REQUEST(req);
+
+    int scale = 1;
+    char query[32];
+    char value[4];
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK &&
+        httpd_query_key_value(query, "scale", value, sizeof(value)) == ESP_OK) {
+        scale = atoi(value);
+        if (scale != 1 && scale != 2 && scale != 4 && scale != 8) {
+            s_stats.badRequests++;
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "scale must be 1, 2, 4 or 8");
+            return ESP_OK;
+        }
+    }
+
+    // Erster Abruf nach einer Pause meldet Bedarf an; die Analyse kopiert ab
+    // ihrem nächsten Frame wieder. Bei zwei Auflösungen schaltet sie zugleich
+    // auf Details, bis dahin kommen noch kleine Frames: auf einen großen
+    // warten, sonst den kleinen liefern.
+    requestDetailCapture();
+    bool dual = getCaptureModeStats().enabled;
+    int waitMs = dual ? SNAPSHOT_DETAIL_WAIT_MS : SNAPSHOT_WAIT_MS;
+    SnapshotFrame frame;
+    bool cached = acquireSnapshotFrame(&frame, SNAPSHOT_MAX_AGE_MS);
+    for (int waited = 0; waited < waitMs; waited += 20) {
+        if (cached && (!dual || frame.width >= detailCaptureWidth())) {
+            break;
+        }
+        if (cached) {
+            releaseSnapshotFrame(&frame);
+        }
+        vTaskDelay(pdMS_TO_TICKS(20));
+        cached = acquireSnapshotFrame(&frame, SNAPSHOT_MAX_AGE_MS);
+    }
+    if (cached) {
+        esp_err_t res = sendSnapshot(req, frame.jpeg, frame.len, frame.width, frame.height,
+                                     scale, frame.sequence, frame.captureUs);
+        releaseSnapshotFrame(&frame);
+        return res;
+    }
+
+    camera_fb_t *fb = acquireFrame(s_snapshotConsumer, SNAPSHOT_FRAME_TIMEOUT_MS);
+    if (!fb) {
+        LOG_E("[snapshot] ERROR: Failed to get camera frame");
+        s_stats.cameraErrors++;
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Camera error");
+        return ESP_OK;
+    }
+    int64_t captureUs = (int64_t)fb->timestamp.tv_sec * 1000000LL + fb->timestamp.tv_usec;
+    esp_err_t res = sendSnapshot(req, fb->buf, fb->len, fb->width, fb->height, scale, 0, captureUs);
+    releaseFrame(fb);
+    return res;
+}
+
+// API: empfängt 4 Punkte und Segmentzahlen, berechnet Zwischenpunkte
+static esp_err_t handle_grid(httpd_req_t* req)
+{
+    BEGIN_REQUEST(req);
+    LOG_D("[handle_grid] === GRID REQUEST RECEIVED ===");
+    String body;
+    if (!readBody(req, body)) {
+        Serial.println("[handle_grid] No body");
+        return ESP_OK;
+    }
+
+    StaticJsonDocument<1024> doc;
+    DeserializationError err = deserializeJson(doc, body);
+    if (err) {
+        Serial.println("[handle_grid] JSON parse error");
+        s_stats.badRequests++;
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "JSON parse error");
+        return ESP_OK;
+    }
+
+    JsonArray pts = doc["points"].as<JsonArray>();
+    if (pts.size() != 4) {
+        Serial.print("[handle_grid] pts size:"); Serial.println(pts.size());
+        s_stats.badRequests++;
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Need 4 points");
+        return ESP_OK;
+    }
+
+    int hSeg = doc["hSeg"].as<int>() | 1;
+    int vSeg = doc["vSeg"].as<int>() | 1;
+
+    struct P { float x; float y; };
+    P p[4];
+    for (int i = 0; i < 4; ++i) {
+        p[i].x = pts[i]["x"].as<float>();
+        p[i].y = pts[i]["y"].as<float>();
+    }
+
+    DynamicJsonDocument outDoc(2048);
+    JsonArray arr = outDoc.createNestedArray("points");
+
+    auto addIntermediates = [&](P a, P b, int count) {
+        float dx = b.x - a.x;
+        float dy = b.y - a.y;
+        for (int i = 1; i < count; ++i) {
+            float t = (float)i / count;
+            JsonObject obj = arr.createNestedObject();
+            obj["x"] = a.x + dx * t;
+            obj["y"] = a.y + dy * t;
+        }
+    };
+
+    // horizontale Linien 1-2 und 3-4
+    addIntermediates(p[0], p[1], hSeg);
+    addIntermediates(p[2], p[3], hSeg);
+    // vertikale Linien 2-3 und 4-1
+    addIntermediates(p[1], p[2], vSeg);
+    addIntermediates(p[3], p[0], vSeg);
+
+    serializeJsonPretty(outDoc, Serial);
+    Serial.println();
+
+    String response;
+    serializeJson(outDoc, response);
+    return sendJson(req, response);
+}
+
+// API: Konfiguration setzen (ersetzt /api/grid), wirkt ab dem nächsten Analyse-Frame
+static esp_err_t handle_config(httpd_req_t* req)
+{
+    BEGIN_REQUEST(req);
+    LOG_D("[handle_config] === CONFIG REQUEST RECEIVED ===");
+
+    String body;
+    if (!readBody(req, body)) {
+        LOG_W("[handle_config] No body");
+        return ESP_OK;
+    }
+
+    updateAmbilightConfig(body);
+
+    LOG_I("[handle_config] Config updated!");
+    return sendJson(req, "{\"status\":\"ok\"}");
+}
+
+// API: Ambilight-Daten abrufen (GET - gibt den veröffentlichten Stand zurück)
+static esp_err_t handle_ambilight(httpd_req_t* req)
+{
+    BEGIN_REQUEST(req);
+    LOG_D("[handle_ambilight] === AMBILIGHT GET REQUEST ===");
+
+    String response = getAmbilightResult();
+    return sendJson(req, response);
+}
+
+// API: Takt der Analyse (Jitter), ?reset=1 setzt die Statistik zurück
+static esp_err_t handle_timing(httpd_req_t* req)
+{
+    BEGIN_REQUEST(req);
+    AnalysisTimingStats t = getAnalysisTimingStats();
+
+    char query[32];
+    char value[4];
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK &&
+        httpd_query_key_value(query, "reset", value, sizeof(value)) == ESP_OK &&
+        atoi(value) != 0) {
+        resetAnalysisTimingStats();
+    }
+
+    char json[256];
+    snprintf(json, sizeof(json),
+             "{\"targetUs\":%d,\"frames\":%u,\"overruns\":%u,"
+             "\"periodMeanUs\":%u,\"periodStddevUs\":%u,\"periodMinUs\":%u,\"periodMaxUs\":%u,"
+             "\"busyMeanUs\":%u,\"busyMaxUs\":%u}",
+             ANALYSIS_PERIOD_MS * 1000, t.frames, t.overruns,
+             t.periodMeanUs, t.periodStddevUs, t.periodMinUs, t.periodMaxUs,
+             t.busyMeanUs, t.busyMaxUs);
+    return sendJson(req, json);
+}
+
+// Zusätzliche Werte für /api/metrics: collectMetricValues() plus im
+// Debug-Build die Allokationszähler (4 Summen, 2 je Verursacher)
+#define METRIC_MAX_COUNTERS   32
+#if ALLOC_TRACKING
+#define METRIC_MAX_VALUES     (METRIC_MAX_COUNTERS + 4 + 2 * ALLOC_MAX_SCOPES)
+#else
+#define METRIC_MAX_VALUES     METRIC_MAX_COUNTERS
+#endif
+
+// Zähler und Momentanwerte, die zusätzlich zu den Stufen ausgegeben werden
+static int collectMetricValues(MetricValue* out, int cap)
+{
+    FrameBrokerStats broker = getFrameBrokerStats();
+    AnalysisTimingStats timing = getAnalysisTimingStats();
+    EspNowStats espnow = getEspNowStats();
+    LiveSocketStats live = getLiveSocketStats();
+    StreamStats stream = getStreamStats();
+    ReduceWorkerStats reduce = getReduceWorkerStats();
+    SensorCropStats crop = getSensorCropStats();
+    CaptureModeStats capture = getCaptureModeStats();
+    CameraTuneStats tune = getCameraTuneStats();
+    std::shared_ptr<const AmbilightResult> result = getPublishedAmbilightResult();
+    const MetricValue values[] = {
+        { "free_heap_bytes",              "Freier interner Heap",                      false, (double)ESP.getFreeHeap() },
+        { "min_free_heap_bytes",          "Kleinster freier Heap seit dem Start",      false, (double)ESP.getMinFreeHeap() },
+        { "free_psram_bytes",             "Freies PSRAM",                              false, (double)ESP.getFreePsram() },
+        { "frames_captured_total",        "Vom Capture-Task aufgenommene Frames",      true,  (double)broker.framesCaptured },
+        { "camera_errors_total",          "esp_camera_fb_get() ohne Frame",            true,  (double)broker.captureErrors },
+        { "camera_busy_total",            "acquireFrame() ohne Frame (Timeout)",       true,  (double)broker.waitTimeouts },
+        { "analysis_frames",              "Analyse-Durchläufe seit /api/timing-Reset", false, (double)timing.frames },
+        { "analysis_overruns",            "Durchläufe länger als die Periode",         false, (double)timing.overruns },
+        { "espnow_frames_late_total",     "Vor dem Senden verspätete Frames",          true,  (double)espnow.framesLate },
+        { "espnow_frames_failed_total",   "Nicht vollständig gesendete Frames",        true,  (double)espnow.framesFailed },
+        { "live_frames_dropped_total",    "Vom nächsten Frame überholte Live-Pushes",  true,  (double)live.framesDropped },
+        { "stream_send_errors_total",     "Abgebrochene MJPEG-Clients",                true,  (double)stream.sendErrors },
+        { "reduction_parallel_total",     "Reduktion auf beide Kerne verteilt",        true,  (double)reduce.parallelFrames },
+        { "reduction_single_total",       "Reduktion auf einem Kern",                  true,  (double)reduce.singleFrames },
+        { "reduction_barrier_max_us",     "Längstes Warten auf Core 0",                false, (double)reduce.barrierWaitMaxUs },
+        { "decode_scale",                 "JPEG-Skalierung der Analyse (1, 2, 4, 8)",  false, result ? (double)result->decodeScale : 0.0 },
+        { "sensor_crop_active",           "Sensor-Ausschnitt gesetzt (0/1)",           false, crop.active ? 1.0 : 0.0 },
+        { "sensor_crop_dropped_total",    "Nach dem Umschalten verworfene Frames",     true,  (double)crop.framesDropped },
+        { "capture_detail",               "Detail-Auflösung angefordert (0/1)",        false, capture.detail ? 1.0 : 0.0 },
+        { "capture_switches_total",       "Wechsel zwischen den Auflösungen",          true,  (double)capture.switches },
+        { "autotune_running",             "Autotuner misst gerade (0/1)",              false,
+          tune.phase == CAMERA_TUNE_REFERENCE || tune.phase == CAMERA_TUNE_SWEEP ? 1.0 : 0.0 },
+    };
+    static_assert(sizeof(values) / sizeof(values[0]) <= METRIC_MAX_COUNTERS, "METRIC_MAX_COUNTERS erhöhen");
+    int n = 0;
+    for (const MetricValue& v : values) {
+        if (n < cap) {
+            out[n++] = v;
+        }
+    }
+    if (n < (int)(sizeof(values) / sizeof(values[0]))) {
+        LOG_W("[metrics] Nur %d von %d Werten ausgegeben", n, (int)(sizeof(values) / sizeof(values[0])));
+    }
+    return n;
+}
+
+// API: Laufzeit je Verarbeitungsschritt (p50/p95/p99/max) und Zähler.
+// JSON, mit ?format=prometheus (bzw. unter /metrics) im Prometheus-Textformat;
+// ?reset=1 leert die Histogramme.
+static esp_err_t handle_metrics(httpd_req_t* req)
+{
+    BEGIN_REQUEST(req);
+
+    bool prometheus = strcmp(req->uri, "/metrics") == 0;
+    char query[48];
+    char value[16];
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+        if (httpd_query_key_value(query, "format", value, sizeof(value)) == ESP_OK) {
+            prometheus = strcmp(value, "prometheus") == 0;
+        }
+        if (httpd_query_key_value(query, "reset", value, sizeof(value)) == ESP_OK && atoi(value) != 0) {
+            resetStageMetrics();
+#if ALLOC_TRACKING
+            resetAllocStats();
+#endif
+        }
+    }
+
+    MetricValue extras[METRIC_MAX_VALUES];
+    const int extraCap = sizeof(extras) / sizeof(extras[0]);
+    int extraCount = collectMetricValues(extras, extraCap);
+#if ALLOC_TRACKING
+    extraCount += getAllocMetricValues(extras + extraCount, extraCap - extraCount);
+#endif
+
+    // Erst Länge bestimmen, dann in einen passenden Puffer schreiben
+    size_t len = prometheus ? formatMetricsPrometheus(nullptr, 0, extras, extraCount)
+                            : formatMetricsJson(nullptr, 0, extras, extraCount);
+    char* text = (char*)malloc(len + 1);
+    if (!text) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Out of memory");
+        return ESP_OK;
+    }
+    len = prometheus ? formatMetricsPrometheus(text, len + 1, extras, extraCount)
+                     : formatMetricsJson(text, len + 1, extras, extraCount);
+
+    httpd_resp_set_type(req, prometheus ? "text/plain; version=0.0.4" : "application/json");
+    esp_err_t res = httpd_resp_send(req, text, len);
+    free(text);
+    return res;
+}
+
+#if TRACE_ENABLED
+static bool sendTraceChunk(void* ctx, const char* data, size_t len)
+{
+    return httpd_resp_send_chunk((httpd_req_t*)ctx, data, len) == ESP_OK;
+}
+#endif
+
+// API: Zeitleiste der letzten ?ms= Millisekunden (Standard 2000) als
+// Chrome-Trace-JSON, z. B. in ui.perfetto.dev öffnen
+static esp_err_t handle_trace(httpd_req_t* req)
+{
+    logRequest(req);
+#if TRACE_ENABLED
+    uint32_t windowMs = TRACE_DEFAULT_MS;
+    char query[32];
+    char value[12];
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK &&
+        httpd_query_key_value(query, "ms", value, sizeof(value)) == ESP_OK) {
+        windowMs = strtoul(value, nullptr, 10);
+    }
+
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_set_hdr(req, "Content-Disposition", "attachment; filename=\"hanawa-trace.json\"");
+    exportTraceJson(windowMs, sendTraceChunk, req);
+    return httpd_resp_send_chunk(req, nullptr, 0);
+#else
+    httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "Tracing disabled (TRACE_ENABLED=0)");
+    return ESP_OK;
+#endif
+}
+
+// API: letzte Log-Einträge als Text (?n=, Standard 50). Liest nur mit,
+// der Serial-Task bekommt weiterhin alle Einträge.
+static esp_err_t handle_log(httpd_req_t* req)
+{
+    BEGIN_REQUEST(req);
+
+    uint32_t count = 50;
+    char query[32];
+    char value[8];
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK &&
+        httpd_query_key_value(query, "n", value, sizeof(value)) == ESP_OK) {
+        count = atoi(value);
+    }
+
+    httpd_resp_set_type(req, "text/plain; charset=utf-8");
+    static const char LEVELS[] = "-EWID";
+    LogCursor cursor = logCursorLast(count);
+    LogEntry entry;
+    uint32_t lost = 0;
+    char line[200];
+    while (logReadNext(&cursor, &entry, &lost)) {
+        int n = snprintf(line, sizeof(line), "%10.3f %c ",
+                         entry.timestampUs / 1000.0, entry.level <= LOG_LEVEL_DEBUG ? LEVELS[entry.level] : '?');
+        logFormat(entry, line + n, sizeof(line) - n - 1);
+        strcat(line, "\n");
+        if (httpd_resp_send_chunk(req, line, HTTPD_RESP_USE_STRLEN) != ESP_OK) {
+            return ESP_FAIL;
+        }
+    }
+    if (lost > 0) {
+        snprintf(line, sizeof(line), "(%u Einträge beim Lesen überschrieben)\n", lost);
+        httpd_resp_send_chunk(req, line, HTTPD_RESP_USE_STRLEN);
+    }
+    return httpd_resp_send_chunk(req, nullptr, 0);
+}
+
+static bool sendRecordChunk(void* ctx, const uint8_t* data, size_t len)
+{
+    return httpd_resp_send_chunk((httpd_req_t*)ctx, (const char*)data, len) == ESP_OK;
+}
+
+// API: Farb-Log der veröffentlichten Ergebnisse (color_recorder.h).
+// ?start=1&s= startet eine Aufnahme (Standard 60 s), ?stop=1 beendet sie,
+// beide antworten mit dem Stand als JSON. Ohne Parameter kommt das Log
+// (.hcol, auch während der Aufnahme: alles bis zum letzten Frame).
+static esp_err_t handle_record(httpd_req_t* req)
+{
+    BEGIN_REQUEST(req);
+
+    char query[48];
+    char value[12];
+    bool control = false;
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+        if (httpd_query_key_value(query, "start", value, sizeof(value)) == ESP_OK && atoi(value) != 0) {
+            uint32_t seconds = COLOR_RECORD_DEFAULT_S;
+            if (httpd_query_key_value(query, "s", value, sizeof(value)) == ESP_OK) {
+                seconds = constrain(atoi(value), 1, COLOR_RECORD_MAX_S);
+            }
+            startColorRecording(seconds);
+            control = true;
+        } else if (httpd_query_key_value(query, "stop", value, sizeof(value)) == ESP_OK && atoi(value) != 0) {
+            stopColorRecording();
+            control = true;
+        }
+    }
+
+    ColorRecorderStats stats = getColorRecorderStats();
+    if (stats.capacity == 0) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "No recorder buffer");
+        return ESP_OK;
+    }
+    if (control) {
+        // Start/Stopp übernimmt der Analyse-Task mit dem nächsten Frame,
+        // der Stand hier ist also noch der vorige
+        char json[160];
+        snprintf(json, sizeof(json),
+                 "{\"accepted\":true,\"recording\":%s,\"frames\":%u,\"bytes\":%u,\"capacity\":%u}",
+                 stats.recording ? "true" : "false", stats.frames, stats.bytes, stats.capacity);
+        return sendJson(req, json);
+    }
+
+    char frames[12];
+    snprintf(frames, sizeof(frames), "%u", stats.frames);
+    httpd_resp_set_type(req, "application/octet-stream");
+    httpd_resp_set_hdr(req, "Content-Disposition", "attachment; filename=\"hanawa.hcol\"");
+    httpd_resp_set_hdr(req, "X-Recording", stats.recording ? "running" : "stopped");
+    httpd_resp_set_hdr(req, "X-Frames", frames);
+    if (!exportColorRecording(sendRecordChunk, req)) {
+        return ESP_FAIL;   // Client weg oder Aufnahme neu gestartet: Verbindung schließen
+    }
+    return httpd_resp_send_chunk(req, nullptr, 0);
+}
+
+// API: Sensor-Ausschnitt um die TV-Ecken (sensor_crop.h). ?on=1 schaltet
+// ihn ein (optional &margin=, &w=, &h=), ?on=0 aus; ohne Parameter nur der
+// Stand. Umgeschaltet wird mit dem nächsten Analyse-Frame.
+static esp_err_t handle_crop(httpd_req_t* req)
+{
+    BEGIN_REQUEST(req);
+
+    char query[64];
+    char value[12];
+    bool accepted = false;
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK &&
+        httpd_query_key_value(query, "on", value, sizeof(value)) == ESP_OK) {
+        bool enabled = atoi(value) != 0;
+        float margin = SENSOR_CROP_MARGIN_DEFAULT;
+        int width = SENSOR_CROP_WIDTH_DEFAULT;
+        int height = SENSOR_CROP_HEIGHT_DEFAULT;
+        if (httpd_query_key_value(query, "margin", value, sizeof(value)) == ESP_OK) {
+            margin = constrain(atof(value), 0.0, 0.5);
+        }
+        if (httpd_query_key_value(query, "w", value, sizeof(value)) == ESP_OK) {
+            width = atoi(value);
+        }
+        if (httpd_query_key_value(query, "h", value, sizeof(value)) == ESP_OK) {
+            height = atoi(value);
+        }
+        requestSensorCrop(enabled, margin, width, height);
+        accepted = true;
+    }
+
+    // Bei einer Anfrage ist der Stand noch der vorige
+    SensorCropStats crop = getSensorCropStats();
+    const SensorWindow& w = crop.window;
+    char json[320];
+    snprintf(json, sizeof(json),
+             "{\"accepted\":%s,\"enabled\":%s,\"active\":%s,\"mode\":\"%s\","
+             "\"offsetX\":%d,\"offsetY\":%d,\"width\":%d,\"height\":%d,"
+             "\"outputWidth\":%d,\"outputHeight\":%d,\"view\":[%.4f,%.4f,%.4f,%.4f],"
+             "\"updates\":%u,\"failures\":%u,\"framesDropped\":%u}",
+             accepted ? "true" : "false", crop.enabled ? "true" : "false", crop.active ? "true" : "false",
+             w.mode == OV2640_MODE_SVGA ? "SVGA" : "UXGA", w.offsetX, w.offsetY, w.width, w.height,
+             w.outputWidth, w.outputHeight, w.view[0], w.view[1], w.view[2], w.view[3],
+             crop.updates, crop.failures, crop.framesDropped);
+    return sendJson(req, json);
+}
+
+// API: zwei Auflösungen (capture_mode.h). ?dual=1 schaltet sie ein, ?dual=0
+// aus; ohne Parameter nur der Stand. Umgeschaltet wird mit dem nächsten
+// Analyse-Frame.
+static esp_err_t handle_capture(httpd_req_t* req)
+{
+    BEGIN_REQUEST(req);
+
+    char query[32];
+    char value[4];
+    bool accepted = false;
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK &&
+        httpd_query_key_value(query, "dual", value, sizeof(value)) == ESP_OK) {
+        setDualResolution(atoi(value) != 0);
+        accepted = true;
+    }
+
+    CaptureModeStats capture = getCaptureModeStats();
+    char json[200];
+    snprintf(json, sizeof(json),
+             "{\"accepted\":%s,\"dual\":%s,\"detail\":%s,\"width\":%u,\"height\":%u,"
+             "\"switches\":%u,\"failures\":%u,\"framesDropped\":%u}",
+             accepted ? "true" : "false", capture.enabled ? "true" : "false", capture.detail ? "true" : "false",
+             capture.width, capture.height, capture.switches, capture.failures, capture.framesDropped);
+    return sendJson(req, json);
+}
+
+// Ergebnistabelle des Autotuners als CSV
+static esp_err_t sendAutotuneTable(httpd_req_t* req)
+{
+    AutotuneResult* results = (AutotuneResult*)malloc(AUTOTUNE_MAX_SETTINGS * sizeof(AutotuneResult));
+    if (!results) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Out of memory");
+        return ESP_OK;
+    }
+    int count = copyCameraTuneResults(results, AUTOTUNE_MAX_SETTINGS);
+    size_t len = autotuneFormatCsv(nullptr, 0, results, count);
+    char* text = (char*)malloc(len + 1);
+    if (!text) {
+        free(results);
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Out of memory");
+        return ESP_OK;
+    }
+    len = autotuneFormatCsv(text, len + 1, results, count);
+    free(results);
+
+    httpd_resp_set_type(req, "text/csv");
+    httpd_resp_set_hdr(req, "Content-Disposition", "attachment; filename=\"hanawa-autotune.csv\"");
+    esp_err_t res = httpd_resp_send(req, text, len);
+    free(text);
+    return res;
+}
+
+// API: Autotuner (camera_tune.h). ?start=1 startet einen Lauf (optional
+// &xclk=, &quality=, &width=, &scale= als kommagetrennte Listen, &frames=),
+// ?stop=1 bricht ab bzw. stellt die Einstellungen von vorher wieder her,
+// ?apply=1 wendet das beste Ergebnis an (optional &latency_ms= oder &fps=
+// als Ziel). ?table=1 liefert die Ergebnisse als CSV, sonst den Stand.
+static esp_err_t handle_autotune(httpd_req_t* req)
+{
+    BEGIN_REQUEST(req);
+
+    char query[160];
+    char value[32];
+    bool accepted = false;
+    bool table = false;
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+        if (httpd_query_key_value(query, "start", value, sizeof(value)) == ESP_OK && atoi(value) != 0) {
+            AutotuneAxes axes;
+            const char* keys[4] = { "xclk", "quality", "width", "scale" };
+            const char* defaults[4] = { CAMERA_TUNE_XCLK_DEFAULT, CAMERA_TUNE_QUALITY_DEFAULT,
+                                        CAMERA_TUNE_WIDTH_DEFAULT, CAMERA_TUNE_SCALE_DEFAULT };
+            AutotuneAxis* axis[4] = { &axes.xclkMhz, &axes.jpegQuality, &axes.frameWidth, &axes.decodeScale };
+            bool valid = true;
+            for (int i = 0; i < 4; i++) {
+                bool given = httpd_query_key_value(query, keys[i], value, sizeof(value)) == ESP_OK;
+                valid = autotuneParseAxis(given ? value : defaults[i], axis[i]) && valid;
+            }
+            if (!valid) {
+                s_stats.badRequests++;
+                httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "xclk, quality, width and scale must be number lists");
+                return ESP_OK;
+            }
+            int frames = CAMERA_TUNE_FRAMES_DEFAULT;
+            if (httpd_query_key_value(query, "frames", value, sizeof(value)) == ESP_OK) {
+                frames = atoi(value);
+            }
+            accepted = startCameraTune(axes, frames);
+        } else if (httpd_query_key_value(query, "stop", value, sizeof(value)) == ESP_OK && atoi(value) != 0) {
+            stopCameraTune();
+            accepted = true;
+        } else if (httpd_query_key_value(query, "apply", value, sizeof(value)) == ESP_OK && atoi(value) != 0) {
+            AutotuneTarget target = { 0, 0 };
+            if (httpd_query_key_value(query, "latency_ms", value, sizeof(value)) == ESP_OK) {
+                target.maxLatencyUs = (uint32_t)(atof(value) * 1000);
+            }
+            if (httpd_query_key_value(query, "fps", value, sizeof(value)) == ESP_OK) {
+                target.minFps = atof(value);
+            }
+            accepted = applyCameraTune(target);
+        }
+        table = httpd_query_key_value(query, "table", value, sizeof(value)) == ESP_OK && atoi(value) != 0;
+    }
+    if (table) {
+        return sendAutotuneTable(req);
+    }
+
+    // Bei einer Anfrage ist der Stand noch der vorige
+    CameraTuneStats tune = getCameraTuneStats();
+    const AutotuneSetting& s = tune.setting;
+    char json[320];
+    snprintf(json, sizeof(json),
+             "{\"accepted\":%s,\"phase\":\"%s\",\"current\":%d,\"total\":%d,\"framesPerSetting\":%d,"
+             "\"results\":%d,\"runs\":%u,\"applied\":%d,\"setting\":{\"xclkMhz\":%d,\"jpegQuality\":%d,"
+             "\"width\":%d,\"height\":%d,\"decodeScale\":%d}}",
+             accepted ? "true" : "false", cameraTunePhaseName(tune.phase), tune.current, tune.total,
+             tune.framesPerSetting, tune.results, tune.runs, tune.applied,
+             s.xclkMhz, s.jpegQuality, s.frameWidth, s.frameHeight, s.decodeScale);
+    return sendJson(req, json);
+}
+
+static esp_err_t handle_not_found(httpd_req_t* req, httpd_err_code_t err)
+{
+    s_stats.notFound++;
+    LOG_W("[NOT_FOUND] %s (fd %d)", req->method == HTTP_GET ? "GET" : "POST", httpd_req_to_sockfd(req));
+    httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "Not found");
+    return ESP_OK;
+}
+
+// ============================================================================
+// INIT
+// ============================================================================
+
+bool initApiServer() {
+    s_snapshotConsumer = registerFrameConsumer("snapshot");
+
+    httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+    config.server_port = API_PORT;
+    config.ctrl_port = API_PORT + 32768;           // eigener Steuer-Port je httpd-Instanz
+    config.max_open_sockets = API_MAX_CLIENTS;
+    config.lru_purge_enable = true;                 // Flut verdrängt alte Verbindungen
+    config.recv_wait_timeout = API_SOCKET_TIMEOUT;
+    config.send_wait_timeout = API_SOCKET_TIMEOUT;
+    config.task_priority = API_TASK_PRIORITY;       // unter dem Analyse-Task
+    config.core_id = API_TASK_CORE;
+    config.stack_size = API_TASK_STACK;
+    config.max_uri_handlers = API_MAX_ROUTES;
+
+    if (httpd_start(&s_apiHttpd, &config) != ESP_OK) {
+        Serial.println("[api] ERROR: httpd_start fehlgeschlagen");
+        return false;
+    }
+
+    const httpd_uri_t routes[] = {
+        { "/",              HTTP_GET,  handle_root,      nullptr },
+        { "/api/snapshot",  HTTP_GET,  handle_snapshot,  nullptr },
+        { "/api/grid",      HTTP_POST, handle_grid,      nullptr },
+        { "/api/config",    HTTP_POST, handle_config,    nullptr },
+        { "/api/ambilight", HTTP_GET,  handle_ambilight, nullptr },
+        { "/api/timing",    HTTP_GET,  handle_timing,    nullptr },
+        { "/api/metrics",   HTTP_GET,  handle_metrics,   nullptr },
+        { "/metrics",       HTTP_GET,  handle_metrics,   nullptr },
+        { "/api/log",       HTTP_GET,  handle_log,       nullptr },
+        { "/api/trace",     HTTP_GET,  handle_trace,     nullptr },
+        { "/api/record",    HTTP_GET,  handle_record,    nullptr },
+        { "/api/crop",      HTTP_GET,  handle_crop,      nullptr },
+        { "/api/capture",   HTTP_GET,  handle_capture,   nullptr },
+        { "/api/autotune",  HTTP_GET,  handle_autotune,  nullptr },
+    };
+    for (const httpd_uri_t& route : routes) {
+        httpd_uri_t handler = route;
+        handler.user_ctx = (void*)route.uri;   // Route für logRequest()
+        httpd_register_uri_handler(s_apiHttpd, &handler);
+    }
+    httpd_register_err_handler(s_apiHttpd, HTTPD_404_NOT_FOUND, handle_not_found);
+
+    Serial.printf("[api] HTTP-Server bereit: http://%s/ (Core %d, Priorität %d)\n",
+                  WiFi.localIP().toString().c_str(), API_TASK_CORE, API_TASK_PRIORITY);
+    return true;
+}
+
+ApiServerStats getApiServerStats() {
+    ApiServerStats copy;
+    copy.requests = s_stats.requests;
+    copy.notFound = s_stats.notFound;
+    copy.badRequests = s_stats.badRequests;
+    copy.cameraErrors = s_stats.cameraErrors;
+    copy.notModified = s_stats.notModified;
+    return copy;
+}
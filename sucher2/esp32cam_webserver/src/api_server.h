@@ -0,0 +1,33 @@
+#ifndef API_SERVER_H
+#define API_SERVER_H
+
+#include <Arduino.h>
+
+// Weboberfläche und JSON-API auf Port 80, eigener esp_http_server mit eigenem
+// Task unterhalb des Analyse-Tasks. Die Handler lesen nur veröffentlichten
+// State (getPublishedAmbilightResult()) und hinterlegen neue Konfigurationen,
+// sie greifen nie in die laufende Berechnung ein.
+#define API_PORT            80
+#define API_MAX_CLIENTS     4
+#define API_MAX_BODY        2048   // Bytes, größere POST-Bodies werden abgelehnt
+#define API_SOCKET_TIMEOUT  2      // s, danach wird ein hängender Client getrennt
+#define API_TASK_CORE       1      // gleicher Core wie die Analyse, aber darunter
+#define API_TASK_PRIORITY   1
+#define API_TASK_STACK      8192   // ArduinoJson-Dokumente liegen teilweise auf dem Stack
+#define API_MAX_ROUTES      16
+
+struct ApiServerStats {
+    uint32_t requests;       // bearbeitete Requests
+    uint32_t notFound;       // 404
+    uint32_t badRequests;    // 400 (fehlender/zu großer Body, JSON-Fehler)
+    uint32_t cameraErrors;   // /api/snapshot ohne Frame
+    uint32_t notModified;    // /api/snapshot mit 304 (If-None-Match passte)
+};
+
+// Startet den Server (http://<ip>/) und meldet den Snapshot-Verbraucher beim
+// Frame-Broker an. Nach dem WLAN-Connect aufrufen.
+bool initApiServer();
+
+ApiServerStats getApiServerStats();
+
+#endif // API_SERVER_H
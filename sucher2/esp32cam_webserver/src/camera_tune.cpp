@@ -0,0 +1,386 @@
+#include "camera_tune.h"
+#include "esp_camera.h"
+#include "sensor_crop.h"
+#include "deferred_log.h"
+
+// ============================================================================
+// SENSOR
+// ============================================================================
+
+// Größte Bildgröße: die aus init_camera(), danach sind die Frame-Puffer bemessen
+#define CAMERA_TUNE_MAX_FRAMESIZE  FRAMESIZE_VGA
+#define CAMERA_TUNE_LEDC_TIMER     LEDC_TIMER_0   // wie config.ledc_timer in init_camera()
+
+struct SensorSettings {
+    int xclkMhz;
+    int quality;
+    framesize_t framesize;
+};
+
+// Standard-Bildgröße mit genau dieser Ausgabe, FRAMESIZE_INVALID wenn keine
+static framesize_t frameSizeFor(int width, int height) {
+    for (int i = 0; i < FRAMESIZE_INVALID; i++) {
+        if (resolution[i].width == width && resolution[i].height == height) {
+            return (framesize_t)i;
+        }
+    }
+    return FRAMESIZE_INVALID;
+}
+
+static bool readSensor(SensorSettings* out) {
+    sensor_t* s = esp_camera_sensor_get();
+    if (!s) {
+        return false;
+    }
+    out->xclkMhz = s->xclk_freq_hz / 1000000;
+    out->quality = s->status.quality;
+    out->framesize = s->status.framesize;
+    return true;
+}
+
+static bool writeSensor(const SensorSettings& settings) {
+    sensor_t* s = esp_camera_sensor_get();
+    if (!s) {
+        return false;
+    }
+    // set_xclk() konfiguriert den LEDC-Timer neu, nur bei echter Änderung
+    if (settings.xclkMhz != s->xclk_freq_hz / 1000000 &&
+        s->set_xclk(s, CAMERA_TUNE_LEDC_TIMER, settings.xclkMhz) != 0) {
+        return false;
+    }
+    return s->set_quality(s, settings.quality) == 0 && s->set_framesize(s, settings.framesize) == 0;
+}
+
+static bool toSensorSettings(const AutotuneSetting& setting, SensorSettings* out) {
+    framesize_t size = frameSizeFor(setting.frameWidth, setting.frameHeight);
+    if (size == FRAMESIZE_INVALID ||
+        setting.frameWidth > resolution[CAMERA_TUNE_MAX_FRAMESIZE].width ||
+        setting.frameHeight > resolution[CAMERA_TUNE_MAX_FRAMESIZE].height ||
+        setting.xclkMhz <= 0 || setting.jpegQuality < 0 || setting.jpegQuality > 63) {
+        return false;
+    }
+    out->xclkMhz = setting.xclkMhz;
+    out->quality = setting.jpegQuality;
+    out->framesize = size;
+    return true;
+}
+
+// ============================================================================
+// STATE
+// ============================================================================
+
+enum CameraTuneRequest {
+    REQUEST_NONE,
+    REQUEST_START,
+    REQUEST_STOP,
+    REQUEST_APPLY,
+};
+
+// Anfragen aus anderen Tasks, übernimmt updateCameraTune()
+static portMUX_TYPE s_mux = portMUX_INITIALIZER_UNLOCKED;
+static CameraTuneRequest s_request = REQUEST_NONE;
+static AutotuneAxes s_requestAxes;
+static int s_requestFrames = CAMERA_TUNE_FRAMES_DEFAULT;
+static AutotuneTarget s_requestTarget;
+
+// Unter s_mux: Stand und Ergebnisse für andere Tasks. Ein Ergebnis wird
+// nur geschrieben, bevor s_stats.results es mitzählt.
+static CameraTuneStats s_stats = { CAMERA_TUNE_IDLE, 0, 0, CAMERA_TUNE_FRAMES_DEFAULT, 0, -1, {}, 0 };
+static AutotuneResult s_results[AUTOTUNE_MAX_SETTINGS];
+
+// Nur im Analyse-Task
+static CameraTunePhase s_phase = CAMERA_TUNE_IDLE;
+static AutotuneSetting s_settings[AUTOTUNE_MAX_SETTINGS];
+static int s_total = 0;
+static int s_current = 0;
+static int s_framesPerSetting = CAMERA_TUNE_FRAMES_DEFAULT;
+static uint32_t s_configVersion = 0;
+static SensorSettings s_saved;          // Einstellungen von vor dem Lauf
+static bool s_sensorChanged = false;    // s_saved muss zurückgeschrieben werden
+static int s_scale = 0;
+static int s_settleFrames = 0;
+static AutotuneReference s_reference;
+static RGB s_referenceColors[AMBI_MAX_RECTANGLES];
+static int s_referenceCount = 0;
+static AutotuneMeasurement s_measurement;
+
+static void setPhase(CameraTunePhase phase) {
+    s_phase = phase;
+    taskENTER_CRITICAL(&s_mux);
+    s_stats.phase = phase;
+    s_stats.current = s_current;
+    taskEXIT_CRITICAL(&s_mux);
+}
+
+// ============================================================================
+// ABLAUF (Analyse-Task)
+// ============================================================================
+
+static bool running() {
+    return s_phase == CAMERA_TUNE_REFERENCE || s_phase == CAMERA_TUNE_SWEEP;
+}
+
+// Sensor verstellen, beim ersten Mal die Einstellungen von vorher merken
+static bool changeSensor(const SensorSettings& settings) {
+    if (!s_sensorChanged) {
+        if (!readSensor(&s_saved)) {
+            return false;
+        }
+        s_sensorChanged = true;
+    }
+    s_settleFrames = CAMERA_TUNE_SETTLE_FRAMES;
+    return writeSensor(settings);
+}
+
+static void restoreSensor() {
+    if (!s_sensorChanged) {
+        return;
+    }
+    if (!writeSensor(s_saved)) {
+        LOG_W("[autotune] Einstellungen von vorher nicht wiederhergestellt (%d MHz, Q%d)",
+              s_saved.xclkMhz, s_saved.quality);
+    }
+    s_sensorChanged = false;
+    s_settleFrames = CAMERA_TUNE_SETTLE_FRAMES;
+    s_scale = 0;
+}
+
+static void abortRun(const char* reason) {
+    LOG_W("[autotune] Abbruch bei %d/%d: %s", s_current + 1, s_total, reason);
+    restoreSensor();
+    setPhase(CAMERA_TUNE_ABORTED);
+}
+
+static void storeResult(const AutotuneResult& result) {
+    taskENTER_CRITICAL(&s_mux);
+    s_results[s_current] = result;
+    s_stats.results = s_current + 1;
+    taskEXIT_CRITICAL(&s_mux);
+}
+
+// Nächste messbare Kombination ab index einstellen; abgelehnte bleiben ohne Frames
+static void startSetting(int index) {
+    for (s_current = index; s_current < s_total; s_current++) {
+        const AutotuneSetting& setting = s_settings[s_current];
+        s_measurement.begin(setting);
+        SensorSettings sensor;
+        if (toSensorSettings(setting, &sensor) && changeSensor(sensor)) {
+            s_scale = setting.decodeScale;
+            setPhase(CAMERA_TUNE_SWEEP);
+            return;
+        }
+        LOG_W("[autotune] %d MHz, Q%d, %dx%d abgelehnt",
+              setting.xclkMhz, setting.jpegQuality, setting.frameWidth, setting.frameHeight);
+        storeResult(s_measurement.finish());
+    }
+
+    restoreSensor();
+    setPhase(CAMERA_TUNE_DONE);
+    AutotuneTarget none = { 0, 0 };
+    int best = autotuneSelect(s_results, s_total, none);
+    if (best >= 0) {
+        const AutotuneSetting& b = s_results[best].setting;
+        LOG_I("[autotune] Fertig, bestes Bild: %d MHz, Q%d, %dx%d, %dx",
+              b.xclkMhz, b.jpegQuality, b.frameWidth, b.frameHeight, b.decodeScale);
+    }
+}
+
+static void startRun(const AutotuneAxes& axes, int framesPerSetting, uint32_t configVersion) {
+    restoreSensor();   // angewendetes Ergebnis gilt nicht als Ausgangslage
+    s_total = autotuneSettings(axes, s_settings, AUTOTUNE_MAX_SETTINGS);
+    s_framesPerSetting = framesPerSetting;
+    s_current = 0;
+    s_configVersion = configVersion;
+    s_reference.reset();
+    s_referenceCount = 0;
+    taskENTER_CRITICAL(&s_mux);
+    s_stats.total = s_total;
+    s_stats.framesPerSetting = framesPerSetting;
+    s_stats.results = 0;
+    s_stats.applied = -1;
+    s_stats.runs++;
+    taskEXIT_CRITICAL(&s_mux);
+
+    // Referenz: größtes Bild, hohe Qualität, ungeteilt dekodiert
+    SensorSettings reference;
+    bool ok = readSensor(&reference);
+    reference.quality = CAMERA_TUNE_REFERENCE_QUALITY;
+    reference.framesize = CAMERA_TUNE_MAX_FRAMESIZE;
+    setPhase(CAMERA_TUNE_REFERENCE);
+    if (!ok || s_total == 0 || !changeSensor(reference)) {
+        abortRun("Referenz nicht einstellbar");
+        return;
+    }
+    s_scale = 1;
+    LOG_I("[autotune] Start: %d Kombinationen, je %d Frames", s_total, framesPerSetting);
+}
+
+static void applyResult(const AutotuneTarget& target) {
+    int count = s_phase == CAMERA_TUNE_DONE || s_phase == CAMERA_TUNE_APPLIED ? s_total : 0;
+    int best = autotuneSelect(s_results, count, target);
+    SensorSettings sensor;
+    if (best < 0 || !toSensorSettings(s_results[best].setting, &sensor) || !changeSensor(sensor)) {
+        LOG_W("[autotune] Kein anwendbares Ergebnis");
+        return;
+    }
+    const AutotuneSetting& setting = s_results[best].setting;
+    s_scale = setting.decodeScale;
+    taskENTER_CRITICAL(&s_mux);
+    s_stats.applied = best;
+    s_stats.setting = setting;
+    taskEXIT_CRITICAL(&s_mux);
+    setPhase(CAMERA_TUNE_APPLIED);
+    LOG_I("[autotune] Angewendet: %d MHz, Q%d, %dx%d, %dx",
+          setting.xclkMhz, setting.jpegQuality, setting.frameWidth, setting.frameHeight, setting.decodeScale);
+}
+
+bool updateCameraTune(uint32_t configVersion) {
+    taskENTER_CRITICAL(&s_mux);
+    CameraTuneRequest request = s_request;
+    AutotuneAxes axes = s_requestAxes;
+    int frames = s_requestFrames;
+    AutotuneTarget target = s_requestTarget;
+    s_request = REQUEST_NONE;
+    taskEXIT_CRITICAL(&s_mux);
+
+    switch (request) {
+    case REQUEST_START:
+        startRun(axes, frames, configVersion);
+        break;
+    case REQUEST_STOP:
+        if (running()) {
+            abortRun("gestoppt");
+        } else if (s_phase == CAMERA_TUNE_APPLIED) {
+            restoreSensor();
+            taskENTER_CRITICAL(&s_mux);
+            s_stats.applied = -1;
+            taskEXIT_CRITICAL(&s_mux);
+            setPhase(CAMERA_TUNE_DONE);
+            LOG_I("[autotune] Einstellungen von vorher wiederhergestellt");
+        }
+        break;
+    case REQUEST_APPLY:
+        applyResult(target);
+        break;
+    case REQUEST_NONE:
+        break;
+    }
+
+    // Neue Kalibrierung = andere Fenster, die Referenz passt nicht mehr
+    if (running() && configVersion != s_configVersion) {
+        abortRun("neue Kalibrierung");
+    }
+    return s_sensorChanged;
+}
+
+int cameraTuneDecodeScale() {
+    return s_scale;
+}
+
+bool cameraTuneSettling() {
+    if (s_settleFrames == 0) {
+        return false;
+    }
+    s_settleFrames--;
+    return true;
+}
+
+void cameraTuneOnFrame(const RGB* colors, int count, uint32_t busyUs, uint32_t latencyUs, uint32_t jpegBytes) {
+    if (s_phase == CAMERA_TUNE_REFERENCE) {
+        if (!s_reference.add(colors, count)) {
+            abortRun("Fensterzahl");
+            return;
+        }
+        if (s_reference.frames() == CAMERA_TUNE_REFERENCE_FRAMES) {
+            s_referenceCount = s_reference.finish(s_referenceColors);
+            startSetting(0);
+        }
+    } else if (s_phase == CAMERA_TUNE_SWEEP) {
+        if (count != s_referenceCount) {
+            abortRun("Fensterzahl");
+            return;
+        }
+        s_measurement.addFrame(busyUs, latencyUs, jpegBytes, colors, s_referenceColors, count);
+        if (s_measurement.frames() == s_framesPerSetting) {
+            AutotuneResult result = s_measurement.finish();
+            LOG_I("[autotune] %d/%d: %.1f Bilder/s, p95 %u us, Fehler %.2f",
+                  s_current + 1, s_total, result.fps, result.latencyP95Us, result.colorError);
+            storeResult(result);
+            startSetting(s_current + 1);
+        }
+    }
+}
+
+// ============================================================================
+// ANFRAGEN (jeder Task)
+// ============================================================================
+
+bool startCameraTune(const AutotuneAxes& axes, int framesPerSetting) {
+    int total = axes.xclkMhz.count * axes.jpegQuality.count * axes.frameWidth.count * axes.decodeScale.count;
+    if (total == 0 || total > AUTOTUNE_MAX_SETTINGS || getSensorCropStats().active) {
+        return false;
+    }
+    bool accepted = false;
+    taskENTER_CRITICAL(&s_mux);
+    bool busy = s_stats.phase == CAMERA_TUNE_REFERENCE || s_stats.phase == CAMERA_TUNE_SWEEP;
+    if (!busy && s_request != REQUEST_START) {
+        s_request = REQUEST_START;
+        s_requestAxes = axes;
+        s_requestFrames = constrain(framesPerSetting, 1, AUTOTUNE_MAX_FRAMES);
+        accepted = true;
+    }
+    taskEXIT_CRITICAL(&s_mux);
+    return accepted;
+}
+
+void stopCameraTune() {
+    taskENTER_CRITICAL(&s_mux);
+    s_request = REQUEST_STOP;
+    taskEXIT_CRITICAL(&s_mux);
+}
+
+bool applyCameraTune(const AutotuneTarget& target) {
+    bool accepted = false;
+    taskENTER_CRITICAL(&s_mux);
+    if ((s_stats.phase == CAMERA_TUNE_DONE || s_stats.phase == CAMERA_TUNE_APPLIED) && s_stats.results > 0) {
+        s_request = REQUEST_APPLY;
+        s_requestTarget = target;
+        accepted = true;
+    }
+    taskEXIT_CRITICAL(&s_mux);
+    return accepted;
+}
+
+CameraTuneStats getCameraTuneStats() {
+    taskENTER_CRITICAL(&s_mux);
+    CameraTuneStats copy = s_stats;
+    taskEXIT_CRITICAL(&s_mux);
+    return copy;
+}
+
+int copyCameraTuneResults(AutotuneResult* out, int cap) {
+    int n = 0;
+    for (;;) {
+        taskENTER_CRITICAL(&s_mux);
+        bool more = n < cap && n < s_stats.results;
+        if (more) {
+            out[n] = s_results[n];
+        }
+        taskEXIT_CRITICAL(&s_mux);
+        if (!more) {
+            return n;
+        }
+        n++;
+    }
+}
+
+const char* cameraTunePhaseName(CameraTunePhase phase) {
+    switch (phase) {
+    case CAMERA_TUNE_REFERENCE: return "reference";
+    case CAMERA_TUNE_SWEEP:     return "sweep";
+    case CAMERA_TUNE_DONE:      return "done";
+    case CAMERA_TUNE_ABORTED:   return "aborted";
+    case CAMERA_TUNE_APPLIED:   return "applied";
+    default:                    return "idle";
+    }
+}
@@ -0,0 +1,82 @@
+#ifndef CAMERA_TUNE_H
+#define CAMERA_TUNE_H
+
+#include <Arduino.h>
+#include "autotune.h"
+
+// Autotuner auf dem Gerät: der Analyse-Task nimmt zuerst ein Referenzbild
+// in VGA mit hoher JPEG-Qualität und 1x-Dekodierung auf (Mittel über
+// mehrere Frames), schaltet dann nacheinander alle Kombinationen aus XCLK,
+// JPEG-Qualität, Bildgröße und Dekodier-Skalierung und misst je Kombination
+// Frames/s, Latenz Capture → Ergebnis, JPEG-Größe und Farbfehler gegen die
+// Referenz (Auswertung in lib/hanawa_core/src/autotune.h). Danach gelten
+// wieder die Einstellungen von vorher; die beste Kombination für ein Ziel
+// (Latenz oder Frames/s) lässt sich anwenden. Steuerung per /api/autotune.
+//
+// Das Bild muss während des Laufs stillstehen (Standbild am Fernseher),
+// sonst misst der Farbfehler den Inhalt. fb_count lässt sich nur mit
+// esp_camera_init() ändern und wird nicht durchgemessen.
+#define CAMERA_TUNE_XCLK_DEFAULT       "10,20"
+#define CAMERA_TUNE_QUALITY_DEFAULT    "10,12,15,20"
+#define CAMERA_TUNE_WIDTH_DEFAULT      "320,640"   // höchstens die Größe aus init_camera() (Frame-Puffer)
+#define CAMERA_TUNE_SCALE_DEFAULT      "1,2,4"
+#define CAMERA_TUNE_FRAMES_DEFAULT     20          // gemessene Frames je Kombination
+#define CAMERA_TUNE_REFERENCE_FRAMES   10          // gemittelt für das Referenzbild
+#define CAMERA_TUNE_REFERENCE_QUALITY  6
+#define CAMERA_TUNE_SETTLE_FRAMES      3           // nach dem Umschalten verwerfen (fb_count + Belichtung)
+
+enum CameraTunePhase {
+    CAMERA_TUNE_IDLE,
+    CAMERA_TUNE_REFERENCE,   // Referenzbild
+    CAMERA_TUNE_SWEEP,       // Kombinationen messen
+    CAMERA_TUNE_DONE,        // Ergebnisse liegen vor
+    CAMERA_TUNE_ABORTED,     // abgebrochen (Stopp, neue Kalibrierung, Sensorfehler)
+    CAMERA_TUNE_APPLIED,     // Ergebnis angewendet
+};
+
+struct CameraTuneStats {
+    CameraTunePhase phase;
+    int current;             // Kombination in Messung
+    int total;               // Kombinationen des Laufs
+    int framesPerSetting;
+    int results;             // fertige Ergebnisse
+    int applied;             // angewendete Kombination, -1 = keine
+    AutotuneSetting setting; // angewendete Einstellung
+    uint32_t runs;           // gestartete Läufe
+};
+
+// Aus jedem Task; wirkt mit dem nächsten Analyse-Frame. false = läuft
+// schon, Sensor-Ausschnitt aktiv oder zu viele Kombinationen.
+bool startCameraTune(const AutotuneAxes& axes, int framesPerSetting);
+
+// Aus jedem Task: Lauf abbrechen bzw. angewendete Einstellung verwerfen,
+// beides mit Rückkehr zu den Einstellungen von vor dem Lauf
+void stopCameraTune();
+
+// Aus jedem Task: beste Kombination für target anwenden (autotuneSelect()).
+// false = keine Ergebnisse oder Lauf noch nicht fertig.
+bool applyCameraTune(const AutotuneTarget& target);
+
+// Analyse-Task, vor jedem Frame. Abbruch, wenn sich configVersion während
+// des Laufs ändert. true = Autotuner bestimmt Sensor und Skalierung,
+// Ausschnitt und zwei Auflösungen bleiben untätig.
+bool updateCameraTune(uint32_t configVersion);
+
+// Analyse-Task: vorgegebene Dekodier-Skalierung, 0 = wie geplant
+int cameraTuneDecodeScale();
+
+// Analyse-Task: true = Frame stammt womöglich noch von der vorigen Einstellung
+bool cameraTuneSettling();
+
+// Analyse-Task, nach der Reduktion: Farben aller Fenster, busyUs = Durchlauf
+// inkl. Warten auf den Frame, latencyUs = Capture → Ergebnis
+void cameraTuneOnFrame(const RGB* colors, int count, uint32_t busyUs, uint32_t latencyUs, uint32_t jpegBytes);
+
+CameraTuneStats getCameraTuneStats();
+
+// Kopiert die fertigen Ergebnisse nach out, höchstens cap. Liefert die Anzahl.
+int copyCameraTuneResults(AutotuneResult* out, int cap);
+
+const char* cameraTunePhaseName(CameraTunePhase phase);
+
+#endif // CAMERA_TUNE_H
@@ -0,0 +1,114 @@
+#include "capture_mode.h"
+#include "config.h"
+#include "stream_server.h"
+#include "deferred_log.h"
+
+// ============================================================================
+// STATE
+// ============================================================================
+
+// Anfragen aus anderen Tasks
+static volatile bool s_enabled = DUAL_RESOLUTION;
+static volatile uint32_t s_lastDemandMs = 0;     // 0 = noch nie
+
+// Nur im Analyse-Task
+static bool s_switched = false;     // Sensor wurde von hier aus umgeschaltet
+static framesize_t s_failed = FRAMESIZE_INVALID;   // abgelehnt, nicht jeden Frame neu versuchen
+static framesize_t s_wanted = FRAMESIZE_INVALID;   // zuletzt gewünschte Größe
+static int s_settleFrames = 0;
+
+static portMUX_TYPE s_statsMux = portMUX_INITIALIZER_UNLOCKED;
+static CaptureModeStats s_stats = { DUAL_RESOLUTION, false, 0, 0, 0, 0, 0 };
+
+// ============================================================================
+// UMSCHALTEN
+// ============================================================================
+
+void setDualResolution(bool enabled) {
+    s_enabled = enabled;
+    taskENTER_CRITICAL(&s_statsMux);
+    s_stats.enabled = enabled;
+    taskEXIT_CRITICAL(&s_statsMux);
+}
+
+void requestDetailCapture() {
+    uint32_t now = millis();
+    s_lastDemandMs = now ? now : 1;
+}
+
+int detailCaptureWidth() {
+    return resolution[CAPTURE_DETAIL_FRAMESIZE].width;
+}
+
+void updateCaptureMode(bool sensorOwned) {
+    if (sensorOwned) {
+        s_switched = false;   // Ausschnitt setzt beim Ausschalten selbst auf das volle Bild zurück
+        return;
+    }
+    if (!s_enabled && !s_switched) {
+        return;
+    }
+    if (getStreamStats().clients > 0) {
+        requestDetailCapture();
+    }
+    uint32_t demand = s_lastDemandMs;
+    bool detail = !s_enabled || (demand != 0 && millis() - demand < CAPTURE_DETAIL_HOLD_MS);
+    framesize_t wanted = detail ? CAPTURE_DETAIL_FRAMESIZE : CAPTURE_ANALYSIS_FRAMESIZE;
+    taskENTER_CRITICAL(&s_statsMux);
+    s_stats.detail = detail;
+    taskEXIT_CRITICAL(&s_statsMux);
+
+    // Abgelehnt gilt nur bis zum nächsten Wechsel des Bedarfs, sonst bliebe
+    // eine einmal abgelehnte Detail-Größe bis zum Neustart gesperrt
+    if (wanted != s_wanted) {
+        s_wanted = wanted;
+        s_failed = FRAMESIZE_INVALID;
+    }
+
+    // Gelesen wird der Sensor selbst, der Ausschnitt kann ihn inzwischen zurückgesetzt haben
+    sensor_t* s = esp_camera_sensor_get();
+    if (!s || s->status.framesize == wanted || wanted == s_failed) {
+        if (!s_enabled) {
+            s_switched = false;
+        }
+        return;
+    }
+    bool ok = s->set_framesize(s, wanted) == 0;
+    s_failed = ok ? FRAMESIZE_INVALID : wanted;
+    if (ok) {
+        s_switched = s_enabled;
+        s_settleFrames = CAPTURE_SETTLE_FRAMES;
+        LOG_I("[capture] %s-Auflösung %dx%d", detail ? "Detail" : "Analyse",
+              resolution[wanted].width, resolution[wanted].height);
+    } else {
+        LOG_W("[capture] Bildgröße %dx%d abgelehnt", resolution[wanted].width, resolution[wanted].height);
+    }
+
+    taskENTER_CRITICAL(&s_statsMux);
+    if (ok) {
+        s_stats.width = resolution[wanted].width;
+        s_stats.height = resolution[wanted].height;
+        s_stats.switches++;
+    } else {
+        s_stats.failures++;
+    }
+    taskEXIT_CRITICAL(&s_statsMux);
+}
+
+bool captureModeSettling() {
+    if (s_settleFrames == 0) {
+        return false;
+    }
+    s_settleFrames--;
+    taskENTER_CRITICAL(&s_statsMux);
+    s_stats.framesDropped++;
+    taskEXIT_CRITICAL(&s_statsMux);
+    return true;
+}
+
+CaptureModeStats getCaptureModeStats() {
+    taskENTER_CRITICAL(&s_statsMux);
+    CaptureModeStats copy = s_stats;
+    taskEXIT_CRITICAL(&s_statsMux);
+    return copy;
+}
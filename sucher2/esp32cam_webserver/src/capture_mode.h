@@ -0,0 +1,49 @@
+#ifndef CAPTURE_MODE_H
+#define CAPTURE_MODE_H
+
+#include <Arduino.h>
+#include "esp_camera.h"
+
+// Zwei Auflösungen: ohne Zuschauer läuft der Sensor klein, die Analyse
+// bekommt mehr und billigere Frames. Solange ein Stream-Client verbunden
+// ist (Kalibrierung in der Weboberfläche) oder /api/snapshot abgerufen
+// wird, schaltet der Analyse-Task auf die Detail-Auflösung. Die Fenster
+// folgen von selbst, weil die Kalibrierung normiert ist (buildSamplingPlan()
+// je Bildgröße). Ein- und Ausschalten per /api/capture, Startwert
+// DUAL_RESOLUTION in config.h. Bei aktivem Sensor-Ausschnitt (sensor_crop.h)
+// bestimmt dieser die Bildgröße, dann bleibt der Modus untätig.
+#define CAPTURE_ANALYSIS_FRAMESIZE  FRAMESIZE_QVGA   // 320x240, dekodiert mit 1x statt VGA mit 2x
+#define CAPTURE_DETAIL_FRAMESIZE    FRAMESIZE_VGA    // höchstens die Größe aus init_camera() (Frame-Puffer)
+#define CAPTURE_DETAIL_HOLD_MS      5000             // nach dem letzten Bedarf noch so lange groß bleiben
+#define CAPTURE_SETTLE_FRAMES       2                // Frames nach dem Umschalten verwerfen (fb_count)
+
+struct CaptureModeStats {
+    bool enabled;            // zwei Auflösungen eingeschaltet
+    bool detail;             // gerade Detail-Auflösung angefordert
+    uint16_t width;          // zuletzt gesetzte Bildgröße (0 = noch nie umgeschaltet)
+    uint16_t height;
+    uint32_t switches;       // Umschaltungen
+    uint32_t failures;       // vom Sensor abgelehnt
+    uint32_t framesDropped;  // nach dem Umschalten verworfen
+};
+
+// Aus jedem Task; wirkt mit dem nächsten Analyse-Frame
+void setDualResolution(bool enabled);
+
+// Aus jedem Task: Details werden gebraucht (Snapshot), hält
+// CAPTURE_DETAIL_HOLD_MS. Stream-Clients zählen von selbst.
+void requestDetailCapture();
+
+// Breite der Detail-Auflösung, auf die /api/snapshot wartet
+int detailCaptureWidth();
+
+// Analyse-Task, vor jedem Frame. sensorOwned = Sensor-Ausschnitt aktiv,
+// dann wird nichts umgeschaltet.
+void updateCaptureMode(bool sensorOwned);
+
+// Analyse-Task: true = Frame stammt womöglich noch von der vorigen Größe
+bool captureModeSettling();
+
+CaptureModeStats getCaptureModeStats();
+
+#endif // CAPTURE_MODE_H
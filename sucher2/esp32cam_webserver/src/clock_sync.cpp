@@ -0,0 +1,178 @@
+#include "clock_sync.h"
+#include <string.h>
+
+// ============================================================================
+// HILFSFUNKTIONEN
+// ============================================================================
+
+static void putU32(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static uint32_t getU32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// ============================================================================
+// SENDER
+// ============================================================================
+
+ClockSyncSender::ClockSyncSender()
+    : m_peerCount(0), m_pingSeq(0), m_pingUs(0), m_pingSent(false), m_pongsRejected(0) {
+    memset(m_peers, 0, sizeof(m_peers));
+}
+
+size_t ClockSyncSender::buildPing(uint32_t nowUs, uint8_t* buf, size_t cap) {
+    // Nur Empfänger mit gültiger Schätzung werden mitgeschickt
+    int valid = 0;
+    for (int i = 0; i < m_peerCount; i++) {
+        if (m_peers[i].valid) valid++;
+    }
+    size_t len = CLOCK_SYNC_PING_HEADER + valid * CLOCK_SYNC_PING_ENTRY;
+    if (cap < len) {
+        return 0;
+    }
+
+    m_pingSeq++;
+    m_pingUs = nowUs;
+    m_pingSent = true;
+
+    buf[0] = AMBI_SYNC_PING;
+    buf[1] = m_pingSeq;
+    putU32(buf + 2, nowUs);
+    buf[6] = (uint8_t)valid;
+
+    uint8_t* entry = buf + CLOCK_SYNC_PING_HEADER;
+    for (int i = 0; i < m_peerCount; i++) {
+        if (!m_peers[i].valid) continue;
+        entry[0] = m_peers[i].id;
+        putU32(entry + 1, (uint32_t)m_peers[i].offsetUs);
+        entry += CLOCK_SYNC_PING_ENTRY;
+    }
+    return len;
+}
+
+bool ClockSyncSender::onPong(const uint8_t* data, size_t len, uint32_t nowUs) {
+    if (len < CLOCK_SYNC_PONG_SIZE || data[0] != AMBI_SYNC_PONG) {
+        m_pongsRejected++;
+        return false;
+    }
+
+    // Nur Antworten auf den letzten Ping: ältere haben einen veralteten t1
+    // und wären wegen ihrer langen Laufzeit ohnehin schlechte Samples
+    uint32_t t1 = getU32(data + 3);
+    if (!m_pingSent || data[2] != m_pingSeq || t1 != m_pingUs) {
+        m_pongsRejected++;
+        return false;
+    }
+    uint32_t t2 = getU32(data + 7);
+    uint32_t t3 = getU32(data + 11);
+    uint32_t t4 = nowUs;
+
+    ClockSyncPeer* peer = peerFor(data[1]);
+    if (!peer) {
+        m_pongsRejected++;
+        return false;
+    }
+
+    // Differenzen als int32_t: korrekt über den Überlauf der µs-Zähler hinweg
+    int32_t roundTrip = (int32_t)(t4 - t1);
+    int32_t processing = (int32_t)(t3 - t2);
+    int32_t delay = roundTrip - processing;
+    if (delay < 0) delay = 0;
+    int32_t offset = (int32_t)(((int64_t)(int32_t)(t2 - t1) + (int32_t)(t3 - t4)) / 2);
+
+    peer->sampleOffset[peer->sampleNext] = offset;
+    peer->sampleDelay[peer->sampleNext] = (uint32_t)delay;
+    peer->sampleTimeUs[peer->sampleNext] = t4;
+    peer->sampleNext = (peer->sampleNext + 1) % CLOCK_SYNC_SAMPLES;
+    if (peer->sampleCount < CLOCK_SYNC_SAMPLES) {
+        peer->sampleCount++;
+    }
+
+    // Minimum-Delay-Filter wie bei NTP: ein Sample ist höchstens delay / 2
+    // falsch (asymmetrische Wege), dazu kommt die seitdem aufgelaufene Drift.
+    // Gewählt wird das Sample mit der kleinsten Fehlerschranke.
+    int best = -1;
+    uint32_t bestError = 0;
+    for (int i = 0; i < peer->sampleCount; i++) {
+        uint32_t ageUs = t4 - peer->sampleTimeUs[i];
+        uint32_t error = peer->sampleDelay[i] / 2 + (uint32_t)((uint64_t)ageUs * CLOCK_SYNC_MAX_DRIFT_PPM / 1000000);
+        if (best < 0 || error < bestError) {
+            best = i;
+            bestError = error;
+        }
+    }
+    peer->offsetUs = peer->sampleOffset[best];
+    peer->delayUs = peer->sampleDelay[best];
+    peer->lastPongUs = t4;
+    peer->pongs++;
+    peer->valid = true;
+    return true;
+}
+
+const ClockSyncPeer* ClockSyncSender::findPeer(uint8_t id) const {
+    for (int i = 0; i < m_peerCount; i++) {
+        if (m_peers[i].id == id) {
+            return &m_peers[i];
+        }
+    }
+    return nullptr;
+}
+
+ClockSyncPeer* ClockSyncSender::peerFor(uint8_t id) {
+    for (int i = 0; i < m_peerCount; i++) {
+        if (m_peers[i].id == id) {
+            return &m_peers[i];
+        }
+    }
+    if (m_peerCount >= CLOCK_SYNC_MAX_RECEIVERS) {
+        return nullptr;
+    }
+    ClockSyncPeer* peer = &m_peers[m_peerCount++];
+    memset(peer, 0, sizeof(*peer));
+    peer->id = id;
+    return peer;
+}
+
+// ============================================================================
+// EMPFÄNGER
+// ============================================================================
+
+ClockSyncReceiver::ClockSyncReceiver(uint8_t id)
+    : m_id(id), m_synced(false), m_offsetUs(0) {
+}
+
+size_t ClockSyncReceiver::onPing(const uint8_t* data, size_t len, uint32_t rxUs, uint32_t txUs,
+                                 uint8_t* pong, size_t cap) {
+    if (len < CLOCK_SYNC_PING_HEADER || data[0] != AMBI_SYNC_PING) {
+        return 0;
+    }
+    int count = data[6];
+    if (len < (size_t)(CLOCK_SYNC_PING_HEADER + count * CLOCK_SYNC_PING_ENTRY)) {
+        return 0;
+    }
+
+    // Eigene Schätzung aus der Tabelle übernehmen
+    const uint8_t* entry = data + CLOCK_SYNC_PING_HEADER;
+    for (int i = 0; i < count; i++, entry += CLOCK_SYNC_PING_ENTRY) {
+        if (entry[0] == m_id) {
+            m_offsetUs = (int32_t)getU32(entry + 1);
+            m_synced = true;
+        }
+    }
+
+    if (cap < CLOCK_SYNC_PONG_SIZE) {
+        return 0;
+    }
+    pong[0] = AMBI_SYNC_PONG;
+    pong[1] = m_id;
+    pong[2] = data[1];               // seq
+    memcpy(pong + 3, data + 2, 4);   // t1 unverändert zurück
+    putU32(pong + 7, rxUs);          // t2
+    putU32(pong + 11, txUs);         // t3
+    return CLOCK_SYNC_PONG_SIZE;
+}
@@ -0,0 +1,111 @@
+#ifndef CLOCK_SYNC_H
+#define CLOCK_SYNC_H
+
+// Uhrensynchronisation Sucher ↔ Leuchter (siehe doc/AMBILIGHT_PROTOCOL.md).
+// NTP-artiger Ping/Pong über denselben Kanal wie die Farbdaten:
+//
+//   Sender  t1 ──Ping──▶ t2  Empfänger
+//           t4 ◀──Pong── t3
+//
+//   offset = ((t2 - t1) + (t3 - t4)) / 2   (Empfänger-Uhr − Sender-Uhr)
+//   delay  = (t4 - t1) - (t3 - t2)          (Round-Trip ohne Verarbeitungszeit)
+//
+// Der Sender führt pro Empfänger eine Schätzung und verteilt sie mit dem
+// nächsten Ping zurück. Damit kann jeder Leuchter den gemeinsamen
+// Anzeigezeitpunkt eines Frames (captureUs + deadlineMs, Sender-Uhr) in seine
+// eigene Uhr umrechnen – auch wenn der Frame per Broadcast kommt.
+// Plattformunabhängig, Zeiten in µs (uint32_t, Überlauf wird berücksichtigt).
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Paket-Typen (Byte 0). Bit 7 + Bit 6 gesetzt: kollidiert weder mit v1
+// (packet_num < 0x80) noch mit v2 (0x80 | Index, Index < 4).
+#define AMBI_SYNC_PING          0xC0
+#define AMBI_SYNC_PONG          0xC1
+
+#define CLOCK_SYNC_MAX_RECEIVERS 8
+#define CLOCK_SYNC_SAMPLES       8     // Fenster für den Minimum-Delay-Filter
+#define CLOCK_SYNC_MAX_DRIFT_PPM 50    // angenommene max. Gangabweichung Sender ↔ Empfänger
+#define CLOCK_SYNC_PING_HEADER   7     // type, seq, t1 (u32), count
+#define CLOCK_SYNC_PING_ENTRY    5     // receiver_id, offset_us (i32)
+#define CLOCK_SYNC_PING_MAX      (CLOCK_SYNC_PING_HEADER + CLOCK_SYNC_MAX_RECEIVERS * CLOCK_SYNC_PING_ENTRY)
+#define CLOCK_SYNC_PONG_SIZE     15    // type, receiver_id, seq, t1 (u32), t2 (u32), t3 (u32)
+
+// true = Ping oder Pong (nicht an den AmbilightReceiver geben)
+inline bool ambilightIsSyncPacket(const uint8_t* data, size_t len) {
+    return len > 0 && (data[0] & 0xC0) == 0xC0;
+}
+
+// Zustand eines Empfängers auf der Sender-Seite
+struct ClockSyncPeer {
+    uint8_t id;
+    bool valid;               // mindestens ein gültiges Sample
+    int32_t offsetUs;         // Empfänger-Uhr − Sender-Uhr (bestes Sample im Fenster)
+    uint32_t delayUs;         // Round-Trip des besten Samples
+    uint32_t lastPongUs;      // Sender-Uhr beim letzten Pong
+    uint32_t pongs;
+
+    // Ringpuffer der letzten Samples
+    int32_t sampleOffset[CLOCK_SYNC_SAMPLES];
+    uint32_t sampleDelay[CLOCK_SYNC_SAMPLES];
+    uint32_t sampleTimeUs[CLOCK_SYNC_SAMPLES];  // t4 des Samples
+    int sampleCount;
+    int sampleNext;
+};
+
+// Sender-Seite (Sucher): baut Pings, wertet Pongs aus
+class ClockSyncSender {
+public:
+    ClockSyncSender();
+
+    // Baut einen Ping mit den aktuellen Offsets aller bekannten Empfänger.
+    // nowUs = Sender-Uhr direkt vor dem Senden. Liefert die Länge, 0 = Puffer zu klein.
+    size_t buildPing(uint32_t nowUs, uint8_t* buf, size_t cap);
+
+    // Wertet einen Pong aus. nowUs = Sender-Uhr beim Empfang (möglichst früh
+    // stempeln). false = kein Pong, unbekannter Ping oder Tabelle voll.
+    bool onPong(const uint8_t* data, size_t len, uint32_t nowUs);
+
+    int peerCount() const { return m_peerCount; }
+    const ClockSyncPeer& peer(int index) const { return m_peers[index]; }
+    const ClockSyncPeer* findPeer(uint8_t id) const;
+
+    uint32_t pongsRejected() const { return m_pongsRejected; }
+
+private:
+    ClockSyncPeer* peerFor(uint8_t id);
+
+    ClockSyncPeer m_peers[CLOCK_SYNC_MAX_RECEIVERS];
+    int m_peerCount;
+    uint8_t m_pingSeq;
+    uint32_t m_pingUs;         // t1 des letzten Pings
+    bool m_pingSent;
+    uint32_t m_pongsRejected;
+};
+
+// Empfänger-Seite (Leuchter): beantwortet Pings, übernimmt den eigenen Offset
+class ClockSyncReceiver {
+public:
+    explicit ClockSyncReceiver(uint8_t id);
+
+    // Verarbeitet einen Ping und baut den Pong. rxUs = eigene Uhr beim Empfang
+    // (t2), txUs = eigene Uhr direkt vor dem Senden des Pongs (t3).
+    // Liefert die Pong-Länge, 0 = kein Ping oder Puffer zu klein.
+    size_t onPing(const uint8_t* data, size_t len, uint32_t rxUs, uint32_t txUs,
+                  uint8_t* pong, size_t cap);
+
+    uint8_t id() const { return m_id; }
+    bool synced() const { return m_synced; }
+    int32_t offsetUs() const { return m_offsetUs; }  // eigene Uhr − Sender-Uhr
+
+    // Rechnet einen Zeitpunkt der Sender-Uhr in die eigene Uhr um
+    uint32_t toLocal(uint32_t senderUs) const { return senderUs + (uint32_t)m_offsetUs; }
+
+private:
+    uint8_t m_id;
+    bool m_synced;
+    int32_t m_offsetUs;
+};
+
+#endif // CLOCK_SYNC_H
@@ -0,0 +1,167 @@
+#include "color_recorder.h"
+#include <WiFi.h>
+#include <atomic>
+#include "esp_timer.h"
+#include "windows.h"
+#include "color_recording.h"
+#include "deferred_log.h"
+
+#define COLOR_RECORD_EXPORT_CHUNK 4096
+
+// ============================================================================
+// STATE
+// ============================================================================
+
+// Puffer im PSRAM, gehört dem Analyse-Task (Listener). Andere Tasks lesen nur
+// den Bereich bis s_length; was darunter liegt, ändert sich bis zum nächsten
+// Start nicht mehr. s_generation zählt die Starts, damit ein Export merkt,
+// dass ihm der Puffer unter den Füßen neu beschrieben wurde.
+static uint8_t* s_buffer = nullptr;
+static size_t s_capacity = 0;
+static std::atomic<uint32_t> s_length(0);
+static std::atomic<uint32_t> s_generation(0);
+
+// Anfragen aus anderen Tasks, übernimmt der Listener
+static portMUX_TYPE s_requestMux = portMUX_INITIALIZER_UNLOCKED;
+static bool s_startRequested = false;
+static bool s_stopRequested = false;
+static uint32_t s_requestedSeconds = 0;
+
+// Nur im Analyse-Task
+static bool s_recording = false;
+static int64_t s_endUs = 0;
+
+static volatile ColorRecorderStats s_stats = {false, 0, 0, 0, 0};
+
+// ============================================================================
+// AUFNAHME
+// ============================================================================
+
+static void applyPendingRequest(int64_t now) {
+    taskENTER_CRITICAL(&s_requestMux);
+    bool start = s_startRequested;
+    bool stop = s_stopRequested;
+    uint32_t seconds = s_requestedSeconds;
+    s_startRequested = false;
+    s_stopRequested = false;
+    taskEXIT_CRITICAL(&s_requestMux);
+
+    if (start) {
+        s_generation.fetch_add(1, std::memory_order_acq_rel);
+        size_t header = colorRecordingWriteFileHeader(s_buffer);
+        s_length.store(header, std::memory_order_release);
+        s_recording = true;
+        s_endUs = now + (int64_t)seconds * 1000000LL;
+        s_stats.frames = 0;
+        s_stats.bytes = header;
+        s_stats.framesDropped = 0;
+        s_stats.recording = true;
+        LOG_I("[record] Aufnahme gestartet (%u s)", seconds);
+    } else if (stop && s_recording) {
+        s_recording = false;
+        s_stats.recording = false;
+        LOG_I("[record] Aufnahme gestoppt: %u Frames, %u B", s_stats.frames, s_stats.bytes);
+    }
+}
+
+static void onAmbilightResult(const AmbilightResult& result) {
+    int64_t now = esp_timer_get_time();
+    applyPendingRequest(now);
+    if (!s_recording) {
+        return;
+    }
+    if (now >= s_endUs) {
+        s_recording = false;
+        s_stats.recording = false;
+        LOG_I("[record] Aufnahme beendet: %u Frames, %u B", s_stats.frames, s_stats.bytes);
+        return;
+    }
+
+    AmbilightSides sides = {
+        result.topColors.data(),    (int)result.topColors.size(),
+        result.rightColors.data(),  (int)result.rightColors.size(),
+        result.bottomColors.data(), (int)result.bottomColors.size(),
+        result.leftColors.data(),   (int)result.leftColors.size()
+    };
+    uint32_t length = s_length.load(std::memory_order_relaxed);
+    size_t n = colorRecordingWriteFrame(s_buffer + length, s_capacity - length,
+                                        result.sequence, result.captureUs, result.configVersion,
+                                        g_ambilightConfig.hSeg, g_ambilightConfig.vSeg, sides);
+    if (n == 0) {
+        // Puffer voll: Aufnahme beenden statt alte Frames zu überschreiben,
+        // das Log bleibt so ein zusammenhängender Ausschnitt
+        s_stats.framesDropped++;
+        s_recording = false;
+        s_stats.recording = false;
+        LOG_W("[record] Puffer voll nach %u Frames, Aufnahme beendet", s_stats.frames);
+        return;
+    }
+    s_length.store(length + n, std::memory_order_release);
+    s_stats.frames++;
+    s_stats.bytes = length + n;
+}
+
+// ============================================================================
+// API
+// ============================================================================
+
+bool initColorRecorder() {
+    s_capacity = COLOR_RECORD_BUFFER_KB * 1024;
+    s_buffer = (uint8_t*)heap_caps_malloc(s_capacity, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!s_buffer) {
+        s_capacity = 0;
+        Serial.println("[record] ERROR: Kein PSRAM für den Farb-Recorder");
+        return false;
+    }
+    s_stats.capacity = s_capacity;
+
+    if (!addAmbilightResultListener(onAmbilightResult)) {
+        Serial.println("[record] ERROR: Kein freier Listener-Slot");
+        return false;
+    }
+
+    Serial.printf("[record] Farb-Recorder bereit: %u KB PSRAM, http://%s/api/record?start=1\n",
+                  COLOR_RECORD_BUFFER_KB, WiFi.localIP().toString().c_str());
+    return true;
+}
+
+void startColorRecording(uint32_t seconds) {
+    taskENTER_CRITICAL(&s_requestMux);
+    s_startRequested = true;
+    s_stopRequested = false;
+    s_requestedSeconds = seconds;
+    taskEXIT_CRITICAL(&s_requestMux);
+}
+
+void stopColorRecording() {
+    taskENTER_CRITICAL(&s_requestMux);
+    s_stopRequested = true;
+    s_startRequested = false;
+    taskEXIT_CRITICAL(&s_requestMux);
+}
+
+bool exportColorRecording(ColorRecordWriter writer, void* ctx) {
+    if (!s_buffer) {
+        return false;
+    }
+    uint32_t generation = s_generation.load(std::memory_order_acquire);
+    uint32_t length = s_length.load(std::memory_order_acquire);
+    for (uint32_t pos = 0; pos < length; pos += COLOR_RECORD_EXPORT_CHUNK) {
+        uint32_t n = min((uint32_t)COLOR_RECORD_EXPORT_CHUNK, length - pos);
+        if (!writer(ctx, s_buffer + pos, n) ||
+            s_generation.load(std::memory_order_acquire) != generation) {
+            return false;
+        }
+    }
+    return true;
+}
+
+ColorRecorderStats getColorRecorderStats() {
+    ColorRecorderStats copy;
+    copy.recording = s_stats.recording;
+    copy.frames = s_stats.frames;
+    copy.bytes = s_stats.bytes;
+    copy.capacity = s_stats.capacity;
+    copy.framesDropped = s_stats.framesDropped;
+    return copy;
+}
@@ -0,0 +1,39 @@
+#ifndef COLOR_RECORDER_H
+#define COLOR_RECORDER_H
+
+#include <Arduino.h>
+
+// Farb-Recorder: schreibt jedes veröffentlichte Ergebnis als Farb-Log
+// (color_recording.h im Analyse-Kern) in einen festen PSRAM-Puffer. Abholen
+// per /api/record, abspielen auf dem Rechner mit colorplay. Der Listener
+// kopiert nur in den vorab angelegten Puffer, die Frame-Schleife bleibt
+// ohne Allokation.
+#define COLOR_RECORD_BUFFER_KB  256   // ≈ 2700 Frames bei 10x8 Fenstern (≈ 4,5 min bei 10 fps)
+#define COLOR_RECORD_DEFAULT_S  60    // /api/record?start=1 ohne ?s=
+#define COLOR_RECORD_MAX_S      3600
+
+struct ColorRecorderStats {
+    bool recording;          // Aufnahme läuft
+    uint32_t frames;         // Frames der aktuellen/letzten Aufnahme
+    uint32_t bytes;          // Länge des Logs inkl. Dateiheader
+    uint32_t capacity;       // Puffergröße in Bytes (0 = kein Puffer)
+    uint32_t framesDropped;  // Puffer voll, Aufnahme wurde beendet
+};
+
+// Legt den Puffer an und registriert den Listener. Aufgenommen wird erst
+// nach startColorRecording().
+bool initColorRecorder();
+
+// Aus jedem Task; wirkt mit dem nächsten veröffentlichten Ergebnis. Ein
+// Start verwirft die vorige Aufnahme.
+void startColorRecording(uint32_t seconds);
+void stopColorRecording();
+
+// Gibt das Log stückweise an writer (nur lesend, Aufnahme darf weiterlaufen).
+// false = writer hat abgebrochen oder die Aufnahme wurde währenddessen neu gestartet.
+typedef bool (*ColorRecordWriter)(void* ctx, const uint8_t* data, size_t len);
+bool exportColorRecording(ColorRecordWriter writer, void* ctx);
+
+ColorRecorderStats getColorRecorderStats();
+
+#endif // COLOR_RECORDER_H
@@ -5,4 +5,37 @@
 #define WIFI_SSID      "Zippen 24"
 #define WIFI_PASSWORD  "Boyzoneanker24"
 
+// MAC-Adresse des Leuchters für ESP-NOW (FF:FF:FF:FF:FF:FF = Broadcast)
+#define ESPNOW_PEER_MAC {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF}
+
+// Mehrpaket-Frames mit XOR-Paritätspaket senden (Protokoll v2, Leuchter muss v2 können)
+#define ESPNOW_FEC_PARITY 0
+
+// Jeden Frame mit Sequenznummer, Capture-Zeitstempel und Deadline senden (Protokoll v2)
+#define ESPNOW_TIMING 0
+
+// Spätester Anzeigezeitpunkt nach dem Capture in ms (ältere Frames werden
+// verworfen, nur mit ESPNOW_TIMING)
+#define ESPNOW_DEADLINE_MS 150
+
+// Uhrensynchronisation mit den Leuchtern (Ping/Pong), damit mehrere Leuchter
+// zum gemeinsamen Anzeigezeitpunkt captureUs + ESPNOW_DEADLINE_MS umschalten
+// (benötigt ESPNOW_TIMING)
+#define ESPNOW_CLOCK_SYNC 0
+
+// Fan-out: jeden Frame zusätzlich einmal per UDP-Multicast senden. Jeder
+// Leuchter in der Gruppe nimmt sich seinen Ausschnitt des Farb-Arrays.
+#define UDP_FANOUT 0
+#define UDP_FANOUT_GROUP "239.0.0.81"
+#define UDP_FANOUT_PORT 8888
+
+// Sensor-Ausschnitt: der OV2640 liefert nur das Rechteck um die kalibrierten
+// TV-Ecken (Startwert, umschaltbar per /api/crop). Erst einschalten, wenn
+// die Kalibrierung steht, Stream und Weboberfläche zeigen dann den Ausschnitt.
+#define SENSOR_CROP 0
+
+// Zwei Auflösungen: Analyse in QVGA, VGA nur solange Stream oder Snapshots
+// abgerufen werden (Startwert, umschaltbar per /api/capture)
+#define DUAL_RESOLUTION 0
+
 #endif // CONFIG_H
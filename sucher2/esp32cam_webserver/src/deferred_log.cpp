@@ -0,0 +1,252 @@
+#include "deferred_log.h"
+#include <stdio.h>
+#include <atomic>
+#include "stage_metrics.h"
+
+#ifdef ESP_PLATFORM
+#include <Arduino.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#endif
+
+// ============================================================================
+// STATE
+// ============================================================================
+
+// Jeder Platz trägt eine Sequenznummer: Index + 1 = gültig, 0 = wird gerade
+// geschrieben. Schreiber reservieren mit fetch_add, Leser prüfen die Nummer
+// vor und nach dem Kopieren (Seqlock) und erkennen so überholte Einträge.
+struct LogSlot {
+    std::atomic<uint32_t> seq;
+    LogEntry entry;
+};
+
+static LogSlot s_ring[LOG_RING_SIZE];
+static std::atomic<uint32_t> s_head(0);
+static std::atomic<uint32_t> s_lost(0);
+
+static_assert((LOG_RING_SIZE & (LOG_RING_SIZE - 1)) == 0, "LOG_RING_SIZE muss eine Zweierpotenz sein");
+
+// ============================================================================
+// SCHREIBEN
+// ============================================================================
+
+void logWrite(uint8_t level, const char* format, int argc, const uint64_t* args) {
+    uint32_t index = s_head.fetch_add(1, std::memory_order_relaxed);
+    LogSlot& slot = s_ring[index & (LOG_RING_SIZE - 1)];
+
+    slot.seq.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot.entry.timestampUs = (uint32_t)metricsNowUs();
+    slot.entry.format = format;
+    slot.entry.level = level;
+    slot.entry.argc = (uint8_t)argc;
+    for (int i = 0; i < argc; i++) {
+        slot.entry.args[i] = args[i];
+    }
+
+    slot.seq.store(index + 1, std::memory_order_release);
+}
+
+// ============================================================================
+// LESEN
+// ============================================================================
+
+LogCursor logCursorLast(uint32_t count) {
+    uint32_t head = s_head.load(std::memory_order_acquire);
+    if (count > LOG_RING_SIZE) {
+        count = LOG_RING_SIZE;
+    }
+    LogCursor cursor;
+    cursor.next = head >= count ? head - count : 0;
+    return cursor;
+}
+
+bool logReadNext(LogCursor* cursor, LogEntry* entry, uint32_t* lost) {
+    for (;;) {
+        uint32_t head = s_head.load(std::memory_order_acquire);
+        if (cursor->next == head) {
+            return false;
+        }
+        if (head - cursor->next > LOG_RING_SIZE) {
+            // Schreiber hat den Leser überholt
+            if (lost) {
+                *lost += head - cursor->next - LOG_RING_SIZE;
+            }
+            cursor->next = head - LOG_RING_SIZE;
+        }
+
+        LogSlot& slot = s_ring[cursor->next & (LOG_RING_SIZE - 1)];
+        uint32_t before = slot.seq.load(std::memory_order_acquire);
+        if (before != cursor->next + 1) {
+            if (before == 0 || before < cursor->next + 1) {
+                return false;   // reserviert, aber noch nicht fertig geschrieben
+            }
+            // Inzwischen von einer neueren Runde überschrieben
+            if (lost) {
+                (*lost)++;
+            }
+            cursor->next++;
+            continue;
+        }
+
+        *entry = slot.entry;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint32_t after = slot.seq.load(std::memory_order_relaxed);
+        cursor->next++;
+        if (after != before) {
+            if (lost) {
+                (*lost)++;
+            }
+            continue;   // während des Kopierens überschrieben
+        }
+        return true;
+    }
+}
+
+// ============================================================================
+// FORMATIEREN
+// ============================================================================
+
+// Formatiert eine einzelne Konvertierung mit dem gespeicherten Argument
+static int formatArg(char* out, size_t cap, const char* spec, size_t specLen, uint64_t value) {
+    // Längen-Modifikatoren entfernen, Ganzzahlen immer als long long ausgeben
+    char clean[24];
+    size_t n = 0;
+    bool isLongLong = false;
+    int longs = 0;
+    for (size_t i = 0; i + 1 < specLen && n < sizeof(clean) - 4; i++) {
+        char c = spec[i];
+        if (c == 'l') {
+            longs++;
+            continue;
+        }
+        if (c == 'h' || c == 'z' || c == 'j' || c == 't' || c == 'L') {
+            if (c == 'z' || c == 'j' || c == 't') {
+                longs = 2;
+            }
+            continue;
+        }
+        clean[n++] = c;
+    }
+    isLongLong = longs >= 2 || (longs == 1 && sizeof(long) == 8);
+    char conv = spec[specLen - 1];
+
+    switch (conv) {
+    case 'd': case 'i': {
+        long long v = isLongLong ? (long long)(int64_t)value : (long long)(int32_t)(uint32_t)value;
+        clean[n++] = 'l'; clean[n++] = 'l'; clean[n++] = conv; clean[n] = '\0';
+        return snprintf(out, cap, clean, v);
+    }
+    case 'u': case 'x': case 'X': case 'o': {
+        unsigned long long v = isLongLong ? (unsigned long long)value : (unsigned long long)(uint32_t)value;
+        clean[n++] = 'l'; clean[n++] = 'l'; clean[n++] = conv; clean[n] = '\0';
+        return snprintf(out, cap, clean, v);
+    }
+    case 'c':
+        clean[n++] = conv; clean[n] = '\0';
+        return snprintf(out, cap, clean, (int)(uint8_t)value);
+    case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': {
+        double v;
+        memcpy(&v, &value, sizeof(v));
+        clean[n++] = conv; clean[n] = '\0';
+        return snprintf(out, cap, clean, v);
+    }
+    case 's': {
+        const char* s = (const char*)(uintptr_t)value;
+        clean[n++] = conv; clean[n] = '\0';
+        return snprintf(out, cap, clean, s ? s : "(null)");
+    }
+    case 'p':
+        clean[n++] = conv; clean[n] = '\0';
+        return snprintf(out, cap, clean, (void*)(uintptr_t)value);
+    default:
+        return snprintf(out, cap, "%.*s", (int)specLen, spec);
+    }
+}
+
+int logFormat(const LogEntry& entry, char* buf, size_t cap) {
+    size_t len = 0;
+    int arg = 0;
+    const char* p = entry.format ? entry.format : "";
+    auto room = [&]() -> size_t { return len < cap ? cap - len : 0; };
+    auto put = [&](int n) { if (n > 0) len += n; };
+
+    while (*p) {
+        if (*p != '%') {
+            const char* end = strchr(p, '%');
+            size_t chunk = end ? (size_t)(end - p) : strlen(p);
+            put(snprintf(room() ? buf + len : nullptr, room(), "%.*s", (int)chunk, p));
+            p += chunk;
+            continue;
+        }
+        if (p[1] == '%') {
+            put(snprintf(room() ? buf + len : nullptr, room(), "%%"));
+            p += 2;
+            continue;
+        }
+        // Konvertierung bis zum Typ-Zeichen einlesen
+        const char* start = p++;
+        while (*p && strchr("-+ #0123456789.hlLzjt", *p)) {
+            p++;
+        }
+        if (!*p) {
+            break;
+        }
+        p++;
+        size_t specLen = p - start;
+        if (arg < entry.argc) {
+            put(formatArg(room() ? buf + len : nullptr, room(), start, specLen, entry.args[arg++]));
+        } else {
+            put(snprintf(room() ? buf + len : nullptr, room(), "%.*s", (int)specLen, start));
+        }
+    }
+    if (cap > 0 && len == 0) {
+        buf[0] = '\0';
+    }
+    return (int)len;
+}
+
+LogStats getLogStats() {
+    LogStats stats;
+    stats.written = s_head.load(std::memory_order_relaxed);
+    stats.lost = s_lost.load(std::memory_order_relaxed);
+    return stats;
+}
+
+// ============================================================================
+// SERIAL-TASK (nur ESP32)
+// ============================================================================
+
+#ifdef ESP_PLATFORM
+
+static void logTask(void* arg) {
+    LogCursor cursor = logCursorLast(0);
+    char line[256];
+    for (;;) {
+        vTaskDelay(pdMS_TO_TICKS(LOG_DRAIN_INTERVAL_MS));
+
+        LogEntry entry;
+        uint32_t lost = 0;
+        while (logReadNext(&cursor, &entry, &lost)) {
+            logFormat(entry, line, sizeof(line));
+            Serial.println(line);
+        }
+        if (lost > 0) {
+            s_lost.fetch_add(lost, std::memory_order_relaxed);
+            Serial.printf("[log] %u Einträge verloren (LOG_RING_SIZE erhöhen)\n", lost);
+        }
+    }
+}
+
+bool initDeferredLog() {
+    if (xTaskCreatePinnedToCore(logTask, "log", 4096, nullptr, LOG_TASK_PRIORITY,
+                                nullptr, LOG_TASK_CORE) != pdPASS) {
+        Serial.println("[log] ERROR: Task konnte nicht gestartet werden");
+        return false;
+    }
+    return true;
+}
+
+#endif
@@ -0,0 +1,114 @@
+#ifndef DEFERRED_LOG_H
+#define DEFERRED_LOG_H
+
+// Verzögertes Logging für heiße Pfade: ein Log-Aufruf legt nur Format-Zeiger
+// und Argumente (binär) in einen lock-freien Ringpuffer, formatiert wird
+// später – auf dem ESP32 von einem Task niedriger Priorität für die serielle
+// Konsole und für /api/log. Einträge unter LOG_COMPILE_LEVEL werden schon
+// vom Compiler entfernt.
+//
+// Einschränkungen: höchstens LOG_MAX_ARGS Argumente; %s nur mit Strings, die
+// bis zum Formatieren leben (Literale, statische Namen) – keine String::c_str().
+// Plattformunabhängig (Host-Tests), Serial-Task nur auf dem ESP32.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define LOG_LEVEL_NONE    0
+#define LOG_LEVEL_ERROR   1
+#define LOG_LEVEL_WARN    2
+#define LOG_LEVEL_INFO    3
+#define LOG_LEVEL_DEBUG   4
+
+// Per build_flags überschreibbar, z. B. -DLOG_COMPILE_LEVEL=4
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL LOG_LEVEL_INFO
+#endif
+
+#define LOG_RING_SIZE           128    // Einträge, Zweierpotenz
+#define LOG_MAX_ARGS            6
+#define LOG_DRAIN_INTERVAL_MS   50     // Serial-Task: so oft den Puffer leeren
+#define LOG_TASK_CORE           0
+#define LOG_TASK_PRIORITY       1      // unter allem, was Frames verarbeitet
+
+struct LogEntry {
+    uint32_t timestampUs;              // untere 32 Bit von metricsNowUs()
+    const char* format;                // Format-String = Format-ID
+    uint8_t level;
+    uint8_t argc;
+    uint64_t args[LOG_MAX_ARGS];       // Ganzzahlen, double-Bits oder Zeiger
+};
+
+struct LogStats {
+    uint32_t written;   // insgesamt geschriebene Einträge
+    uint32_t lost;      // vom Serial-Task nicht mehr gelesen (Puffer überholt)
+};
+
+// Lesezeiger; mehrere Leser sind unabhängig voneinander
+struct LogCursor {
+    uint32_t next;
+};
+
+// --- Schreiben -------------------------------------------------------------
+
+void logWrite(uint8_t level, const char* format, int argc, const uint64_t* args);
+
+inline uint64_t logArg(bool v)               { return v ? 1 : 0; }
+inline uint64_t logArg(char v)               { return (uint64_t)(int64_t)v; }
+inline uint64_t logArg(signed char v)        { return (uint64_t)(int64_t)v; }
+inline uint64_t logArg(unsigned char v)      { return v; }
+inline uint64_t logArg(short v)              { return (uint64_t)(int64_t)v; }
+inline uint64_t logArg(unsigned short v)     { return v; }
+inline uint64_t logArg(int v)                { return (uint64_t)(int64_t)v; }
+inline uint64_t logArg(unsigned int v)       { return v; }
+inline uint64_t logArg(long v)               { return (uint64_t)(int64_t)v; }
+inline uint64_t logArg(unsigned long v)      { return v; }
+inline uint64_t logArg(long long v)          { return (uint64_t)v; }
+inline uint64_t logArg(unsigned long long v) { return v; }
+inline uint64_t logArg(double v)             { uint64_t bits; memcpy(&bits, &v, sizeof(bits)); return bits; }
+inline uint64_t logArg(float v)              { return logArg((double)v); }
+inline uint64_t logArg(const char* v)        { return (uint64_t)(uintptr_t)v; }
+inline uint64_t logArg(const void* v)        { return (uint64_t)(uintptr_t)v; }
+
+inline void logDeferred(uint8_t level, const char* format) {
+    logWrite(level, format, 0, nullptr);
+}
+
+template <typename... Args>
+inline void logDeferred(uint8_t level, const char* format, Args... values) {
+    static_assert(sizeof...(Args) <= LOG_MAX_ARGS, "zu viele Log-Argumente");
+    const uint64_t args[] = { logArg(values)... };
+    logWrite(level, format, sizeof...(Args), args);
+}
+
+#define LOG_AT(level, ...) do { \
+    if ((level) <= LOG_COMPILE_LEVEL) { \
+        logDeferred((level), __VA_ARGS__); \
+    } \
+} while (0)
+
+#define LOG_E(...)  LOG_AT(LOG_LEVEL_ERROR, __VA_ARGS__)
+#define LOG_W(...)  LOG_AT(LOG_LEVEL_WARN, __VA_ARGS__)
+#define LOG_I(...)  LOG_AT(LOG_LEVEL_INFO, __VA_ARGS__)
+#define LOG_D(...)  LOG_AT(LOG_LEVEL_DEBUG, __VA_ARGS__)
+
+// --- Lesen -----------------------------------------------------------------
+
+// Cursor auf die letzten count Einträge (count >= LOG_RING_SIZE = alles Vorhandene)
+LogCursor logCursorLast(uint32_t count);
+
+// Nächster Eintrag; false = (noch) keiner. lost zählt überholte Einträge hoch.
+bool logReadNext(LogCursor* cursor, LogEntry* entry, uint32_t* lost);
+
+// Formatiert einen Eintrag wie printf (ohne Zeitstempel), Rückgabe wie snprintf
+int logFormat(const LogEntry& entry, char* buf, size_t cap);
+
+LogStats getLogStats();
+
+#ifdef ESP_PLATFORM
+// Startet den Task, der den Puffer auf die serielle Konsole ausgibt
+bool initDeferredLog();
+#endif
+
+#endif // DEFERRED_LOG_H
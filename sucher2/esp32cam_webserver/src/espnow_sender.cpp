@@ -0,0 +1,267 @@
+#include "espnow_sender.h"
+#include <WiFi.h>
+#include <esp_now.h>
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/queue.h"
+#include "config.h"
+#include "stage_metrics.h"
+#include "windows.h"
+#include "ambilight_protocol.h"
+#include "clock_sync.h"
+
+// ============================================================================
+// STATE
+// ============================================================================
+
+static const uint8_t s_peerMac[6] = ESPNOW_PEER_MAC;
+
+// Fester Paketpuffer für alle Frames (kein Heap im Sendepfad)
+static AmbilightFrameEncoder s_encoder;
+
+// Wird vom Send-Callback freigegeben, sobald ein Paket raus ist
+static SemaphoreHandle_t s_sendDone = nullptr;
+
+// Zähler: txSuccess/txFailure schreibt der WiFi-Task, den Rest der Analyse-Task
+static volatile EspNowStats s_stats = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+
+// Uhrensynchronisation: Pongs werden im WiFi-Task gestempelt und per Queue
+// an den Analyse-Kontext übergeben, dort liegt der gesamte Sync-Zustand
+struct PongEvent {
+    uint32_t rxUs;
+    uint8_t data[CLOCK_SYNC_PONG_SIZE];
+};
+static ClockSyncSender s_clockSync;
+static QueueHandle_t s_pongQueue = nullptr;
+static int64_t s_lastPingUs = 0;
+
+// Kopie der Empfängertabelle für andere Tasks (loop()), nach jedem Pong
+// im Analyse-Task aktualisiert
+static portMUX_TYPE s_peerMux = portMUX_INITIALIZER_UNLOCKED;
+static ClockSyncPeer s_peerCopy[CLOCK_SYNC_MAX_RECEIVERS];
+static int s_peerCopyCount = 0;
+
+// ============================================================================
+// ESP-NOW TRANSPORT
+// ============================================================================
+
+static void onEspNowSent(const uint8_t *mac_addr, esp_now_send_status_t status) {
+    if (status == ESP_NOW_SEND_SUCCESS) {
+        s_stats.txSuccess++;
+    } else {
+        s_stats.txFailure++;
+    }
+    xSemaphoreGive(s_sendDone);
+}
+
+static void onEspNowReceived(const uint8_t *mac_addr, const uint8_t *data, int len) {
+    // t4 so früh wie möglich nehmen
+    uint32_t rxUs = (uint32_t)esp_timer_get_time();
+    if (!s_pongQueue || len != CLOCK_SYNC_PONG_SIZE || data[0] != AMBI_SYNC_PONG) {
+        return;
+    }
+    PongEvent ev;
+    ev.rxUs = rxUs;
+    memcpy(ev.data, data, CLOCK_SYNC_PONG_SIZE);
+    xQueueSend(s_pongQueue, &ev, 0);  // Queue voll → Sample verwerfen
+}
+
+class EspNowTransport : public AmbilightTransport {
+public:
+    EspNowTransport() : m_lastSendUs(0) {}
+
+    bool sendPacket(const uint8_t* data, size_t len) override {
+        esp_err_t err = esp_now_send(s_peerMac, data, len);
+        m_lastSendUs = esp_timer_get_time();
+        if (err != ESP_OK) {
+            s_stats.queueErrors++;
+            return false;
+        }
+        s_stats.packetsQueued++;
+        return true;
+    }
+
+    void waitBetweenPackets() override {
+        // Erst auf den Callback des vorherigen Fragments warten ...
+        if (xSemaphoreTake(s_sendDone, pdMS_TO_TICKS(ESPNOW_SEND_TIMEOUT_MS)) != pdTRUE) {
+            s_stats.paceTimeouts++;
+        }
+        // ... dann den Mindestabstand einhalten
+        int64_t elapsed = esp_timer_get_time() - m_lastSendUs;
+        if (elapsed < ESPNOW_PACKET_GAP_US) {
+            delayMicroseconds(ESPNOW_PACKET_GAP_US - elapsed);
+        }
+    }
+
+private:
+    int64_t m_lastSendUs;
+};
+
+static EspNowTransport s_transport;
+
+// ============================================================================
+// UHRENSYNCHRONISATION
+// ============================================================================
+
+static void serviceClockSync() {
+    PongEvent ev;
+    bool updated = false;
+    while (xQueueReceive(s_pongQueue, &ev, 0) == pdTRUE) {
+        if (s_clockSync.onPong(ev.data, CLOCK_SYNC_PONG_SIZE, ev.rxUs)) {
+            s_stats.syncPongs++;
+            updated = true;
+        }
+    }
+    if (updated) {
+        portENTER_CRITICAL(&s_peerMux);
+        s_peerCopyCount = s_clockSync.peerCount();
+        for (int i = 0; i < s_peerCopyCount; i++) {
+            s_peerCopy[i] = s_clockSync.peer(i);
+        }
+        portEXIT_CRITICAL(&s_peerMux);
+    }
+
+    int64_t now = esp_timer_get_time();
+    if (now - s_lastPingUs < (int64_t)ESPNOW_SYNC_INTERVAL_MS * 1000) {
+        return;
+    }
+    s_lastPingUs = now;
+
+    uint8_t ping[CLOCK_SYNC_PING_MAX];
+    size_t len = s_clockSync.buildPing((uint32_t)esp_timer_get_time(), ping, sizeof(ping));
+    if (len > 0 && esp_now_send(s_peerMac, ping, len) == ESP_OK) {
+        s_stats.syncPings++;
+    }
+}
+
+// ============================================================================
+// PUBLIKATION
+// ============================================================================
+
+static void onAmbilightResult(const AmbilightResult& result) {
+    s_stats.framesPublished++;
+
+    // Mit Timing-Erweiterung: Frames, die schon vor dem Senden ihre Deadline
+    // verpasst haben, nicht mehr in die Luft schicken (der Leuchter würde sie
+    // ohnehin verwerfen). Ohne Timing kennt der Leuchter keine Deadline.
+    int64_t ageUs = esp_timer_get_time() - result.captureUs;
+    if (ESPNOW_TIMING && ESPNOW_DEADLINE_MS > 0 && ageUs > (int64_t)ESPNOW_DEADLINE_MS * 1000) {
+        s_stats.framesLate++;
+        return;
+    }
+
+    AmbilightFrameMeta meta = {
+        result.sequence,
+        (uint32_t)result.captureUs,  // Empfänger rechnet modulo 2^32
+        ESPNOW_DEADLINE_MS
+    };
+
+    AmbilightSides sides = {
+        result.topColors.data(),    (int)result.topColors.size(),
+        result.rightColors.data(),  (int)result.rightColors.size(),
+        result.bottomColors.data(), (int)result.bottomColors.size(),
+        result.leftColors.data(),   (int)result.leftColors.size()
+    };
+
+    StageTimer serializeTimer(STAGE_SERIALIZE);
+    int packets = s_encoder.encode(g_ambilightConfig.hSeg, g_ambilightConfig.vSeg, sides, &meta);
+    serializeTimer.stop();
+    if (packets == 0) {
+        s_stats.framesSkipped++;
+        return;
+    }
+
+    // Übrig gebliebene Freigabe vom letzten Frame verwerfen
+    xSemaphoreTake(s_sendDone, 0);
+
+    StageTimer transmitTimer(STAGE_TRANSMIT);
+    if (s_encoder.send(s_transport) == packets) {
+        s_stats.framesSent++;
+    } else {
+        s_stats.framesFailed++;
+    }
+    transmitTimer.stop();
+
+    // Ping erst nach dem Frame, damit er das Pacing der Fragmente nicht stört
+    if (s_pongQueue) {
+        serviceClockSync();
+    }
+}
+
+bool initEspNowSender() {
+    s_sendDone = xSemaphoreCreateBinary();
+    if (!s_sendDone) {
+        Serial.println("[espnow] ERROR: Semaphore konnte nicht erstellt werden");
+        return false;
+    }
+
+    if (esp_now_init() != ESP_OK) {
+        Serial.println("[espnow] ERROR: esp_now_init fehlgeschlagen");
+        return false;
+    }
+    esp_now_register_send_cb(onEspNowSent);
+
+    if (ESPNOW_CLOCK_SYNC) {
+        s_pongQueue = xQueueCreate(CLOCK_SYNC_MAX_RECEIVERS, sizeof(PongEvent));
+        if (!s_pongQueue) {
+            Serial.println("[espnow] ERROR: Pong-Queue konnte nicht erstellt werden");
+            return false;
+        }
+        esp_now_register_recv_cb(onEspNowReceived);
+    }
+
+    s_encoder.setParityEnabled(ESPNOW_FEC_PARITY);
+    s_encoder.setTimingEnabled(ESPNOW_TIMING);
+
+    // Peer auf dem aktuellen WLAN-Kanal (channel 0), unverschlüsselt
+    esp_now_peer_info_t peer = {};
+    memcpy(peer.peer_addr, s_peerMac, sizeof(s_peerMac));
+    peer.channel = 0;
+    peer.ifidx = WIFI_IF_STA;
+    peer.encrypt = false;
+    if (esp_now_add_peer(&peer) != ESP_OK) {
+        Serial.println("[espnow] ERROR: Peer konnte nicht hinzugefügt werden");
+        return false;
+    }
+
+    if (!addAmbilightResultListener(onAmbilightResult)) {
+        Serial.println("[espnow] ERROR: Kein freier Listener-Slot");
+        return false;
+    }
+
+    Serial.printf("[espnow] Sender bereit, Peer %02X:%02X:%02X:%02X:%02X:%02X, Kanal %d, FEC %s, Timing %s, Uhrensync %s\n",
+                  s_peerMac[0], s_peerMac[1], s_peerMac[2],
+                  s_peerMac[3], s_peerMac[4], s_peerMac[5], WiFi.channel(),
+                  ESPNOW_FEC_PARITY ? "an" : "aus", ESPNOW_TIMING ? "an" : "aus",
+                  ESPNOW_CLOCK_SYNC ? "an" : "aus");
+    return true;
+}
+
+EspNowStats getEspNowStats() {
+    EspNowStats copy;
+    copy.framesPublished = s_stats.framesPublished;
+    copy.framesLate = s_stats.framesLate;
+    copy.framesSent = s_stats.framesSent;
+    copy.framesFailed = s_stats.framesFailed;
+    copy.framesSkipped = s_stats.framesSkipped;
+    copy.packetsQueued = s_stats.packetsQueued;
+    copy.queueErrors = s_stats.queueErrors;
+    copy.txSuccess = s_stats.txSuccess;
+    copy.txFailure = s_stats.txFailure;
+    copy.paceTimeouts = s_stats.paceTimeouts;
+    copy.syncPings = s_stats.syncPings;
+    copy.syncPongs = s_stats.syncPongs;
+    return copy;
+}
+
+bool getEspNowClockPeer(int index, ClockSyncPeer* out) {
+    bool found = false;
+    portENTER_CRITICAL(&s_peerMux);
+    if (index >= 0 && index < s_peerCopyCount) {
+        *out = s_peerCopy[index];
+        found = true;
+    }
+    portEXIT_CRITICAL(&s_peerMux);
+    return found;
+}
@@ -0,0 +1,40 @@
+#ifndef ESPNOW_SENDER_H
+#define ESPNOW_SENDER_H
+
+#include <Arduino.h>
+#include "clock_sync.h"
+
+// Pacing zwischen den Fragmenten eines Frames
+#define ESPNOW_SEND_TIMEOUT_MS   10    // max. Wartezeit auf den Send-Callback des Vorgängers
+#define ESPNOW_PACKET_GAP_US     1500  // Mindestabstand zwischen zwei Fragmenten
+
+// Uhrensynchronisation (nur mit ESPNOW_CLOCK_SYNC)
+#define ESPNOW_SYNC_INTERVAL_MS  1000  // Abstand zwischen zwei Pings
+
+// Zähler des ESP-NOW-Senders
+struct EspNowStats {
+    uint32_t framesPublished; // vom Analyse-Task gemeldete Ergebnisse
+    uint32_t framesLate;     // mit ESPNOW_TIMING: vor dem Senden älter als ESPNOW_DEADLINE_MS (verworfen)
+    uint32_t framesSent;     // Frames, deren Pakete alle übergeben wurden
+    uint32_t framesFailed;   // Frames mit mindestens einem abgewiesenen Paket
+    uint32_t framesSkipped;  // Ergebnisse, die nicht kodiert werden konnten
+    uint32_t packetsQueued;  // esp_now_send() == ESP_OK
+    uint32_t queueErrors;    // esp_now_send() != ESP_OK
+    uint32_t txSuccess;      // Send-Callback: ESP_NOW_SEND_SUCCESS (MAC-ACK erhalten)
+    uint32_t txFailure;      // Send-Callback: ESP_NOW_SEND_FAIL
+    uint32_t paceTimeouts;   // Send-Callback kam nicht innerhalb ESPNOW_SEND_TIMEOUT_MS
+    uint32_t syncPings;      // gesendete Pings
+    uint32_t syncPongs;      // ausgewertete Pongs
+};
+
+// Initialisiert ESP-NOW (nach dem WLAN-Connect aufrufen) und registriert den
+// Sender als Listener für veröffentlichte Ambilight-Ergebnisse.
+bool initEspNowSender();
+
+EspNowStats getEspNowStats();
+
+// Kopie der Uhrensynchronisation für Empfänger index (false = kein solcher).
+// Aus jedem Task; Stand nach dem letzten ausgewerteten Pong.
+bool getEspNowClockPeer(int index, ClockSyncPeer* out);
+
+#endif // ESPNOW_SENDER_H
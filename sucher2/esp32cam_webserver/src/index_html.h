@@ -52,59 +52,24 @@ const char INDEX_HTML[] PROGMEM = R"rawliteral(
     console.log('Buttons gefunden:', { reset: !!resetBtn, ambilight: !!ambilightBtn });
     let points = [];
     let gridPts = [];
-    let ambilightData = null;
 
-    // === SNAPSHOT-POLLING (ersetzt MJPEG-Stream) ===
-    let snapshotUpdateRunning = false;
-    
-    function updateSnapshot() {
-      if (snapshotUpdateRunning) {
-        console.log('Snapshot-Update bereits aktiv, überspringe...');
-        return;
-      }
-      
-      snapshotUpdateRunning = true;
-      const timestamp = Date.now();
-      
-      fetch('/api/snapshot?t=' + timestamp)
-        .then(response => {
-          if (!response.ok) {
-            throw new Error('Snapshot-Request fehlgeschlagen: ' + response.status);
-          }
-          return response.blob();
-        })
-        .then(blob => {
-          const url = URL.createObjectURL(blob);
-          streamImg.onload = () => {
-            URL.revokeObjectURL(url);
-            snapshotUpdateRunning = false;
-          };
-          streamImg.onerror = () => {
-            URL.revokeObjectURL(url);
-            snapshotUpdateRunning = false;
-            console.error('Fehler beim Laden des Snapshots');
-          };
-          streamImg.src = url;
-        })
-        .catch(err => {
-          console.error('Snapshot-Fehler:', err);
-          snapshotUpdateRunning = false;
-        });
+    // === MJPEG-STREAM (eigener Server auf Port 82) ===
+    function startStream() {
+      streamImg.src = 'http://' + location.hostname + ':82/stream';
     }
-    
-    // Snapshot alle 1 Sekunde aktualisieren
-    setInterval(updateSnapshot, 1000);
-    updateSnapshot(); // Sofort erstes Bild laden
+    streamImg.onerror = () => {
+      console.error('Stream unterbrochen, neuer Versuch in 2 s');
+      setTimeout(startStream, 2000);
+    };
+    startStream();
 
     function drawPoints() {
-      console.log('drawPoints aufgerufen, ambilightData:', ambilightData ? 'vorhanden' : 'null');
       ctx.clearRect(0, 0, overlayCanvas.width, overlayCanvas.height);
 
-      // Ambilight-Rechtecke zeichnen (falls vorhanden)
-      if (ambilightData) {
-        drawAmbilightRects(ambilightData);
-      } else {
-        console.log('Keine Ambilight-Daten zum Zeichnen');
+      // Ambilight-Rechtecke zeichnen (nicht während neue Punkte gesetzt werden)
+      const editing = points.length > 0 && points.length < 4;
+      if (!editing && liveRects && liveColors && liveRects.version === liveColors.version) {
+        drawAmbilightRects();
       }
 
       // Punkte zeichnen
@@ -137,101 +102,82 @@ const char INDEX_HTML[] PROGMEM = R"rawliteral(
       }
     }
 
-    function drawAmbilightRects(data) {
-      // Zeichne alle Ambilight-Rechtecke mit ihren berechneten Farben
+    function drawAmbilightRects() {
+      // Rechtecke und Farben kommen im Uhrzeigersinn (siehe live_socket.h)
       // WICHTIG: ESP32 sendet Koordinaten für 320x240, Canvas ist 640x480
       // -> Koordinaten müssen x2 skaliert werden!
       const scale = 2.0;
-      
-      console.log('drawAmbilightRects aufgerufen mit Daten:', data);
-      
-      const sides = ['top', 'bottom', 'left', 'right'];
-      let totalRects = 0;
-      
-      sides.forEach(side => {
-        const colors = data[side] || [];
-        const rects = data[side + 'Rects'] || [];
-        
-        console.log(`${side}: ${colors.length} Farben, ${rects.length} Rechtecke`);
-        
-        for (let i = 0; i < colors.length && i < rects.length; i++) {
-          const [r, g, b] = colors[i];
-          const rect = rects[i];
-          
-          // Skaliere Koordinaten zurück auf Canvas-Größe
-          const x1 = rect.x1 * scale;
-          const y1 = rect.y1 * scale;
-          const x2 = rect.x2 * scale;
-          const y2 = rect.y2 * scale;
-          
-          if (i === 0) {
-            console.log(`${side}[0]: Farbe rgb(${r},${g},${b}), Rect (${x1},${y1}) -> (${x2},${y2})`);
-          }
-          
-          // Fülle das Rechteck mit der berechneten Farbe
-          ctx.fillStyle = `rgb(${r}, ${g}, ${b})`;
-          ctx.fillRect(x1, y1, x2 - x1, y2 - y1);
-          
-          // Zeichne grünen Rahmen für bessere Sichtbarkeit
-          ctx.strokeStyle = 'rgba(0, 255, 0, 0.5)';
-          ctx.lineWidth = 1;
-          ctx.strokeRect(x1, y1, x2 - x1, y2 - y1);
-          totalRects++;
-        }
-      });
-      
-      console.log(`Insgesamt ${totalRects} Rechtecke gezeichnet`);
-    }
+      const rects = liveRects.rects;
+      const colors = liveColors.rgb;
+      const count = Math.min(rects.length / 4, colors.length / 3);
 
-    // === KONTINUIERLICHES POLLING ===
-    let pollingInterval = null;
+      for (let k = 0; k < count; k++) {
+        const x1 = rects[k * 4] * scale;
+        const y1 = rects[k * 4 + 1] * scale;
+        const x2 = rects[k * 4 + 2] * scale;
+        const y2 = rects[k * 4 + 3] * scale;
 
-    // Holt Ambilight-Daten vom Server (GET - keine Berechnung, nur Abruf)
-    function fetchAmbilightData() {
-      if (points.length !== 4) {
-        return; // Kein Log mehr, zu viel Spam
+        // Fülle das Rechteck mit der berechneten Farbe
+        ctx.fillStyle = `rgb(${colors[k * 3]}, ${colors[k * 3 + 1]}, ${colors[k * 3 + 2]})`;
+        ctx.fillRect(x1, y1, x2 - x1, y2 - y1);
+
+        // Zeichne grünen Rahmen für bessere Sichtbarkeit
+        ctx.strokeStyle = 'rgba(0, 255, 0, 0.5)';
+        ctx.lineWidth = 1;
+        ctx.strokeRect(x1, y1, x2 - x1, y2 - y1);
       }
-      
-      console.log('Polling: Hole Daten...');
-      fetch('/api/ambilight')
-        .then(r => {
-          console.log('Polling: Response erhalten, Status:', r.status, r.statusText);
-          return r.text();
-        })
-        .then(text => {
-          console.log('Polling: Response-Text (erste 200 Zeichen):', text.substring(0, 200));
-          const data = JSON.parse(text);
-          console.log('Polling: JSON geparst:', data);
-          if (!data.error) {
-            ambilightData = data;
-            console.log('Polling: ambilightData gesetzt, rufe drawPoints()...');
-            drawPoints();
-          } else {
-            console.error('Polling: Server-Fehler:', data.error);
-          }
-        })
-        .catch(err => {
-          console.error('Polling-Fehler:', err);
-        });
     }
 
-    // Startet automatisches Polling (nur zur Visualisierung)
-    function startPolling() {
-      if (pollingInterval) return;
-      console.log('Starte Polling...');
-      pollingInterval = setInterval(fetchAmbilightData, 2000); // Alle 2000ms (0.5 Hz)
-      fetchAmbilightData(); // Sofort einmal ausführen
+    // === LIVE-VORSCHAU PER WEBSOCKET (ersetzt 2-s-Polling) ===
+    // Der Server schickt bei jedem neuen Ergebnis die Farben (binär) und die
+    // Rechtecke nur, wenn sich die Konfiguration geändert hat.
+    let liveSocket = null;
+    let liveRects = null;    // { version, rects: Int16Array [x1,y1,x2,y2,...] }
+    let liveColors = null;   // { sequence, version, rgb: Uint8Array }
+    let drawScheduled = false;
+
+    function scheduleDraw() {
+      if (drawScheduled) return;
+      drawScheduled = true;
+      requestAnimationFrame(() => {
+        drawScheduled = false;
+        drawPoints();
+      });
     }
 
-    // Stoppt Polling
-    function stopPolling() {
-      if (pollingInterval) {
-        console.log('Stoppe Polling...');
-        clearInterval(pollingInterval);
-        pollingInterval = null;
+    function onLiveMessage(ev) {
+      const view = new DataView(ev.data);
+      const type = view.getUint8(0);
+      if (type === 2) {
+        const count = view.getUint16(3, true);
+        const rects = new Int16Array(count * 4);
+        for (let i = 0; i < count * 4; i++) {
+          rects[i] = view.getInt16(5 + i * 2, true);
+        }
+        liveRects = { version: view.getUint16(1, true), rects };
+      } else if (type === 1) {
+        const count = view.getUint16(9, true);
+        liveColors = {
+          sequence: view.getUint32(1, true),
+          version: view.getUint16(5, true),
+          rgb: new Uint8Array(ev.data, 11, count * 3)
+        };
+        scheduleDraw();
       }
     }
 
+    function connectLive() {
+      liveSocket = new WebSocket('ws://' + location.hostname + ':81/ws');
+      liveSocket.binaryType = 'arraybuffer';
+      liveSocket.onopen = () => console.log('Live-WebSocket verbunden');
+      liveSocket.onmessage = onLiveMessage;
+      liveSocket.onclose = () => {
+        console.log('Live-WebSocket getrennt, neuer Versuch in 2 s');
+        liveSocket = null;
+        setTimeout(connectLive, 2000);
+      };
+    }
+
     // Klick auf Bild registrieren
     document.getElementById('stream-container').addEventListener('click', (e) => {
       if (points.length >= 4) return; // Maximal vier Punkte
@@ -273,11 +219,16 @@ const char INDEX_HTML[] PROGMEM = R"rawliteral(
         })
         .catch(console.error);
         
-        // Config-Request für Ambilight-Berechnung
+        // Config-Request für Ambilight-Berechnung, Punkte normiert auf [0, 1]
+        const config = {
+          ...payload,
+          points: points.map(p => ({ x: p.x / overlayCanvas.width, y: p.y / overlayCanvas.height })),
+          normalized: true
+        };
         fetch('/api/config', {
           method: 'POST',
           headers: { 'Content-Type': 'application/json' },
-          body: JSON.stringify(payload)
+          body: JSON.stringify(config)
         })
         .then(r => r.json())
         .then(data => {
@@ -291,22 +242,21 @@ const char INDEX_HTML[] PROGMEM = R"rawliteral(
     resetBtn.addEventListener('click', () => {
       points = [];
       gridPts = [];
-      ambilightData = null;
       coordList.innerHTML = '';
       drawPoints();
     });
 
-    // Button für manuelles Update
+    // Button für manuelles Update: Verbindung neu aufbauen (Server schickt
+    // dann Rechtecke und aktuelle Farben sofort)
     ambilightBtn.addEventListener('click', () => {
       console.log('Manuelles Update angefordert');
-      fetchAmbilightData();
+      if (liveSocket) {
+        liveSocket.close();
+      }
     });
 
-    // Polling automatisch starten
-    startPolling();
-
-    // Polling stoppen beim Verlassen der Seite
-    window.addEventListener('beforeunload', stopPolling);
+    // Live-Vorschau starten
+    connectLive();
   </script>
 </body>
 </html>
@@ -0,0 +1,334 @@
+#include "live_socket.h"
+#include <WiFi.h>
+#include <esp_http_server.h>
+#include <unistd.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "windows.h"
+#include "ambilight_protocol.h"
+#include "stage_metrics.h"
+#include "trace.h"
+
+#if !CONFIG_HTTPD_WS_SUPPORT
+#error "live_socket.cpp benötigt CONFIG_HTTPD_WS_SUPPORT (WebSocket-Unterstützung im esp_http_server)"
+#endif
+
+#define LIVE_MAX_RECTS       AMBI_MAX_RECTANGLES
+#define LIVE_COLORS_MAX      (LIVE_COLORS_HEADER + LIVE_MAX_RECTS * 3)
+#define LIVE_RECTS_MAX       (LIVE_RECTS_HEADER + LIVE_MAX_RECTS * 8)
+
+// ============================================================================
+// STATE
+// ============================================================================
+
+static httpd_handle_t s_liveHttpd = nullptr;
+
+// Schützt die "pending"-Puffer (Analyse-Kontext schreibt, httpd-Task liest)
+static SemaphoreHandle_t s_lock = nullptr;
+
+// Zuletzt veröffentlichter Frame, fertig als Nachricht kodiert.
+// Ein neuer Frame überschreibt einen noch nicht gesendeten (drop-to-latest).
+static uint8_t s_pendingColors[LIVE_COLORS_MAX];
+static size_t s_pendingColorsLen = 0;
+static uint8_t s_pendingRects[LIVE_RECTS_MAX];
+static size_t s_pendingRectsLen = 0;
+static uint32_t s_pendingRectsVersion = 0;
+static bool s_pushQueued = false;
+
+// Sendepuffer, nur im httpd-Task benutzt
+static uint8_t s_txColors[LIVE_COLORS_MAX];
+static uint8_t s_txRects[LIVE_RECTS_MAX];
+
+// Clients, nur im httpd-Task verändert
+struct LiveClient {
+    int fd;                  // -1 = frei
+    uint32_t rectsVersion;   // zuletzt gesendete Rechtecke, 0 = noch keine
+};
+static LiveClient s_clients[LIVE_WS_MAX_CLIENTS];
+static volatile int s_clientCount = 0;
+
+static volatile LiveSocketStats s_stats = {0, 0, 0, 0, 0};
+
+// ============================================================================
+// KODIERUNG
+// ============================================================================
+
+static void putU16(uint8_t* p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void putU32(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+// Rechteck k im Uhrzeigersinn (gleiche Reihenfolge wie ambilightClockwiseColor)
+static const WindowRect& clockwiseRect(const AmbilightResult& r, int k) {
+    int top = r.topRects.size(), right = r.rightRects.size(), bottom = r.bottomRects.size();
+    if (k < top) return r.topRects[k];
+    k -= top;
+    if (k < right) return r.rightRects[k];
+    k -= right;
+    if (k < bottom) return r.bottomRects[bottom - 1 - k];
+    k -= bottom;
+    return r.leftRects[r.leftRects.size() - 1 - k];
+}
+
+static size_t encodeColors(const AmbilightResult& result, uint8_t* out) {
+    AmbilightSides sides = {
+        result.topColors.data(),    (int)result.topColors.size(),
+        result.rightColors.data(),  (int)result.rightColors.size(),
+        result.bottomColors.data(), (int)result.bottomColors.size(),
+        result.leftColors.data(),   (int)result.leftColors.size()
+    };
+    int count = sides.topCount + sides.rightCount + sides.bottomCount + sides.leftCount;
+    if (count > LIVE_MAX_RECTS) count = LIVE_MAX_RECTS;
+
+    out[0] = LIVE_MSG_COLORS;
+    putU32(out + 1, result.sequence);
+    putU16(out + 5, (uint16_t)result.configVersion);
+    out[7] = (uint8_t)g_ambilightConfig.hSeg;
+    out[8] = (uint8_t)g_ambilightConfig.vSeg;
+    putU16(out + 9, (uint16_t)count);
+    uint8_t* p = out + LIVE_COLORS_HEADER;
+    for (int k = 0; k < count; k++) {
+        RGB c = ambilightClockwiseColor(sides, k);
+        *p++ = c.r;
+        *p++ = c.g;
+        *p++ = c.b;
+    }
+    return p - out;
+}
+
+static size_t encodeRects(const AmbilightResult& result, uint8_t* out) {
+    int count = result.topRects.size() + result.rightRects.size() +
+                result.bottomRects.size() + result.leftRects.size();
+    if (count > LIVE_MAX_RECTS) count = LIVE_MAX_RECTS;
+
+    out[0] = LIVE_MSG_RECTS;
+    putU16(out + 1, (uint16_t)result.configVersion);
+    putU16(out + 3, (uint16_t)count);
+    uint8_t* p = out + LIVE_RECTS_HEADER;
+    for (int k = 0; k < count; k++) {
+        const WindowRect& r = clockwiseRect(result, k);
+        putU16(p, (uint16_t)r.x1);
+        putU16(p + 2, (uint16_t)r.y1);
+        putU16(p + 4, (uint16_t)r.x2);
+        putU16(p + 6, (uint16_t)r.y2);
+        p += 8;
+    }
+    return p - out;
+}
+
+// ============================================================================
+// CLIENTS (httpd-Task)
+// ============================================================================
+
+static bool addClient(int fd) {
+    for (int i = 0; i < LIVE_WS_MAX_CLIENTS; i++) {
+        if (s_clients[i].fd < 0) {
+            s_clients[i].fd = fd;
+            s_clients[i].rectsVersion = 0;
+            s_clientCount++;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void removeClient(int fd) {
+    for (int i = 0; i < LIVE_WS_MAX_CLIENTS; i++) {
+        if (s_clients[i].fd == fd) {
+            s_clients[i].fd = -1;
+            s_clientCount--;
+        }
+    }
+}
+
+// Vom httpd beim Schließen jeder Session aufgerufen
+static void onSessionClosed(httpd_handle_t hd, int sockfd) {
+    removeClient(sockfd);
+    close(sockfd);
+}
+
+static bool sendBinary(int fd, uint8_t* data, size_t len) {
+    httpd_ws_frame_t frame = {};
+    frame.final = true;
+    frame.type = HTTPD_WS_TYPE_BINARY;
+    frame.payload = data;
+    frame.len = len;
+    return httpd_ws_send_frame_async(s_liveHttpd, fd, &frame) == ESP_OK;
+}
+
+// Läuft im httpd-Task (httpd_queue_work): sendet den jeweils neuesten Frame.
+// Blockiert ein langsamer Client den Versand, werden die dazwischen
+// veröffentlichten Frames verworfen statt aufgestaut.
+static void pushLatest(void* arg) {
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    s_pushQueued = false;
+    size_t colorsLen = s_pendingColorsLen;
+    memcpy(s_txColors, s_pendingColors, colorsLen);
+    size_t rectsLen = s_pendingRectsLen;
+    uint32_t rectsVersion = s_pendingRectsVersion;
+    bool rectsNeeded = false;
+    for (int i = 0; i < LIVE_WS_MAX_CLIENTS; i++) {
+        if (s_clients[i].fd >= 0 && s_clients[i].rectsVersion != rectsVersion) {
+            rectsNeeded = true;
+        }
+    }
+    if (rectsNeeded) {
+        memcpy(s_txRects, s_pendingRects, rectsLen);
+    }
+    xSemaphoreGive(s_lock);
+
+    if (colorsLen == 0) {
+        return;  // noch kein Ergebnis
+    }
+
+    TRACE_SPAN("wifi", "live_send");
+    bool pushed = false;
+    for (int i = 0; i < LIVE_WS_MAX_CLIENTS; i++) {
+        LiveClient& c = s_clients[i];
+        if (c.fd < 0) continue;
+
+        bool ok = true;
+        if (c.rectsVersion != rectsVersion && rectsLen > 0) {
+            ok = sendBinary(c.fd, s_txRects, rectsLen);
+            if (ok) {
+                c.rectsVersion = rectsVersion;
+                s_stats.rectsSent++;
+            }
+        }
+        if (ok) {
+            ok = sendBinary(c.fd, s_txColors, colorsLen);
+        }
+        if (!ok) {
+            s_stats.sendErrors++;
+            httpd_sess_trigger_close(s_liveHttpd, c.fd);
+            continue;
+        }
+        pushed = true;
+    }
+    if (pushed) {
+        s_stats.framesPushed++;
+    }
+}
+
+// Nur einen Push gleichzeitig einreihen (Aufrufer hält s_lock)
+static void queuePushLocked() {
+    if (s_pushQueued) {
+        s_stats.framesDropped++;
+        return;
+    }
+    if (httpd_queue_work(s_liveHttpd, pushLatest, nullptr) == ESP_OK) {
+        s_pushQueued = true;
+    }
+}
+
+// ============================================================================
+// HANDLER
+// ============================================================================
+
+static esp_err_t wsHandler(httpd_req_t* req) {
+    if (req->method == HTTP_GET) {
+        // Handshake ist erledigt: Client aufnehmen und sofort versorgen
+        int fd = httpd_req_to_sockfd(req);
+        if (!addClient(fd)) {
+            Serial.println("[live] Zu viele Clients, Verbindung abgelehnt");
+            return ESP_FAIL;
+        }
+        Serial.printf("[live] Client verbunden (fd %d, %d aktiv)\n", fd, s_clientCount);
+        xSemaphoreTake(s_lock, portMAX_DELAY);
+        queuePushLocked();
+        xSemaphoreGive(s_lock);
+        return ESP_OK;
+    }
+
+    // Die Seite sendet nichts Relevantes: Frames lesen und verwerfen
+    uint8_t buf[32];
+    httpd_ws_frame_t frame = {};
+    esp_err_t err = httpd_ws_recv_frame(req, &frame, 0);
+    if (err != ESP_OK || frame.len > sizeof(buf)) {
+        return ESP_FAIL;
+    }
+    if (frame.len > 0) {
+        frame.payload = buf;
+        return httpd_ws_recv_frame(req, &frame, frame.len);
+    }
+    return ESP_OK;
+}
+
+// ============================================================================
+// PUBLIKATION
+// ============================================================================
+
+static void onAmbilightResult(const AmbilightResult& result) {
+    if (s_clientCount == 0) {
+        return;  // niemand schaut zu: keine Kosten im Analyse-Pfad
+    }
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    StageTimer serializeTimer(STAGE_SERIALIZE);
+    s_pendingColorsLen = encodeColors(result, s_pendingColors);
+    if (result.configVersion != s_pendingRectsVersion) {
+        s_pendingRectsLen = encodeRects(result, s_pendingRects);
+        s_pendingRectsVersion = result.configVersion;
+    }
+    serializeTimer.stop();
+    queuePushLocked();
+    xSemaphoreGive(s_lock);
+}
+
+bool initLiveSocket() {
+    for (int i = 0; i < LIVE_WS_MAX_CLIENTS; i++) {
+        s_clients[i].fd = -1;
+    }
+    s_lock = xSemaphoreCreateMutex();
+    if (!s_lock) {
+        Serial.println("[live] ERROR: Mutex konnte nicht erstellt werden");
+        return false;
+    }
+
+    httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+    config.server_port = LIVE_WS_PORT;
+    config.ctrl_port = LIVE_WS_PORT + 32768;       // eigener Steuer-Port je httpd-Instanz
+    config.max_open_sockets = LIVE_WS_MAX_CLIENTS + 1;
+    config.lru_purge_enable = true;
+    config.send_wait_timeout = LIVE_WS_SEND_TIMEOUT;
+    config.task_priority = tskIDLE_PRIORITY + 1;   // unter dem Analyse-Task
+    config.close_fn = onSessionClosed;
+
+    if (httpd_start(&s_liveHttpd, &config) != ESP_OK) {
+        Serial.println("[live] ERROR: httpd_start fehlgeschlagen");
+        return false;
+    }
+
+    httpd_uri_t wsUri = {};
+    wsUri.uri = "/ws";
+    wsUri.method = HTTP_GET;
+    wsUri.handler = wsHandler;
+    wsUri.is_websocket = true;
+    httpd_register_uri_handler(s_liveHttpd, &wsUri);
+
+    if (!addAmbilightResultListener(onAmbilightResult)) {
+        Serial.println("[live] ERROR: Kein freier Listener-Slot");
+        return false;
+    }
+
+    Serial.printf("[live] WebSocket bereit: ws://%s:%d/ws\n",
+                  WiFi.localIP().toString().c_str(), LIVE_WS_PORT);
+    return true;
+}
+
+LiveSocketStats getLiveSocketStats() {
+    LiveSocketStats copy;
+    copy.clients = s_clientCount;
+    copy.framesPushed = s_stats.framesPushed;
+    copy.framesDropped = s_stats.framesDropped;
+    copy.rectsSent = s_stats.rectsSent;
+    copy.sendErrors = s_stats.sendErrors;
+    return copy;
+}
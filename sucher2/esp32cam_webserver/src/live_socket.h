@@ -0,0 +1,35 @@
+#ifndef LIVE_SOCKET_H
+#define LIVE_SOCKET_H
+
+#include <Arduino.h>
+
+// Live-Vorschau: WebSocket auf eigenem esp_http_server (eigener Task, eigener
+// Port), damit die HTTP-API auf Port 80 nicht belastet wird.
+#define LIVE_WS_PORT         81
+#define LIVE_WS_MAX_CLIENTS  4
+#define LIVE_WS_SEND_TIMEOUT 1     // s, danach wird ein hängender Client getrennt
+
+// Binäre Nachrichten (little endian), Farben und Rechtecke im Uhrzeigersinn
+// wie im Ambilight-Protokoll (siehe doc/AMBILIGHT_PROTOCOL.md):
+//   0x01 Farben:     type, sequence (u32), configVersion (u16), h, v, count (u16), count * RGB
+//   0x02 Rechtecke:  type, configVersion (u16), count (u16), count * (x1, y1, x2, y2 als i16)
+#define LIVE_MSG_COLORS      0x01
+#define LIVE_MSG_RECTS       0x02
+#define LIVE_COLORS_HEADER   11
+#define LIVE_RECTS_HEADER    5
+
+struct LiveSocketStats {
+    uint32_t clients;        // aktuell verbundene Clients
+    uint32_t framesPushed;   // an mindestens einen Client gesendete Frames
+    uint32_t framesDropped;  // vor dem Senden vom nächsten Frame überholt (Backpressure)
+    uint32_t rectsSent;      // Rechteck-Nachrichten (nur bei neuer Konfiguration / neuem Client)
+    uint32_t sendErrors;     // fehlgeschlagene Sends, Client wurde getrennt
+};
+
+// Startet den WebSocket-Server (ws://<ip>:LIVE_WS_PORT/ws) und registriert
+// ihn als Listener für veröffentlichte Ergebnisse. Nach dem WLAN-Connect aufrufen.
+bool initLiveSocket();
+
+LiveSocketStats getLiveSocketStats();
+
+#endif // LIVE_SOCKET_H
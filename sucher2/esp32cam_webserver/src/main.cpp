@@ -1,10 +1,21 @@
 #include "esp_camera.h"
 #include <WiFi.h>
-#include <WebServer.h>
-#include <ArduinoJson.h>
 #include "config.h"
-#include "index_html.h"
 #include "windows.h"
+#include "espnow_sender.h"
+#include "udp_sender.h"
+#include "live_socket.h"
+#include "color_recorder.h"
+#include "stream_server.h"
+#include "frame_broker.h"
+#include "api_server.h"
+#include "analysis_task.h"
+#include "reduce_worker.h"
+#include "snapshot_cache.h"
+#include "stage_metrics.h"
+#include "deferred_log.h"
+#include "trace.h"
+#include "alloc_tracker.h"
 
 // Kamera-Pinbelegung für AI-Thinker ESP32-CAM
 // Quelle: https://github.com/espressif/arduino-esp32/blob/master/libraries/ESP32/examples/Camera/CameraWebServer/CameraWebServer.ino
@@ -26,8 +37,6 @@
 #define HREF_GPIO_NUM     23
 #define PCLK_GPIO_NUM     22
 
-WebServer server(80);
-
 static esp_err_t init_camera()
 {
     camera_config_t config;
@@ -66,130 +75,21 @@ static esp_err_t init_camera()
     return esp_camera_init(&config);
 }
 
-void handle_root()
-{
-    Serial.println("[handle_root] Root page requested");
-    server.send_P(200, "text/html", INDEX_HTML);
-}
-
-// Sendet einzelnes JPEG-Snapshot (ersetzt kontinuierlichen Stream)
-void handle_snapshot()
-{
-    camera_fb_t *fb = esp_camera_fb_get();
-    if (!fb) {
-        Serial.println("[snapshot] ERROR: Failed to get camera frame");
-        server.send(500, "text/plain", "Camera error");
-        return;
-    }
-    
-    server.sendHeader("Access-Control-Allow-Origin", "*");
-    server.sendHeader("Cache-Control", "no-cache, no-store, must-revalidate");
-    server.sendHeader("Pragma", "no-cache");
-    server.sendHeader("Expires", "-1");
-    server.send_P(200, "image/jpeg", (const char *)fb->buf, fb->len);
-    
-    esp_camera_fb_return(fb);
-}
-
-// Global request logger - wird für JEDEN Request aufgerufen
-void logRequest() {
-    Serial.print("[REQUEST] ");
-    Serial.print(server.method() == HTTP_GET ? "GET" : "POST");
-    Serial.print(" ");
-    Serial.print(server.uri());
-    Serial.print(" from ");
-    Serial.println(server.client().remoteIP());
-}
-
-// API: empfängt 4 Punkte und Segmentzahlen, berechnet Zwischenpunkte
-void handle_grid()
-{
-    Serial.println("[handle_grid] === GRID REQUEST RECEIVED ===");
-    if (server.hasArg("plain") == false) {
-        Serial.println("[handle_grid] No body");
-        server.send(400, "text/plain", "No body");
-        return;
-    }
-
-    StaticJsonDocument<1024> doc;
-    DeserializationError err = deserializeJson(doc, server.arg("plain"));
-    if (err) {
-        Serial.println("[handle_grid] JSON parse error");
-        server.send(400, "text/plain", "JSON parse error");
-        return;
-    }
-
-    JsonArray pts = doc["points"].as<JsonArray>();
-    if (pts.size() != 4) {
-        Serial.print("[handle_grid] pts size:"); Serial.println(pts.size());
-        server.send(400, "text/plain", "Need 4 points");
-        return;
-    }
-
-    int hSeg = doc["hSeg"].as<int>() | 1;
-    int vSeg = doc["vSeg"].as<int>() | 1;
-
-    struct P { float x; float y; };
-    P p[4];
-    for (int i = 0; i < 4; ++i) {
-        p[i].x = pts[i]["x"].as<float>();
-        p[i].y = pts[i]["y"].as<float>();
-    }
-
-    DynamicJsonDocument outDoc(2048);
-    JsonArray arr = outDoc.createNestedArray("points");
-
-    auto addIntermediates = [&](P a, P b, int count) {
-        float dx = b.x - a.x;
-        float dy = b.y - a.y;
-        for (int i = 1; i < count; ++i) {
-            float t = (float)i / count;
-            JsonObject obj = arr.createNestedObject();
-            obj["x"] = a.x + dx * t;
-            obj["y"] = a.y + dy * t;
-        }
-    };
-
-    // horizontale Linien 1-2 und 3-4
-    addIntermediates(p[0], p[1], hSeg);
-    addIntermediates(p[2], p[3], hSeg);
-    // vertikale Linien 2-3 und 4-1
-    addIntermediates(p[1], p[2], vSeg);
-    addIntermediates(p[3], p[0], vSeg);
-
-    serializeJsonPretty(outDoc, Serial);
-    Serial.println();
-
-    String response;
-    serializeJson(outDoc, response);
-    server.send(200, "application/json", response);
+// Frame-Broker (lib/hanawa_core): Meldungen auf die Konsole, esp_camera_fb_get() in die Zeitleiste
+static void brokerLog(bool error, const char* message) {
+    Serial.printf("[broker] %s%s\n", error ? "ERROR: " : "", message);
 }
 
-// API: Konfiguration setzen (ersetzt /api/grid)
-void handle_config()
-{
-    Serial.println("[handle_config] === CONFIG REQUEST RECEIVED ===");
-    
-    if (server.hasArg("plain") == false) {
-        Serial.println("[handle_config] No body");
-        server.send(400, "text/plain", "No body");
-        return;
-    }
-    
-    updateAmbilightConfig(server.arg("plain"));
-    
-    server.send(200, "application/json", "{\"status\":\"ok\"}");
-    Serial.println("[handle_config] Config updated!");
+static int64_t brokerCaptureBegin() {
+    return metricsNowUs();
 }
 
-// API: Ambilight-Daten abrufen (GET - gibt gecachte Daten zurück)
-void handle_ambilight()
-{
-    Serial.println("[handle_ambilight] === AMBILIGHT GET REQUEST ===");
-    
-    String response = getAmbilightResult();
-    
-    server.send(200, "application/json", response);
+static void brokerCaptureEnd(int64_t begin) {
+#if TRACE_ENABLED
+    traceComplete("camera", "fb_get", begin, (uint32_t)(metricsNowUs() - begin));
+#else
+    (void)begin;
+#endif
 }
 
 void setup()
@@ -197,11 +97,24 @@ void setup()
     Serial.begin(115200);
     Serial.setDebugOutput(false);
 
+    // LOG_*-Einträge aus den Tasks gibt ein eigener Task auf Serial aus
+    initDeferredLog();
+
+    // Zeitleiste für /api/trace (PSRAM-Ring, mit -DTRACE_ENABLED=0 abschaltbar)
+#if TRACE_ENABLED
+    initTrace();
+#endif
+
     if (init_camera() != ESP_OK) {
         Serial.println("Kamera-Initialisierung fehlgeschlagen");
         return;
     }
 
+    // Einziger Besitzer der Kamera: alle Verbraucher holen Frames über den Broker
+    FrameBrokerHooks brokerHooks = { brokerLog, brokerCaptureBegin, brokerCaptureEnd };
+    setFrameBrokerHooks(brokerHooks);
+    initFrameBroker();
+
     WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
     Serial.println("Verbinde mit WLAN ...");
     while (WiFi.status() != WL_CONNECTED) {
@@ -210,57 +123,96 @@ void setup()
     }
     Serial.println("\nWLAN verbunden. IP: " + WiFi.localIP().toString());
 
-    // Globaler Request-Logger für ALLE Requests
-    server.onNotFound([]() {
-        Serial.print("[NOT_FOUND] ");
-        Serial.print(server.method() == HTTP_GET ? "GET" : "POST");
-        Serial.print(" ");
-        Serial.println(server.uri());
-        server.send(404, "text/plain", "Not found");
-    });
+    // ESP-NOW-Sender zum Leuchter (wird von calculateAmbilightContinuous() getrieben)
+    initEspNowSender();
+    if (UDP_FANOUT) {
+        initUdpFanoutSender();
+    }
+
+    // Farb-Log der veröffentlichten Ergebnisse für /api/record (PSRAM)
+    initColorRecorder();
+
+    // Live-Vorschau für die Weboberfläche (WebSocket auf Port 81)
+    initLiveSocket();
+
+    // MJPEG-Stream auf eigenem Task (Port 82)
+    initStreamServer();
+
+    // Weboberfläche und JSON-API (Port 80), eigener Task unter der Analyse
+    initApiServer();
 
-    server.on("/", HTTP_GET, []() {
-        logRequest();
-        handle_root();
-    });
-    server.on("/api/snapshot", HTTP_GET, []() {
-        logRequest();
-        handle_snapshot();
-    });
-    server.on("/api/grid", HTTP_POST, []() {
-        logRequest();
-        handle_grid();
-    });
-    server.on("/api/config", HTTP_POST, []() {
-        logRequest();
-        handle_config();
-    });
-    server.on("/api/ambilight", HTTP_GET, []() {
-        logRequest();
-        handle_ambilight();
-    });
-    server.begin();
+    // Zweite Hälfte der Farbreduktion auf Core 0
+    initReduceWorker();
+
+    // Kontinuierliche Ambilight-Berechnung, treibt ESP-NOW/UDP/Live-WebSocket
+    initAnalysisTask();
     
-    Serial.print("HTTP-Server gestartet. Free heap: ");
+    Serial.print("Setup abgeschlossen. Free heap: ");
     Serial.println(ESP.getFreeHeap());
 }
 
 void loop()
 {
-    server.handleClient();
-    
-    // Kontinuierliche Ambilight-Berechnung (100ms = 10 FPS für anderen ESP)
-    static unsigned long lastAmbilight = 0;
+    // Analyse und HTTP laufen auf eigenen Tasks, hier nur noch der Heartbeat
     unsigned long now = millis();
-    if (now - lastAmbilight > 100) {
-        calculateAmbilightContinuous();
-        lastAmbilight = now;
-    }
     
     // Heartbeat alle 10 Sekunden
     static unsigned long lastHeartbeat = 0;
     if (now - lastHeartbeat > 10000) {
         Serial.println("[loop] Heartbeat - Server läuft");
+        AnalysisTimingStats timing = getAnalysisTimingStats();
+        Serial.printf("[loop] Analyse: %u Frames, Periode %u ± %u µs (min %u / max %u), Rechenzeit %u µs (max %u), Überläufe %u\n",
+                      timing.frames, timing.periodMeanUs, timing.periodStddevUs, timing.periodMinUs,
+                      timing.periodMaxUs, timing.busyMeanUs, timing.busyMaxUs, timing.overruns);
+        StageSummary decode = getStageSummary(STAGE_JPEG_DECODE);
+        StageSummary reduction = getStageSummary(STAGE_REDUCTION);
+        StageSummary total = getStageSummary(STAGE_FRAME_TOTAL);
+        Serial.printf("[loop] Stufen p50/p99: Decode %u/%u µs, Reduktion %u/%u µs, gesamt %u/%u µs (mehr unter /api/metrics)\n",
+                      decode.p50Us, decode.p99Us, reduction.p50Us, reduction.p99Us, total.p50Us, total.p99Us);
+        ApiServerStats api = getApiServerStats();
+        Serial.printf("[loop] HTTP-API: %u Requests, 404 %u, ungültig %u, Kamera-Fehler %u\n",
+                      api.requests, api.notFound, api.badRequests, api.cameraErrors);
+        SnapshotCacheStats snap = getSnapshotCacheStats();
+        Serial.printf("[loop] Snapshot-Cache: %u kopiert, %u Treffer / %u verfehlt, %u unverändert (304), Fehler %u\n",
+                      snap.framesStored, snap.hits, snap.misses, api.notModified, snap.storeErrors);
+        EspNowStats tx = getEspNowStats();
+        Serial.printf("[loop] ESP-NOW: Frames %u veröffentlicht, %u ok / %u fehlerhaft / %u zu spät, TX %u ok / %u fail, Timeouts %u\n",
+                      tx.framesPublished, tx.framesSent, tx.framesFailed, tx.framesLate,
+                      tx.txSuccess, tx.txFailure, tx.paceTimeouts);
+        ClockSyncPeer peer;
+        for (int i = 0; getEspNowClockPeer(i, &peer); i++) {
+            Serial.printf("[loop] Uhrensync Leuchter %u: Offset %ld µs, Round-Trip %lu µs, %lu Pongs\n",
+                          peer.id, (long)peer.offsetUs, (unsigned long)peer.delayUs, (unsigned long)peer.pongs);
+        }
+        LiveSocketStats live = getLiveSocketStats();
+        Serial.printf("[loop] Live-WebSocket: %u Clients, Frames %u gesendet / %u verworfen, Rects %u, Fehler %u\n",
+                      live.clients, live.framesPushed, live.framesDropped, live.rectsSent, live.sendErrors);
+        FrameBrokerStats broker = getFrameBrokerStats();
+        Serial.printf("[loop] Frame-Broker: %u aufgenommen, %u geteilt, %u Referenzen, %u in Benutzung, Fehler %u, Timeouts %u\n",
+                      broker.framesCaptured, broker.framesShared, broker.deliveries, broker.framesInUse,
+                      broker.captureErrors, broker.waitTimeouts);
+        StreamStats stream = getStreamStats();
+        Serial.printf("[loop] MJPEG-Stream: %u Clients, Frames %u gesendet (%u KB), Kamera-Fehler %u, Sendefehler %u\n",
+                      stream.clients, stream.framesSent, stream.bytesSent / 1024, stream.cameraErrors, stream.sendErrors);
+        ColorRecorderStats rec = getColorRecorderStats();
+        if (rec.recording || rec.frames > 0) {
+            Serial.printf("[loop] Farb-Recorder: %s, %u Frames, %u / %u KB, verworfen %u\n",
+                          rec.recording ? "läuft" : "gestoppt", rec.frames, rec.bytes / 1024,
+                          rec.capacity / 1024, rec.framesDropped);
+        }
+        if (UDP_FANOUT) {
+            UdpFanoutStats udp = getUdpFanoutStats();
+            Serial.printf("[loop] UDP-Fan-out: Frames %u ok / %u fehlerhaft, Pakete %u, Fehler %u\n",
+                          udp.framesSent, udp.framesFailed, udp.packetsSent, udp.sendErrors);
+        }
+#if ALLOC_TRACKING
+        AllocStats alloc = getAllocStats();
+        Serial.printf("[loop] Allokationen: %u (%u KB), in der Frame-Schleife nach Warm-up %u (%u B), %u Frames\n",
+                      alloc.allocs, alloc.bytes / 1024, alloc.steadyAllocs, alloc.steadyBytes, alloc.frames);
+#endif
+        LogStats log = getLogStats();
+        Serial.printf("[loop] Log: %u Einträge, %u verloren\n", log.written, log.lost);
         lastHeartbeat = now;
     }
+    delay(100);
 }
@@ -0,0 +1,101 @@
+#include "reduce_worker.h"
+#include <esp_timer.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "color_reduce.h"
+#include "stage_metrics.h"
+
+// ============================================================================
+// STATE
+// ============================================================================
+
+// Auftrag an den Hilfs-Task. Schreibt nur der Analyse-Task, und nur solange
+// der Hilfs-Task schläft; die Notifications sorgen für die Sichtbarkeit.
+struct ReduceJob {
+    const uint8_t* buf;
+    int width;
+    int height;
+    const WindowRect* rects;
+    int count;
+    RGB* out;
+    TaskHandle_t caller;
+};
+
+static TaskHandle_t s_workerTask = nullptr;
+static ReduceJob s_job = {};
+
+// Nur der Analyse-Task schreibt, Lesen aus der API unter s_statsMux
+static portMUX_TYPE s_statsMux = portMUX_INITIALIZER_UNLOCKED;
+static ReduceWorkerStats s_stats = {};
+
+// ============================================================================
+// TASK
+// ============================================================================
+
+static void reduceWorkerTask(void* arg) {
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        {
+            StageTimer timer(STAGE_REDUCTION_CORE0);
+            calculateMeanRGB2Rects(s_job.buf, s_job.width, s_job.height, s_job.rects, s_job.count, s_job.out);
+        }
+        xTaskNotifyGive(s_job.caller);
+    }
+}
+
+// ============================================================================
+// API
+// ============================================================================
+
+bool initReduceWorker() {
+    if (xTaskCreatePinnedToCore(reduceWorkerTask, "reduce", REDUCE_WORKER_STACK, nullptr,
+                                REDUCE_WORKER_PRIORITY, &s_workerTask, REDUCE_WORKER_CORE) != pdPASS) {
+        s_workerTask = nullptr;
+        Serial.println("[reduce] ERROR: Hilfs-Task konnte nicht gestartet werden, Reduktion auf einem Kern");
+        return false;
+    }
+    Serial.printf("[reduce] Hilfs-Task gestartet (Core %d, Priorität %d)\n",
+                  REDUCE_WORKER_CORE, REDUCE_WORKER_PRIORITY);
+    return true;
+}
+
+void reduceRects(const uint8_t* buf, int width, int height, const WindowRect* rects, int count, RGB* out) {
+    int split = s_workerTask && count >= REDUCE_PARALLEL_MIN_RECTS
+              ? splitRectsByArea(rects, count, width, height) : 0;
+    if (split == 0 || split == count) {
+        StageTimer timer(STAGE_REDUCTION_CORE1);
+        calculateMeanRGB2Rects(buf, width, height, rects, count, out);
+        taskENTER_CRITICAL(&s_statsMux);
+        s_stats.singleFrames++;
+        taskEXIT_CRITICAL(&s_statsMux);
+        return;
+    }
+
+    // Vordere Hälfte an Core 0, hintere selbst
+    s_job = { buf, width, height, rects, split, out, xTaskGetCurrentTaskHandle() };
+    xTaskNotifyGive(s_workerTask);
+    {
+        StageTimer timer(STAGE_REDUCTION_CORE1);
+        calculateMeanRGB2Rects(buf, width, height, rects + split, count - split, out + split);
+    }
+
+    // Barriere: buf gehört danach wieder dem Aufrufer. Ohne Timeout, der
+    // Hilfs-Task liest sonst womöglich aus einem schon freigegebenen Puffer.
+    int64_t waitStartUs = esp_timer_get_time();
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    uint32_t waitUs = (uint32_t)(esp_timer_get_time() - waitStartUs);
+
+    taskENTER_CRITICAL(&s_statsMux);
+    s_stats.parallelFrames++;
+    if (waitUs > s_stats.barrierWaitMaxUs) {
+        s_stats.barrierWaitMaxUs = waitUs;
+    }
+    taskEXIT_CRITICAL(&s_statsMux);
+}
+
+ReduceWorkerStats getReduceWorkerStats() {
+    taskENTER_CRITICAL(&s_statsMux);
+    ReduceWorkerStats stats = s_stats;
+    taskEXIT_CRITICAL(&s_statsMux);
+    return stats;
+}
@@ -0,0 +1,34 @@
+#ifndef REDUCE_WORKER_H
+#define REDUCE_WORKER_H
+
+#include <Arduino.h>
+#include "ambilight_types.h"
+
+// Farbreduktion auf beiden Kernen: der Analyse-Task (Core 1) teilt die
+// Fenster per splitRectsByArea() nach Pixelzahl in zwei Hälften, ein
+// Hilfs-Task auf Core 0 rechnet die vordere, der Analyse-Task die hintere.
+// Danach wartet der Analyse-Task auf den Hilfs-Task (Task-Notification als
+// Barriere). Die Zeiten je Kern erscheinen in /api/metrics als
+// reduction_core0 und reduction_core1, reduction bleibt die Wandzeit.
+#define REDUCE_WORKER_CORE        0
+#define REDUCE_WORKER_PRIORITY    3      // wie der Analyse-Task, über HTTP und Capture
+#define REDUCE_WORKER_STACK       3072
+#define REDUCE_PARALLEL_MIN_RECTS 8      // darunter lohnt das Aufwecken nicht
+
+struct ReduceWorkerStats {
+    uint32_t parallelFrames;   // auf beide Kerne verteilt
+    uint32_t singleFrames;     // allein gerechnet (zu wenige Fenster, kein Hilfs-Task)
+    uint32_t barrierWaitMaxUs; // längste Wartezeit des Analyse-Tasks auf Core 0
+};
+
+// Startet den Hilfs-Task. Ohne ihn rechnet reduceRects() alles selbst.
+bool initReduceWorker();
+
+// calculateMeanRGB2() für alle rects nach out, auf beiden Kernen.
+// Nur aus dem Analyse-Task aufrufen; rects, buf und out müssen bis zur
+// Rückkehr gültig bleiben.
+void reduceRects(const uint8_t* buf, int width, int height, const WindowRect* rects, int count, RGB* out);
+
+ReduceWorkerStats getReduceWorkerStats();
+
+#endif // REDUCE_WORKER_H
@@ -0,0 +1,152 @@
+#include "sensor_crop.h"
+#include "esp_camera.h"
+#include "config.h"
+#include "deferred_log.h"
+
+// ============================================================================
+// SENSOR
+// ============================================================================
+
+// Standard-Bildgröße mit genau dieser Ausgabe, FRAMESIZE_INVALID wenn keine
+static framesize_t frameSizeFor(int width, int height) {
+    for (int i = 0; i < FRAMESIZE_INVALID; i++) {
+        if (resolution[i].width == width && resolution[i].height == height) {
+            return (framesize_t)i;
+        }
+    }
+    return FRAMESIZE_INVALID;
+}
+
+// OV2640 über esp32-camera. set_framesize() zuerst, esp_camera_fb_get()
+// nimmt Breite und Höhe der Frames aus status.framesize; set_res_raw()
+// überschreibt danach nur Fenster und Zoom.
+class CameraWindowPort : public SensorWindowPort {
+public:
+    bool setWindow(int mode, int offsetX, int offsetY, int width, int height,
+                   int outputWidth, int outputHeight) override {
+        sensor_t* s = esp_camera_sensor_get();
+        framesize_t size = frameSizeFor(outputWidth, outputHeight);
+        if (!s || s->id.PID != OV2640_PID || size == FRAMESIZE_INVALID) {
+            return false;
+        }
+        return s->set_framesize(s, size) == 0 &&
+               s->set_res_raw(s, mode, 0, 0, 0, offsetX, offsetY, width, height,
+                              outputWidth, outputHeight, false, false) == 0;
+    }
+
+    bool resetWindow() override {
+        sensor_t* s = esp_camera_sensor_get();
+        return s && s->set_framesize(s, SENSOR_CROP_FULL_FRAMESIZE) == 0;
+    }
+};
+
+// ============================================================================
+// STATE
+// ============================================================================
+
+// Anfragen aus anderen Tasks, übernimmt updateSensorCrop()
+static portMUX_TYPE s_requestMux = portMUX_INITIALIZER_UNLOCKED;
+static bool s_requestPending = SENSOR_CROP;
+static bool s_requestEnabled = SENSOR_CROP;
+static float s_requestMargin = SENSOR_CROP_MARGIN_DEFAULT;
+static int s_requestWidth = SENSOR_CROP_WIDTH_DEFAULT;
+static int s_requestHeight = SENSOR_CROP_HEIGHT_DEFAULT;
+
+// Nur im Analyse-Task
+static CameraWindowPort s_port;
+static bool s_enabled = false;
+static float s_margin = SENSOR_CROP_MARGIN_DEFAULT;
+static int s_outputWidth = SENSOR_CROP_WIDTH_DEFAULT;
+static int s_outputHeight = SENSOR_CROP_HEIGHT_DEFAULT;
+static uint32_t s_configVersion = 0;
+static SensorWindow s_window = fullSensorWindow();
+static int s_settleFrames = 0;
+
+// Kopie für getSensorCropStats(), unter s_requestMux
+static SensorCropStats s_stats = { SENSOR_CROP, false, fullSensorWindow(), 0, 0, 0 };
+
+// ============================================================================
+// AUSSCHNITT
+// ============================================================================
+
+void requestSensorCrop(bool enabled, float margin, int outputWidth, int outputHeight) {
+    taskENTER_CRITICAL(&s_requestMux);
+    s_requestPending = true;
+    s_requestEnabled = enabled;
+    s_requestMargin = margin;
+    s_requestWidth = outputWidth;
+    s_requestHeight = outputHeight;
+    s_stats.enabled = enabled;
+    taskEXIT_CRITICAL(&s_requestMux);
+}
+
+bool updateSensorCrop(const float corners[4][2], uint32_t configVersion) {
+    taskENTER_CRITICAL(&s_requestMux);
+    bool pending = s_requestPending;
+    if (pending) {
+        s_enabled = s_requestEnabled;
+        s_margin = s_requestMargin;
+        s_outputWidth = s_requestWidth;
+        s_outputHeight = s_requestHeight;
+        s_requestPending = false;
+    }
+    taskEXIT_CRITICAL(&s_requestMux);
+
+    if (!pending && (!s_enabled || configVersion == s_configVersion)) {
+        return false;
+    }
+    s_configVersion = configVersion;
+
+    SensorWindow window = s_enabled ? planSensorWindow(corners, s_margin, s_outputWidth, s_outputHeight)
+                                    : fullSensorWindow();
+    if (memcmp(&window, &s_window, sizeof(window)) == 0) {
+        return false;   // kleine Nachkalibrierung, gleicher Ausschnitt: Sensor nicht anfassen
+    }
+    bool ok = applySensorWindow(s_port, window);
+    if (ok) {
+        s_window = window;
+        s_settleFrames = SENSOR_CROP_SETTLE_FRAMES;
+        if (s_enabled) {
+            LOG_I("[crop] Ausschnitt %d+%d x %d+%d, Ausgabe %dx%d",
+                  window.offsetX, window.width, window.offsetY, window.height, window.outputWidth, window.outputHeight);
+        } else {
+            LOG_I("[crop] Volles Bild");
+        }
+    } else {
+        LOG_W("[crop] Ausschnitt %d+%d x %d+%d, Ausgabe %dx%d abgelehnt, bleibe beim vorigen",
+              window.offsetX, window.width, window.offsetY, window.height, window.outputWidth, window.outputHeight);
+    }
+
+    taskENTER_CRITICAL(&s_requestMux);
+    s_stats.active = s_window.outputWidth > 0;
+    s_stats.window = s_window;
+    if (ok) {
+        s_stats.updates++;
+    } else {
+        s_stats.failures++;
+    }
+    taskEXIT_CRITICAL(&s_requestMux);
+    return ok;
+}
+
+bool sensorCropSettling() {
+    if (s_settleFrames == 0) {
+        return false;
+    }
+    s_settleFrames--;
+    taskENTER_CRITICAL(&s_requestMux);
+    s_stats.framesDropped++;
+    taskEXIT_CRITICAL(&s_requestMux);
+    return true;
+}
+
+const SensorWindow& currentSensorWindow() {
+    return s_window;
+}
+
+SensorCropStats getSensorCropStats() {
+    taskENTER_CRITICAL(&s_requestMux);
+    SensorCropStats copy = s_stats;
+    taskEXIT_CRITICAL(&s_requestMux);
+    return copy;
+}
@@ -0,0 +1,44 @@
+#ifndef SENSOR_CROP_H
+#define SENSOR_CROP_H
+
+#include <Arduino.h>
+#include "sensor_window.h"
+
+// Ausschnitt auf dem Sensor: der OV2640 liefert nur das Rechteck um die
+// kalibrierten TV-Ecken plus Rand, vom DSP auf eine kleine Standardgröße
+// skaliert (planSensorWindow() in lib/hanawa_core). Der Analyse-Task setzt
+// ihn bei jeder neuen Kalibrierung neu und rechnet die Ecken auf den
+// Ausschnitt um; Stream und Weboberfläche zeigen dann ebenfalls nur ihn.
+// Ein- und Ausschalten per /api/crop, Startwert SENSOR_CROP in config.h.
+#define SENSOR_CROP_MARGIN_DEFAULT   0.05f        // Rand um die Ecken, Anteil am vollen Bild
+#define SENSOR_CROP_WIDTH_DEFAULT    320          // Ausgabe, muss eine Standard-Bildgröße sein
+#define SENSOR_CROP_HEIGHT_DEFAULT   240
+#define SENSOR_CROP_FULL_FRAMESIZE   FRAMESIZE_VGA  // ohne Ausschnitt, wie in init_camera()
+#define SENSOR_CROP_SETTLE_FRAMES    2            // Frames nach dem Umschalten verwerfen (fb_count)
+
+struct SensorCropStats {
+    bool enabled;            // angefordert
+    bool active;             // Ausschnitt gesetzt
+    SensorWindow window;     // aktueller Ausschnitt (fullSensorWindow() ohne)
+    uint32_t updates;        // gesetzte Ausschnitte
+    uint32_t failures;       // vom Sensor abgelehnt
+    uint32_t framesDropped;  // nach dem Umschalten verworfen
+};
+
+// Aus jedem Task; wirkt mit dem nächsten Analyse-Frame
+void requestSensorCrop(bool enabled, float margin, int outputWidth, int outputHeight);
+
+// Analyse-Task, vor jedem Frame: setzt den Ausschnitt nach einer Anfrage
+// oder neuer Kalibrierung (configVersion). corners normiert auf das volle
+// Bild. true = Ausschnitt hat sich geändert (Rechtecke neu veröffentlichen).
+bool updateSensorCrop(const float corners[4][2], uint32_t configVersion);
+
+// Analyse-Task: true = Frame stammt womöglich noch vom vorigen Ausschnitt
+bool sensorCropSettling();
+
+// Analyse-Task: aktueller Ausschnitt, ändert sich nur in updateSensorCrop()
+const SensorWindow& currentSensorWindow();
+
+SensorCropStats getSensorCropStats();
+
+#endif // SENSOR_CROP_H
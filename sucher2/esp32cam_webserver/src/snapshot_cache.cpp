@@ -0,0 +1,126 @@
+#include "snapshot_cache.h"
+#include <esp_timer.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// ============================================================================
+// STATE
+// ============================================================================
+
+struct SnapshotBuffer {
+    uint8_t* data;           // PSRAM, wächst bei Bedarf
+    size_t capacity;
+    SnapshotFrame frame;
+    int refs;                // HTTP-Handler, die den Puffer gerade senden
+};
+
+// Schützt Puffer-Metadaten und s_latest, Kopieren geschieht außerhalb
+static portMUX_TYPE s_cacheMux = portMUX_INITIALIZER_UNLOCKED;
+static SnapshotBuffer s_buffers[SNAPSHOT_CACHE_BUFFERS];
+static int s_latest = -1;
+
+// millis() des letzten Abrufs, 0 = noch nie
+static volatile uint32_t s_lastRequestMs = 0;
+
+static volatile SnapshotCacheStats s_stats = {0, 0, 0, 0};
+
+// ============================================================================
+// ANALYSE-SEITE
+// ============================================================================
+
+void storeSnapshotFrame(const camera_fb_t* fb, uint32_t sequence) {
+    uint32_t lastRequest = s_lastRequestMs;
+    if (lastRequest == 0 || millis() - lastRequest > SNAPSHOT_CACHE_HOLD_MS) {
+        return;   // niemand schaut zu
+    }
+    if (!fb || fb->format != PIXFORMAT_JPEG) {
+        return;
+    }
+
+    // Freien Puffer suchen: nicht der neueste und von keinem Handler belegt.
+    // Nur dieser Task schreibt, ein so gefundener Puffer gehört ihm allein.
+    int slot = -1;
+    taskENTER_CRITICAL(&s_cacheMux);
+    for (int i = 0; i < SNAPSHOT_CACHE_BUFFERS; i++) {
+        if (i != s_latest && s_buffers[i].refs == 0) {
+            slot = i;
+            break;
+        }
+    }
+    taskEXIT_CRITICAL(&s_cacheMux);
+    if (slot < 0) {
+        s_stats.storeErrors++;
+        return;
+    }
+
+    SnapshotBuffer& buf = s_buffers[slot];
+    if (buf.capacity < fb->len) {
+        // Mit Reserve wachsen, JPEG-Größen schwanken von Frame zu Frame
+        size_t capacity = fb->len + fb->len / 4;
+        free(buf.data);
+        buf.data = (uint8_t*)(psramFound() ? ps_malloc(capacity) : malloc(capacity));
+        buf.capacity = buf.data ? capacity : 0;
+        if (!buf.data) {
+            s_stats.storeErrors++;
+            return;
+        }
+    }
+    memcpy(buf.data, fb->buf, fb->len);
+    buf.frame.jpeg = buf.data;
+    buf.frame.len = fb->len;
+    buf.frame.width = fb->width;
+    buf.frame.height = fb->height;
+    buf.frame.sequence = sequence;
+    buf.frame.captureUs = (int64_t)fb->timestamp.tv_sec * 1000000LL + fb->timestamp.tv_usec;
+
+    taskENTER_CRITICAL(&s_cacheMux);
+    s_latest = slot;
+    taskEXIT_CRITICAL(&s_cacheMux);
+    s_stats.framesStored++;
+}
+
+// ============================================================================
+// HTTP-SEITE
+// ============================================================================
+
+bool acquireSnapshotFrame(SnapshotFrame* frame, uint32_t maxAgeMs) {
+    uint32_t now = millis();
+    s_lastRequestMs = now ? now : 1;
+
+    bool found = false;
+    int64_t oldestUs = esp_timer_get_time() - (int64_t)maxAgeMs * 1000;
+    taskENTER_CRITICAL(&s_cacheMux);
+    if (s_latest >= 0 && s_buffers[s_latest].frame.captureUs >= oldestUs) {
+        s_buffers[s_latest].refs++;
+        *frame = s_buffers[s_latest].frame;
+        found = true;
+    }
+    taskEXIT_CRITICAL(&s_cacheMux);
+
+    if (found) {
+        s_stats.hits++;
+    } else {
+        s_stats.misses++;
+    }
+    return found;
+}
+
+void releaseSnapshotFrame(const SnapshotFrame* frame) {
+    taskENTER_CRITICAL(&s_cacheMux);
+    for (int i = 0; i < SNAPSHOT_CACHE_BUFFERS; i++) {
+        if (s_buffers[i].data == frame->jpeg && s_buffers[i].refs > 0) {
+            s_buffers[i].refs--;
+            break;
+        }
+    }
+    taskEXIT_CRITICAL(&s_cacheMux);
+}
+
+SnapshotCacheStats getSnapshotCacheStats() {
+    SnapshotCacheStats copy;
+    copy.framesStored = s_stats.framesStored;
+    copy.hits = s_stats.hits;
+    copy.misses = s_stats.misses;
+    copy.storeErrors = s_stats.storeErrors;
+    return copy;
+}
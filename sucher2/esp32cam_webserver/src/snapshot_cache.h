@@ -0,0 +1,43 @@
+#ifndef SNAPSHOT_CACHE_H
+#define SNAPSHOT_CACHE_H
+
+#include <Arduino.h>
+#include "esp_camera.h"
+
+// Zuletzt analysierter JPEG-Frame für /api/snapshot. Der Analyse-Task legt
+// eine Kopie ab, solange jemand Snapshots abruft; /api/snapshot liefert sie
+// ohne eigene Aufnahme aus. Mehrere Puffer mit Referenzzähler, damit der
+// Analyse-Task nie auf einen lesenden HTTP-Handler warten muss.
+#define SNAPSHOT_CACHE_BUFFERS   3        // neuester + einer im Versand + einer zum Schreiben
+#define SNAPSHOT_CACHE_HOLD_MS   5000     // so lange nach dem letzten Abruf weiter kopieren
+
+struct SnapshotFrame {
+    const uint8_t* jpeg;
+    size_t len;
+    uint16_t width;
+    uint16_t height;
+    uint32_t sequence;       // AmbilightResult::sequence des analysierten Frames
+    int64_t captureUs;       // Capture-Zeitpunkt (esp_timer-Basis)
+};
+
+struct SnapshotCacheStats {
+    uint32_t framesStored;   // vom Analyse-Task kopierte Frames
+    uint32_t hits;           // aus dem Cache ausgelieferte Snapshots
+    uint32_t misses;         // kein aktueller Frame im Cache
+    uint32_t storeErrors;    // kein freier Puffer / kein Speicher
+};
+
+// Vom Analyse-Task für jeden analysierten Frame aufgerufen (vor releaseFrame()).
+// Kopiert nur, wenn in den letzten SNAPSHOT_CACHE_HOLD_MS ein Snapshot
+// angefragt wurde, sonst kostet der Aufruf nichts.
+void storeSnapshotFrame(const camera_fb_t* fb, uint32_t sequence);
+
+// Neuester Frame, höchstens maxAgeMs alt (ab Capture). Meldet zugleich
+// Bedarf an, damit der Analyse-Task wieder kopiert. false = keiner vorhanden.
+// Jeder erfolgreich geholte Frame muss mit releaseSnapshotFrame() zurück.
+bool acquireSnapshotFrame(SnapshotFrame* frame, uint32_t maxAgeMs);
+void releaseSnapshotFrame(const SnapshotFrame* frame);
+
+SnapshotCacheStats getSnapshotCacheStats();
+
+#endif // SNAPSHOT_CACHE_H
@@ -0,0 +1,329 @@
+#include "stream_server.h"
+#include <WiFi.h>
+#include <esp_http_server.h>
+#include <esp_timer.h>
+#include <unistd.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "frame_broker.h"
+#include "frame_recording.h"
+#include "trace.h"
+
+#define STREAM_BOUNDARY       "hanawaframe"
+#define STREAM_PART_MAX       128
+#define STREAM_FRAME_TIMEOUT_MS 1000
+#define STREAM_IDLE_RETRY_MS  50     // Wartezeit nach einem Frame-Timeout
+
+// ============================================================================
+// STATE
+// ============================================================================
+
+static httpd_handle_t s_streamHttpd = nullptr;
+static TaskHandle_t s_streamTask = nullptr;
+static int s_frameConsumer = -1;
+
+// Schützt s_clients. Der Stream-Task hält ihn während des Sendens, damit
+// onSessionClosed() keinen Socket schließt, auf den gerade geschrieben wird.
+static SemaphoreHandle_t s_lock = nullptr;
+
+struct StreamClient {
+    int fd;                  // -1 = frei
+    int64_t intervalUs;      // Mindestabstand zwischen zwei Frames
+    int64_t nextDueUs;       // frühester Zeitpunkt für den nächsten Frame
+    bool recording;          // /record: Aufnahme-Container statt MJPEG
+    int64_t endUs;           // /record: Ende der Aufnahme
+};
+static StreamClient s_clients[STREAM_MAX_CLIENTS];
+static volatile int s_clientCount = 0;
+
+static volatile StreamStats s_stats = {0, 0, 0, 0, 0};
+
+// ============================================================================
+// CLIENTS
+// ============================================================================
+
+// Aufrufer hält s_lock
+static bool addClientLocked(int fd, int fps, int recordSeconds) {
+    for (int i = 0; i < STREAM_MAX_CLIENTS; i++) {
+        if (s_clients[i].fd < 0) {
+            s_clients[i].fd = fd;
+            s_clients[i].intervalUs = 1000000LL / fps;
+            s_clients[i].nextDueUs = INT64_MAX;   // erst nach dem Response-Header beliefern
+            s_clients[i].recording = recordSeconds > 0;
+            s_clients[i].endUs = esp_timer_get_time() + recordSeconds * 1000000LL;
+            s_clientCount++;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Aufrufer hält s_lock. Header ist gesendet, ab jetzt Frames schicken.
+static void activateClientLocked(int fd) {
+    for (int i = 0; i < STREAM_MAX_CLIENTS; i++) {
+        if (s_clients[i].fd == fd) {
+            s_clients[i].nextDueUs = 0;
+        }
+    }
+}
+
+// Aufrufer hält s_lock
+static void removeClientLocked(int fd) {
+    for (int i = 0; i < STREAM_MAX_CLIENTS; i++) {
+        if (s_clients[i].fd == fd) {
+            s_clients[i].fd = -1;
+            s_clientCount--;
+        }
+    }
+}
+
+// Vom httpd beim Schließen jeder Session aufgerufen
+static void onSessionClosed(httpd_handle_t hd, int sockfd) {
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    removeClientLocked(sockfd);
+    xSemaphoreGive(s_lock);
+    close(sockfd);
+}
+
+// Schreibt den ganzen Puffer direkt auf den Socket der Session
+static bool sendAll(int fd, const uint8_t* data, size_t len) {
+    while (len > 0) {
+        int n = httpd_socket_send(s_streamHttpd, fd, (const char*)data, len, 0);
+        if (n <= 0) {
+            return false;
+        }
+        data += n;
+        len -= n;
+    }
+    return true;
+}
+
+// ============================================================================
+// STREAM-TASK
+// ============================================================================
+
+// Sendet einen Kamera-Frame an alle fälligen Clients. Der JPEG-Puffer der
+// Kamera geht ohne Kopie auf die Sockets und wird erst danach freigegeben.
+static void sendFrame(camera_fb_t* fb) {
+    TRACE_SPAN("wifi", "mjpeg_send");
+    char part[STREAM_PART_MAX];
+    int64_t captureUs = (int64_t)fb->timestamp.tv_sec * 1000000LL + fb->timestamp.tv_usec;
+    int partLen = snprintf(part, sizeof(part),
+                           "\r\n--" STREAM_BOUNDARY "\r\n"
+                           "Content-Type: image/jpeg\r\n"
+                           "Content-Length: %u\r\n"
+                           "X-Timestamp: %lld\r\n\r\n",
+                           (unsigned)fb->len, (long long)captureUs);
+
+    // Frame-Header für Aufnahmen (frame_recording.h)
+    uint8_t recordHeader[RECORDING_FRAME_HEADER];
+    RecordingFrameHeader info = { captureUs, (uint32_t)fb->len, (uint16_t)fb->width, (uint16_t)fb->height };
+    recordingWriteFrameHeader(recordHeader, info);
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    int64_t now = esp_timer_get_time();
+    for (int i = 0; i < STREAM_MAX_CLIENTS; i++) {
+        StreamClient& c = s_clients[i];
+        if (c.fd < 0 || c.nextDueUs > now) continue;
+
+        if (c.recording && now >= c.endUs) {
+            // Aufnahme vollständig: Verbindung schließen beendet die Datei
+            httpd_sess_trigger_close(s_streamHttpd, c.fd);
+            c.fd = -1;
+            s_clientCount--;
+            continue;
+        }
+        bool sent = c.recording
+            ? sendAll(c.fd, recordHeader, sizeof(recordHeader)) && sendAll(c.fd, fb->buf, fb->len)
+            : sendAll(c.fd, (const uint8_t*)part, partLen) && sendAll(c.fd, fb->buf, fb->len);
+        if (!sent) {
+            // Session asynchron schließen lassen, ab sofort nicht mehr beliefern
+            s_stats.sendErrors++;
+            httpd_sess_trigger_close(s_streamHttpd, c.fd);
+            c.fd = -1;
+            s_clientCount--;
+            continue;
+        }
+        c.nextDueUs = now + c.intervalUs;
+        s_stats.framesSent++;
+        s_stats.bytesSent += fb->len;
+    }
+    xSemaphoreGive(s_lock);
+}
+
+static void streamTask(void* arg) {
+    for (;;) {
+        // Nächsten fälligen Client bestimmen
+        int64_t nextDueUs = INT64_MAX;
+        xSemaphoreTake(s_lock, portMAX_DELAY);
+        for (int i = 0; i < STREAM_MAX_CLIENTS; i++) {
+            if (s_clients[i].fd >= 0 && s_clients[i].nextDueUs < nextDueUs) {
+                nextDueUs = s_clients[i].nextDueUs;
+            }
+        }
+        xSemaphoreGive(s_lock);
+
+        if (nextDueUs == INT64_MAX) {
+            // Niemand schaut zu: schlafen bis zum nächsten Client, keine Kamerazugriffe
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            continue;
+        }
+        int64_t waitUs = nextDueUs - esp_timer_get_time();
+        if (waitUs > 0) {
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(waitUs / 1000) + 1);
+            continue;
+        }
+
+        camera_fb_t* fb = acquireFrame(s_frameConsumer, STREAM_FRAME_TIMEOUT_MS);
+        if (!fb || fb->format != PIXFORMAT_JPEG) {
+            releaseFrame(fb);
+            s_stats.cameraErrors++;
+            vTaskDelay(pdMS_TO_TICKS(STREAM_IDLE_RETRY_MS));
+            continue;
+        }
+        sendFrame(fb);
+        releaseFrame(fb);
+    }
+}
+
+// ============================================================================
+// HANDLER
+// ============================================================================
+
+// Nimmt den Client auf und schickt nur den Response-Header. Der Handler kehrt
+// sofort zurück, die Frames schreibt der Stream-Task direkt auf den Socket –
+// so blockiert ein Stream weder den httpd-Task noch andere Clients.
+//
+// /stream: MJPEG. /record: Aufnahme-Container (frame_recording.h) für
+// ?s= Sekunden, danach schließt der Server die Verbindung.
+static esp_err_t streamHandler(httpd_req_t* req) {
+    bool recording = strcmp(req->uri, "/record") == 0 || strncmp(req->uri, "/record?", 8) == 0;
+    int fps = STREAM_MAX_FPS;
+    int seconds = recording ? STREAM_RECORD_DEFAULT_S : 0;
+    char query[48];
+    char value[8];
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+        if (httpd_query_key_value(query, "fps", value, sizeof(value)) == ESP_OK) {
+            fps = constrain(atoi(value), 1, STREAM_MAX_FPS);
+        }
+        if (recording && httpd_query_key_value(query, "s", value, sizeof(value)) == ESP_OK) {
+            seconds = constrain(atoi(value), 1, STREAM_RECORD_MAX_S);
+        }
+    }
+
+    static const char mjpegHeader[] =
+        "HTTP/1.1 200 OK\r\n"
+        "Content-Type: multipart/x-mixed-replace;boundary=" STREAM_BOUNDARY "\r\n"
+        "Access-Control-Allow-Origin: *\r\n"
+        "Cache-Control: no-cache, no-store, must-revalidate\r\n"
+        "Connection: close\r\n\r\n";
+    static const char recordHeader[] =
+        "HTTP/1.1 200 OK\r\n"
+        "Content-Type: application/octet-stream\r\n"
+        "Content-Disposition: attachment; filename=\"hanawa.hrec\"\r\n"
+        "Access-Control-Allow-Origin: *\r\n"
+        "Cache-Control: no-cache, no-store, must-revalidate\r\n"
+        "Connection: close\r\n\r\n";
+
+    int fd = httpd_req_to_sockfd(req);
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    bool added = addClientLocked(fd, fps, seconds);
+    xSemaphoreGive(s_lock);
+    if (!added) {
+        Serial.println("[stream] Zu viele Clients, Verbindung abgelehnt");
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Too many clients");
+        return ESP_OK;
+    }
+
+    // Response-Header (bei /record mit Datei-Header) vor dem ersten Frame
+    uint8_t fileHeader[RECORDING_FILE_HEADER];
+    recordingWriteFileHeader(fileHeader);
+    bool ok = recording
+        ? httpd_send(req, recordHeader, sizeof(recordHeader) - 1) >= 0 &&
+          httpd_send(req, (const char*)fileHeader, sizeof(fileHeader)) >= 0
+        : httpd_send(req, mjpegHeader, sizeof(mjpegHeader) - 1) >= 0;
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    if (ok) {
+        activateClientLocked(fd);
+    } else {
+        removeClientLocked(fd);
+    }
+    xSemaphoreGive(s_lock);
+    if (!ok) {
+        return ESP_FAIL;
+    }
+
+    if (recording) {
+        Serial.printf("[stream] Aufnahme gestartet (fd %d, %d FPS, %d s)\n", fd, fps, seconds);
+    } else {
+        Serial.printf("[stream] Client verbunden (fd %d, %d FPS, %d aktiv)\n", fd, fps, s_clientCount);
+    }
+    xTaskNotifyGive(s_streamTask);
+    return ESP_OK;
+}
+
+// ============================================================================
+// INIT
+// ============================================================================
+
+bool initStreamServer() {
+    for (int i = 0; i < STREAM_MAX_CLIENTS; i++) {
+        s_clients[i].fd = -1;
+    }
+    s_lock = xSemaphoreCreateMutex();
+    if (!s_lock) {
+        Serial.println("[stream] ERROR: Mutex konnte nicht erstellt werden");
+        return false;
+    }
+
+    s_frameConsumer = registerFrameConsumer("stream");
+    if (s_frameConsumer < 0) {
+        return false;
+    }
+
+    if (xTaskCreatePinnedToCore(streamTask, "stream", 4096, nullptr, STREAM_TASK_PRIORITY,
+                                &s_streamTask, STREAM_TASK_CORE) != pdPASS) {
+        Serial.println("[stream] ERROR: Task konnte nicht gestartet werden");
+        return false;
+    }
+
+    httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+    config.server_port = STREAM_PORT;
+    config.ctrl_port = STREAM_PORT + 32768;        // eigener Steuer-Port je httpd-Instanz
+    config.max_open_sockets = STREAM_MAX_CLIENTS + 1;
+    config.lru_purge_enable = true;
+    config.send_wait_timeout = STREAM_SEND_TIMEOUT;
+    config.task_priority = tskIDLE_PRIORITY + 1;
+    config.core_id = STREAM_TASK_CORE;
+    config.close_fn = onSessionClosed;
+
+    if (httpd_start(&s_streamHttpd, &config) != ESP_OK) {
+        Serial.println("[stream] ERROR: httpd_start fehlgeschlagen");
+        return false;
+    }
+
+    httpd_uri_t streamUri = {};
+    streamUri.uri = "/stream";
+    streamUri.method = HTTP_GET;
+    streamUri.handler = streamHandler;
+    httpd_register_uri_handler(s_streamHttpd, &streamUri);
+    streamUri.uri = "/record";
+    httpd_register_uri_handler(s_streamHttpd, &streamUri);
+
+    Serial.printf("[stream] MJPEG bereit: http://%s:%d/stream (max. %d FPS pro Client)\n",
+                  WiFi.localIP().toString().c_str(), STREAM_PORT, STREAM_MAX_FPS);
+    Serial.printf("[stream] Aufnahme: http://%s:%d/record?s=%d\n",
+                  WiFi.localIP().toString().c_str(), STREAM_PORT, STREAM_RECORD_DEFAULT_S);
+    return true;
+}
+
+StreamStats getStreamStats() {
+    StreamStats copy;
+    copy.clients = s_clientCount;
+    copy.framesSent = s_stats.framesSent;
+    copy.bytesSent = s_stats.bytesSent;
+    copy.cameraErrors = s_stats.cameraErrors;
+    copy.sendErrors = s_stats.sendErrors;
+    return copy;
+}
@@ -0,0 +1,34 @@
+#ifndef STREAM_SERVER_H
+#define STREAM_SERVER_H
+
+#include <Arduino.h>
+
+// MJPEG-Stream (multipart/x-mixed-replace) auf eigenem esp_http_server und
+// eigenem Task. Die JPEG-Puffer der Kamera werden unverändert gesendet
+// (kein Dekodieren/Neukodieren), ein Frame für alle fälligen Clients.
+// /record liefert dieselben Frames mit Zeitstempel als Aufnahme-Container
+// (frame_recording.h) für die Wiedergabe im Host-Build.
+#define STREAM_PORT           82
+#define STREAM_MAX_CLIENTS    3
+#define STREAM_MAX_FPS        10    // Obergrenze pro Client, per ?fps= weiter senkbar
+#define STREAM_RECORD_DEFAULT_S 10  // /record ohne ?s=
+#define STREAM_RECORD_MAX_S   600
+#define STREAM_SEND_TIMEOUT   1     // s, danach wird ein hängender Client getrennt
+#define STREAM_TASK_CORE      0     // Analyse-Task läuft auf Core 1
+#define STREAM_TASK_PRIORITY  1     // unter dem Analyse-Task
+
+struct StreamStats {
+    uint32_t clients;        // aktuell verbundene Clients
+    uint32_t framesSent;     // an einzelne Clients gesendete Frames
+    uint32_t bytesSent;      // JPEG-Nutzdaten
+    uint32_t cameraErrors;   // kein Frame vom Frame-Broker
+    uint32_t sendErrors;     // fehlgeschlagene Sends, Client wurde getrennt
+};
+
+// Startet Server (http://<ip>:STREAM_PORT/stream und /record) und Stream-Task.
+// Nach dem WLAN-Connect aufrufen.
+bool initStreamServer();
+
+StreamStats getStreamStats();
+
+#endif // STREAM_SERVER_H
@@ -0,0 +1,228 @@
+#include "trace.h"
+
+#if TRACE_ENABLED
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <new>
+
+#ifdef ESP_PLATFORM
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#endif
+
+// ============================================================================
+// STATE
+// ============================================================================
+
+// Ein Platz im Ring. seq = Index + 1 wenn gültig, 0 während des Schreibens
+// (gleiches Verfahren wie deferred_log.cpp).
+struct TraceSlot {
+    std::atomic<uint32_t> seq;
+    uint16_t core;
+    int64_t startUs;
+    uint32_t durUs;
+    const char* cat;
+    const char* name;
+    const char* task;     // FreeRTOS-Taskname bzw. traceSetThreadName()
+};
+
+// Der Ring liegt im PSRAM, der Schreibzeiger im internen RAM: atomare
+// Read-Modify-Write-Befehle (fetch_add) gehen auf dem ESP32 nicht im PSRAM.
+static TraceSlot* s_ring = nullptr;
+static std::atomic<uint32_t> s_head(0);
+
+static_assert((TRACE_RING_EVENTS & (TRACE_RING_EVENTS - 1)) == 0, "TRACE_RING_EVENTS muss eine Zweierpotenz sein");
+
+#ifndef ESP_PLATFORM
+static thread_local const char* s_threadName = "host";
+#endif
+
+// ============================================================================
+// ERFASSUNG
+// ============================================================================
+
+static void onStage(MetricStage stage, uint32_t us) {
+    traceComplete("stage", metricStageName(stage), metricsNowUs() - us, us);
+}
+
+bool initTrace() {
+    if (s_ring) {
+        return true;
+    }
+    size_t bytes = sizeof(TraceSlot) * TRACE_RING_EVENTS;
+#ifdef ESP_PLATFORM
+    void* mem = heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!mem) {
+        Serial.println("[trace] ERROR: Kein PSRAM für den Trace-Puffer");
+        return false;
+    }
+#else
+    void* mem = malloc(bytes);
+    if (!mem) {
+        return false;
+    }
+#endif
+    TraceSlot* ring = (TraceSlot*)mem;
+    for (int i = 0; i < TRACE_RING_EVENTS; i++) {
+        new (&ring[i]) TraceSlot();
+        ring[i].seq.store(0, std::memory_order_relaxed);
+    }
+    s_ring = ring;
+    setStageHook(onStage);
+#ifdef ESP_PLATFORM
+    Serial.printf("[trace] Puffer bereit: %d Spannen (%u KB PSRAM)\n", TRACE_RING_EVENTS, (unsigned)(bytes / 1024));
+#endif
+    return true;
+}
+
+void traceComplete(const char* cat, const char* name, int64_t startUs, uint32_t durUs) {
+    TraceSlot* ring = s_ring;
+    if (!ring) {
+        return;
+    }
+    uint32_t index = s_head.fetch_add(1, std::memory_order_relaxed);
+    TraceSlot& slot = ring[index & (TRACE_RING_EVENTS - 1)];
+
+    slot.seq.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot.startUs = startUs;
+    slot.durUs = durUs;
+    slot.cat = cat;
+    slot.name = name;
+#ifdef ESP_PLATFORM
+    slot.task = pcTaskGetTaskName(nullptr);
+    slot.core = xPortGetCoreID();
+#else
+    slot.task = s_threadName;
+    slot.core = 0;
+#endif
+
+    slot.seq.store(index + 1, std::memory_order_release);
+}
+
+void traceSetThreadName(const char* name) {
+#ifndef ESP_PLATFORM
+    s_threadName = name;
+#else
+    (void)name;   // FreeRTOS kennt die Tasknamen selbst
+#endif
+}
+
+TraceStats getTraceStats() {
+    TraceStats stats;
+    stats.recorded = s_head.load(std::memory_order_relaxed);
+    stats.capacity = s_ring ? TRACE_RING_EVENTS : 0;
+    return stats;
+}
+
+// ============================================================================
+// AUSGABE
+// ============================================================================
+
+// Sammelt kurze Stücke und gibt sie in Blöcken an den Writer weiter
+struct TraceOut {
+    TraceWriter writer;
+    void* ctx;
+    char buf[1024];
+    size_t len;
+    bool ok;
+};
+
+static void flush(TraceOut& out) {
+    if (out.ok && out.len > 0) {
+        out.ok = out.writer(out.ctx, out.buf, out.len);
+    }
+    out.len = 0;
+}
+
+static void emit(TraceOut& out, const char* text, int n) {
+    if (n <= 0) {
+        return;
+    }
+    if (out.len + n > sizeof(out.buf)) {
+        flush(out);
+    }
+    if ((size_t)n > sizeof(out.buf)) {
+        n = sizeof(out.buf);
+    }
+    memcpy(out.buf + out.len, text, n);
+    out.len += n;
+}
+
+uint32_t exportTraceJson(uint32_t windowMs, TraceWriter writer, void* ctx) {
+    TraceOut out;
+    out.writer = writer;
+    out.ctx = ctx;
+    out.len = 0;
+    out.ok = true;
+
+    // Tasks bekommen in der Reihenfolge ihres Auftretens eine tid
+    const char* tasks[TRACE_MAX_TASKS];
+    int taskCount = 0;
+    uint32_t exported = 0;
+    char line[256];
+
+    static const char HEADER[] =
+        "{\"displayTimeUnit\":\"ms\",\"traceEvents\":["
+        "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"hanawa\"}}";
+    emit(out, HEADER, sizeof(HEADER) - 1);
+
+    TraceSlot* ring = s_ring;
+    uint32_t head = s_head.load(std::memory_order_acquire);
+    uint32_t first = head > TRACE_RING_EVENTS ? head - TRACE_RING_EVENTS : 0;
+    int64_t fromUs = metricsNowUs() - (int64_t)windowMs * 1000;
+
+    for (uint32_t i = first; ring && i != head && out.ok; i++) {
+        TraceSlot& slot = ring[i & (TRACE_RING_EVENTS - 1)];
+        uint32_t before = slot.seq.load(std::memory_order_acquire);
+        if (before != i + 1) {
+            continue;   // wird gerade geschrieben oder schon überholt
+        }
+        int64_t startUs = slot.startUs;
+        uint32_t durUs = slot.durUs;
+        const char* cat = slot.cat;
+        const char* name = slot.name;
+        const char* task = slot.task;
+        unsigned core = slot.core;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.seq.load(std::memory_order_relaxed) != before) {
+            continue;
+        }
+        if (startUs + durUs < fromUs) {
+            continue;
+        }
+
+        int tid = 0;
+        while (tid < taskCount && tasks[tid] != task) {
+            tid++;
+        }
+        if (tid == taskCount && taskCount < TRACE_MAX_TASKS) {
+            tasks[taskCount++] = task;
+        }
+        int n = snprintf(line, sizeof(line),
+                         ",{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%lld,\"dur\":%u,"
+                         "\"pid\":1,\"tid\":%d,\"args\":{\"core\":%u}}",
+                         name, cat, (long long)startUs, (unsigned)durUs, tid + 1, core);
+        emit(out, line, n);
+        exported++;
+    }
+
+    // Namen der Tasks als Metadaten, damit Perfetto die Spuren beschriftet
+    for (int t = 0; t < taskCount; t++) {
+        int n = snprintf(line, sizeof(line),
+                         ",{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                         t + 1, tasks[t] ? tasks[t] : "?");
+        emit(out, line, n);
+    }
+    emit(out, "]}", 2);
+    flush(out);
+    return exported;
+}
+
+#endif // TRACE_ENABLED
@@ -0,0 +1,76 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+// Zeitleiste einzelner Frames: Spannen (Beginn + Dauer) mit Task und Core
+// landen in einem festen Ringpuffer (auf dem ESP32 im PSRAM) und werden als
+// Chrome-Trace-JSON exportiert (/api/trace, ansehen in ui.perfetto.dev oder
+// chrome://tracing). Alle Stufen aus stage_metrics.h kommen automatisch mit,
+// weitere Stellen markiert TRACE_SPAN(kategorie, name).
+//
+// Mit -DTRACE_ENABLED=0 verschwinden alle Makros und der Puffer; aktiv kostet
+// eine Spanne zwei Zeitstempel und einen Ringpuffer-Eintrag.
+// Plattformunabhängig (Host-Tests und Replay), Task-Name auf dem Rechner per
+// traceSetThreadName().
+
+#include <stddef.h>
+#include <stdint.h>
+#include "stage_metrics.h"
+
+#ifndef TRACE_ENABLED
+#define TRACE_ENABLED 1
+#endif
+
+#define TRACE_RING_EVENTS   4096   // Zweierpotenz, 32 Byte je Eintrag
+#define TRACE_MAX_TASKS     24     // verschiedene Tasks/Threads im Export
+#define TRACE_DEFAULT_MS    2000   // /api/trace ohne ?ms=
+
+struct TraceStats {
+    uint32_t recorded;   // insgesamt geschriebene Spannen
+    uint32_t capacity;   // Einträge im Ring (0 = nicht initialisiert)
+};
+
+// Bekommt den exportierten Text stückweise; false bricht den Export ab
+typedef bool (*TraceWriter)(void* ctx, const char* data, size_t len);
+
+#if TRACE_ENABLED
+
+// Legt den Ring an und hängt sich an recordStage(). Ohne Aufruf wird nichts
+// aufgezeichnet.
+bool initTrace();
+
+// Spanne mit bekanntem Beginn; cat und name müssen Literale sein
+void traceComplete(const char* cat, const char* name, int64_t startUs, uint32_t durUs);
+
+// Setzt den Namen des aufrufenden Threads (nur auf dem Rechner nötig)
+void traceSetThreadName(const char* name);
+
+// Schreibt alle Spannen der letzten windowMs als Chrome-Trace-JSON.
+// Liefert die Zahl der exportierten Spannen.
+uint32_t exportTraceJson(uint32_t windowMs, TraceWriter writer, void* ctx);
+
+TraceStats getTraceStats();
+
+// Misst vom Konstruktor bis zum Ende des Blocks
+class TraceSpan {
+public:
+    TraceSpan(const char* cat, const char* name) : m_cat(cat), m_name(name), m_startUs(metricsNowUs()) {}
+    ~TraceSpan() { traceComplete(m_cat, m_name, m_startUs, (uint32_t)(metricsNowUs() - m_startUs)); }
+private:
+    const char* m_cat;
+    const char* m_name;
+    int64_t m_startUs;
+};
+
+#define TRACE_CONCAT2(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT2(a, b)
+#define TRACE_SPAN(cat, name) TraceSpan TRACE_CONCAT(traceSpan_, __LINE__)((cat), (name))
+#define TRACE_THREAD_NAME(name) traceSetThreadName(name)
+
+#else
+
+#define TRACE_SPAN(cat, name) ((void)0)
+#define TRACE_THREAD_NAME(name) ((void)0)
+
+#endif // TRACE_ENABLED
+
+#endif // TRACE_H
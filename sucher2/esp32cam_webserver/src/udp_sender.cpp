@@ -0,0 +1,103 @@
+#include "udp_sender.h"
+#include <WiFi.h>
+#include <WiFiUdp.h>
+#include "esp_timer.h"
+#include "config.h"
+#include "windows.h"
+#include "ambilight_protocol.h"
+#include "stage_metrics.h"
+
+// ============================================================================
+// STATE
+// ============================================================================
+
+static WiFiUDP s_udp;
+static IPAddress s_group;
+
+// Eigener Paketpuffer, unabhängig vom ESP-NOW-Sender
+static AmbilightFrameEncoder s_encoder;
+
+static UdpFanoutStats s_stats = {0, 0, 0, 0, 0};
+
+// ============================================================================
+// UDP TRANSPORT
+// ============================================================================
+
+// Gleiche Pakete wie über ESP-NOW, je Fragment ein Multicast-Datagramm
+class UdpMulticastTransport : public AmbilightTransport {
+public:
+    bool sendPacket(const uint8_t* data, size_t len) override {
+        if (!s_udp.beginPacket(s_group, UDP_FANOUT_PORT) ||
+            s_udp.write(data, len) != len ||
+            !s_udp.endPacket()) {
+            s_stats.sendErrors++;
+            return false;
+        }
+        s_stats.packetsSent++;
+        return true;
+    }
+};
+
+static UdpMulticastTransport s_transport;
+
+// ============================================================================
+// PUBLIKATION
+// ============================================================================
+
+static void onAmbilightResult(const AmbilightResult& result) {
+    AmbilightSides sides = {
+        result.topColors.data(),    (int)result.topColors.size(),
+        result.rightColors.data(),  (int)result.rightColors.size(),
+        result.bottomColors.data(), (int)result.bottomColors.size(),
+        result.leftColors.data(),   (int)result.leftColors.size()
+    };
+    AmbilightFrameMeta meta = {
+        result.sequence,
+        (uint32_t)result.captureUs,
+        ESPNOW_DEADLINE_MS
+    };
+
+    StageTimer serializeTimer(STAGE_SERIALIZE);
+    int packets = s_encoder.encode(g_ambilightConfig.hSeg, g_ambilightConfig.vSeg, sides, &meta);
+    serializeTimer.stop();
+    if (packets == 0) {
+        s_stats.framesSkipped++;
+        return;
+    }
+
+    StageTimer transmitTimer(STAGE_TRANSMIT);
+    if (s_encoder.send(s_transport) == packets) {
+        s_stats.framesSent++;
+    } else {
+        s_stats.framesFailed++;
+    }
+}
+
+bool initUdpFanoutSender() {
+    if (!s_group.fromString(UDP_FANOUT_GROUP)) {
+        Serial.println("[udp] ERROR: Ungültige Multicast-Adresse " UDP_FANOUT_GROUP);
+        return false;
+    }
+
+    // Lokaler Port nur als Absender, empfangen wird nichts
+    if (!s_udp.begin(UDP_FANOUT_PORT)) {
+        Serial.println("[udp] ERROR: UDP-Socket konnte nicht geöffnet werden");
+        return false;
+    }
+
+    // Gleiche Protokolloptionen wie der ESP-NOW-Sender
+    s_encoder.setParityEnabled(ESPNOW_FEC_PARITY);
+    s_encoder.setTimingEnabled(ESPNOW_TIMING);
+
+    if (!addAmbilightResultListener(onAmbilightResult)) {
+        Serial.println("[udp] ERROR: Kein freier Listener-Slot");
+        return false;
+    }
+
+    Serial.printf("[udp] Fan-out bereit: %s:%d\n", UDP_FANOUT_GROUP, UDP_FANOUT_PORT);
+    return true;
+}
+
+UdpFanoutStats getUdpFanoutStats() {
+    return s_stats;
+}
@@ -0,0 +1,23 @@
+#ifndef UDP_SENDER_H
+#define UDP_SENDER_H
+
+#include <Arduino.h>
+
+// Zähler des UDP-Fan-out-Senders
+struct UdpFanoutStats {
+    uint32_t framesSent;     // Frames, deren Pakete alle rausgingen
+    uint32_t framesFailed;   // Frames mit mindestens einem fehlgeschlagenen Paket
+    uint32_t framesSkipped;  // Ergebnisse, die nicht kodiert werden konnten
+    uint32_t packetsSent;
+    uint32_t sendErrors;     // beginPacket/write/endPacket fehlgeschlagen
+};
+
+// Sendet jeden Frame einmal per UDP-Multicast an UDP_FANOUT_GROUP.
+// Beliebig viele Leuchter hören mit und nehmen sich ihren Ausschnitt
+// (AmbilightIndexRange); die Funkzeit pro Frame hängt nicht von ihrer Zahl ab.
+// Nach dem WLAN-Connect aufrufen.
+bool initUdpFanoutSender();
+
+UdpFanoutStats getUdpFanoutStats();
+
+#endif // UDP_SENDER_H
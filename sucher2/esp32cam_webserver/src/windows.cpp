@@ -4,6 +4,21 @@
 #include <cmath>
 #include "esp_camera.h"
 #include "img_converters.h"
+#include "frame_broker.h"
+#include "snapshot_cache.h"
+#include "stage_metrics.h"
+#include "deferred_log.h"
+#include "trace.h"
+#include "alloc_tracker.h"
+#include "window_geometry.h"
+#include "color_reduce.h"
+#include "reduce_worker.h"
+#include "sensor_crop.h"
+#include "capture_mode.h"
+#include "camera_tune.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 
 // ============================================================================
 // GLOBALER STATE FÜR KONTINUIERLICHE AMBILIGHT-BERECHNUNG
@@ -11,13 +26,17 @@
 
 // Konfiguration (wird von Browser gesetzt)
 AmbilightConfig g_ambilightConfig = {
-    {25.0, 25.0},    // topLeft (skaliert für 320x240)
-    {295.0, 25.0},   // topRight
-    {295.0, 215.0},  // botRight
-    {25.0, 215.0},   // botLeft
+    {
+        {50.0f / 640, 50.0f / 480},    // topLeft (bei VGA 50,50)
+        {590.0f / 640, 50.0f / 480},   // topRight
+        {590.0f / 640, 430.0f / 480},  // botRight
+        {50.0f / 640, 430.0f / 480},   // botLeft
+    },
     10,              // hSeg (default)
     8,               // vSeg (default)
-    true             // isValid (default Punkte sind gültig)
+    true,            // isValid (default Punkte sind gültig)
+    1,               // version
+    DECODE_MIN_SAMPLES_DEFAULT  // minSamples
 };
 
 // Ergebnis (wird kontinuierlich aktualisiert)
@@ -31,232 +50,87 @@ AmbilightResult g_ambilightResult = {
     std::vector<WindowRect>(), // leftRects
     std::vector<WindowRect>(), // rightRects
     0,                         // timestamp
+    0,                         // sequence
+    0,                         // captureUs
+    0,                         // configVersion
+    2,                         // decodeScale
     false                      // isValid
 };
 
-// ============================================================================
-
-// Berechnet den quadratischen Mittelwert der RGB-Werte in einem Rechteck
-// Entspricht der mean_bgr() Funktion aus ambivios.py (Zeilen 54-67)
-//
-// Diese Funktion arbeitet mit RGB565-Daten (konvertiert aus JPEG)
-RGB calculateMeanRGB(uint8_t *rgb_buf, int width, int height, int x1, int y1, int x2, int y2) {
-    if (!rgb_buf) {
-        return {0, 0, 0};
-    }
-
-    // Sicherstellen, dass die Koordinaten im gültigen Bereich liegen
-    x1 = constrain(x1, 0, width - 1);
-    x2 = constrain(x2, 0, width - 1);
-    y1 = constrain(y1, 0, height - 1);
-    y2 = constrain(y2, 0, height - 1);
-
-    if (x1 >= x2 || y1 >= y2) {
-        return {0, 0, 0};
-    }
-
-    // Sampling mit step=2 wie im Original
-    const int step = 2;
-    uint32_t sumR = 0, sumG = 0, sumB = 0;
-    int pixelCount = 0;
-
-    // RGB565: 2 Bytes pro Pixel
-    for (int y = y1; y < y2; y += step) {
-        for (int x = x1; x < x2; x += step) {
-            size_t idx = (y * width + x) * 2; // RGB565 = 2 Bytes pro Pixel
-            
-            // RGB565 Format: RRRRR GGGGGG BBBBB (16 Bit)
-            uint16_t pixel = (rgb_buf[idx] << 8) | rgb_buf[idx + 1];
-            
-            // Extrahiere RGB-Komponenten und skaliere auf 8 Bit
-            uint8_t r = ((pixel >> 11) & 0x1F) << 3; // 5 Bit -> 8 Bit
-            uint8_t g = ((pixel >> 5) & 0x3F) << 2;  // 6 Bit -> 8 Bit
-            uint8_t b = (pixel & 0x1F) << 3;         // 5 Bit -> 8 Bit
-            
-            // Quadratischer Mittelwert wie in Python
-            sumR += (uint32_t)r * r;
-            sumG += (uint32_t)g * g;
-            sumB += (uint32_t)b * b;
-            pixelCount++;
-        }
-    }
-
-    if (pixelCount == 0) {
-        return {128, 128, 128}; // Grau als Fallback
-    }
-
-    // Quadratische Wurzel des Durchschnitts (RMS), mit step-Korrektur
-    uint8_t r = (uint8_t)round(sqrt((float)(step * step * sumR) / pixelCount));
-    uint8_t g = (uint8_t)round(sqrt((float)(step * step * sumG) / pixelCount));
-    uint8_t b = (uint8_t)round(sqrt((float)(step * step * sumB) / pixelCount));
-
-    return {r, g, b};
+// Veröffentlichter Stand für andere Tasks (HTTP-API). g_ambilightConfig und
+// g_ambilightResult gehören allein dem Analyse-Task; andere Tasks lesen nur
+// s_published (unveränderliche Kopie) und schreiben nur s_pendingConfig.
+// Unter s_stateMux werden nur Zeiger/PODs kopiert, nie Speicher freigegeben.
+// Die Kopien liegen in festen Plätzen (s_resultSlots), einmal angelegt und
+// danach nur in ihre Kapazität überschrieben: kein Heap pro Frame.
+#define RESULT_SLOTS 3   // veröffentlicht + gerade gehalten + frei zum Füllen
+static portMUX_TYPE s_stateMux = portMUX_INITIALIZER_UNLOCKED;
+static std::shared_ptr<AmbilightResult> s_resultSlots[RESULT_SLOTS];
+static std::shared_ptr<const AmbilightResult> s_published;
+static AmbilightConfig s_pendingConfig;
+static bool s_configPending = false;
+
+// Listener für veröffentlichte Ergebnisse (feste Tabelle, kein Heap)
+static AmbilightResultListener s_resultListeners[MAX_AMBILIGHT_LISTENERS] = {nullptr};
+static int s_resultListenerCount = 0;
+
+bool addAmbilightResultListener(AmbilightResultListener listener) {
+    if (!listener || s_resultListenerCount >= MAX_AMBILIGHT_LISTENERS) {
+        return false;
+    }
+    s_resultListeners[s_resultListenerCount++] = listener;
+    return true;
 }
 
-// Visuell korrekte Farbmittelwert-Berechnung mit Gamma-Korrektur (sRGB → linear → sRGB)
-// Basiert auf linear.txt - respektiert die menschliche Helligkeitswahrnehmung
-RGB calculateMeanRGB2(uint8_t *rgb_buf, int width, int height, int x1, int y1, int x2, int y2) {
-    if (!rgb_buf) {
-        return {0, 0, 0};
+static void notifyAmbilightResultListeners() {
+    for (int i = 0; i < s_resultListenerCount; i++) {
+        s_resultListeners[i](g_ambilightResult);
     }
+}
 
-    // Sicherstellen, dass die Koordinaten im gültigen Bereich liegen
-    x1 = constrain(x1, 0, width - 1);
-    x2 = constrain(x2, 0, width - 1);
-    y1 = constrain(y1, 0, height - 1);
-    y2 = constrain(y2, 0, height - 1);
-
-    if (x1 >= x2 || y1 >= y2) {
-        return {0, 0, 0};
-    }
+// Frames kommen vom Frame-Broker (frame_broker.h), nie direkt vom Treiber
+#define ANALYSIS_FRAME_TIMEOUT_MS 200
 
-    // Hilfsfunktion: sRGB (0-255) → linear RGB (0-1)
-    auto srgbToLinear = [](uint8_t value) -> float {
-        float v = value / 255.0f;
-        if (v <= 0.04045f) {
-            return v / 12.92f;
-        } else {
-            return pow((v + 0.055f) / 1.055f, 2.4f);
-        }
-    };
+static jpg_scale_t jpgScale(int scale) {
+    return scale == 8 ? JPG_SCALE_8X : scale == 4 ? JPG_SCALE_4X : scale == 2 ? JPG_SCALE_2X : JPG_SCALE_NONE;
+}
 
-    // Hilfsfunktion: linear RGB (0-1) → sRGB (0-255)
-    auto linearToSrgb = [](float value) -> uint8_t {
-        float v;
-        if (value <= 0.0031308f) {
-            v = value * 12.92f;
-        } else {
-            v = 1.055f * pow(value, 1.0f/2.4f) - 0.055f;
-        }
-        return (uint8_t)round(v * 255.0f);
-    };
-
-    // Sampling mit step=2
-    const int step = 2;
-    float sumLinearR = 0, sumLinearG = 0, sumLinearB = 0;
-    int pixelCount = 0;
-
-    // RGB565: 2 Bytes pro Pixel
-    for (int y = y1; y < y2; y += step) {
-        for (int x = x1; x < x2; x += step) {
-            size_t idx = (y * width + x) * 2;
-            
-            // RGB565 Format: RRRRR GGGGGG BBBBB (16 Bit)
-            uint16_t pixel = (rgb_buf[idx] << 8) | rgb_buf[idx + 1];
-            
-            // Extrahiere RGB-Komponenten und skaliere auf 8 Bit
-            uint8_t r = ((pixel >> 11) & 0x1F) << 3;
-            uint8_t g = ((pixel >> 5) & 0x3F) << 2;
-            uint8_t b = (pixel & 0x1F) << 3;
-            
-            // Konvertiere zu linear und summiere
-            sumLinearR += srgbToLinear(r);
-            sumLinearG += srgbToLinear(g);
-            sumLinearB += srgbToLinear(b);
-            pixelCount++;
+// Kamerabild, auf das sich Eckpunkte in Pixeln beziehen, wenn der Aufrufer
+// nichts anderes angibt (Weboberfläche zeigt den Stream in VGA)
+#define CONFIG_POINTS_WIDTH   640
+#define CONFIG_POINTS_HEIGHT  480
+
+// Eckpunkte aus doc["points"] normiert nach out (TL, TR, BR, BL).
+// "normalized": true = schon in [0, 1], sonst Pixel eines width x height
+// großen Bildes. false, wenn ein Punkt außerhalb des Bildes liegt.
+static bool readCorners(const JsonDocument& doc, float out[4][2]) {
+    JsonArrayConst pts = doc["points"].as<JsonArrayConst>();
+    bool normalized = doc["normalized"] | false;
+    float width = normalized ? 1.0f : (doc["width"] | (float)CONFIG_POINTS_WIDTH);
+    float height = normalized ? 1.0f : (doc["height"] | (float)CONFIG_POINTS_HEIGHT);
+    if (pts.size() != 4 || width <= 0 || height <= 0) {
+        return false;
+    }
+    for (int i = 0; i < 4; i++) {
+        out[i][0] = pts[i]["x"].as<float>() / width;
+        out[i][1] = pts[i]["y"].as<float>() / height;
+        if (out[i][0] < 0 || out[i][0] > 1 || out[i][1] < 0 || out[i][1] > 1) {
+            return false;
         }
     }
-
-    if (pixelCount == 0) {
-        return {128, 128, 128};
-    }
-
-    // Mittelwert im linearen Raum
-    float avgLinearR = sumLinearR / pixelCount;
-    float avgLinearG = sumLinearG / pixelCount;
-    float avgLinearB = sumLinearB / pixelCount;
-
-    // Zurück zu sRGB konvertieren
-    return {
-        linearToSrgb(avgLinearR),
-        linearToSrgb(avgLinearG),
-        linearToSrgb(avgLinearB)
-    };
+    return true;
 }
 
-// Berechnet alle Ambilight-Fenster basierend auf den 4 Eckpunkten
-// Entspricht der Logik aus ambivios.py (Zeilen 86-120)
-void calculateAmbilightWindows(
-    float topLeft[], float topRight[], float botLeft[], float botRight[],
-    int xwindows, int ywindows,
-    std::vector<WindowRect>& topRects, std::vector<WindowRect>& bottomRects,
-    std::vector<WindowRect>& leftRects, std::vector<WindowRect>& rightRects)
-{
-    // Fensterbreiten und -höhen berechnen
-    float xtopwinwidth = (topRight[0] - topLeft[0]) / xwindows;
-    float xbotwinwidth = (botRight[0] - botLeft[0]) / xwindows;
-    float yleftwinheight = (botLeft[1] - topLeft[1]) / ywindows;
-    float yrightwinheight = (botRight[1] - topRight[1]) / ywindows;
-
-    // Slopes für Trapez-Verzerrung
-    float topslope = (topRight[1] - topLeft[1]) / xwindows;
-    float bottomslope = (botRight[1] - botLeft[1]) / xwindows;
-    float leftslope = (botLeft[0] - topLeft[0]) / ywindows;
-    float rightslope = (botRight[0] - topRight[0]) / ywindows;
-
-    // Horizontale Fenster (top und bottom)
-    for (int i = 0; i < xwindows; i++) {
-        // Top - Höhe interpoliert zwischen links und rechts
-        int tx1 = topLeft[0] + round(i * xtopwinwidth);
-        int ty1 = topLeft[1] + round(i * topslope);
-        int tx2 = tx1 + round(xtopwinwidth);
-        // Lineare Interpolation der Fensterhöhe zwischen yleftwinheight und yrightwinheight
-        float ty2 = ty1 + (1.0 - (float(i) / (xwindows - 1))) * yleftwinheight + (float(i) / (xwindows - 1)) * yrightwinheight;
-        topRects.push_back({tx1, ty1, tx2, (int)ty2});
-
-        // Bottom - Höhe interpoliert zwischen links und rechts
-        int bx1 = botLeft[0] + round(i * xbotwinwidth);
-        float by1 = botLeft[1] + round(i * bottomslope) - (1.0 - (float(i) / (xwindows - 1))) * yleftwinheight - (float(i) / (xwindows - 1)) * yrightwinheight;
-        int bx2 = bx1 + round(xbotwinwidth);
-        int by2 = botLeft[1] + round(i * bottomslope);
-        bottomRects.push_back({bx1, (int)by1, bx2, by2});
-    }
-
-    // Vertikale Fenster (left und right) - Ecken werden übersprungen (i startet bei 1 und endet bei ywindows-2)
-    Serial.print("[calculateWindows] Vertikale Fenster: ywindows=");
-    Serial.print(ywindows);
-    Serial.print(", Loop von i=1 bis i<");
-    Serial.println(ywindows - 1);
-    
-    for (int i = 1; i < (ywindows - 1); i++) {
-        // Left - Breite interpoliert zwischen oben und unten
-        int lx1 = topLeft[0] + round(i * leftslope);
-        int ly1 = topLeft[1] + round(i * yleftwinheight);
-        // Lineare Interpolation der Fensterbreite zwischen xtopwinwidth und xbotwinwidth
-        float lx2 = lx1 + (1.0 - (float(i) / (ywindows - 1))) * xtopwinwidth + (float(i) / (ywindows - 1)) * xbotwinwidth;
-        int ly2 = ly1 + round(yleftwinheight);
-        leftRects.push_back({lx1, ly1, (int)lx2, ly2});
-
-        // Right - Breite interpoliert zwischen oben und unten
-        float rx1 = topRight[0] + round(i * rightslope) - (1.0 - (float(i) / (ywindows - 1))) * xtopwinwidth - (float(i) / (ywindows - 1)) * xbotwinwidth;
-        int ry1 = topRight[1] + round(i * yrightwinheight);
-        int rx2 = topRight[0] + round(i * rightslope);
-        int ry2 = ry1 + round(yrightwinheight);
-        
-        if (i == 1) {
-            Serial.print("[calculateWindows] Right[0]: rx1=");
-            Serial.print((int)rx1);
-            Serial.print(", ry1=");
-            Serial.print(ry1);
-            Serial.print(", rx2=");
-            Serial.print(rx2);
-            Serial.print(", ry2=");
-            Serial.println(ry2);
-        }
-        
-        rightRects.push_back({(int)rx1, ry1, rx2, ry2});
+static int analysisConsumer() {
+    static int s_consumer = -1;
+    if (s_consumer < 0) {
+        s_consumer = registerFrameConsumer("analysis");
     }
-    
-    Serial.print("[calculateWindows] Ergebnis: Top=");
-    Serial.print(topRects.size());
-    Serial.print(", Bottom=");
-    Serial.print(bottomRects.size());
-    Serial.print(", Left=");
-    Serial.print(leftRects.size());
-    Serial.print(", Right=");
-    Serial.println(rightRects.size());
+    return s_consumer;
 }
 
+// ============================================================================
+
 // Hauptfunktion: verarbeitet JSON-Input und gibt JSON-Response zurück
 String processAmbilight(const String& jsonInput) {
     Serial.println("[processAmbilight] === START ===");
@@ -287,44 +161,23 @@ String processAmbilight(const String& jsonInput) {
     Serial.print(", vSeg=");
     Serial.println(ywindows);
 
-    // Eckpunkte extrahieren
-    float topLeft[2] = {pts[0]["x"].as<float>(), pts[0]["y"].as<float>()};
-    float topRight[2] = {pts[1]["x"].as<float>(), pts[1]["y"].as<float>()};
-    float botRight[2] = {pts[2]["x"].as<float>(), pts[2]["y"].as<float>()};
-    float botLeft[2] = {pts[3]["x"].as<float>(), pts[3]["y"].as<float>()};
-    
-    Serial.print("[processAmbilight] Eckpunkte (Original): TL(");
-    Serial.print(topLeft[0]); Serial.print(","); Serial.print(topLeft[1]);
-    Serial.print(") TR(");
-    Serial.print(topRight[0]); Serial.print(","); Serial.print(topRight[1]);
-    Serial.print(") BR(");
-    Serial.print(botRight[0]); Serial.print(","); Serial.print(botRight[1]);
-    Serial.print(") BL(");
-    Serial.print(botLeft[0]); Serial.print(","); Serial.print(botLeft[1]);
-    Serial.println(")");
-    
-    // Koordinaten für 2x-Skalierung halbieren (640x480 -> 320x240)
-    // Dies reduziert den Speicherverbrauch von ~600KB auf ~150KB
-    topLeft[0] /= 2.0; topLeft[1] /= 2.0;
-    topRight[0] /= 2.0; topRight[1] /= 2.0;
-    botRight[0] /= 2.0; botRight[1] /= 2.0;
-    botLeft[0] /= 2.0; botLeft[1] /= 2.0;
-    
-    Serial.print("[processAmbilight] Eckpunkte (Skaliert): TL(");
-    Serial.print(topLeft[0]); Serial.print(","); Serial.print(topLeft[1]);
-    Serial.print(") TR(");
-    Serial.print(topRight[0]); Serial.print(","); Serial.print(topRight[1]);
-    Serial.print(") BR(");
-    Serial.print(botRight[0]); Serial.print(","); Serial.print(botRight[1]);
-    Serial.print(") BL(");
-    Serial.print(botLeft[0]); Serial.print(","); Serial.print(botLeft[1]);
-    Serial.println(")");
+    // Eckpunkte normiert, Rechtecke der Antwort im Raster 320x240
+    float normalized[4][2];
+    if (!readCorners(doc, normalized)) {
+        Serial.println("[processAmbilight] ERROR: Eckpunkt außerhalb des Bildes");
+        return "{\"error\":\"Point outside of image\"}";
+    }
+    float corners[4][2];
+    denormalizeCorners(normalized, AMBILIGHT_RECT_WIDTH, AMBILIGHT_RECT_HEIGHT, corners);
+    Serial.printf("[processAmbilight] Eckpunkte (Raster): TL(%.1f,%.1f) TR(%.1f,%.1f) BR(%.1f,%.1f) BL(%.1f,%.1f)\n",
+                  corners[0][0], corners[0][1], corners[1][0], corners[1][1],
+                  corners[2][0], corners[2][1], corners[3][0], corners[3][1]);
 
     // Rechtecke berechnen
     Serial.println("[processAmbilight] Berechne Fenster-Geometrie...");
     std::vector<WindowRect> topRects, bottomRects, leftRects, rightRects;
     calculateAmbilightWindows(
-        topLeft, topRight, botLeft, botRight,
+        corners[0], corners[1], corners[3], corners[2],
         xwindows, ywindows,
         topRects, bottomRects, leftRects, rightRects
     );
@@ -340,7 +193,7 @@ String processAmbilight(const String& jsonInput) {
 
     // Kamera-Frame holen (JPEG)
     Serial.println("[processAmbilight] Hole Kamera-Frame...");
-    camera_fb_t *fb = esp_camera_fb_get();
+    camera_fb_t *fb = acquireFrame(analysisConsumer(), ANALYSIS_FRAME_TIMEOUT_MS);
     if (!fb) {
         Serial.println("[processAmbilight] ERROR: Failed to get camera frame");
         return "{\"error\":\"Camera frame failed\"}";
@@ -354,14 +207,23 @@ String processAmbilight(const String& jsonInput) {
     Serial.print(fb->len);
     Serial.println(" bytes");
 
+    // Ecken auf das aktuelle Bild abbilden, Dekodier-Skalierung aus der Fenstergröße
+    int minSamples = doc["minSamples"] | DECODE_MIN_SAMPLES_DEFAULT;
+    SamplingPlan plan = buildSamplingPlan(normalized, xwindows, ywindows, fb->width, fb->height,
+                                          minSamples, DECODE_MAX_SCALE);
+    int scale = plan.scale;
+    Serial.printf("[processAmbilight] Dekodier-Skalierung %dx\n", scale);
+    std::vector<WindowRect> topDecode, bottomDecode, leftDecode, rightDecode;
+    calculateAmbilightWindows(plan.topLeft, plan.topRight, plan.botLeft, plan.botRight, xwindows, ywindows,
+                              topDecode, bottomDecode, leftDecode, rightDecode);
+
     // JPEG zu RGB565 konvertieren für Farbberechnung
     Serial.println("[processAmbilight] Konvertiere JPEG zu RGB565...");
     
-    // Bild wird 2x skaliert (640x480 -> 320x240), um Speicher zu sparen
-    // Original: 640 * 480 * 2 = 614.400 Bytes (~600 KB) - zu viel für ESP32!
-    // Skaliert: 320 * 240 * 2 = 153.600 Bytes (~150 KB) - passt in RAM!
-    int width = fb->width / 2;
-    int height = fb->height / 2;
+    // Bild wird mit der geplanten Skalierung dekodiert, um Speicher zu sparen
+    // (2x: 320 * 240 * 2 = 153.600 Bytes statt ~600 KB für VGA)
+    int width = plan.width;
+    int height = plan.height;
     
     // RGB565 benötigt 2 Bytes pro Pixel
     size_t rgb_len = width * height * 2;
@@ -375,17 +237,17 @@ String processAmbilight(const String& jsonInput) {
     
     if (!rgb_buf) {
         Serial.println("[processAmbilight] ERROR: Failed to allocate RGB buffer");
-        esp_camera_fb_return(fb);
+        releaseFrame(fb);
         return "{\"error\":\"Memory allocation failed\"}";
     }
     Serial.println("[processAmbilight] RGB-Buffer allokiert");
     
-    bool converted = jpg2rgb565(fb->buf, fb->len, rgb_buf, JPG_SCALE_2X);
+    bool converted = jpg2rgb565(fb->buf, fb->len, rgb_buf, jpgScale(scale));
     
     if (!converted) {
         Serial.println("[processAmbilight] ERROR: JPEG conversion failed");
         free(rgb_buf);
-        esp_camera_fb_return(fb);
+        releaseFrame(fb);
         return "{\"error\":\"JPEG conversion failed\"}";
     }
     Serial.println("[processAmbilight] JPEG erfolgreich konvertiert");
@@ -411,8 +273,10 @@ String processAmbilight(const String& jsonInput) {
     
     // Top-Farben berechnen
     Serial.println("[processAmbilight] Berechne Top-Farben...");
-    for (const auto& rect : topRects) {
-        RGB color = calculateMeanRGB(rgb_buf, width, height, rect.x1, rect.y1, rect.x2, rect.y2);
+    for (size_t i = 0; i < topRects.size(); i++) {
+        const WindowRect& rect = topRects[i];
+        const WindowRect& d = topDecode[i];
+        RGB color = calculateMeanRGB(rgb_buf, width, height, d.x1, d.y1, d.x2, d.y2);
         JsonArray colorArray = topColors.createNestedArray();
         colorArray.add(color.r);
         colorArray.add(color.g);
@@ -427,8 +291,10 @@ String processAmbilight(const String& jsonInput) {
 
     Serial.println("[processAmbilight] Berechne Bottom-Farben...");
     // Bottom-Farben berechnen
-    for (const auto& rect : bottomRects) {
-        RGB color = calculateMeanRGB(rgb_buf, width, height, rect.x1, rect.y1, rect.x2, rect.y2);
+    for (size_t i = 0; i < bottomRects.size(); i++) {
+        const WindowRect& rect = bottomRects[i];
+        const WindowRect& d = bottomDecode[i];
+        RGB color = calculateMeanRGB(rgb_buf, width, height, d.x1, d.y1, d.x2, d.y2);
         JsonArray colorArray = bottomColors.createNestedArray();
         colorArray.add(color.r);
         colorArray.add(color.g);
@@ -443,8 +309,10 @@ String processAmbilight(const String& jsonInput) {
 
     Serial.println("[processAmbilight] Berechne Left-Farben...");
     // Left-Farben berechnen
-    for (const auto& rect : leftRects) {
-        RGB color = calculateMeanRGB(rgb_buf, width, height, rect.x1, rect.y1, rect.x2, rect.y2);
+    for (size_t i = 0; i < leftRects.size(); i++) {
+        const WindowRect& rect = leftRects[i];
+        const WindowRect& d = leftDecode[i];
+        RGB color = calculateMeanRGB(rgb_buf, width, height, d.x1, d.y1, d.x2, d.y2);
         JsonArray colorArray = leftColors.createNestedArray();
         colorArray.add(color.r);
         colorArray.add(color.g);
@@ -459,8 +327,10 @@ String processAmbilight(const String& jsonInput) {
 
     Serial.println("[processAmbilight] Berechne Right-Farben...");
     // Right-Farben berechnen
-    for (const auto& rect : rightRects) {
-        RGB color = calculateMeanRGB(rgb_buf, width, height, rect.x1, rect.y1, rect.x2, rect.y2);
+    for (size_t i = 0; i < rightRects.size(); i++) {
+        const WindowRect& rect = rightRects[i];
+        const WindowRect& d = rightDecode[i];
+        RGB color = calculateMeanRGB(rgb_buf, width, height, d.x1, d.y1, d.x2, d.y2);
         JsonArray colorArray = rightColors.createNestedArray();
         colorArray.add(color.r);
         colorArray.add(color.g);
@@ -476,7 +346,7 @@ String processAmbilight(const String& jsonInput) {
     // Aufräumen
     Serial.println("[processAmbilight] Räume Speicher auf...");
     free(rgb_buf);
-    esp_camera_fb_return(fb);
+    releaseFrame(fb);
 
     // JSON serialisieren
     Serial.println("[processAmbilight] Serialisiere JSON-Response...");
@@ -494,173 +364,350 @@ String processAmbilight(const String& jsonInput) {
 // NEUE API FÜR KONTINUIERLICHE BERECHNUNG
 // ============================================================================
 
-// Aktualisiert die Konfiguration aus JSON (ersetzt processAmbilight für Config-Update)
+// Aktualisiert die Konfiguration aus JSON (ersetzt processAmbilight für Config-Update).
+// Läuft im HTTP-Task: die neue Konfiguration wird nur hinterlegt und vom
+// Analyse-Task zu Beginn des nächsten Frames übernommen.
 void updateAmbilightConfig(const String& jsonInput) {
     Serial.println("[updateConfig] Aktualisiere Ambilight-Konfiguration...");
     
+    AmbilightConfig config = {};
     StaticJsonDocument<1024> doc;
     DeserializationError err = deserializeJson(doc, jsonInput);
     
     if (err) {
         Serial.println("[updateConfig] ERROR: JSON parse error");
-        g_ambilightConfig.isValid = false;
-        return;
-    }
-    
-    JsonArray pts = doc["points"].as<JsonArray>();
-    if (pts.size() != 4) {
+        config.isValid = false;
+    } else if (doc["points"].as<JsonArray>().size() != 4) {
         Serial.print("[updateConfig] ERROR: Falsche Punktanzahl: ");
-        Serial.println(pts.size());
-        g_ambilightConfig.isValid = false;
-        return;
+        Serial.println(doc["points"].as<JsonArray>().size());
+        config.isValid = false;
+    } else {
+        // Eckpunkte normiert speichern, unabhängig von der Bildgröße
+        config.isValid = readCorners(doc, config.corners);
+        
+        int hSeg = doc["hSeg"].as<int>();
+        int vSeg = doc["vSeg"].as<int>();
+        int minSamples = doc["minSamples"] | 0;
+        config.hSeg = (hSeg > 0) ? hSeg : 10;  // Default: 10
+        config.vSeg = (vSeg > 0) ? vSeg : 8;   // Default: 8
+        config.minSamples = (minSamples > 0) ? minSamples : DECODE_MIN_SAMPLES_DEFAULT;
+        
+        if (!config.isValid) {
+            Serial.println("[updateConfig] ERROR: Eckpunkt außerhalb des Bildes");
+        } else {
+            Serial.printf("[updateConfig] Konfiguration gesetzt: TL(%.3f,%.3f) TR(%.3f,%.3f) BR(%.3f,%.3f) BL(%.3f,%.3f) "
+                          "hSeg=%d vSeg=%d minSamples=%d\n",
+                          config.corners[0][0], config.corners[0][1], config.corners[1][0], config.corners[1][1],
+                          config.corners[2][0], config.corners[2][1], config.corners[3][0], config.corners[3][1],
+                          config.hSeg, config.vSeg, config.minSamples);
+        }
     }
     
-    // Eckpunkte extrahieren und direkt skalieren (640x480 -> 320x240)
-    g_ambilightConfig.topLeft[0] = pts[0]["x"].as<float>() / 2.0;
-    g_ambilightConfig.topLeft[1] = pts[0]["y"].as<float>() / 2.0;
-    g_ambilightConfig.topRight[0] = pts[1]["x"].as<float>() / 2.0;
-    g_ambilightConfig.topRight[1] = pts[1]["y"].as<float>() / 2.0;
-    g_ambilightConfig.botRight[0] = pts[2]["x"].as<float>() / 2.0;
-    g_ambilightConfig.botRight[1] = pts[2]["y"].as<float>() / 2.0;
-    g_ambilightConfig.botLeft[0] = pts[3]["x"].as<float>() / 2.0;
-    g_ambilightConfig.botLeft[1] = pts[3]["y"].as<float>() / 2.0;
+    // Neueste Konfiguration gewinnt, version vergibt der Analyse-Task
+    taskENTER_CRITICAL(&s_stateMux);
+    s_pendingConfig = config;
+    s_configPending = true;
+    taskEXIT_CRITICAL(&s_stateMux);
+}
+
+// Übernimmt eine hinterlegte Konfiguration (nur im Analyse-Task)
+static void applyPendingConfig() {
+    taskENTER_CRITICAL(&s_stateMux);
+    bool pending = s_configPending;
+    AmbilightConfig config = s_pendingConfig;
+    s_configPending = false;
+    taskEXIT_CRITICAL(&s_stateMux);
     
-    int hSeg = doc["hSeg"].as<int>();
-    int vSeg = doc["vSeg"].as<int>();
-    g_ambilightConfig.hSeg = (hSeg > 0) ? hSeg : 10;  // Default: 10
-    g_ambilightConfig.vSeg = (vSeg > 0) ? vSeg : 8;   // Default: 8
-    g_ambilightConfig.isValid = true;
-    
-    Serial.print("[updateConfig] Konfiguration gesetzt: TL(");
-    Serial.print(g_ambilightConfig.topLeft[0]); Serial.print(","); Serial.print(g_ambilightConfig.topLeft[1]);
-    Serial.print(") TR(");
-    Serial.print(g_ambilightConfig.topRight[0]); Serial.print(","); Serial.print(g_ambilightConfig.topRight[1]);
-    Serial.print(") BR(");
-    Serial.print(g_ambilightConfig.botRight[0]); Serial.print(","); Serial.print(g_ambilightConfig.botRight[1]);
-    Serial.print(") BL(");
-    Serial.print(g_ambilightConfig.botLeft[0]); Serial.print(","); Serial.print(g_ambilightConfig.botLeft[1]);
-    Serial.print(") hSeg=");
-    Serial.print(g_ambilightConfig.hSeg);
-    Serial.print(" vSeg=");
-    Serial.println(g_ambilightConfig.vSeg);
+    if (!pending) {
+        return;
+    }
+    // Geklickt wurde im gelieferten Bild: bei Sensor-Ausschnitt auf das volle Bild zurückrechnen
+    uncropCorners(currentSensorWindow(), config.corners, config.corners);
+    config.version = g_ambilightConfig.version + 1;
+    g_ambilightConfig = config;
+    ALLOC_RESTART_WARMUP();   // Puffer dürfen auf die neue Fensterzahl wachsen
+}
+
+// Kopiert src in dst, ohne Speicher freizugeben (assign() in die vorhandene Kapazität)
+static void copyAmbilightResult(AmbilightResult& dst, const AmbilightResult& src) {
+    dst.topColors.assign(src.topColors.begin(), src.topColors.end());
+    dst.bottomColors.assign(src.bottomColors.begin(), src.bottomColors.end());
+    dst.leftColors.assign(src.leftColors.begin(), src.leftColors.end());
+    dst.rightColors.assign(src.rightColors.begin(), src.rightColors.end());
+    dst.topRects.assign(src.topRects.begin(), src.topRects.end());
+    dst.bottomRects.assign(src.bottomRects.begin(), src.bottomRects.end());
+    dst.leftRects.assign(src.leftRects.begin(), src.leftRects.end());
+    dst.rightRects.assign(src.rightRects.begin(), src.rightRects.end());
+    dst.timestamp = src.timestamp;
+    dst.sequence = src.sequence;
+    dst.captureUs = src.captureUs;
+    dst.configVersion = src.configVersion;
+    dst.decodeScale = src.decodeScale;
+    dst.isValid = src.isValid;
+}
+
+// Veröffentlicht eine Kopie von g_ambilightResult für andere Tasks. Gefüllt
+// wird ein Platz, den weder s_published noch ein Handler hält (use_count 1,
+// nur die Tabelle); neue Verweise gibt es nur über s_published, daher kann
+// ihn währenddessen niemand greifen.
+static void publishAmbilightResult() {
+    if (!s_resultSlots[0]) {
+        for (std::shared_ptr<AmbilightResult>& slot : s_resultSlots) {
+            slot = std::make_shared<AmbilightResult>();   // einmalig beim ersten Ergebnis
+        }
+    }
+    int index = -1;
+    taskENTER_CRITICAL(&s_stateMux);
+    for (int i = 0; i < RESULT_SLOTS && index < 0; i++) {
+        if (s_resultSlots[i].use_count() == 1) {
+            index = i;
+        }
+    }
+    taskEXIT_CRITICAL(&s_stateMux);
+    if (index < 0) {
+        // Alle Plätze gehalten (langsame Handler): alten Stand stehen lassen
+        LOG_D("[publish] Kein freier Ergebnis-Platz, Frame %u nicht veröffentlicht", g_ambilightResult.sequence);
+        return;
+    }
+
+    copyAmbilightResult(*s_resultSlots[index], g_ambilightResult);
+    taskENTER_CRITICAL(&s_stateMux);
+    s_published = s_resultSlots[index];
+    taskEXIT_CRITICAL(&s_stateMux);
+    // Der vorige Platz bleibt in der Tabelle, freigegeben wird nichts
+}
+
+std::shared_ptr<const AmbilightResult> getPublishedAmbilightResult() {
+    taskENTER_CRITICAL(&s_stateMux);
+    std::shared_ptr<const AmbilightResult> snapshot = s_published;
+    taskEXIT_CRITICAL(&s_stateMux);
+    return snapshot;
 }
 
 // Führt eine Ambilight-Berechnung durch und speichert das Ergebnis im globalen State
 void calculateAmbilightContinuous() {
+    int64_t startUs = esp_timer_get_time();
+    applyPendingConfig();
+    
     // Nur berechnen wenn Konfiguration gültig ist
     if (!g_ambilightConfig.isValid) {
         // Kein Log hier, sonst Spam in Console
-        g_ambilightResult.isValid = false;
+        if (g_ambilightResult.isValid) {
+            g_ambilightResult.isValid = false;
+            publishAmbilightResult();
+        }
         return;
     }
     
-    // Rechtecke berechnen
-    std::vector<WindowRect> topRects, bottomRects, leftRects, rightRects;
-    calculateAmbilightWindows(
-        g_ambilightConfig.topLeft, g_ambilightConfig.topRight, 
-        g_ambilightConfig.botLeft, g_ambilightConfig.botRight,
-        g_ambilightConfig.hSeg, g_ambilightConfig.vSeg,
-        topRects, bottomRects, leftRects, rightRects
-    );
+    // Sensor-Ausschnitt der Kalibrierung nachführen, Ecken auf den Ausschnitt
+    // umrechnen. Neuer Ausschnitt = neue Rechtecke, daher neue Version.
+    // Während der Autotuner den Sensor verstellt, ruhen Ausschnitt und
+    // zwei Auflösungen.
+    bool tuning = updateCameraTune(g_ambilightConfig.version);
+    if (!tuning && updateSensorCrop(g_ambilightConfig.corners, g_ambilightConfig.version)) {
+        g_ambilightConfig.version++;
+    }
+    const SensorWindow& window = currentSensorWindow();
+    updateCaptureMode(tuning || window.outputWidth > 0);
+    float view[4][2];
+    cropCorners(window, g_ambilightConfig.corners, view);
+    
+    // Rechtecke berechnen (festes Raster für API und Weboberfläche), nur bei
+    // neuer Konfiguration oder neuem Ausschnitt. Statisch, damit clear() die
+    // Kapazität behält und der Frame-Pfad nach dem Warm-up nicht allokiert.
+    StageTimer geometryTimer(STAGE_GEOMETRY);
+    static std::vector<WindowRect> topRects, bottomRects, leftRects, rightRects;
+    static uint32_t s_geometryVersion = 0;
+    static float s_geometryView[4] = {0, 0, 0, 0};
+    if (s_geometryVersion != g_ambilightConfig.version ||
+        memcmp(s_geometryView, window.view, sizeof(s_geometryView)) != 0) {
+        topRects.clear();
+        bottomRects.clear();
+        leftRects.clear();
+        rightRects.clear();
+        float corners[4][2];
+        denormalizeCorners(view, AMBILIGHT_RECT_WIDTH, AMBILIGHT_RECT_HEIGHT, corners);
+        calculateAmbilightWindows(
+            corners[0], corners[1], corners[3], corners[2],
+            g_ambilightConfig.hSeg, g_ambilightConfig.vSeg,
+            topRects, bottomRects, leftRects, rightRects
+        );
+        s_geometryVersion = g_ambilightConfig.version;
+        memcpy(s_geometryView, window.view, sizeof(s_geometryView));
+        LOG_D("[calculateWindows] Ergebnis: Top=%u, Bottom=%u, Left=%u, Right=%u",
+              topRects.size(), bottomRects.size(), leftRects.size(), rightRects.size());
+    }
+    geometryTimer.stop();
     
     // Kamera-Frame holen
-    camera_fb_t *fb = esp_camera_fb_get();
+    StageTimer captureTimer(STAGE_CAPTURE_WAIT);
+    camera_fb_t *fb = acquireFrame(analysisConsumer(), ANALYSIS_FRAME_TIMEOUT_MS);
+    captureTimer.stop();
     if (!fb) {
-        // Kamera ist busy (wahrscheinlich vom Stream benutzt)
+        // Kein Frame innerhalb des Timeouts (Kamera-Fehler)
         // Behalte das letzte gültige Ergebnis bei, anstatt es zu invalidieren
         static unsigned long lastErrorLog = 0;
         if (millis() - lastErrorLog > 10000) {
-            Serial.println("[calculateContinuous] Camera busy, keeping last result");
+            LOG_W("[calculateContinuous] No camera frame, keeping last result");
             lastErrorLog = millis();
         }
         return; // Beende ohne isValid zu ändern
     }
+    bool stale = sensorCropSettling();
+    stale = captureModeSettling() || stale;
+    stale = cameraTuneSettling() || stale;
+    if (stale) {
+        releaseFrame(fb);   // noch mit dem vorigen Ausschnitt, der vorigen Größe bzw. Einstellung aufgenommen
+        return;
+    }
     
-    // JPEG zu RGB565 konvertieren mit 2x Skalierung (640x480 -> 320x240)
-    int width = fb->width / 2;
-    int height = fb->height / 2;
-    size_t rgb_len = width * height * 2;
+    // Capture-Zeitpunkt merken (gleiche Zeitbasis wie esp_timer_get_time())
+    int64_t captureUs = (int64_t)fb->timestamp.tv_sec * 1000000LL + fb->timestamp.tv_usec;
+    
+    // Ecken auf das aktuelle Bild abbilden und Skalierung wählen, nur bei
+    // neuer Konfiguration, neuem Ausschnitt, geänderter Bildgröße oder
+    // vom Autotuner vorgegebener Skalierung (minSamples 0 = genau diese)
+    static uint32_t s_planVersion = 0;
+    static int s_planWidth = 0;
+    static int s_planHeight = 0;
+    static int s_planForced = 0;
+    static float s_planView[4] = {0, 0, 0, 0};
+    static SamplingPlan s_plan;
+    // Alle Fenster im dekodierten Bild hintereinander in einer Liste (oben,
+    // unten, links, rechts), nur zusammen mit dem Plan neu
+    static std::vector<WindowRect> s_allRects;
+    int forcedScale = cameraTuneDecodeScale();
+    if (s_planVersion != g_ambilightConfig.version || s_planWidth != fb->width || s_planHeight != fb->height ||
+        s_planForced != forcedScale || memcmp(s_planView, window.view, sizeof(s_planView)) != 0) {
+        s_plan = buildSamplingPlan(view, g_ambilightConfig.hSeg, g_ambilightConfig.vSeg, fb->width, fb->height,
+                                   forcedScale ? 0 : g_ambilightConfig.minSamples,
+                                   forcedScale ? forcedScale : DECODE_MAX_SCALE);
+        s_planVersion = g_ambilightConfig.version;
+        s_planWidth = fb->width;
+        s_planHeight = fb->height;
+        s_planForced = forcedScale;
+        memcpy(s_planView, window.view, sizeof(s_planView));
+        LOG_I("[calculateContinuous] Dekodier-Skalierung %dx (%dx%d, min. %d Pixel je Fenster, gefordert %d)",
+              s_plan.scale, s_plan.width, s_plan.height, s_plan.samples, g_ambilightConfig.minSamples);
+
+        // Fenster im dekodierten Bild; hat es die Größe des API-Rasters, dieselben
+        static std::vector<WindowRect> s_decodeTop, s_decodeBottom, s_decodeLeft, s_decodeRight;
+        const std::vector<WindowRect>* decodeRects[4] = { &topRects, &bottomRects, &leftRects, &rightRects };
+        if (s_plan.width != AMBILIGHT_RECT_WIDTH || s_plan.height != AMBILIGHT_RECT_HEIGHT) {
+            s_decodeTop.clear();
+            s_decodeBottom.clear();
+            s_decodeLeft.clear();
+            s_decodeRight.clear();
+            calculateAmbilightWindows(s_plan.topLeft, s_plan.topRight, s_plan.botLeft, s_plan.botRight,
+                                      g_ambilightConfig.hSeg, g_ambilightConfig.vSeg,
+                                      s_decodeTop, s_decodeBottom, s_decodeLeft, s_decodeRight);
+            decodeRects[0] = &s_decodeTop;
+            decodeRects[1] = &s_decodeBottom;
+            decodeRects[2] = &s_decodeLeft;
+            decodeRects[3] = &s_decodeRight;
+        }
+        s_allRects.clear();
+        for (const std::vector<WindowRect>* side : decodeRects) {
+            s_allRects.insert(s_allRects.end(), side->begin(), side->end());
+        }
+    }
+    int scale = s_plan.scale;
     
-    uint8_t *rgb_buf = (uint8_t*)malloc(rgb_len);
+    // JPEG zu RGB565 konvertieren mit der geplanten Skalierung. Der Puffer
+    // bleibt liegen und wächst nur, wenn ein neuer Plan mehr Pixel braucht.
+    int width = s_plan.width;
+    int height = s_plan.height;
+    size_t rgb_len = width * height * 2;
+    static uint8_t* s_rgbBuf = nullptr;
+    static size_t s_rgbCapacity = 0;
+    if (rgb_len > s_rgbCapacity) {
+        free(s_rgbBuf);
+        s_rgbBuf = (uint8_t*)(psramFound() ? ps_malloc(rgb_len) : malloc(rgb_len));
+        s_rgbCapacity = s_rgbBuf ? rgb_len : 0;
+    }
+    uint8_t *rgb_buf = s_rgbBuf;
     if (!rgb_buf) {
-        Serial.println("[calculateContinuous] ERROR: Out of memory");
-        esp_camera_fb_return(fb);
+        LOG_E("[calculateContinuous] ERROR: Out of memory");
+        releaseFrame(fb);
         return; // Behalte letztes Ergebnis
     }
     
-    bool converted = jpg2rgb565(fb->buf, fb->len, rgb_buf, JPG_SCALE_2X);
+    StageTimer decodeTimer(STAGE_JPEG_DECODE);
+    bool converted = jpg2rgb565(fb->buf, fb->len, rgb_buf, jpgScale(scale));
+    decodeTimer.stop();
     if (!converted) {
-        Serial.println("[calculateContinuous] ERROR: JPEG conversion failed");
-        free(rgb_buf);
-        esp_camera_fb_return(fb);
+        LOG_E("[calculateContinuous] ERROR: JPEG conversion failed");
+        releaseFrame(fb);
         return; // Behalte letztes Ergebnis
     }
     
-    // Farben berechnen und in globalen Vektoren speichern
-    g_ambilightResult.topColors.clear();
-    g_ambilightResult.bottomColors.clear();
-    g_ambilightResult.leftColors.clear();
-    g_ambilightResult.rightColors.clear();
-    
-    for (const auto& rect : topRects) {
-        RGB color = calculateMeanRGB2(rgb_buf, width, height, rect.x1, rect.y1, rect.x2, rect.y2);
-        g_ambilightResult.topColors.push_back(color);
-    }
-    
-    for (const auto& rect : bottomRects) {
-        RGB color = calculateMeanRGB2(rgb_buf, width, height, rect.x1, rect.y1, rect.x2, rect.y2);
-        g_ambilightResult.bottomColors.push_back(color);
-    }
-    
-    for (const auto& rect : leftRects) {
-        RGB color = calculateMeanRGB2(rgb_buf, width, height, rect.x1, rect.y1, rect.x2, rect.y2);
-        g_ambilightResult.leftColors.push_back(color);
-    }
-    
-    for (const auto& rect : rightRects) {
-        RGB color = calculateMeanRGB2(rgb_buf, width, height, rect.x1, rect.y1, rect.x2, rect.y2);
-        g_ambilightResult.rightColors.push_back(color);
-    }
-    
-    // Rechtecke speichern
-    g_ambilightResult.topRects = topRects;
-    g_ambilightResult.bottomRects = bottomRects;
-    g_ambilightResult.leftRects = leftRects;
-    g_ambilightResult.rightRects = rightRects;
-    
-    Serial.print("[calculateContinuous] Gespeichert: Top=");
-    Serial.print(g_ambilightResult.topColors.size());
-    Serial.print("/");
-    Serial.print(g_ambilightResult.topRects.size());
-    Serial.print(", Left=");
-    Serial.print(g_ambilightResult.leftColors.size());
-    Serial.print("/");
-    Serial.print(g_ambilightResult.leftRects.size());
-    Serial.print(", Right=");
-    Serial.print(g_ambilightResult.rightColors.size());
-    Serial.print("/");
-    Serial.println(g_ambilightResult.rightRects.size());
+    // Farben berechnen und in globalen Vektoren speichern. reduceRects()
+    // verteilt die Fenster aus s_allRects nach Pixelzahl auf beide Kerne.
+    // s_allColors und die Ergebnis-Vektoren wachsen nur mit der Fensterzahl,
+    // Decode-Puffer und Rechtecke oben nur mit Plan bzw. Konfiguration.
+    StageTimer reductionTimer(STAGE_REDUCTION);
+    static std::vector<RGB> s_allColors;
+    s_allColors.resize(s_allRects.size());
+    reduceRects(rgb_buf, width, height, s_allRects.data(), (int)s_allRects.size(), s_allColors.data());
+    int64_t doneUs = esp_timer_get_time();
+    cameraTuneOnFrame(s_allColors.data(), (int)s_allColors.size(), (uint32_t)(doneUs - startUs),
+                      (uint32_t)(doneUs - captureUs), fb->len);
+    
+    const RGB* colors = s_allColors.data();
+    g_ambilightResult.topColors.assign(colors, colors + topRects.size());
+    colors += topRects.size();
+    g_ambilightResult.bottomColors.assign(colors, colors + bottomRects.size());
+    colors += bottomRects.size();
+    g_ambilightResult.leftColors.assign(colors, colors + leftRects.size());
+    colors += leftRects.size();
+    g_ambilightResult.rightColors.assign(colors, colors + rightRects.size());
+    
+    reductionTimer.stop();
+    
+    // Rechtecke speichern (assign() nutzt die vorhandene Kapazität)
+    g_ambilightResult.topRects.assign(topRects.begin(), topRects.end());
+    g_ambilightResult.bottomRects.assign(bottomRects.begin(), bottomRects.end());
+    g_ambilightResult.leftRects.assign(leftRects.begin(), leftRects.end());
+    g_ambilightResult.rightRects.assign(rightRects.begin(), rightRects.end());
+    g_ambilightResult.configVersion = g_ambilightConfig.version;
+    g_ambilightResult.decodeScale = scale;
+    
+    LOG_D("[calculateContinuous] Gespeichert: Top=%u/%u, Left=%u/%u, Right=%u/%u",
+          g_ambilightResult.topColors.size(), g_ambilightResult.topRects.size(),
+          g_ambilightResult.leftColors.size(), g_ambilightResult.leftRects.size(),
+          g_ambilightResult.rightColors.size(), g_ambilightResult.rightRects.size());
     
     g_ambilightResult.timestamp = millis();
+    g_ambilightResult.captureUs = captureUs;
+    g_ambilightResult.sequence++;
     g_ambilightResult.isValid = true;
     
+    // JPEG für /api/snapshot ablegen (nur solange Snapshots abgerufen werden)
+    storeSnapshotFrame(fb, g_ambilightResult.sequence);
+    
     // Aufräumen
-    free(rgb_buf);
-    esp_camera_fb_return(fb);
+    releaseFrame(fb);
+    
+    // Ergebnis veröffentlichen (erst nach Rückgabe des Frames, damit die
+    // Kamera während des Sendens schon den nächsten Frame füllen kann)
+    TRACE_SPAN("analysis", "publish");
+    publishAmbilightResult();
+    notifyAmbilightResultListeners();
 }
 
-// Gibt das gespeicherte Ergebnis als JSON zurück (ohne neue Berechnung)
+// Gibt das veröffentlichte Ergebnis als JSON zurück (ohne neue Berechnung)
 String getAmbilightResult() {
-    if (!g_ambilightResult.isValid) {
+    // Nur den veröffentlichten Stand lesen, der Analyse-Task rechnet parallel weiter
+    std::shared_ptr<const AmbilightResult> snapshot = getPublishedAmbilightResult();
+    if (!snapshot || !snapshot->isValid) {
         return "{\"error\":\"No data available\"}";
     }
     
-    Serial.print("[getResult] Serialisiere: Top=");
-    Serial.print(g_ambilightResult.topColors.size());
-    Serial.print(", Left=");
-    Serial.print(g_ambilightResult.leftColors.size());
-    Serial.print(", Right=");
-    Serial.println(g_ambilightResult.rightColors.size());
+    const AmbilightResult& result = *snapshot;
+    StageTimer jsonTimer(STAGE_API_JSON);
+    
+    LOG_D("[getResult] Serialisiere: Top=%u, Left=%u, Right=%u",
+          result.topColors.size(), result.leftColors.size(), result.rightColors.size());
     
     // DynamicJsonDocument für automatische Größenanpassung
     // Geschätzt: 32 Rechtecke * 100 Bytes = 3200 + Overhead = ~4000 Bytes
@@ -669,79 +716,78 @@ String getAmbilightResult() {
     // Top-Farben und Rechtecke
     JsonArray topColors = doc.createNestedArray("top");
     JsonArray topRectsJson = doc.createNestedArray("topRects");
-    for (size_t i = 0; i < g_ambilightResult.topColors.size(); i++) {
+    for (size_t i = 0; i < result.topColors.size(); i++) {
         JsonArray colorArray = topColors.createNestedArray();
-        colorArray.add(g_ambilightResult.topColors[i].r);
-        colorArray.add(g_ambilightResult.topColors[i].g);
-        colorArray.add(g_ambilightResult.topColors[i].b);
+        colorArray.add(result.topColors[i].r);
+        colorArray.add(result.topColors[i].g);
+        colorArray.add(result.topColors[i].b);
         
         JsonObject rectObj = topRectsJson.createNestedObject();
-        rectObj["x1"] = g_ambilightResult.topRects[i].x1;
-        rectObj["y1"] = g_ambilightResult.topRects[i].y1;
-        rectObj["x2"] = g_ambilightResult.topRects[i].x2;
-        rectObj["y2"] = g_ambilightResult.topRects[i].y2;
+        rectObj["x1"] = result.topRects[i].x1;
+        rectObj["y1"] = result.topRects[i].y1;
+        rectObj["x2"] = result.topRects[i].x2;
+        rectObj["y2"] = result.topRects[i].y2;
     }
     
     // Bottom-Farben und Rechtecke
     JsonArray bottomColors = doc.createNestedArray("bottom");
     JsonArray bottomRectsJson = doc.createNestedArray("bottomRects");
-    for (size_t i = 0; i < g_ambilightResult.bottomColors.size(); i++) {
+    for (size_t i = 0; i < result.bottomColors.size(); i++) {
         JsonArray colorArray = bottomColors.createNestedArray();
-        colorArray.add(g_ambilightResult.bottomColors[i].r);
-        colorArray.add(g_ambilightResult.bottomColors[i].g);
-        colorArray.add(g_ambilightResult.bottomColors[i].b);
+        colorArray.add(result.bottomColors[i].r);
+        colorArray.add(result.bottomColors[i].g);
+        colorArray.add(result.bottomColors[i].b);
         
         JsonObject rectObj = bottomRectsJson.createNestedObject();
-        rectObj["x1"] = g_ambilightResult.bottomRects[i].x1;
-        rectObj["y1"] = g_ambilightResult.bottomRects[i].y1;
-        rectObj["x2"] = g_ambilightResult.bottomRects[i].x2;
-        rectObj["y2"] = g_ambilightResult.bottomRects[i].y2;
+        rectObj["x1"] = result.bottomRects[i].x1;
+        rectObj["y1"] = result.bottomRects[i].y1;
+        rectObj["x2"] = result.bottomRects[i].x2;
+        rectObj["y2"] = result.bottomRects[i].y2;
     }
     
     // Left-Farben und Rechtecke
     JsonArray leftColors = doc.createNestedArray("left");
     JsonArray leftRectsJson = doc.createNestedArray("leftRects");
-    for (size_t i = 0; i < g_ambilightResult.leftColors.size(); i++) {
+    for (size_t i = 0; i < result.leftColors.size(); i++) {
         JsonArray colorArray = leftColors.createNestedArray();
-        colorArray.add(g_ambilightResult.leftColors[i].r);
-        colorArray.add(g_ambilightResult.leftColors[i].g);
-        colorArray.add(g_ambilightResult.leftColors[i].b);
+        colorArray.add(result.leftColors[i].r);
+        colorArray.add(result.leftColors[i].g);
+        colorArray.add(result.leftColors[i].b);
         
         JsonObject rectObj = leftRectsJson.createNestedObject();
-        rectObj["x1"] = g_ambilightResult.leftRects[i].x1;
-        rectObj["y1"] = g_ambilightResult.leftRects[i].y1;
-        rectObj["x2"] = g_ambilightResult.leftRects[i].x2;
-        rectObj["y2"] = g_ambilightResult.leftRects[i].y2;
+        rectObj["x1"] = result.leftRects[i].x1;
+        rectObj["y1"] = result.leftRects[i].y1;
+        rectObj["x2"] = result.leftRects[i].x2;
+        rectObj["y2"] = result.leftRects[i].y2;
     }
     
     // Right-Farben und Rechtecke
     JsonArray rightColors = doc.createNestedArray("right");
     JsonArray rightRectsJson = doc.createNestedArray("rightRects");
-    for (size_t i = 0; i < g_ambilightResult.rightColors.size(); i++) {
+    for (size_t i = 0; i < result.rightColors.size(); i++) {
         JsonArray colorArray = rightColors.createNestedArray();
-        colorArray.add(g_ambilightResult.rightColors[i].r);
-        colorArray.add(g_ambilightResult.rightColors[i].g);
-        colorArray.add(g_ambilightResult.rightColors[i].b);
+        colorArray.add(result.rightColors[i].r);
+        colorArray.add(result.rightColors[i].g);
+        colorArray.add(result.rightColors[i].b);
         
         JsonObject rectObj = rightRectsJson.createNestedObject();
-        rectObj["x1"] = g_ambilightResult.rightRects[i].x1;
-        rectObj["y1"] = g_ambilightResult.rightRects[i].y1;
-        rectObj["x2"] = g_ambilightResult.rightRects[i].x2;
-        rectObj["y2"] = g_ambilightResult.rightRects[i].y2;
+        rectObj["x1"] = result.rightRects[i].x1;
+        rectObj["y1"] = result.rightRects[i].y1;
+        rectObj["x2"] = result.rightRects[i].x2;
+        rectObj["y2"] = result.rightRects[i].y2;
     }
     
-    doc["timestamp"] = g_ambilightResult.timestamp;
+    doc["timestamp"] = result.timestamp;
+    doc["sequence"] = result.sequence;
+    doc["captureUs"] = result.captureUs;
+    doc["configVersion"] = result.configVersion;
+    doc["decodeScale"] = result.decodeScale;
     
     String response;
     size_t jsonSize = serializeJson(doc, response);
     
-    Serial.print("[getResult] JSON-Größe: ");
-    Serial.print(jsonSize);
-    Serial.print(" bytes (capacity: 6144, overflow: ");
-    Serial.print(doc.overflowed() ? "JA!" : "nein");
-    Serial.print(", free heap: ");
-    Serial.print(ESP.getFreeHeap());
-    Serial.println(")");
+    LOG_D("[getResult] JSON-Größe: %u bytes (capacity: 6144, overflow: %s, free heap: %u)",
+          jsonSize, doc.overflowed() ? "JA!" : "nein", ESP.getFreeHeap());
     
     return response;
 }
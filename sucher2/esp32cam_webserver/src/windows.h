@@ -3,27 +3,30 @@
 
 #include <Arduino.h>
 #include <vector>
+#include <memory>
 #include "esp_camera.h"
+#include "ambilight_types.h"
 
-// Struktur für Rechteck-Koordinaten
-struct WindowRect {
-    int x1, y1, x2, y2;
-};
-
-// Struktur für RGB-Farbwerte
-struct RGB {
-    uint8_t r, g, b;
-};
+// Kalibrierung und Dekodier-Skalierung: die Ecken sind auf [0, 1] normiert
+// und werden erst im Analyse-Task auf das aktuelle Kamerabild abgebildet
+// (buildSamplingPlan() in lib/hanawa_core). Dabei wählt er die gröbste
+// JPEG-Skalierung (1x/2x/4x/8x), bei der jedes Fenster noch mindestens
+// minSamples Pixel hat. Bildgröße und Skalierung können sich so ändern, ohne
+// neu zu kalibrieren. Rechtecke in /api/ambilight und im Live-WebSocket
+// stehen unabhängig davon in einem festen Raster von 320x240.
+#define DECODE_MIN_SAMPLES_DEFAULT  64
+#define DECODE_MAX_SCALE            8
+#define AMBILIGHT_RECT_WIDTH        320
+#define AMBILIGHT_RECT_HEIGHT       240
 
 // Struktur für Ambilight-Konfiguration (globaler State)
 struct AmbilightConfig {
-    float topLeft[2];
-    float topRight[2];
-    float botRight[2];
-    float botLeft[2];
+    float corners[4][2];  // normiert [0, 1]: oben links, oben rechts, unten rechts, unten links
     int hSeg;
     int vSeg;
     bool isValid;
+    uint32_t version;     // wird bei jeder neuen Konfiguration erhöht
+    int minSamples;       // Pixel je Fenster für die Wahl der Dekodier-Skalierung
 };
 
 // Struktur für Ambilight-Ergebnis (globaler State)
@@ -37,26 +40,40 @@ struct AmbilightResult {
     std::vector<WindowRect> leftRects;
     std::vector<WindowRect> rightRects;
     unsigned long timestamp;
+    uint32_t sequence;    // fortlaufende Nummer der Veröffentlichung (1, 2, ...)
+    int64_t captureUs;    // Capture-Zeitpunkt des Frames (fb->timestamp, esp_timer-Basis)
+    uint32_t configVersion; // AmbilightConfig::version, zu der die Rects gehören
+    int decodeScale;      // verwendete JPEG-Skalierung (1, 2, 4, 8)
     bool isValid;
 };
 
-// Globaler State (extern deklariert, in windows.cpp definiert)
+// Wird nach jeder erfolgreichen Berechnung mit dem neuen Ergebnis aufgerufen
+// (z.B. ESP-NOW-Sender). Listener laufen im Analyse-Kontext und müssen kurz sein.
+typedef void (*AmbilightResultListener)(const AmbilightResult& result);
+#define MAX_AMBILIGHT_LISTENERS 6
+
+// Globaler State (extern deklariert, in windows.cpp definiert). Gehört dem
+// Analyse-Task: nur dort und in Listenern lesen, andere Tasks verwenden
+// getPublishedAmbilightResult() bzw. updateAmbilightConfig().
 extern AmbilightConfig g_ambilightConfig;
 extern AmbilightResult g_ambilightResult;
 
 // Neue API-Funktionen für kontinuierliche Berechnung
-void updateAmbilightConfig(const String& jsonInput);
-void calculateAmbilightContinuous();
-String getAmbilightResult();
+void updateAmbilightConfig(const String& jsonInput);   // aus jedem Task, wirkt ab dem nächsten Frame
+void calculateAmbilightContinuous();                   // nur im Analyse-Task
+String getAmbilightResult();                           // JSON des veröffentlichten Stands
+bool addAmbilightResultListener(AmbilightResultListener listener);
+
+// Zuletzt veröffentlichtes Ergebnis (unveränderliche Kopie, nullptr = noch keins).
+// Der Aufrufer darf es beliebig lange halten, der Analyse-Task wartet nie darauf
+// und beschreibt den Platz erst wieder, wenn ihn niemand mehr hält.
+std::shared_ptr<const AmbilightResult> getPublishedAmbilightResult();
 
 // Alte Funktion (deprecated, wird durch neue Architektur ersetzt)
 String processAmbilight(const String& jsonInput);
 
-// Hilfsfunktionen (intern verwendet)
-// calculateMeanRGB  - RMS-Mittelwert (Original aus ambivios.py)
-// calculateMeanRGB2 - Gamma-korrigierter Mittelwert (visuell korrekt, basierend auf linear.txt)
-RGB calculateMeanRGB(uint8_t *rgb_buf, int width, int height, int x1, int y1, int x2, int y2);
-RGB calculateMeanRGB2(uint8_t *rgb_buf, int width, int height, int x1, int y1, int x2, int y2);
+// Geometrie (calculateAmbilightWindows) und Farbreduktion (calculateMeanRGB,
+// calculateMeanRGB2) liegen plattformunabhängig in lib/hanawa_core.
 
 #endif // WINDOWS_H
 